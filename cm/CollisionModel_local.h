@@ -264,6 +264,12 @@ typedef struct cm_traceWork_s {
 	idPluecker polygonEdgePlueckerCache[CM_MAX_POLYGON_EDGES];
 	idPluecker polygonVertexPlueckerCache[CM_MAX_POLYGON_EDGES];
 	idVec3 polygonRotationOriginCache[CM_MAX_POLYGON_EDGES];
+	// pluecker coordinates of trm vertex movement and trm edges in SoA layout (translation only)
+	// sidedness of a model edge/vertex against all trm vertices/edges is computed at once with SIMD
+	ALIGNTYPE16 float trmVertexPlueckerSoA[6][MAX_TRACEMODEL_VERTS];
+	ALIGNTYPE16 float trmEdgePlueckerSoA[6][MAX_TRACEMODEL_EDGES + 1];
+	uint64 trmVertexSideMask;						// bits of used trm vertices in trmVertexPlueckerSoA
+	uint64 trmEdgeSideMask;							// bits of used trm edges in trmEdgePlueckerSoA
 } cm_traceWork_t;
 
 /*
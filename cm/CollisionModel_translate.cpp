@@ -182,15 +182,69 @@ ID_INLINE void CM_AddContact( cm_traceWork_t *tw ) {
 	tw->trace.fraction = 1.0f;
 }
 
+/*
+================
+CM_SidednessBits
+
+  Computes sign of vpl.PermutedInnerProduct( epl ) for first num entries of SoA pluecker array
+  bit k of result is set if k-th product is negative
+================
+*/
+ID_INLINE uint64 CM_SidednessBits( const idPluecker &vpl, const float *soa, const int stride, const int num ) {
+	const float *e0 = soa, *e1 = e0 + stride, *e2 = e1 + stride, *e3 = e2 + stride, *e4 = e3 + stride, *e5 = e4 + stride;
+	uint64 bits = 0;
+	int k = 0;
+#ifdef __SSE__
+	__m128 p0 = _mm_set1_ps( vpl[0] ), p1 = _mm_set1_ps( vpl[1] ), p2 = _mm_set1_ps( vpl[2] );
+	__m128 p3 = _mm_set1_ps( vpl[3] ), p4 = _mm_set1_ps( vpl[4] ), p5 = _mm_set1_ps( vpl[5] );
+	for ( ; k + 4 <= num; k += 4 ) {
+		// same order of operations as in idPluecker::PermutedInnerProduct
+		__m128 r = _mm_mul_ps( p0, _mm_loadu_ps( e4 + k ) );
+		r = _mm_add_ps( r, _mm_mul_ps( p1, _mm_loadu_ps( e5 + k ) ) );
+		r = _mm_add_ps( r, _mm_mul_ps( p2, _mm_loadu_ps( e3 + k ) ) );
+		r = _mm_add_ps( r, _mm_mul_ps( p4, _mm_loadu_ps( e0 + k ) ) );
+		r = _mm_add_ps( r, _mm_mul_ps( p5, _mm_loadu_ps( e1 + k ) ) );
+		r = _mm_add_ps( r, _mm_mul_ps( p3, _mm_loadu_ps( e2 + k ) ) );
+		bits |= uint64( _mm_movemask_ps( r ) ) << k;
+	}
+#endif
+	for ( ; k < num; k++ ) {
+		float fl = vpl[0] * e4[k] + vpl[1] * e5[k] + vpl[2] * e3[k] + vpl[4] * e0[k] + vpl[5] * e1[k] + vpl[3] * e2[k];
+		bits |= uint64( FLOATSIGNBITSET( fl ) ) << k;
+	}
+	return bits;
+}
+
+/*
+================
+CM_SetPlueckerSoA
+
+  stores pluecker coordinate as k-th entry of SoA array
+================
+*/
+ID_INLINE void CM_SetPlueckerSoA( float *soa, const int stride, const int k, const idPluecker &pl ) {
+	for ( int j = 0; j < 6; j++ ) {
+		soa[j * stride + k] = pl[j];
+	}
+}
+
 /*
 ================
 CM_SetVertexSidedness
 
   stores for the given model vertex at which side of one of the trm edges it passes
+  Sidedness against all used trm edges is computed at once when possible
 ================
 */
-ID_INLINE void CM_SetVertexSidedness( cm_vertex_t *v, const idPluecker &vpl, const idPluecker &epl, const int bitNum ) {
+ID_INLINE void CM_SetVertexSidedness( cm_vertex_t *v, const idPluecker &vpl, const idPluecker &epl, const int bitNum, const cm_traceWork_t *tw ) {
 	if ( !(v->sideSet & (1LL << bitNum)) ) {
+		uint64 mask = tw->trmEdgeSideMask & ~v->sideSet;
+		if ( mask & (1LL << bitNum) ) {
+			uint64 bits = CM_SidednessBits( vpl, tw->trmEdgePlueckerSoA[0], MAX_TRACEMODEL_EDGES + 1, tw->numEdges + 1 );
+			v->side = ( v->side & ~mask ) | ( bits & mask );
+			v->sideSet |= mask;
+			return;
+		}
 		float fl;
 		fl = vpl.PermutedInnerProduct( epl );
 		v->side &= ~(1LL << bitNum);
@@ -204,10 +258,18 @@ ID_INLINE void CM_SetVertexSidedness( cm_vertex_t *v, const idPluecker &vpl, con
 CM_SetEdgeSidedness
 
   stores for the given model edge at which side one of the trm vertices
+  Sidedness for all used trm vertices is computed at once when possible
 ================
 */
-ID_INLINE void CM_SetEdgeSidedness( cm_edge_t *edge, const idPluecker &vpl, const idPluecker &epl, const int bitNum ) {
+ID_INLINE void CM_SetEdgeSidedness( cm_edge_t *edge, const idPluecker &vpl, const idPluecker &epl, const int bitNum, const cm_traceWork_t *tw ) {
 	if ( !(edge->sideSet & (1LL << bitNum)) ) {
+		uint64 mask = tw->trmVertexSideMask & ~edge->sideSet;
+		if ( mask & (1LL << bitNum) ) {
+			uint64 bits = CM_SidednessBits( vpl, tw->trmVertexPlueckerSoA[0], MAX_TRACEMODEL_VERTS, tw->numVerts );
+			edge->side = ( edge->side & ~mask ) | ( bits & mask );
+			edge->sideSet |= mask;
+			return;
+		}
 		float fl;
 		fl = vpl.PermutedInnerProduct( epl );
 		edge->side &= ~(1LL << bitNum);
@@ -243,17 +305,17 @@ void idCollisionModelManagerLocal::TranslateTrmEdgeThroughPolygon( cm_traceWork_
 		}
 		pl = &tw->polygonEdgePlueckerCache[i];
 		// get the sides at which the trm edge vertices pass the polygon edge
-		CM_SetEdgeSidedness( edge, *pl, tw->vertices[trmEdge->vertexNum[0]].pl, trmEdge->vertexNum[0] );
-		CM_SetEdgeSidedness( edge, *pl, tw->vertices[trmEdge->vertexNum[1]].pl, trmEdge->vertexNum[1] );
+		CM_SetEdgeSidedness( edge, *pl, tw->vertices[trmEdge->vertexNum[0]].pl, trmEdge->vertexNum[0], tw );
+		CM_SetEdgeSidedness( edge, *pl, tw->vertices[trmEdge->vertexNum[1]].pl, trmEdge->vertexNum[1], tw );
 		// if the trm edge start and end vertex do not pass the polygon edge at different sides
 		if ( !(((edge->side >> trmEdge->vertexNum[0]) ^ (edge->side >> trmEdge->vertexNum[1])) & 1) ) {
 			continue;
 		}
 		// get the sides at which the polygon edge vertices pass the trm edge
 		v1 = tw->model->vertices + edge->vertexNum[INTSIGNBITSET(edgeNum)];
-		CM_SetVertexSidedness( v1, tw->polygonVertexPlueckerCache[i], trmEdge->pl, trmEdge->bitNum );
+		CM_SetVertexSidedness( v1, tw->polygonVertexPlueckerCache[i], trmEdge->pl, trmEdge->bitNum, tw );
 		v2 = tw->model->vertices + edge->vertexNum[INTSIGNBITNOTSET(edgeNum)];
-		CM_SetVertexSidedness( v2, tw->polygonVertexPlueckerCache[i+1], trmEdge->pl, trmEdge->bitNum );
+		CM_SetVertexSidedness( v2, tw->polygonVertexPlueckerCache[i+1], trmEdge->pl, trmEdge->bitNum, tw );
 		// if the polygon edge start and end vertex do not pass the trm edge at different sides
 		if ( !(((v1->side ^ v2->side) >> trmEdge->bitNum) & 1) ) {
 			continue;
@@ -410,7 +472,7 @@ void idCollisionModelManagerLocal::TranslateTrmVertexThroughPolygon( cm_traceWor
 		for ( i = 0; i < poly->numEdges; i++ ) {
 			edgeNum = poly->edges[i];
 			edge = tw->model->edges + abs(edgeNum);
-			CM_SetEdgeSidedness( edge, tw->polygonEdgePlueckerCache[i], v->pl, bitNum );
+			CM_SetEdgeSidedness( edge, tw->polygonEdgePlueckerCache[i], v->pl, bitNum, tw );
 			if ( INTSIGNBITSET(edgeNum) ^ ((edge->side >> bitNum) & 1) ) {
 				return;
 			}
@@ -507,7 +569,7 @@ void idCollisionModelManagerLocal::TranslateVertexThroughTrmPolygon( cm_traceWor
 			edgeNum = tw->edgeUses[trmpoly->firstEdge + i];
 			edge = tw->edges + abs(edgeNum);
 
-			CM_SetVertexSidedness( v, pl, edge->pl, edge->bitNum );
+			CM_SetVertexSidedness( v, pl, edge->pl, edge->bitNum, tw );
 			if ( INTSIGNBITSET(edgeNum) ^ ((v->side >> edge->bitNum) & 1) ) {
 				return;
 			}
@@ -822,6 +884,8 @@ void idCollisionModelManagerLocal::Translation( trace_t *results, const idVec3 &
 	tw.start = start - modelOrigin;
 	tw.end = end - modelOrigin;
 	tw.dir = end - start;
+	tw.trmVertexSideMask = 0;
+	tw.trmEdgeSideMask = 0;
 
 	model_rotated = modelAxis.IsRotated();
 	if ( model_rotated ) {
@@ -1006,6 +1070,21 @@ void idCollisionModelManagerLocal::Translation( trace_t *results, const idVec3 &
 		edge->bitNum = i;
 	}
 
+	// pack pluecker coordinates of used trm vertices and edges for SIMD sidedness tests
+	for ( vert = tw.vertices, i = 0; i < tw.numVerts; i++, vert++ ) {
+		CM_SetPlueckerSoA( tw.trmVertexPlueckerSoA[0], MAX_TRACEMODEL_VERTS, i, vert->used ? vert->pl : idPluecker( 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f ) );
+		if ( vert->used ) {
+			tw.trmVertexSideMask |= (1LL << i);
+		}
+	}
+	CM_SetPlueckerSoA( tw.trmEdgePlueckerSoA[0], MAX_TRACEMODEL_EDGES + 1, 0, idPluecker( 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f ) );
+	for ( edge = tw.edges + 1, i = 1; i <= tw.numEdges; i++, edge++ ) {
+		CM_SetPlueckerSoA( tw.trmEdgePlueckerSoA[0], MAX_TRACEMODEL_EDGES + 1, i, edge->used ? edge->pl : idPluecker( 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f ) );
+		if ( edge->used ) {
+			tw.trmEdgeSideMask |= (1LL << i);
+		}
+	}
+
 	// set trm plane distances
 	for ( poly = tw.polys, i = 0; i < tw.numPolys; i++, poly++ ) {
 		if ( poly->used ) {
@@ -727,6 +727,9 @@ idCommonLocal::Error
 void idCommonLocal::Error( const char *fmt, ... ) {
 	va_list		argptr;
 
+	// make sure lines logged before the error reach DarkMod.log
+	g_Global.FlushLog();
+
 	if ( com_error_crash.GetInteger() >= 2 ) {
 		Com_Crash_f(idCmdArgs());
 	}
@@ -846,6 +849,8 @@ void idCommonLocal::FatalError( const char *fmt, ... ) {
 	va_list		argptr;
 	char msgBuf[MAX_PRINT_MSG_SIZE];
 
+	g_Global.FlushLog();
+
 	if ( com_error_crash.GetInteger() >= 1 ) {
 		Com_Crash_f(idCmdArgs());
 	}
@@ -817,6 +817,7 @@ void idSessionLocal::StopPlayingRenderDemo() {
 	soundSystem->SetPlayingSoundWorld( menuSoundWorld );
 
 	common->Printf( "stopped playing %s.\n", readDemo->GetName() );
+	idStr demoName = readDemo->GetName();
 	delete readDemo;
 	readDemo = NULL;
 
@@ -827,6 +828,7 @@ void idSessionLocal::StopPlayingRenderDemo() {
 		idStr	message = va( "%i frames rendered in %3.1f seconds = %3.1f fps\n", numDemoFrames, demoSeconds, demoFPS );
 
 		common->Printf( "%s", message.c_str() );
+		renderSystem->EndFrameStatsCapture( demoName.c_str() );
 		if ( timeDemo == TD_YES_THEN_QUIT ) {
 			cmdSystem->BufferCommandText( CMD_EXEC_APPEND, "quit\n" );
 		} else {
@@ -944,6 +946,7 @@ void idSessionLocal::TimeRenderDemo( const char *demoName, bool twice ) {
 	}
 
 	timeDemo = TD_YES;
+	renderSystem->BeginFrameStatsCapture();
 }
 
 
@@ -1909,6 +1912,15 @@ bool idSessionLocal::SaveGame( const char *saveName, bool autosave, bool skipChe
 		return false;
 	}
 
+	// previous savegame may still be written in background
+	double startTicks = Sys_GetClockTicks();
+	double waitMilliseconds = saveGameWriter.Wait();
+
+	// quicksaves are written as deltas against base savegame
+	idStr quicksaveName = common->Translate( "#str_07178" );
+	quicksaveName.Replace( " ", "_" );
+	bool delta = cv_savegame_delta.GetInteger() > 0 && cv_savegame_compress.GetBool() && gameFile.IcmpPrefix( quicksaveName ) == 0;
+
 	idSoundWorld *pauseWorld = soundSystem->GetPlayingSoundWorld();
 	if ( pauseWorld ) {
 		pauseWorld->Pause();
@@ -1933,8 +1945,22 @@ bool idSessionLocal::SaveGame( const char *saveName, bool autosave, bool skipChe
 	descriptionFile = gameFile;
 	descriptionFile.SetFileExtension( ".txt" );
 
+	saveGameDelta.SetTarget( delta ? gameFile.c_str() : NULL );
+	if ( !delta ) {
+		// full savegame replaces delta one of the same name
+		saveGameDelta.RemoveBase( gameFile );
+	}
+
 	// Open savegame file
-	idFile *fileOut = fileSystem->OpenFileWrite( gameFile );
+	// in async mode, game state goes to memory and is written to disk by worker thread
+	bool async = cv_savegame_async.GetBool();
+	idFile *fileOut = NULL;
+	if ( async ) {
+		fileOut = new idFile_Memory( gameFile );
+		saveGameWriter.Begin( fileOut );
+	} else {
+		fileOut = fileSystem->OpenFileWrite( gameFile );
+	}
 	if ( fileOut == NULL ) {
 		common->Warning( "Failed to open save file '%s'", gameFile.c_str() );
 		if ( pauseWorld ) {
@@ -1944,6 +1970,23 @@ bool idSessionLocal::SaveGame( const char *saveName, bool autosave, bool skipChe
 		return false;
 	}
 
+	// game may throw error while saving: stop collecting and don't leak the file
+	struct SaveFileGuard {
+		idFile *file;
+		bool async;
+		~SaveFileGuard() {
+			if ( !file ) {
+				return;
+			}
+			if ( async ) {
+				saveGameWriter.Cancel();
+				delete file;
+			} else {
+				fileSystem->CloseFile( file );
+			}
+		}
+	} fileGuard = { fileOut, async };
+
 	// Write SaveGame Header: 
 	// Game Name / Version / Map Name / Persistent Player Info
 
@@ -1968,7 +2011,15 @@ bool idSessionLocal::SaveGame( const char *saveName, bool autosave, bool skipChe
 	game->SaveGame( fileOut );
 
 	// close the sava game file
-	fileSystem->CloseFile( fileOut );
+	fileGuard.file = NULL;
+	if ( async ) {
+		saveGameWriter.Submit( static_cast<idFile_Memory *>( fileOut ), gameFile );
+	} else {
+		fileSystem->CloseFile( fileOut );
+	}
+	common->Printf( "Game state saved in %.1lf ms (%s, %.1lf ms waiting for previous save)\n",
+		( Sys_GetClockTicks() - startTicks ) * 1000.0 / Sys_ClockTicksPerSecond(), async ? "async" : "sync", waitMilliseconds
+	);
 
 	//stgatilov: clear old screenshots with this name (if present)
 	{
@@ -2068,6 +2119,9 @@ bool idSessionLocal::SaveGame( const char *saveName, bool autosave, bool skipChe
 
 bool idSessionLocal::LoadGame(const char *saveName, eSaveConflictHandling conflictHandling)
 {
+	// make sure savegame is completely written
+	saveGameWriter.Wait();
+
 	if (strlen(saveName) == 0)
 		saveName = lastSaveName;
 	else
@@ -243,6 +243,10 @@ void idSessionLocal::GetSaveGameList( idStrList &fileList, idList<fileTIME_T> &f
 	int i;
 	idFileList *files;
 
+	// savegame written in background is still .tmp file with old timestamp
+	// Wait also clears directory cache after the rename
+	saveGameWriter.Wait();
+
 	// NOTE: no fs_mod for savegames -- fan mission name stored in fs_currentfm
 	idStr game = cvarSystem->GetCVarString( "fs_currentfm" );
 	if( game.Length() ) {
@@ -484,10 +488,13 @@ bool idSessionLocal::HandleSaveGameMenuCommand( idCmdArgs &args, int &icmd ) {
 	if ( !idStr::Icmp( cmd, "deleteGame" ) ) {
 		int choice = guiActive->State().GetInt( "loadgame_sel_0" );
 		if ( choice >= 0 && choice < loadGameList.Num() ) {
+			// rename in flight could bring deleted savegame back
+			saveGameWriter.Wait();
 			fileSystem->RemoveFile( va("savegames/%s.save", loadGameList[choice].c_str()) );
 			fileSystem->RemoveFile( va("savegames/%s.tga", loadGameList[choice].c_str()) );
 			fileSystem->RemoveFile( va("savegames/%s.jpg", loadGameList[choice].c_str()) );
 			fileSystem->RemoveFile( va("savegames/%s.txt", loadGameList[choice].c_str()) );
+			saveGameDelta.RemoveBase( va("savegames/%s.save", loadGameList[choice].c_str()) );
 			SetSaveGameGuiVars( );
 			guiActive->StateChanged( com_frameTime );
 		}
@@ -26,6 +26,7 @@ Project: The Dark Mod (http://www.thedarkmod.com/)
 #include "ai/AI.h"
 #include "IniFile.h"
 #include "Debug.h"
+#include "LogWriter.h"
 
 #ifdef MACOS_X
 #include <mach-o/dyld.h>
@@ -149,6 +150,7 @@ CGlobal::CGlobal()
 	memset(m_LogArray, 0, sizeof(m_LogArray));
 	memset(m_ClassArray, 0, sizeof(m_ClassArray));
 	m_LogFile = 0;
+	m_LogWriter = NULL;
 	m_MaxFrobDistance = 0;
 	m_LogClass = LC_SYSTEM;
 	m_LogType = LT_DEBUG;
@@ -165,6 +167,12 @@ CGlobal::~CGlobal()
 void CGlobal::Shutdown() {
 	m_SurfaceHardness.ClearFree();
 	m_SurfaceHardnessHash.ClearFree();
+	if (m_LogWriter != NULL)
+	{
+		m_LogWriter->Stop();
+		delete m_LogWriter;
+		m_LogWriter = NULL;
+	}
 	if (m_LogFile != NULL)
 	{
 		fclose(m_LogFile);
@@ -208,6 +216,8 @@ void CGlobal::Init()
 
 	if (m_LogFile != NULL)
 	{
+		m_LogWriter = new idLogWriter();
+		m_LogWriter->Start(m_LogFile);
 		DM_LOG(LC_INIT, LT_INIT)LOGSTRING("Initializing mod logging\r");
 	}
 
@@ -312,15 +322,28 @@ void CGlobal::LogString(const char *fmt, ...)
 	va_list arg;
 	va_start(arg, fmt);
 
-	const char *cleanFilename = CleanupSourceCodeFileName(m_Filename);
-	fprintf(m_LogFile, "[%s (%4u):%s (%s) GT: %4u] ", cleanFilename, m_Linenumber, LTString[lt], LCString[lc], gameLocal.time);
-	vfprintf(m_LogFile, fmt, arg);
-	fprintf(m_LogFile, "\n");
-	fflush(m_LogFile);
+	if (m_LogWriter != NULL && cv_log_async.GetBool())
+	{
+		// only format the message here, writer thread does the rest
+		m_LogWriter->Append(m_Filename, m_Linenumber, LTString[lt], LCString[lc], gameLocal.time, fmt, arg);
+	}
+	else
+	{
+		FlushLog();
+		idLogWriter::WriteDirect(m_LogFile, m_Filename, m_Linenumber, LTString[lt], LCString[lc], gameLocal.time, fmt, arg);
+	}
 
 	va_end(arg);
 }
 
+void CGlobal::FlushLog()
+{
+	if (m_LogWriter != NULL)
+	{
+		m_LogWriter->Flush();
+	}
+}
+
 void CGlobal::LoadINISettings(const IniFilePtr& iniFile)
 {
 	DM_LOG(LC_INIT, LT_INIT)LOGSTRING("Loading INI settings\r");
@@ -338,6 +361,12 @@ void CGlobal::LoadINISettings(const IniFilePtr& iniFile)
 		DM_LOG(LC_INIT, LT_INIT)LOGSTRING("Logging disabled by darkmod.ini, closing logfile.\r");
 
 		// No logfile defined, quit logging
+		if (m_LogWriter != NULL)
+		{
+			m_LogWriter->Stop();
+			delete m_LogWriter;
+			m_LogWriter = NULL;
+		}
 		fclose(m_LogFile);
 		m_LogFile = NULL;
 	}
@@ -351,6 +380,7 @@ void CGlobal::LoadINISettings(const IniFilePtr& iniFile)
 
 			if (m_LogFile != NULL)
 			{
+				m_LogWriter->SetFile(logfile);
 				fclose(m_LogFile);
 				m_LogFile = logfile;
 			}
@@ -101,6 +101,7 @@ typedef enum {
 
 class idCmdArgs;
 class CDarkModPlayer;
+class idLogWriter;
 
 class CGlobal {
 public:
@@ -114,6 +115,8 @@ public:
 	void LogVector(idStr const &Name, idVec3 const &Vector);
 	void LogMat3(idStr const &Name, idMat3 const &Matrix);
 	void LogString(const char *Format, ...);
+	// blocks until all logged lines are written to logfile
+	void FlushLog();
 
 	/**
 	* Lookup the name of a the surface for a given material
@@ -168,6 +171,8 @@ public:
 	 * to the logfile. The logsettings are switched on in the INI file.
 	 */
 	FILE *m_LogFile;
+	// background writer of m_LogFile, exists while logfile is open
+	idLogWriter *m_LogWriter;
 	bool m_LogArray[LT_COUNT];
 	bool m_ClassArray[LC_COUNT];
 
@@ -45,6 +45,11 @@ Project: The Dark Mod (http://www.thedarkmod.com/)
 // Static member for debugging hiding spot results
 idList<darkModHidingSpot> CDarkmodAASHidingSpotFinder::DebugDrawList;
 
+int CDarkmodAASHidingSpotFinder::budgetFrameNumber = -1;
+double CDarkmodAASHidingSpotFinder::budgetUsedMilliseconds = 0.0;
+int CDarkmodAASHidingSpotFinder::budgetOldestWaitingFrame = INT_MAX;
+int CDarkmodAASHidingSpotFinder::budgetOldestWaitingFrameNext = INT_MAX;
+
 
 //----------------------------------------------------------------------------
 
@@ -65,6 +70,11 @@ CDarkmodAASHidingSpotFinder::CDarkmodAASHidingSpotFinder() :
 	hidingSpotTypesAllowed(0),
 	areasTestedThisPass(0),
 	lastProcessingFrameNumber(-1),
+	searchStartTime(0),
+	searchNumPasses(0),
+	searchNumPointsTested(0),
+	searchMilliseconds(0.0f),
+	budgetWaitingSinceFrame(-1),
 	currentGridSearchAASAreaNum(0),
 	currentGridSearchBounds(vec3_origin, vec3_origin),
 	currentGridSearchBoundMins(vec3_origin),
@@ -119,6 +129,12 @@ CDarkmodAASHidingSpotFinder::CDarkmodAASHidingSpotFinder
 	p_ignoreEntity = in_p_ignoreEntity;
 	lastProcessingFrameNumber = -1;
 
+	searchStartTime = 0;
+	searchNumPasses = 0;
+	searchNumPointsTested = 0;
+	searchMilliseconds = 0.0f;
+	budgetWaitingSinceFrame = -1;
+
 	// No hiding spot PVS areas identified yet
 	numPVSAreas = 0;
 	numPVSAreasIterated = 0;
@@ -175,6 +191,12 @@ bool CDarkmodAASHidingSpotFinder::initialize
 	p_ignoreEntity = in_p_ignoreEntity;
 	lastProcessingFrameNumber = -1;
 
+	searchStartTime = 0;
+	searchNumPasses = 0;
+	searchNumPointsTested = 0;
+	searchMilliseconds = 0.0f;
+	budgetWaitingSinceFrame = -1;
+
 	// No hiding spot PVS areas identified yet
 	numPVSAreas = 0;
 	numPVSAreasIterated = 0;
@@ -316,6 +338,13 @@ void CDarkmodAASHidingSpotFinder::Restore( idRestoreGame *savefile )
 
 	savefile->ReadInt(lastProcessingFrameNumber);
 
+	// Search statistics and budget state are not saved, so the savegame format is unchanged
+	searchStartTime = gameLocal.time;
+	searchNumPasses = 0;
+	searchNumPointsTested = 0;
+	searchMilliseconds = 0.0f;
+	budgetWaitingSinceFrame = -1;
+
 	savefile->ReadInt(currentGridSearchAASAreaNum);
 	savefile->ReadBounds(currentGridSearchBounds);
 	savefile->ReadVec3(currentGridSearchBoundMins);
@@ -341,7 +370,7 @@ bool CDarkmodAASHidingSpotFinder::findMoreHidingSpots
 	bool searchNotDone = (searchState != EDone);
 
 	while (searchNotDone && 
-			inout_numPointsTestedThisPass < numPointsToTestThisPass && 
+			!isPassQuotaFilled(numPointsToTestThisPass, inout_numPointsTestedThisPass) && 
 			areasTestedThisPass < MAX_AREAS_PER_PASS)
 	{
 		if (searchState == ENewPVSArea)
@@ -693,7 +722,7 @@ bool CDarkmodAASHidingSpotFinder::testingInsideVisibleAASArea
 		while ( currentGridSearchPoint.y <= currentGridSearchBoundMaxes.y - WALL_MARGIN_SIZE + 0.1 )
 		{
 			// See if we have filled our point quota
-			if ( inout_numPointsTestedThisPass >= numPointsToTestThisPass )
+			if ( isPassQuotaFilled(numPointsToTestThisPass, inout_numPointsTestedThisPass) )
 			{
 				// Filled point quota, but we need to keep iterating this grid next time
 				return true;
@@ -1203,6 +1232,12 @@ bool CDarkmodAASHidingSpotFinder::startHidingSpotSearch
 	// Set search state
 	searchState = EBuildingPVSList;
 
+	searchStartTime = gameLocal.time;
+	searchNumPasses = 0;
+	searchNumPointsTested = 0;
+	searchMilliseconds = 0.0f;
+	budgetWaitingSinceFrame = -1;
+
 	// Ensure the PVS to AAS table is initialized
 	// If already initialized, this returns right away.
 	if (!LAS.pvsToAASMappingTable.buildMappings("aas32"))
@@ -1222,18 +1257,24 @@ bool CDarkmodAASHidingSpotFinder::startHidingSpotSearch
 	// Iterating PVS areas
 	searchState = ENewPVSArea;
 
+	if (!beginPass(frameNumber))
+	{
+		// No frame budget left, points are tested in later frames
+		return true;
+	}
+
 	// Call the interior function
-	if (!findMoreHidingSpots(out_hidingSpots, numPointsToTestThisPass, numPointsTestedThisPass))
+	bool searchContinues = findMoreHidingSpots(out_hidingSpots, numPointsToTestThisPass, numPointsTestedThisPass);
+	if (!searchContinues)
 	{
 		// Sub divide the tree
 		out_hidingSpots.subDivideAreas(NUM_POINTS_PER_AREA_FOR_SUBDIVISION);
-		return false;
-	}
-	else
-	{
-		// More spots to test
-		return true;
 	}
+
+	endPass(out_hidingSpots, numPointsTestedThisPass, searchContinues);
+
+	// true if more spots to test
+	return searchContinues;
 }
 
 //-------------------------------------------------------------------------------------------------------
@@ -1264,16 +1305,114 @@ bool CDarkmodAASHidingSpotFinder::continueSearchForHidingSpots
 	// The number of points this pass
 	int numPointsTestedThisPass = 0;
 
+	if (!beginPass(frameNumber))
+	{
+		// No frame budget left, points are tested in later frames
+		return true;
+	}
+
 	// Call the interior function
-	if (!findMoreHidingSpots(inout_hidingSpots,	numPointsToTestThisPass, numPointsTestedThisPass))
+	bool searchContinues = findMoreHidingSpots(inout_hidingSpots, numPointsToTestThisPass, numPointsTestedThisPass);
+	if (!searchContinues)
 	{
 		// Sub divide the tree
 		inout_hidingSpots.subDivideAreas(NUM_POINTS_PER_AREA_FOR_SUBDIVISION);
+	}
+
+	endPass(inout_hidingSpots, numPointsTestedThisPass, searchContinues);
+
+	// true if more spots to test
+	return searchContinues;
+}
+
+//-------------------------------------------------------------------------------------------------------
+
+void CDarkmodAASHidingSpotFinder::resetFrameBudget()
+{
+	budgetFrameNumber = -1;
+	budgetUsedMilliseconds = 0.0;
+	budgetOldestWaitingFrame = INT_MAX;
+	budgetOldestWaitingFrameNext = INT_MAX;
+}
+
+//-------------------------------------------------------------------------------------------------------
+
+bool CDarkmodAASHidingSpotFinder::beginPass(int frameNumber)
+{
+	if (budgetFrameNumber != frameNumber)
+	{
+		// New frame, budget is full again
+		budgetFrameNumber = frameNumber;
+		budgetUsedMilliseconds = 0.0;
+		budgetOldestWaitingFrame = budgetOldestWaitingFrameNext;
+		budgetOldestWaitingFrameNext = INT_MAX;
+	}
+
+	if (cv_ai_hiding_spot_frame_budget.GetFloat() > 0.0f)
+	{
+		// Searches refused last frame go first, starting from the one waiting longest
+		int waitingSince = (budgetWaitingSinceFrame >= 0 ? budgetWaitingSinceFrame : frameNumber);
+		if (budgetUsedMilliseconds >= cv_ai_hiding_spot_frame_budget.GetFloat() || waitingSince > budgetOldestWaitingFrame)
+		{
+			budgetWaitingSinceFrame = waitingSince;
+			budgetOldestWaitingFrameNext = idMath::Imin(budgetOldestWaitingFrameNext, waitingSince);
+			return false;
+		}
+	}
+	budgetWaitingSinceFrame = -1;
+
+	passTimer.Clear();
+	passTimer.Start();
+	return true;
+}
+
+//-------------------------------------------------------------------------------------------------------
+
+bool CDarkmodAASHidingSpotFinder::isPassQuotaFilled(int numPointsToTestThisPass, int numPointsTestedThisPass)
+{
+	float budget = cv_ai_hiding_spot_frame_budget.GetFloat();
+	if (budget <= 0.0f)
+	{
+		// Fixed number of points per pass
+		return numPointsTestedThisPass >= numPointsToTestThisPass;
+	}
+
+	if (numPointsTestedThisPass == 0)
+	{
+		// beginPass has admitted this search, test at least one point so that it progresses
 		return false;
 	}
-	else
+
+	passTimer.Stop();
+	double elapsed = passTimer.Milliseconds();
+	passTimer.Start();
+
+	return budgetUsedMilliseconds + elapsed >= budget;
+}
+
+//-------------------------------------------------------------------------------------------------------
+
+void CDarkmodAASHidingSpotFinder::endPass(CDarkmodHidingSpotTree& hidingSpots, int numPointsTestedThisPass, bool searchContinues)
+{
+	passTimer.Stop();
+	double elapsed = passTimer.Milliseconds();
+	budgetUsedMilliseconds += elapsed;
+
+	searchNumPasses++;
+	searchNumPointsTested += numPointsTestedThisPass;
+	searchMilliseconds += elapsed;
+
+	if (searchContinues)
 	{
-		// More spots to test
-		return true;
+		return;
+	}
+
+	DM_LOG(LC_AI, LT_INFO)LOGSTRING("Hiding spot search completed in %d ms over %d passes: %d points tested, %d spots found, %.2f ms of game thread time\r",
+		gameLocal.time - searchStartTime, searchNumPasses, searchNumPointsTested, hidingSpots.getNumSpots(), searchMilliseconds);
+
+	if (cv_ai_search_show.GetInteger() >= 1)
+	{
+		gameLocal.Printf("Hiding spot search completed in %d ms over %d passes: %d points tested, %d spots found, %.2f ms of game thread time\n",
+			gameLocal.time - searchStartTime, searchNumPasses, searchNumPointsTested, hidingSpots.getNumSpots(), searchMilliseconds);
 	}
 }
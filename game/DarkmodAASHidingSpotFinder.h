@@ -119,6 +119,27 @@ protected:
 	*/
 	int lastProcessingFrameNumber;
 
+	// Statistics of the whole search, reported when it completes
+	int searchStartTime;
+	int searchNumPasses;
+	int searchNumPointsTested;
+	float searchMilliseconds;
+
+	// All searches share one game thread time budget per frame
+	// (see tdm_ai_hiding_spot_frame_budget), spent time is accumulated here.
+	static int budgetFrameNumber;
+	static double budgetUsedMilliseconds;
+
+	// Searches which got no budget wait for it, the longest waiting ones are served first.
+	// Oldest waiting frame among searches refused in previous frame, and in this frame.
+	static int budgetOldestWaitingFrame;
+	static int budgetOldestWaitingFrameNext;
+
+	// Frame when this search was first refused a pass, -1 if it is not waiting
+	int budgetWaitingSinceFrame;
+
+	// Measures time spent in the current pass
+	idTimer passTimer;
 	// These variables are for doing a gridded sweep of a visible AAS area
 	// for lighting and occlusion tests
 	int currentGridSearchAASAreaNum;
@@ -296,6 +317,17 @@ protected:
 		int& inout_numPointsTestedThisPass
 	);
 
+	/*!
+	* These methods measure the time spent in one call of start/continue search.
+	* The pass stops when point quota is filled, or when frame time budget is exceeded if it is set.
+	* With the budget set, beginPass returns false if no budget is left for this search in this frame.
+	* A search which is allowed to run tests at least one point, and the search which
+	* waits longest is allowed first, so every search progresses.
+	*/
+	bool beginPass(int frameNumber);
+	bool isPassQuotaFilled(int numPointsToTestThisPass, int numPointsTestedThisPass);
+	void endPass(CDarkmodHidingSpotTree& hidingSpots, int numPointsTestedThisPass, bool searchContinues);
+
 	// greebo: Makes sure we have a valid PVS handle to work with
 	// Call this right before a PVS operation to ensure that the PVS
 	// handle is initialised.
@@ -468,6 +500,11 @@ public:
 	*/
 	static void debugDrawHidingSpots(int viewLifetime);
 
+	/*!
+	* Forgets the frame time budget spent by the searches, called on map load.
+	*/
+	static void resetFrameBudget();
+
 	/*!
 	* This method is used as a test stub for the hiding
 	* spot finding routine. It uses the LAS to find hiding spots near
@@ -106,6 +106,8 @@ void tdmFuncShooter::Spawn()
 	{
 		//DM_LOG(LC_STIM_RESPONSE, LT_INFO)LOGSTRING("tdmFuncShooter is requiring stim %d\r", _requiredStim);
 		GetPhysics()->SetContents( GetPhysics()->GetContents() | CONTENTS_RESPONSE );
+		// register as response entity, so that stims of required type consider it
+		gameLocal.AddResponse( this );
 	}
 }
 
@@ -159,6 +161,11 @@ void tdmFuncShooter::Restore( idRestoreGame *savefile )
 	savefile->ReadInt( _triggerTimeOut );
 	savefile->ReadInt( _ammo );
 	savefile->ReadBool( _useAmmo );
+
+	if (_requiredStim != ST_DEFAULT)
+	{
+		gameLocal.AddResponse( this );
+	}
 }
 
 /*
@@ -61,6 +61,9 @@ public:
 	*/
 	virtual void		stimulate(StimType stimId);
 
+	// Returns the stim type this shooter reacts to (ST_DEFAULT if none)
+	StimType			GetRequiredStim() const { return _requiredStim; }
+
 private:
 	// Calculates the next time this shooter should fire
 	void				setupNextFireTime();
@@ -23,6 +23,7 @@ Project: The Dark Mod (http://www.thedarkmod.com/)
 #include "Game_local.h"
 #include "DarkModGlobals.h"
 #include "darkModLAS.h"
+#include "DarkmodAASHidingSpotFinder.h"
 #include "declxdata.h"
 #include "Grabber.h"
 #include "Relations.h"
@@ -49,6 +50,7 @@ Project: The Dark Mod (http://www.thedarkmod.com/)
 #include "framework/Session_local.h"
 #include "framework/Common.h"
 #include "LightEstimateSystem.h"
+#include "ai/PerceptionScheduler.h"
 
 #include <chrono>
 #include <iostream>
@@ -252,9 +254,16 @@ void idGameLocal::Clear( void )
 {
 	m_HighestSRId = 0;
 	m_StimTimer.Clear();
+	m_StimTimerDue.Clear();
+	m_StimTimerDueDirty = true;
 	m_Timer.Clear();
 	m_StimEntity.Clear();
 	m_RespEntity.Clear();
+	m_RespBuckets.Clear();
+	m_RespBucketHash.Clear();
+	m_RespBucketsDirty = true;
+	m_StimResponseChecks = 0;
+	m_StimResponseQueries = 0;
 
 	m_sndPropLoader = &g_SoundPropLoader;
 	m_sndProp = &g_SoundProp;
@@ -555,6 +564,7 @@ void idGameLocal::Init( void ) {
 	m_LightController->Init();
 
 	m_LightEstimateSystem = new LightEstimateSystem();
+	m_PerceptionScheduler = new PerceptionScheduler();
 
 	// greebo: Create the persistent inventory - will be handled by game state changing code
 	persistentPlayerInventory.reset(new CInventory);
@@ -705,6 +715,14 @@ void idGameLocal::Shutdown( void ) {
 	delete m_LightEstimateSystem;
 	m_LightEstimateSystem = nullptr;
 
+	delete m_PerceptionScheduler;
+	m_PerceptionScheduler = nullptr;
+
+	afIslandSolver.Shutdown();
+
+	saveGameWriter.Shutdown();
+	saveGameDelta.Clear();
+
 	// Clear http connection
 	m_HttpConnection.reset();
 	m_GuiMessages.ClearFree();
@@ -1530,6 +1548,7 @@ void idGameLocal::LoadMap( const char *mapName, int randseed ) {
 	* This must occur AFTER the AAS list is loaded
 	*/
 	LAS.initialize();
+	CDarkmodAASHidingSpotFinder::resetFrameBudget();
 
 	// clear the smoke particle free list
 	smokeParticles->Init();
@@ -1802,6 +1821,7 @@ void idGameLocal::LocalMapRestart( ) {
 	* The Dark Mod LAS: Init the LAS
 	*/
 	LAS.initialize();
+	CDarkmodAASHidingSpotFinder::resetFrameBudget();
 
 	// the spawnCount is reset to zero temporarily to spawn the map entities with the same spawnId
 	// if we don't do that, network clients are confused and don't show any map entities
@@ -2396,6 +2416,8 @@ bool idGameLocal::InitFromSaveGame( const char *mapName, idRenderWorld *renderWo
 	{
 		m_StimTimer[i] = static_cast<CStim*>(FindStimResponse(tempStimTimerIdList[i]).get());
 	}
+	InvalidateStimTimerDue();
+	InvalidateResponseBuckets();
 
 	// Let the mission database know that we start playing
 	m_MissionManager->OnMissionStart();
@@ -2503,6 +2525,11 @@ void idGameLocal::MapShutdown( void ) {
 		m_LightEstimateSystem->Clear();
 	}
 
+	if (m_PerceptionScheduler)
+	{
+		m_PerceptionScheduler->Clear();
+	}
+
 	pvs.Shutdown();
 
 	// Remove the grabber entity itself (note that it's safe to pass NULL pointers to delete)
@@ -2536,6 +2563,12 @@ void idGameLocal::MapShutdown( void ) {
 	// m_Shop->Clear();
 
 	clip.Shutdown();
+	afIslandSolver.Clear();
+
+	// new map will need new base for delta savegames
+	saveGameWriter.Wait();
+	saveGameDelta.Clear();
+	sleepIslands.Clear();
 	idClipModel::ClearTraceModelCache();
 
 	mapFileName.Clear();
@@ -3259,6 +3292,19 @@ gameReturn_t idGameLocal::RunFrame( const usercmd_t *clientCmds, int timestepMs,
 	// Handle any mission downloads in progress
 	m_DownloadManager->ProcessDownloads();
 
+	// finish savegame written in background
+	saveGameWriter.Update();
+
+	// rebuild precomputed routing dropped by doors and obstacles last frame
+	for (int aasNum = 0; aasNum < NumAAS(); aasNum++)
+	{
+		idAASLocal* aas = dynamic_cast<idAASLocal*>(GetAAS(aasNum));
+		if (aas != NULL)
+		{
+			aas->UpdatePrecomputedRouting();
+		}
+	}
+
 	if (framenum == 0 && player != NULL && !player->IsReady())
 	{
 		// greebo: This is the first game frame, handle the "click to start GUI"
@@ -3366,6 +3412,9 @@ gameReturn_t idGameLocal::RunFrame( const usercmd_t *clientCmds, int timestepMs,
 			timer_think.Clear();
 			timer_think.Start();
 
+			// simulate independent ragdolls in parallel, their think will skip physics
+			afIslandSolver.Evaluate();
+
 			{ // let entities think
 				TRACE_CPU_SCOPE( "ThinkAllEntities" )
 				num = 0;
@@ -3403,6 +3452,9 @@ gameReturn_t idGameLocal::RunFrame( const usercmd_t *clientCmds, int timestepMs,
 				}
 			}
 
+			// put to rest groups of rigid bodies which are ready
+			sleepIslands.Update();
+
 			// remove any entities that have stopped thinking
 			if ( numEntitiesToDeactivate ) {
 				TRACE_CPU_SCOPE( "DeactivateEntities" )
@@ -3436,6 +3488,9 @@ gameReturn_t idGameLocal::RunFrame( const usercmd_t *clientCmds, int timestepMs,
 			// grayman #3857 - Process the active searches
 			m_searchManager->ProcessSearches();
 
+			// execute AI visual scans requested during think (needs player pvs)
+			m_PerceptionScheduler->Think();
+
 			// free the player pvs
 			FreePlayerPVS();
 
@@ -5516,6 +5571,16 @@ void idGameLocal::SetupEAS()
 		}
 	}
 
+	// doors and elevators are set up, precompute routing inside clusters
+	for (int aasNum = 0; aasNum < NumAAS(); aasNum++)
+	{
+		idAASLocal* aas = dynamic_cast<idAASLocal*>(GetAAS(aasNum));
+		if (aas != NULL)
+		{
+			aas->PrecomputeRouting(TFL_WALK|TFL_AIR|TFL_DOOR);
+		}
+	}
+
 	session->UpdateLoadingProgressBar(PROGRESS_STAGE_ROUTING, 1.0f);
 }
 
@@ -7193,6 +7258,8 @@ bool idGameLocal::AddResponse(idEntity *e)
 	{
 		m_RespEntity.Append(e);
 	}
+	// entity could have got a response of new type
+	InvalidateResponseBuckets();
 
 	return rc;
 }
@@ -7205,9 +7272,102 @@ void idGameLocal::RemoveResponse(idEntity *e)
 	if (i != -1)
 	{
 		m_RespEntity.RemoveIndex(i);
+		InvalidateResponseBuckets();
 	}
 }
 
+void idGameLocal::AddStimTimer(CStim *stim)
+{
+	m_StimTimer.AddUnique(stim);
+	InvalidateStimTimerDue();
+}
+
+void idGameLocal::RemoveStimTimer(CStim *stim)
+{
+	m_StimTimer.Remove(stim);
+	m_StimTimerDue.Remove(stim);
+}
+
+void idGameLocal::UpdateResponseBuckets()
+{
+	if (!m_RespBucketsDirty)
+	{
+		return;
+	}
+	m_RespBucketsDirty = false;
+
+	for (int b = 0; b < m_RespBuckets.Num(); b++)
+	{
+		m_RespBuckets[b].entities.Clear();
+	}
+
+	auto AddToBucket = [this](int stimType, idEntity* ent) {
+		int b;
+		for (b = m_RespBucketHash.First(stimType); b != -1; b = m_RespBucketHash.Next(b))
+		{
+			if (m_RespBuckets[b].stimType == stimType)
+			{
+				break;
+			}
+		}
+		if (b == -1)
+		{
+			b = m_RespBuckets.Append(responseBucket_t());
+			m_RespBuckets[b].stimType = stimType;
+			m_RespBucketHash.Add(stimType, b);
+		}
+		idList<idEntity*> &entities = m_RespBuckets[b].entities;
+		// shooter may also have a response of its required type
+		if (entities.Num() == 0 || entities[entities.Num() - 1] != ent)
+		{
+			entities.Append(ent);
+		}
+	};
+
+	for (int i = 0; i < m_RespEntity.Num(); i++)
+	{
+		idEntity* ent = m_RespEntity[i].GetEntity();
+
+		if (ent == NULL) continue;
+
+		if (ent->IsType(tdmFuncShooter::Type))
+		{
+			StimType requiredStim = static_cast<tdmFuncShooter*>(ent)->GetRequiredStim();
+			if (requiredStim != ST_DEFAULT)
+			{
+				AddToBucket(requiredStim, ent);
+			}
+		}
+
+		CStimResponseCollection* srColl = ent->GetStimResponseCollection();
+		for (int r = 0; r < srColl->GetNumResponses(); r++)
+		{
+			AddToBucket(srColl->GetResponse(r)->m_StimTypeId, ent);
+		}
+	}
+}
+
+const idList<idEntity*>* idGameLocal::FindResponseBucket(int stimType) const
+{
+	for (int b = m_RespBucketHash.First(stimType); b != -1; b = m_RespBucketHash.Next(b))
+	{
+		if (m_RespBuckets[b].stimType == stimType)
+		{
+			return m_RespBuckets[b].entities.Num() > 0 ? &m_RespBuckets[b].entities : NULL;
+		}
+	}
+	return NULL;
+}
+
+bool idGameLocal::RespondsToStim(idEntity* ent, int stimType) const
+{
+	if (ent->IsType(tdmFuncShooter::Type) && static_cast<tdmFuncShooter*>(ent)->GetRequiredStim() == stimType)
+	{
+		return true;
+	}
+	return ent->GetStimResponseCollection()->GetResponseByType(static_cast<StimType>(stimType)) != NULL;
+}
+
 // grayman #1104 - DoesOpeningExist() looks for any opening along the axis of the
 // normal of the surface the original trace impacted. It creates a grid of points
 // to test from, and applies a randomized jitter to the grid, to minimize testing
@@ -7458,6 +7618,14 @@ int idGameLocal::DoResponseAction(const CStimPtr& stim, const idClip_EntityList
 			continue;
 		}
 
+		// entities without matching response would do nothing below,
+		// so reject them before distance checks and gas traces
+		if (cv_sr_broadphase.GetBool() && !RespondsToStim(srEntities[i], stim->m_StimTypeId))
+		{
+			continue;
+		}
+		m_StimResponseChecks++;
+
 		// Check if the radius is really fitting. EntitiesTouchingBounds is using a rectangular volume
 		// greebo: Be sure to use this check only if "use bounds" is set to false
 		if (!stim->m_bCollisionBased && !stim->m_bUseEntBounds)
@@ -7665,6 +7833,43 @@ CStimResponsePtr idGameLocal::FindStimResponse(int uniqueId)
 	return CStimResponsePtr();
 }
 
+// if response bucket is not larger than this, its entities are tested directly
+static const int SR_BUCKET_SCAN_LIMIT = 32;
+
+// same result as idClip::EntitiesTouchingBounds with CONTENTS_RESPONSE,
+// but only the given candidate entities are considered
+static int ResponseEntitiesTouchingBounds(const idList<idEntity*> &candidates, const idBounds &bounds, idClip_EntityList &entityList)
+{
+	idBounds queryBox = bounds;
+	queryBox.ExpandSelf(CM_BOX_EPSILON);
+
+	entityList.Clear();
+	for (int i = 0; i < candidates.Num(); i++)
+	{
+		idEntity* ent = candidates[i];
+		idPhysics* phys = ent->GetPhysics();
+
+		for (int c = 0; c < phys->GetNumClipModels(); c++)
+		{
+			const idClipModel* cm = phys->GetClipModel(c);
+
+			if (cm == NULL || cm->GetEntity() != ent || !cm->IsLinked() || !cm->IsEnabled())
+			{
+				continue;
+			}
+			if (!(cm->GetContents() & CONTENTS_RESPONSE) || !cm->GetAbsBounds().IntersectsBounds(queryBox))
+			{
+				continue;
+			}
+
+			entityList.AddGrow(ent);
+			break;
+		}
+	}
+
+	return entityList.Num();
+}
+
 void idGameLocal::ProcessStimResponse(unsigned int ticks)
 {
 	if (cv_sr_disable.GetBool())
@@ -7677,12 +7882,36 @@ void idGameLocal::ProcessStimResponse(unsigned int ticks)
 	srTimer.Clear();
 	srTimer.Start();
 
+	m_StimResponseChecks = 0;
+	m_StimResponseQueries = 0;
+
+	// only stims with running timer are visited each frame
+	// when some timer is started, the due list is rebuilt from all timed stims
+	if (m_StimTimerDueDirty)
+	{
+		m_StimTimerDue.Clear();
+		for (int i = 0; i < m_StimTimer.Num(); i++)
+		{
+			CStim* stim = m_StimTimer[i];
+			if (stim != NULL && stim->GetTimer()->GetState() == CStimResponseTimer::SRTS_RUNNING)
+			{
+				m_StimTimerDue.Append(stim);
+			}
+		}
+		m_StimTimerDueDirty = false;
+	}
+
 	// Check the timed stims first.
-	for (int i = 0; i < m_StimTimer.Num(); i++)
+	for (int i = 0; i < m_StimTimerDue.Num(); i++)
 	{
-		CStim* stim = m_StimTimer[i];
+		CStim* stim = m_StimTimerDue[i];
 
-		if (stim == NULL) continue;
+		if (stim->GetTimer()->GetState() != CStimResponseTimer::SRTS_RUNNING)
+		{
+			// timer stopped since last frame: drop it until restarted
+			m_StimTimerDue.RemoveIndex(i--);
+			continue;
+		}
 
 		// Only advance the timer if the stim can be fired in the first place
 		if (stim->m_MaxFireCount > 0 || stim->m_MaxFireCount == -1)
@@ -7706,6 +7935,13 @@ void idGameLocal::ProcessStimResponse(unsigned int ticks)
 	int n;
 	idClip_EntityList srEntities;
 
+	bool useBroadphase = cv_sr_broadphase.GetBool();
+	const idList<idEntity*>* respBucket = NULL;
+	if (useBroadphase)
+	{
+		UpdateResponseBuckets();
+	}
+
 	// Now check the rest of the stims.
 	for (int i = 0; i < m_StimEntity.Num(); i++)
 	{
@@ -7847,10 +8083,22 @@ void idGameLocal::ProcessStimResponse(unsigned int ticks)
 					stim->m_bCollisionFired = false;
 					stim->m_CollisionEnts.Clear();
 				}
+				else if (useBroadphase && (respBucket = FindResponseBucket(stim->m_StimTypeId)) == NULL)
+				{
+					// nobody can respond to this stim, no need to search
+					srEntities.Clear();
+					n = 0;
+				}
+				else if (useBroadphase && respBucket->Num() <= SR_BUCKET_SCAN_LIMIT)
+				{
+					// few entities can respond: check them directly instead of searching whole clip octree
+					n = ResponseEntitiesTouchingBounds(*respBucket, bounds, srEntities);
+				}
 				else 
 				{
 					// Radius based stims
 					n = clip.EntitiesTouchingBounds(bounds, CONTENTS_RESPONSE, srEntities);
+					m_StimResponseQueries++;
 					//DM_LOG(LC_STIM_RESPONSE, LT_INFO)LOGSTRING("Entities touching bounds: %d\r", n);
 				}
 				
@@ -7885,7 +8133,13 @@ void idGameLocal::ProcessStimResponse(unsigned int ticks)
 	}
 
 	srTimer.Stop();
-	DM_LOG(LC_STIM_RESPONSE, LT_INFO)LOGSTRING("Processing S/R took %lf\r", srTimer.Milliseconds());
+	DM_LOG(LC_STIM_RESPONSE, LT_INFO)LOGSTRING("Processing S/R took %lf, %d queries, %d checks\r", srTimer.Milliseconds(), m_StimResponseQueries, m_StimResponseChecks);
+
+	if (cv_sr_stats.GetBool())
+	{
+		Printf("S/R: %d stims, %d timers due, %d queries, %d checks, %.3lf ms\n",
+			m_StimEntity.Num(), m_StimTimerDue.Num(), m_StimResponseQueries, m_StimResponseChecks, srTimer.Milliseconds());
+	}
 }
 
 /*
@@ -163,6 +163,7 @@ typedef std::shared_ptr<CShop> CShopPtr;
 class CSearchManager; // grayman #3857
 
 class LightEstimateSystem;
+class PerceptionScheduler;
 
 const int MAX_GAME_MESSAGE_SIZE		= 8192;
 const int MAX_ENTITY_STATE_SIZE		= 512;
@@ -431,6 +432,8 @@ struct SuspiciousEvent
 #include "SearchManager.h" // grayman #3857 - must follow the definition of "EventType"
 #include "Entity.h"
 #include "EntityList.h"
+#include "physics/AFIslandSolver.h"
+#include "physics/SleepIslands.h"
 
 class idDeclEntityDef;
 
@@ -501,6 +504,8 @@ public:
 
 	idClip					clip;					// collision detection
 	idPush					push;					// geometric pushing
+	idAFIslandSolver		afIslandSolver;			// parallel evaluation of ragdolls
+	idSleepIslands			sleepIslands;			// rigid bodies put to rest and woken up together
 	idPVS					pvs;					// potential visible set
 
 	idTestModel *			testmodel;				// for development testing of models
@@ -609,6 +614,9 @@ public:
 	// stgatilov #6546: aka "lightgem for bodies"
 	LightEstimateSystem *m_LightEstimateSystem;
 
+	// budgeted execution of AI visual scans
+	PerceptionScheduler *m_PerceptionScheduler;
+
 	/**
 	* Temporary storage of the walkspeed.  This is a workaround
 	*	because the walkspeed keeps getting reset.
@@ -623,6 +631,21 @@ public:
 	idList< idEntityPtr<idEntity> >		m_StimEntity;			// all entities that currently have a stim regardless of it's state
 	idList< idEntityPtr<idEntity> >		m_RespEntity;			// all entities that currently have a response regardless of it's state
 
+	// response entities bucketed by the stim type they react to (rebuilt lazily from m_RespEntity)
+	// lets ProcessStimResponse skip stims nobody can respond to, and avoid testing entities without matching response
+	struct responseBucket_t {
+		int						stimType;
+		idList<idEntity*>		entities;
+	};
+	idList<responseBucket_t>	m_RespBuckets;
+	idHashIndex				m_RespBucketHash;		// stim type -> index in m_RespBuckets
+	bool					m_RespBucketsDirty;
+	// stims with running timer: only these are ticked each frame (rebuilt from m_StimTimer when some timer starts)
+	idList<CStim *>			m_StimTimerDue;
+	bool					m_StimTimerDueDirty;
+	int						m_StimResponseChecks;	// stim -> response entity checks done on the last frame
+	int						m_StimResponseQueries;	// spatial queries done by stims on the last frame
+
 	int						cinematicSkipTime;		// don't allow skipping cinemetics until this time has passed so player doesn't skip out accidently from a firefight
 	int						cinematicStopTime;		// cinematics have several camera changes, so keep track of when we stop them so that we don't reset cinematicSkipTime unnecessarily
 	int						cinematicMaxSkipTime;	// time to end cinematic when skipping.  there's a possibility of an infinite loop if the map isn't set up right.
@@ -889,6 +912,12 @@ public:
 	void					RemoveStim(idEntity *);
 	bool					AddResponse(idEntity *);
 	void					RemoveResponse(idEntity *);
+	// must be called whenever set of responses of any entity changes
+	void					InvalidateResponseBuckets() { m_RespBucketsDirty = true; }
+	// stim timers should be added/removed via these methods, see also m_StimTimerDue
+	void					AddStimTimer(CStim *stim);
+	void					RemoveStimTimer(CStim *stim);
+	void					InvalidateStimTimerDue() { m_StimTimerDueDirty = true; }
 	bool					DoesOpeningExist( const idVec3 origin, const idVec3 target, const float radius, const idVec3 normal, idEntity* ent ); // grayman #1104
 
 	
@@ -925,6 +954,21 @@ public:
 	*/
 	int						DoResponseAction(const CStimPtr& stim, const idClip_EntityList &srEntities, idEntity* originator, const idVec3& stimOrigin);
 
+	/**
+	 * Rebuilds m_RespBuckets from m_RespEntity if it has been invalidated.
+	 */
+	void					UpdateResponseBuckets();
+
+	/**
+	 * Returns the list of entities which may respond to the given stim type, or NULL if there are none.
+	 */
+	const idList<idEntity*>* FindResponseBucket(int stimType) const;
+
+	/**
+	 * Returns true if the entity has a response to the given stim type (or is a shooter requiring it).
+	 */
+	bool					RespondsToStim(idEntity* ent, int stimType) const;
+
 	/**
 	 * Trace a LOS path from gas origin to a point.
 	 */
@@ -26,6 +26,37 @@ idCVar g_lesEvaluationPeriod(
 	"Evaluation of all samples is spread across this period of game time (in ms)"
 );
 
+idCVar g_lesFrameBudget(
+	"g_lesFrameBudget", "0.5", CVAR_GAME | CVAR_FLOAT,
+	"Time per frame allowed for evaluating light samples (in ms), number of new queries is adapted to measured cost of a query. "
+	"Set to 0 to disable time limit"
+);
+idCVar g_lesMaxQueriesPerFrame(
+	"g_lesMaxQueriesPerFrame", "256", CVAR_GAME | CVAR_INTEGER,
+	"Never start more than this number of light queries per frame (0 = no limit)"
+);
+idCVar g_lesNearDistance(
+	"g_lesNearDistance", "256", CVAR_GAME | CVAR_FLOAT,
+	"Entity at this distance from player is evaluated with g_lesEvaluationPeriod, "
+	"evaluation period is proportional to distance"
+);
+idCVar g_lesPeriodScaleMin(
+	"g_lesPeriodScaleMin", "0.25", CVAR_GAME | CVAR_FLOAT,
+	"Minimum multiplier of g_lesEvaluationPeriod (for entities close to player or quickly changing)"
+);
+idCVar g_lesPeriodScaleMax(
+	"g_lesPeriodScaleMax", "4", CVAR_GAME | CVAR_FLOAT,
+	"Maximum multiplier of g_lesEvaluationPeriod (for distant entities)"
+);
+idCVar g_lesChangeRateFactor(
+	"g_lesChangeRateFactor", "4", CVAR_GAME | CVAR_FLOAT,
+	"Evaluation period is divided by (1 + K * R), where R is change of entity brightness per second"
+);
+idCVar g_lesStats(
+	"g_lesStats", "0", CVAR_GAME | CVAR_BOOL,
+	"Print number of started and deferred light queries and max staleness of tracked entities once per second"
+);
+
 idCVar g_lesSamplingMinPerSurface(
 	"g_lesSamplingMinPerSurface", "1", CVAR_GAME | CVAR_INTEGER,
 	"Minimum number of samples to have on any surface"
@@ -95,6 +126,13 @@ void LightEstimateSystem::Think() {
 	// special care is needed if model has changed
 	idList<TrackedEntity> entitiesWithModelChange;
 
+	const idPlayer *player = gameLocal.GetLocalPlayer();
+	idVec3 viewOrigin = player ? player->GetEyePosition() : vec3_origin;
+	// samples of all entities which need reevaluation
+	idList<DueSample> due;
+	// queries started earlier but not computed yet
+	int outstanding = 0;
+
 	for (int i = 0; i < trackedEntities.Num(); i++) {
 		TRACE_CPU_SCOPE("LES::EntityThink")
 		TrackedEntity &trackedEnt = trackedEntities[i];
@@ -124,14 +162,27 @@ void LightEstimateSystem::Think() {
 
 		// check if any pending light queries are ready
 		int received = ReceiveQueryResults(trackedEnt);
-		// start new light queries if needed
-		int started = StartNewQueries(trackedEnt);
-		TRACE_ATTACH_FORMAT("recv %d\nstart %d\n", received, started)
-
-		trackedEntities[newNum++] = trackedEntities[i];
+		if (received > 0)
+			UpdateChangeRate(trackedEnt);
+		outstanding += trackedEnt.pending.Num();
+		TRACE_ATTACH_FORMAT("recv %d\n", received)
+
+		trackedEntities[newNum] = trackedEntities[i];
+		// find samples which need new light queries
+		CollectDueSamples(newNum, viewOrigin, due);
+		newNum++;
 	}
 	trackedEntities.SetNum(newNum, false);
 
+	{
+		TRACE_CPU_SCOPE("LES::StartQueries")
+		// start new light queries for most outdated samples within budget
+		statsBudget = GetQueryBudget();
+		int started = StartNewQueries(due, idMath::Imax(statsBudget - outstanding, 0));
+		TRACE_ATTACH_FORMAT("due %d\nstart %d\nbudget %d\n", due.Num(), started, statsBudget)
+	}
+	UpdateStats();
+
 	for (int i = 0; i < entitiesWithModelChange.Num(); i++) {
 		const idEntity *ent = entitiesWithModelChange[i].entity.GetEntity();
 		TRACE_CPU_SCOPE_TEXT("LES::EntityReadd", ent->GetName())
@@ -177,6 +228,9 @@ void LightEstimateSystem::DebugVisualize() {
 			gameRenderWorld->DebugFilledBox(idVec4(smp.value, validity), tmpBox);
 			gameRenderWorld->DebugText(va("%0.3f", brightness), smp.position, textSize, colorYellow, eyeAxis);
 		}
+
+		int staleness = ComputeStaleness(trackedEnt);
+		gameRenderWorld->DebugText(va("%d ms", staleness), ent->GetPhysics()->GetAbsBounds().GetCenter(), sampleRadius * 0.003f, colorCyan, eyeAxis);
 	}
 }
 
@@ -231,6 +285,24 @@ float LightEstimateSystem::ComputeAverageLightBrightness(const TrackedEntity &tr
 	return avgBrightness;
 }
 
+int LightEstimateSystem::ComputeStaleness(const TrackedEntity &trackedEnt) const {
+	// note: samples never evaluated yet count as very old
+	int oldestTime = gameLocal.time;
+	for (int i = 0; i < trackedEnt.samples.Num(); i++) {
+		const EvaluatedSample &smp = trackedEnt.samples[i];
+		if (smp.excluded)
+			continue;
+		oldestTime = idMath::Imin(oldestTime, smp.evalTime);
+	}
+	return gameLocal.time - oldestTime;
+}
+
+int LightEstimateSystem::GetStaleness(const idEntity *entity) const {
+	if (const TrackedEntity *trackedEnt = FindEntity(entity))
+		return ComputeStaleness(*trackedEnt);
+	return -1;
+}
+
 float LightEstimateSystem::GetLightOnEntity(const idEntity *entity) {
 	const char *single = g_lesSingleEntity.GetString();
 	if (single[0] && idStr::Icmp(entity->GetName(), single))
@@ -290,38 +362,148 @@ int LightEstimateSystem::ReceiveQueryResults(TrackedEntity &trackedEnt) {
 	return received;
 }
 
-int LightEstimateSystem::StartNewQueries(TrackedEntity &trackedEnt) {
+void LightEstimateSystem::UpdateChangeRate(TrackedEntity &trackedEnt) {
 	int nowTime = gameLocal.time;
+	float brightness = ComputeAverageLightBrightness(trackedEnt);
+	if (trackedEnt.lastBrightnessTime >= 0 && nowTime > trackedEnt.lastBrightnessTime) {
+		float rate = idMath::Fabs(brightness - trackedEnt.lastBrightness) * 1000.0f / (nowTime - trackedEnt.lastBrightnessTime);
+		trackedEnt.changeRate = 0.7f * trackedEnt.changeRate + 0.3f * rate;
+	}
+	trackedEnt.lastBrightness = brightness;
+	trackedEnt.lastBrightnessTime = nowTime;
+}
+
+int LightEstimateSystem::GetEvaluationPeriod(const TrackedEntity &trackedEnt, const ModelCache &mcache, const idVec3 &viewOrigin) const {
+	// entities near player are evaluated more often, as well as entities with quickly changing lighting
 	const idEntity *entity = trackedEnt.entity.GetEntity();
+	float distance = (entity->GetPhysics()->GetOrigin() - viewOrigin).LengthFast();
+	float scale = distance / idMath::Fmax(g_lesNearDistance.GetFloat(), 1.0f);
+	scale /= 1.0f + trackedEnt.changeRate * idMath::Fmax(g_lesChangeRateFactor.GetFloat(), 0.0f);
+	scale = idMath::ClampFloat(g_lesPeriodScaleMin.GetFloat(), g_lesPeriodScaleMax.GetFloat(), scale);
+	return idMath::Imax(int(mcache.period * scale), 1);
+}
+
+void LightEstimateSystem::CollectDueSamples(int entityIndex, const idVec3 &viewOrigin, idList<DueSample> &due) const {
+	int nowTime = gameLocal.time;
+	const TrackedEntity &trackedEnt = trackedEntities[entityIndex];
 
 	if (trackedEnt.modelIndex < 0)
-		return 0;		// no model?
+		return;		// no model?
 	const ModelCache &mcache = modelsCache[trackedEnt.modelIndex];
-	assert(GetModelOfEntity(entity) == mcache.model);
+	assert(GetModelOfEntity(trackedEnt.entity.GetEntity()) == mcache.model);
+
+	int period = GetEvaluationPeriod(trackedEnt, mcache, viewOrigin);
 
-	int oldNumPending = trackedEnt.pending.Num();
 	for (int s = 0; s < mcache.samples.Num(); s++) {
 		// evaluation moments for each sample must have prescribed reminder module period
-		int maxK = (nowTime + mcache.period - mcache.schedule[s]) / mcache.period - 1;
-		int maxEvalTime = mcache.schedule[s] + maxK * mcache.period;
-		assert(maxEvalTime <= nowTime && maxEvalTime + mcache.period > nowTime);
+		// schedule is stretched to the period of this entity
+		int phase = int(int64(mcache.schedule[s]) * period / mcache.period);
+		int maxK = (nowTime + period - phase) / period - 1;
+		int maxEvalTime = phase + maxK * period;
+		assert(maxEvalTime <= nowTime && maxEvalTime + period > nowTime);
 		if (trackedEnt.samples[s].evalTime >= maxEvalTime)
 			continue;	// fresh enough
 
+		bool isPending = false;
+		for (int i = 0; i < trackedEnt.pending.Num(); i++)
+			if (trackedEnt.pending[i].sampleIndex == s)
+				isPending = true;
+		if (isPending)
+			continue;	// result not received yet
+
+		DueSample ds;
+		ds.entityIndex = entityIndex;
+		ds.sampleIndex = s;
+		ds.urgency = float(nowTime - trackedEnt.samples[s].evalTime) / period;
+		due.AddGrow(ds);
+	}
+}
+
+int LightEstimateSystem::GetQueryBudget() const {
+	int budget = g_lesMaxQueriesPerFrame.GetInteger();
+	if (budget <= 0)
+		budget = INT_MAX;
+
+	float frameBudget = g_lesFrameBudget.GetFloat();
+	float cost = gameRenderWorld->LightAtPointQuery_GetAverageCost();
+	if (frameBudget > 0.0f && cost > 0.0f) {
+		// always make some progress, even if queries are very slow
+		int timedBudget = int(frameBudget * 1000.0f / cost);
+		budget = idMath::Imin(budget, idMath::Imax(timedBudget, 4));
+	}
+
+	return budget;
+}
+
+int LightEstimateSystem::StartNewQueries(idList<DueSample> &due, int budget) {
+	int nowTime = gameLocal.time;
+
+	// most outdated samples (relative to their period) go first
+	std::sort(due.begin(), due.end(), [](const DueSample &a, const DueSample &b) {
+		return a.urgency > b.urgency;
+	});
+
+	int started = 0;
+	int ignoredEntityIndex = -1;
+	idList<qhandle_t> ignoredHandles;
+	for (int i = 0; i < due.Num(); i++) {
+		TrackedEntity &trackedEnt = trackedEntities[due[i].entityIndex];
+		const idEntity *entity = trackedEnt.entity.GetEntity();
+		const ModelCache &mcache = modelsCache[trackedEnt.modelIndex];
+		int s = due[i].sampleIndex;
+
 		PendingSample pend;
 		pend.sampleIndex = s;
 		pend.proto.evalTime = nowTime;
 		pend.proto.excluded = ShouldSampleBeExcluded(entity, mcache.samples[s]);
 		// don't waste time on excluded sample, don't send query
 		if (!pend.proto.excluded) {
-			idList<qhandle_t> ignoredHandles = GetIgnoredRenderEntityList(entity);
+			if (started >= budget) {
+				// sample will be more urgent on next frame
+				statsDeferred++;
+				continue;
+			}
+			if (ignoredEntityIndex != due[i].entityIndex) {
+				ignoredEntityIndex = due[i].entityIndex;
+				ignoredHandles = GetIgnoredRenderEntityList(entity);
+			}
 			pend.queryId = gameRenderWorld->LightAtPointQuery_AddQuery(entity->GetModelDefHandle(), mcache.samples[s], ignoredHandles);
+			started++;
 		}
 
 		trackedEnt.pending.AddGrow(pend);
 	}
 
-	return trackedEnt.pending.Num() - oldNumPending;
+	statsStarted += started;
+	return started;
+}
+
+void LightEstimateSystem::UpdateStats() {
+	int nowTime = gameLocal.time;
+	int elapsed = nowTime - statsTime;
+	if (statsTime >= 0 && elapsed >= 0 && elapsed < 1000)
+		return;
+
+	if (g_lesStats.GetBool() && statsTime >= 0 && elapsed > 0) {
+		int maxStaleness = 0;
+		const char *stalestName = "none";
+		for (int i = 0; i < trackedEntities.Num(); i++) {
+			int staleness = ComputeStaleness(trackedEntities[i]);
+			if (staleness > maxStaleness) {
+				maxStaleness = staleness;
+				stalestName = trackedEntities[i].entity.GetEntity()->GetName();
+			}
+		}
+		float perSecond = 1000.0f / elapsed;
+		gameLocal.Printf("LES: %d tracked, %.1f queries/s, %.1f deferred/s, budget %d per frame (%.2f us/query), max staleness %d ms (%s)\n",
+			trackedEntities.Num(), statsStarted * perSecond, statsDeferred * perSecond,
+			statsBudget, gameRenderWorld->LightAtPointQuery_GetAverageCost(), maxStaleness, stalestName
+		);
+	}
+
+	statsTime = nowTime;
+	statsStarted = 0;
+	statsDeferred = 0;
 }
 
 idList<qhandle_t> LightEstimateSystem::GetIgnoredRenderEntityList(const idEntity *entity) const {
@@ -421,7 +603,7 @@ LightEstimateSystem::ModelCache &LightEstimateSystem::FindOrAddModel(const idRen
 	model->GenerateSamples(mcache.samples, params, rnd);
 	int n = mcache.samples.Num();
 
-	mcache.period = g_lesEvaluationPeriod.GetInteger();
+	mcache.period = idMath::Imax(g_lesEvaluationPeriod.GetInteger(), 1);
 	mcache.schedule.SetNum(n);
 	for (int i = 0; i < n; i++)
 		mcache.schedule[i] = mcache.period * i / n;
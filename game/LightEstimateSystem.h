@@ -37,6 +37,10 @@ public:
 	// note: tracking takes CPU time for evaluating light samples
 	void TrackEntity(const idEntity *entity, int duration = -1);
 
+	// how old is the oldest light sample of the entity (in milliseconds)
+	// returns -1 if entity is not tracked
+	int GetStaleness(const idEntity *entity) const;
+
 	void DebugVisualize();
 	bool DebugIgnorePlayer(const idEntity *entity) const;
 	bool DebugGetLightOnEntity(const idEntity *entity, float &result) const;
@@ -62,6 +66,16 @@ private:
 		idList<EvaluatedSample> samples;	// light values for sample points (same-indexed as ModelCache::samples)
 		idList<PendingSample> pending;		// pending light queries for samples
 		int periodStartsAt = -1;			// when current period started (game time)
+		float lastBrightness = 0.0f;		// average brightness after last received results
+		int lastBrightnessTime = -1;		// when lastBrightness was computed (game time)
+		float changeRate = 0.0f;			// smoothed change of brightness per second
+	};
+
+	// sample which should be reevaluated, competes for per-frame budget
+	struct DueSample {
+		int entityIndex;
+		int sampleIndex;
+		float urgency;						// time since evaluation relative to evaluation period
 	};
 
 	struct ModelCache {
@@ -81,8 +95,14 @@ private:
 
 	void ForgetAllQueries(TrackedEntity &trackedEnt);
 	int ReceiveQueryResults(TrackedEntity &trackedEnt);
-	int StartNewQueries(TrackedEntity &trackedEnt);
+	void UpdateChangeRate(TrackedEntity &trackedEnt);
+	int GetEvaluationPeriod(const TrackedEntity &trackedEnt, const ModelCache &mcache, const idVec3 &viewOrigin) const;
+	void CollectDueSamples(int entityIndex, const idVec3 &viewOrigin, idList<DueSample> &due) const;
+	int GetQueryBudget() const;
+	int StartNewQueries(idList<DueSample> &due, int budget);
+	void UpdateStats();
 	float ComputeAverageLightBrightness(const TrackedEntity &trackedEnt) const;
+	int ComputeStaleness(const TrackedEntity &trackedEnt) const;
 
 	ModelCache &FindOrAddModel(const idRenderModel *model);
 	TrackedEntity &FindOrAddEntity(const idEntity *entity);
@@ -94,6 +114,12 @@ private:
 
 	int lastThinkTime = -1;
 	idList<TrackedEntity> trackedEntities;
+
+	// statistics printed with g_lesStats
+	int statsTime = -1;
+	int statsStarted = 0;
+	int statsDeferred = 0;
+	int statsBudget = 0;
 	idList<ModelCache> modelsCache;
 
 	// only valid immediately after game load
@@ -19,6 +19,7 @@ Project: The Dark Mod (http://www.thedarkmod.com/)
 
 
 #include "LightGem.h"
+#include "LightEstimateSystem.h"
 #include "../renderer/tr_local.h"
 
 //------------------------
@@ -129,6 +130,24 @@ void LightGem::Restore( idRestoreGame & a_savedGame )
 
 float LightGem::Calculate(idPlayer *player)
 {
+	if ( cv_lg_estimate.GetBool() ) {
+		// lightgem view is not rendered, use light samples on player model instead
+		float value = 0.0f;
+		if ( player->GetModelDefHandle() != -1 ) {
+			value = gameLocal.m_LightEstimateSystem->GetLightOnEntity( player );
+		}
+		// keep shots up-to-date for savegame
+		m_LightgemShotValue[m_LightgemShotSpot] = value;
+		m_LightgemShotSpot = (m_LightgemShotSpot + 1) % DARKMOD_LG_MAX_RENDERPASSES;
+
+		if (m_LightgemOverrideFrames > 0) {
+			// #6088: return old value for now
+			m_LightgemOverrideFrames--;
+			return m_LightgemOverrideValue;
+		}
+		return value;
+	}
+
 	// analyze rendered shot from previous frame
 	AnalyzeRenderImage();
 	m_LightgemShotValue[m_LightgemShotSpot] = 0.0f;
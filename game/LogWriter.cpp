@@ -0,0 +1,434 @@
+/*****************************************************************************
+The Dark Mod GPL Source Code
+
+This file is part of the The Dark Mod Source Code, originally based
+on the Doom 3 GPL Source Code as published in 2011.
+
+The Dark Mod Source Code is free software: you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version. For details, see LICENSE.TXT.
+
+Project: The Dark Mod (http://www.thedarkmod.com/)
+
+******************************************************************************/
+#include "precompiled.h"
+#pragma hdrstop
+
+#include "LogWriter.h"
+#include "Debug.h"
+
+// size of buffer where writer thread composes lines before writing them to file
+static const int LOG_BATCH_SIZE = 1 << 16;
+// writer thread wakes up at least this often, even if nobody asks for flush
+static const int LOG_WRITER_PERIOD_MS = 100;
+
+#ifdef _WIN32
+// Windows has no graceful exit on crash: unhandled exception filter writes pending lines
+static idLogWriter *crashLogWriter = nullptr;
+static LPTOP_LEVEL_EXCEPTION_FILTER prevExceptionFilter = nullptr;
+
+static LONG WINAPI LogWriterExceptionFilter( EXCEPTION_POINTERS *info ) {
+	if ( crashLogWriter ) {
+		crashLogWriter->FlushOnCrash();
+	}
+	return ( prevExceptionFilter ? prevExceptionFilter( info ) : EXCEPTION_CONTINUE_SEARCH );
+}
+#endif
+
+idLogWriter::idLogWriter() : enqueuePos( 0 ), writtenPos( 0 ) {}
+
+idLogWriter::~idLogWriter() {
+	Stop();
+}
+
+void idLogWriter::Start( FILE *newFile ) {
+	if ( IsRunning() ) {
+		SetFile( newFile );
+		return;
+	}
+
+	file = newFile;
+	ring = new Record[RING_SIZE];
+	for ( int i = 0; i < RING_SIZE; i++ ) {
+		ring[i].sequence.store( i, std::memory_order_relaxed );
+		ring[i].longText = nullptr;
+	}
+	enqueuePos.store( 0 );
+	writtenPos.store( 0 );
+	dequeuePos = 0;
+	stopRequested = false;
+	flushRequested = false;
+	batch.SetNum( LOG_BATCH_SIZE );
+
+	thread = std::thread( &idLogWriter::WriterThread, this );
+
+#ifdef _WIN32
+	if ( !crashLogWriter ) {
+		prevExceptionFilter = SetUnhandledExceptionFilter( LogWriterExceptionFilter );
+	}
+	crashLogWriter = this;
+#endif
+}
+
+void idLogWriter::Stop() {
+	if ( !IsRunning() ) {
+		return;
+	}
+
+#ifdef _WIN32
+	if ( crashLogWriter == this ) {
+		SetUnhandledExceptionFilter( prevExceptionFilter );
+		crashLogWriter = nullptr;
+		prevExceptionFilter = nullptr;
+	}
+#endif
+
+	{
+		std::lock_guard<std::mutex> lock( wakeMutex );
+		stopRequested = true;
+	}
+	wakeWriter.notify_one();
+	thread.join();
+	// catch lines appended while writer was stopping
+	WritePending();
+
+	delete[] ring;
+	ring = nullptr;
+	file = nullptr;
+	batch.ClearFree();
+}
+
+void idLogWriter::Flush() {
+	if ( !IsRunning() ) {
+		return;
+	}
+	unsigned target = enqueuePos.load( std::memory_order_acquire );
+	auto Done = [this, target]() -> bool {
+		return int( writtenPos.load( std::memory_order_acquire ) - target ) >= 0;
+	};
+	if ( Done() ) {
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock( wakeMutex );
+	flushRequested = true;
+	wakeWriter.notify_one();
+	wakeFlushed.wait( lock, Done );
+}
+
+void idLogWriter::FlushOnCrash() {
+	if ( !IsRunning() ) {
+		return;
+	}
+	// writer thread may be in the middle of a batch, or it may be the one which crashed
+	for ( int attempt = 0; attempt < 50; attempt++ ) {
+		if ( fileMutex.try_lock() ) {
+			WritePendingLocked();
+			fileMutex.unlock();
+			return;
+		}
+		std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+	}
+}
+
+void idLogWriter::SetFile( FILE *newFile ) {
+	Flush();
+	std::lock_guard<std::mutex> lock( fileMutex );
+	file = newFile;
+}
+
+int idLogWriter::FormatPrefix( char *dest, int size, const char *filename, int line, const char *typeName, const char *className, int gameTime ) {
+	// shared static buffers of CleanupSourceCodeFileName are not safe to use from writer thread
+	char cleanFilename[MAX_STRING_CHARS];
+	CleanupSourceCodeFileName( filename, cleanFilename );
+	idStr::snPrintf( dest, size, "[%s (%4u):%s (%s) GT: %4u] ", cleanFilename, line, typeName, className, gameTime );
+	return idStr::Length( dest );
+}
+
+void idLogWriter::WriteDirect( FILE *file, const char *filename, int line, const char *typeName, const char *className, int gameTime, const char *fmt, va_list args ) {
+	char prefix[MAX_STRING_CHARS + 256];
+	FormatPrefix( prefix, sizeof( prefix ), filename, line, typeName, className, gameTime );
+	fputs( prefix, file );
+	vfprintf( file, fmt, args );
+	fputs( "\n", file );
+	fflush( file );
+}
+
+void idLogWriter::Append( const char *filename, int line, const char *typeName, const char *className, int gameTime, const char *fmt, va_list args ) {
+	// reserve a slot (bounded MPMC queue with per-slot sequence numbers)
+	unsigned pos = enqueuePos.load( std::memory_order_relaxed );
+	Record *rec;
+	while ( true ) {
+		rec = &ring[pos & ( RING_SIZE - 1 )];
+		int diff = int( rec->sequence.load( std::memory_order_acquire ) - pos );
+		if ( diff == 0 ) {
+			if ( enqueuePos.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) ) {
+				break;
+			}
+		} else if ( diff < 0 ) {
+			// ring is full: wait until writer frees some slots
+			wakeWriter.notify_one();
+			std::this_thread::yield();
+			pos = enqueuePos.load( std::memory_order_relaxed );
+		} else {
+			// another thread took this slot
+			pos = enqueuePos.load( std::memory_order_relaxed );
+		}
+	}
+
+	rec->filename = filename;
+	rec->line = line;
+	rec->typeName = typeName;
+	rec->className = className;
+	rec->gameTime = gameTime;
+	va_list copy;
+	va_copy( copy, args );
+	int len = idStr::vsnPrintf( rec->text, RECORD_TEXT, fmt, copy );
+	va_end( copy );
+	for ( int size = 4 * RECORD_TEXT; len < 0; size *= 2 ) {
+		// rare long message: format into heap, writer thread frees it
+		Mem_Free( rec->longText );
+		rec->longText = (char*)Mem_Alloc( size );
+		va_copy( copy, args );
+		len = idStr::vsnPrintf( rec->longText, size, fmt, copy );
+		va_end( copy );
+	}
+	rec->sequence.store( pos + 1, std::memory_order_release );
+
+	if ( pos - writtenPos.load( std::memory_order_relaxed ) == RING_SIZE / 2 ) {
+		// don't wait for timer when ring is filling up fast
+		wakeWriter.notify_one();
+	}
+}
+
+void idLogWriter::WriterThread() {
+	std::unique_lock<std::mutex> lock( wakeMutex );
+	while ( !stopRequested ) {
+		wakeWriter.wait_for( lock, std::chrono::milliseconds( LOG_WRITER_PERIOD_MS ), [this]() -> bool {
+			return stopRequested || flushRequested || enqueuePos.load( std::memory_order_relaxed ) - writtenPos.load( std::memory_order_relaxed ) >= RING_SIZE / 2;
+		} );
+		flushRequested = false;
+		lock.unlock();
+		WritePending();
+		lock.lock();
+	}
+}
+
+void idLogWriter::WritePending() {
+	{
+		std::lock_guard<std::mutex> lock( fileMutex );
+		WritePendingLocked();
+	}
+
+	// taking the mutex ensures flushing thread is either waiting already or will see new writtenPos
+	{
+		std::lock_guard<std::mutex> wakeLock( wakeMutex );
+	}
+	wakeFlushed.notify_all();
+}
+
+void idLogWriter::WritePendingLocked() {
+	int used = 0;
+	auto WriteBatch = [&]() {
+		if ( used > 0 && file ) {
+			fwrite( batch.Ptr(), 1, used, file );
+		}
+		used = 0;
+	};
+	auto Put = [&]( const char *data, int len ) {
+		if ( used + len > LOG_BATCH_SIZE ) {
+			WriteBatch();
+		}
+		if ( len > LOG_BATCH_SIZE ) {
+			if ( file ) {
+				fwrite( data, 1, len, file );
+			}
+			return;
+		}
+		memcpy( batch.Ptr() + used, data, len );
+		used += len;
+	};
+
+	unsigned pos = dequeuePos;
+	while ( true ) {
+		Record &rec = ring[pos & ( RING_SIZE - 1 )];
+		if ( rec.sequence.load( std::memory_order_acquire ) != pos + 1 ) {
+			// not appended yet, or appending thread has not finished formatting
+			break;
+		}
+
+		char prefix[MAX_STRING_CHARS + 256];
+		int len = FormatPrefix( prefix, sizeof( prefix ), rec.filename, rec.line, rec.typeName, rec.className, rec.gameTime );
+		Put( prefix, len );
+		const char *text = ( rec.longText ? rec.longText : rec.text );
+		Put( text, idStr::Length( text ) );
+		Put( "\n", 1 );
+
+		Mem_Free( rec.longText );
+		rec.longText = nullptr;
+		rec.sequence.store( pos + RING_SIZE, std::memory_order_release );
+		pos++;
+	}
+	WriteBatch();
+
+	if ( pos != dequeuePos ) {
+		dequeuePos = pos;
+		if ( file ) {
+			fflush( file );
+		}
+	}
+	writtenPos.store( pos, std::memory_order_release );
+}
+
+static void LogBenchmarkLine( idLogWriter *writer, FILE *file, const char *fmt, ... ) {
+	va_list args;
+	va_start( args, fmt );
+	if ( writer ) {
+		writer->Append( __FILE__, __LINE__, "DEB", "AI", gameLocal.time, fmt, args );
+	} else {
+		idLogWriter::WriteDirect( file, __FILE__, __LINE__, "DEB", "AI", gameLocal.time, fmt, args );
+	}
+	va_end( args );
+}
+
+void Cmd_LogBenchmark_f( const idCmdArgs &args ) {
+	int numLines = 1000000;
+	if ( args.Argc() > 1 ) {
+		numLines = Max( atoi( args.Argv( 1 ) ), 1 );
+	}
+
+	idStr syncPath = fileSystem->RelativePathToOSPath( "logBenchmark_sync.log", "fs_savepath" );
+	idStr asyncPath = fileSystem->RelativePathToOSPath( "logBenchmark_async.log", "fs_savepath" );
+	FILE *syncFile = fopen( syncPath.c_str(), "w+b" );
+	FILE *asyncFile = fopen( asyncPath.c_str(), "w+b" );
+	if ( !syncFile || !asyncFile ) {
+		common->Warning( "Failed to open %s for writing", !syncFile ? syncPath.c_str() : asyncPath.c_str() );
+		if ( syncFile ) {
+			fclose( syncFile );
+		}
+		if ( asyncFile ) {
+			fclose( asyncFile );
+		}
+		return;
+	}
+
+	double msPerTick = 1000.0 / Sys_ClockTicksPerSecond();
+	idVec3 origin( 1024.5f, -37.25f, 96.0f );
+
+	// old way: format, write and flush every line on calling thread
+	double start = Sys_GetClockTicks();
+	for ( int i = 0; i < numLines; i++ ) {
+		LogBenchmarkLine( nullptr, syncFile, "Benchmark line %d: entity %s at (%.2f %.2f %.2f)\r", i, "atdm:ai_builder_guard_1", origin.x, origin.y, origin.z );
+	}
+	double syncMs = ( Sys_GetClockTicks() - start ) * msPerTick;
+
+	idLogWriter *writer = new idLogWriter();
+	writer->Start( asyncFile );
+	start = Sys_GetClockTicks();
+	for ( int i = 0; i < numLines; i++ ) {
+		LogBenchmarkLine( writer, nullptr, "Benchmark line %d: entity %s at (%.2f %.2f %.2f)\r", i, "atdm:ai_builder_guard_1", origin.x, origin.y, origin.z );
+	}
+	double asyncCallerMs = ( Sys_GetClockTicks() - start ) * msPerTick;
+	writer->Flush();
+	double asyncTotalMs = ( Sys_GetClockTicks() - start ) * msPerTick;
+	writer->Stop();
+	delete writer;
+
+	long syncSize = ftell( syncFile );
+	long asyncSize = ftell( asyncFile );
+	fclose( syncFile );
+	fclose( asyncFile );
+	remove( syncPath.c_str() );
+	remove( asyncPath.c_str() );
+
+	common->Printf( "Logged %d lines:\n", numLines );
+	common->Printf( "  fprintf + fflush:  %10.2lf ms  (%.3lf us per line)\n", syncMs, 1000.0 * syncMs / numLines );
+	common->Printf( "  ring (caller):     %10.2lf ms  (%.3lf us per line)\n", asyncCallerMs, 1000.0 * asyncCallerMs / numLines );
+	common->Printf( "  ring (until disk): %10.2lf ms  (%.3lf us per line)\n", asyncTotalMs, 1000.0 * asyncTotalMs / numLines );
+	if ( syncSize != asyncSize ) {
+		common->Warning( "Log sizes differ: %ld vs %ld bytes", syncSize, asyncSize );
+	}
+}
+
+
+#include "../tests/testing.h"
+
+TEST_CASE("LogWriter:ManyProducers") {
+	static const int NUM_PRODUCERS = 4;
+	// producers only format messages while writer also composes prefixes and writes file,
+	// so together they outpace it and the ring gets full many times
+	static const int NUM_LINES = 20000;
+	static const int LONG_LINE_PERIOD = 997;
+
+	idStr path = fileSystem->RelativePathToOSPath( "logWriterTest.log", "fs_savepath" );
+	FILE *file = fopen( path.c_str(), "w+b" );
+	REQUIRE( file );
+
+	// some lines do not fit into ring record
+	idStr padding;
+	padding.Fill( 'x', 1000 );
+
+	idLogWriter *writer = new idLogWriter();
+	writer->Start( file );
+	std::thread producers[NUM_PRODUCERS];
+	for ( int p = 0; p < NUM_PRODUCERS; p++ ) {
+		producers[p] = std::thread( [writer, p, &padding]() {
+			for ( int i = 0; i < NUM_LINES; i++ ) {
+				const char *extra = ( i % LONG_LINE_PERIOD == 0 ? padding.c_str() : "" );
+				LogBenchmarkLine( writer, nullptr, "producer %d line %d %s", p, i, extra );
+			}
+		} );
+	}
+	for ( int p = 0; p < NUM_PRODUCERS; p++ ) {
+		producers[p].join();
+	}
+	// Flush must write everything, Stop must not lose or repeat anything after it
+	writer->Flush();
+	long flushedSize = ftell( file );
+	writer->Stop();
+	delete writer;
+	CHECK( ftell( file ) == flushedSize );
+
+	idList<char> text;
+	text.SetNum( flushedSize + 1 );
+	fseek( file, 0, SEEK_SET );
+	int readSize = (int)fread( text.Ptr(), 1, flushedSize, file );
+	fclose( file );
+	remove( path.c_str() );
+	REQUIRE( readSize == flushedSize );
+	text[readSize] = 0;
+
+	// lines of every producer must come in order, without gaps
+	int nextLine[NUM_PRODUCERS] = { 0 };
+	int numLines = 0, numBroken = 0, numReordered = 0, numLong = 0;
+	for ( char *line = text.Ptr(); *line; ) {
+		char *eol = strchr( line, '\n' );
+		REQUIRE( eol );
+		*eol = 0;
+		numLines++;
+
+		const char *msg = strstr( line, "] producer " );
+		int p = -1, i = -1;
+		if ( !msg || sscanf( msg, "] producer %d line %d", &p, &i ) != 2 || p < 0 || p >= NUM_PRODUCERS ) {
+			numBroken++;
+		} else {
+			if ( i != nextLine[p] ) {
+				numReordered++;
+			}
+			nextLine[p] = i + 1;
+			if ( i % LONG_LINE_PERIOD == 0 && strstr( msg, padding.c_str() ) ) {
+				numLong++;
+			}
+		}
+		line = eol + 1;
+	}
+
+	CHECK( numLines == NUM_PRODUCERS * NUM_LINES );
+	CHECK( numBroken == 0 );
+	CHECK( numReordered == 0 );
+	CHECK( numLong == NUM_PRODUCERS * ( ( NUM_LINES - 1 ) / LONG_LINE_PERIOD + 1 ) );
+	for ( int p = 0; p < NUM_PRODUCERS; p++ ) {
+		CHECK( nextLine[p] == NUM_LINES );
+	}
+}
@@ -0,0 +1,93 @@
+/*****************************************************************************
+The Dark Mod GPL Source Code
+
+This file is part of the The Dark Mod Source Code, originally based
+on the Doom 3 GPL Source Code as published in 2011.
+
+The Dark Mod Source Code is free software: you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version. For details, see LICENSE.TXT.
+
+Project: The Dark Mod (http://www.thedarkmod.com/)
+
+******************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+class idCmdArgs;
+
+// background writer of DarkMod.log.
+// Logging thread only formats message text into a slot of lock-free ring buffer,
+// together with source location, log type/class and game time.
+// Writer thread composes full lines and writes them to file in batches, flushing after every batch.
+// When ring buffer is full, logging thread waits for writer, so no lines are ever dropped.
+class idLogWriter {
+public:
+	idLogWriter();
+	~idLogWriter();
+
+	// starts writer thread, file is owned by caller
+	void			Start( FILE *file );
+	// writes all pending lines and stops writer thread
+	void			Stop();
+	bool			IsRunning() const { return ring != nullptr; }
+
+	// blocks until all lines appended so far are written and flushed
+	// must be called before file is closed, and on error/crash paths
+	void			Flush();
+	// flushes pending lines to old file, then continues with new one
+	void			SetFile( FILE *file );
+	// writes pending lines from crashing thread, does not wait for writer thread
+	void			FlushOnCrash();
+
+	// can be called from any thread
+	// filename, typeName and className must be static strings (e.g. __FILE__)
+	void			Append( const char *filename, int line, const char *typeName, const char *className, int gameTime, const char *fmt, va_list args );
+
+	// synchronous version: writes the same line directly into file
+	static void		WriteDirect( FILE *file, const char *filename, int line, const char *typeName, const char *className, int gameTime, const char *fmt, va_list args );
+
+private:
+	static const int RING_SIZE = 4096;			// must be power of two
+	static const int RECORD_TEXT = 448;
+
+	struct Record {
+		std::atomic<unsigned> sequence;			// == position + 1 when record is filled
+		const char	*filename;
+		const char	*typeName;
+		const char	*className;
+		int			line;
+		int			gameTime;
+		char		*longText;					// allocated if message does not fit into text
+		char		text[RECORD_TEXT];
+	};
+
+	void			WriterThread();
+	void			WritePending();
+	void			WritePendingLocked();
+	static int		FormatPrefix( char *dest, int size, const char *filename, int line, const char *typeName, const char *className, int gameTime );
+
+	Record *		ring = nullptr;
+	std::atomic<unsigned> enqueuePos;			// next position reserved by logging threads
+	unsigned		dequeuePos = 0;				// next position to be written (writer thread only)
+	std::atomic<unsigned> writtenPos;			// all lines before it are flushed to file
+
+	FILE *			file = nullptr;
+	std::mutex		fileMutex;					// protects file and dequeuePos
+
+	std::thread		thread;
+	std::mutex		wakeMutex;
+	std::condition_variable wakeWriter;
+	std::condition_variable wakeFlushed;
+	bool			stopRequested = false;
+	bool			flushRequested = false;
+
+	idList<char>	batch;						// lines composed by writer thread
+};
+
+void Cmd_LogBenchmark_f( const idCmdArgs &args );
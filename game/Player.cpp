@@ -32,6 +32,7 @@ Project: The Dark Mod (http://www.thedarkmod.com/)
 #include "Inventory/Inventory.h"
 #include "Inventory/WeaponItem.h"
 #include "Shop/Shop.h"
+#include "LightEstimateSystem.h"
 #include <numeric>
 
 #include "../sys/sys_padinput.h"
@@ -10337,6 +10338,8 @@ void idPlayer::DropInventoryItem()
 			{
 				DM_LOG(LC_INVENTORY, LT_INFO)LOGSTRING("Item was successfully put in hands: %s\r", ent->name.c_str());
 				bDropped = true;
+				// dropped item can be noticed by AI, start tracking its light value in advance
+				gameLocal.m_LightEstimateSystem->TrackEntity( ent );
 			}
 			else
 			{
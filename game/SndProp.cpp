@@ -88,6 +88,11 @@ const float s_MAX_DETAILNODES = 6; // grayman #3660 - was 3, so double it
 **/
 const float s_invLog10 = 0.434294482f;
 
+/**
+* Max number of expanded waves kept in cache
+**/
+const int s_WAVE_CACHE_SIZE = 16;
+
 /**************************************************
 * BEGIN CsndProp Implementation
 ***************************************************/
@@ -107,6 +112,16 @@ CsndProp::CsndProp ( void )
 
 	m_TimeStampProp = 0;
 	m_TimeStampPortLoss = 0;
+
+	m_PortLossVersion = 0;
+	m_WaveUseCounter = 0;
+	m_AreaAIFrame = -1;
+	m_AreaAIMaxEyeOffset = 0.0f;
+
+	m_StatsTime = 0;
+	m_StatsSounds = 0;
+	m_StatsExpansions = 0;
+	m_StatsCacheHits = 0;
 }
 
 void CsndProp::Clear( void )
@@ -146,10 +161,24 @@ void CsndProp::Clear( void )
 		m_PopAreas = NULL;
 	}
 
+	ClearWaveCache();
+	m_AreaAIFirst.Clear();
+	m_AreaAIList.Clear();
+	m_AreaAIFrame = -1;
+	m_RangeAreas.Clear();
+
 	// delete m_sndAreas and m_PortData
 	DestroyAreasData();
 }
 
+void CsndProp::ClearWaveCache( void )
+{
+	// cached events point into m_EventAreas
+	m_WaveCache.Clear();
+	m_WaveEvents.Clear();
+	m_WaveEntered.Clear();
+}
+
 CsndProp::~CsndProp ( void )
 {
 	Clear();
@@ -265,8 +294,13 @@ void CsndProp::Restore(idRestoreGame *savefile)
 			m_EventAreas[i].PortalDat[portal].ThisPort = &m_sndAreas[i].portals[portal];
 
 			// greebo: TODO: How to restore PrevPort?
+			m_EventAreas[i].PortalDat[portal].WaveIndex = -1;
 		}
 	}
+
+	// m_EventAreas was reallocated
+	ClearWaveCache();
+	m_AreaAIFrame = -1;
 }
 
 void CsndProp::SetupFromLoader( const CsndPropLoader *in )
@@ -388,6 +422,7 @@ void CsndProp::SetupFromLoader( const CsndPropLoader *in )
 		{
 			SPortEvent *pEvPtr = &pEvArea->PortalDat[l];
 			pEvPtr->ThisPort = &m_sndAreas[j].portals[l];
+			pEvPtr->WaveIndex = -1;
 		}
 	}
 
@@ -416,6 +451,7 @@ void CsndProp::Propagate
 	idBounds	envBounds(origin);
 	idAI				*testAI;
 	idList<idEntity *>	validTypeEnts, validEnts;
+	idList<int>			validTypeAreas, validAreas;
 	SPopArea			*pPopArea;
 
 	idTimer timer_Prop;
@@ -427,6 +463,9 @@ void CsndProp::Propagate
 
 	m_TimeStampProp = gameLocal.time;
 
+	UpdateStats();
+	m_StatsSounds++;
+
 	// clear the old populated areas list
 	m_PopAreasInd.Clear();
 	
@@ -513,11 +552,34 @@ void CsndProp::Propagate
 	bounds.ExpandSelf(range);
 
 	// get a list of all ents with type idAI's or Listeners
-	
-	for ( idAI* ai = gameLocal.spawnedAI.Next() ; ai != NULL ; ai = ai->aiNode.Next() )
+	// only look at AI in areas touched by the range bounds
+	// AI area is determined by its origin, while range is checked against its eyes
+
+	UpdateAreaAI();
+	if ( m_AreaAIList.Num() > 0 )
 	{
-		// TODO: Put in Listeners later
-		validTypeEnts.Append(ai);
+		idBounds aiBounds = bounds.Expand( m_AreaAIMaxEyeOffset );
+		int numRangeAreas = gameRenderWorld->FindAreasInBounds( aiBounds, m_RangeAreas.Ptr(), m_RangeAreas.Num() );
+		numRangeAreas = Min( numRangeAreas, m_RangeAreas.Num() );
+
+		for ( int k = 0 ; k < numRangeAreas ; k++ )
+		{
+			int area = m_RangeAreas[k];
+			if ( area < 0 || area >= m_numAreas )
+			{
+				continue;
+			}
+			for ( int j = m_AreaAIFirst[area] ; j < m_AreaAIFirst[area + 1] ; j++ )
+			{
+				// TODO: Put in Listeners later
+				idAI *ai = m_AreaAIList[j].GetEntity();
+				if ( ai != NULL )
+				{
+					validTypeEnts.Append(ai);
+					validTypeAreas.Append(area);
+				}
+			}
+		}
 	}
 	
 	if ( cv_spr_debug.GetBool() )
@@ -624,6 +686,7 @@ void CsndProp::Propagate
 				gameLocal.Printf("Found a valid propagation target: %s\n", testAI->name.c_str());
 			}
 			validEnts.Append( validTypeEnts[i] );
+			validAreas.Append( validTypeAreas[i] );
 
 			// grayman #3660 - track lowest minimum audio threshold for the AI in this set
 
@@ -687,7 +750,7 @@ void CsndProp::Propagate
 	DM_LOG(LC_SOUND, LT_DEBUG)LOGSTRING("Filling populated areas array with AI\r" );
 	for ( int j = 0 ; j < validEnts.Num() ; j++ )
 	{
-		int AIAreaNum = gameRenderWorld->GetAreaAtPoint( validEnts[j]->GetPhysics()->GetOrigin() );
+		int AIAreaNum = validAreas[j];
 		
 		// Sometimes GetAreaAtPoint returns -1, don't know why
 		if ( AIAreaNum < 0 )
@@ -885,41 +948,41 @@ bool CsndProp::ExpandWave(float volInit, idVec3 origin, float minAudThresh) // g
 	m_PopAreas[ initArea ].bVisited = true;
 	DM_LOG(LC_SOUND, LT_DEBUG)LOGSTRING("Processing initial area, area %d is marked 'visited'\r",initArea);
 
+	// losses don't depend on volume, so a wave expanded from nearby point can be reused
+	float maxLoss = volInit - minAudThresh;
+	if ( cv_spr_cache.GetBool() && ExpandCachedWave( initArea, origin, maxLoss ) )
+	{
+		DM_LOG(LC_SOUND, LT_DEBUG)LOGSTRING("Reused cached wavefront expansion\r" );
+		m_StatsCacheHits++;
+		return true;
+	}
+	m_StatsExpansions++;
+
+	// remember all portal events we write, so that they can be cached
+	m_WaveEvents.Clear();
+	m_WaveEntered.Clear();
+	auto NoteWrite = [this]( SPortEvent *ev, int evArea, int evPort ) -> int
+	{
+		if ( ev->WaveIndex < 0 || ev->WaveIndex >= m_WaveEvents.Num() || m_WaveEvents[ev->WaveIndex].pEvent != ev )
+		{
+			SCachedPortEvent written;
+			written.pEvent = ev;
+			written.area = evArea;
+			written.localPort = evPort;
+			ev->WaveIndex = m_WaveEvents.Append( written );
+		}
+		return ev->WaveIndex;
+	};
+
 	// array index pointers to save on calculation
 	SsndArea *pSndAreas = &m_sndAreas[ initArea ];
 	SEventArea *pEventAreas = &m_EventAreas[ initArea ];
 
 	// calculate initial portal losses from the sound origin point
+	m_WaveInitDist.SetNum( pSndAreas->numPortals );
 	for ( int i2 = 0 ; i2 < pSndAreas->numPortals ; i2++ )
 	{
-		// grayman #3660 - using the portal center can throw the loss
-		// results way off when a mission uses large portals. Instead of
-		// using the center, use an orthogonal projection of the origin onto the plane
-		// of the portal, then pull the projection onto the portal if it's not already there.
-		const idWinding *wind = pSndAreas->portals[i2].winding;
-		idPlane WPlane;
-		wind->GetPlane(WPlane);
-		float scale;
-		WPlane.RayIntersection( origin, WPlane.Normal(), scale );
-		idVec3 portalCoord = origin + scale*WPlane.Normal();
-		if ( !wind->PointInside( WPlane.Normal(), portalCoord, 0.1f ))
-		{
-			// Not inside winding, so pull the point to the portal.
-			if (scale < 0.0f)
-			{
-				portalCoord -= 0.1f*WPlane.Normal();
-			}
-			else
-			{
-				portalCoord += 0.1f*WPlane.Normal();
-			}
-			portalCoord = SurfPoint( origin, portalCoord, &(pSndAreas->portals[i2]));
-		}
-
-		// old way
-		//idVec3 portalCoord = pSndAreas->portals[i2].center;
-
-		tempDist = (origin - portalCoord).LengthFast() * s_DOOM_TO_METERS;
+		tempDist = InitialPortalDist( pSndAreas, i2, origin );
 
 		// calculate and set initial portal losses
 		tempAtt = m_AreaPropsG[ initArea ].LossMult * tempDist;
@@ -936,6 +999,9 @@ bool CsndProp::ExpandWave(float volInit, idVec3 origin, float minAudThresh) // g
 		pPortEv->Att = tempAtt;
 		pPortEv->Floods = 1;
 		pPortEv->PrevPort = NULL;
+		pPortEv->Root = i2;
+		NoteWrite( pPortEv, initArea, i2 );
+		m_WaveInitDist[i2] = tempDist;
 
 		DM_LOG(LC_SOUND, LT_DEBUG)LOGSTRING("Loss tempLoss at portal %d is %f [dB]\r", i2, tempLoss);
 		DM_LOG(LC_SOUND, LT_DEBUG)LOGSTRING("Dist tempDist at portal %d is %f [m], %f [D3]\r", i2, tempDist, tempDist/s_DOOM_TO_METERS);
@@ -952,6 +1018,7 @@ bool CsndProp::ExpandWave(float volInit, idVec3 origin, float minAudThresh) // g
 			tempQEntry.curLoss = tempLoss;
 			tempQEntry.portalH = pSndAreas->portals[i2].handle;
 			tempQEntry.PrevPort = NULL;
+			tempQEntry.root = i2;
 
 			NextAreas.Append( tempQEntry );
 			DM_LOG(LC_SOUND, LT_DEBUG)LOGSTRING("Wavefront intensity still above threshold at portal %d\r", i2);
@@ -1010,6 +1077,8 @@ bool CsndProp::ExpandWave(float volInit, idVec3 origin, float minAudThresh) // g
 			pPortEv->Loss = NextAreas[j].curLoss;
 			pPortEv->Floods = floods - 1;
 			pPortEv->PrevPort = NextAreas[j].PrevPort;
+			pPortEv->Root = NextAreas[j].root;
+			m_WaveEntered.Append( NoteWrite( pPortEv, area, LocalPort ) );
 
 			// Updated the Populated Areas to show that it's been visited
 			// Only do this for populated areas that matter (ie, they've been updated
@@ -1078,6 +1147,8 @@ bool CsndProp::ExpandWave(float volInit, idVec3 origin, float minAudThresh) // g
 				pPortEv->Att = tempAtt;
 				pPortEv->Floods = floods;
 				pPortEv->PrevPort = &pEventAreas->PortalDat[ LocalPort ];
+				pPortEv->Root = NextAreas[j].root;
+				NoteWrite( pPortEv, area, i );
 
 				// add the portal destination to flooding queue
 				tempQEntry.area = pSndAreas->portals[i].to;
@@ -1086,6 +1157,7 @@ bool CsndProp::ExpandWave(float volInit, idVec3 origin, float minAudThresh) // g
 				tempQEntry.curLoss = tempLoss;
 				tempQEntry.portalH = pSndAreas->portals[i].handle;
 				tempQEntry.PrevPort = pPortEv->PrevPort;
+				tempQEntry.root = NextAreas[j].root;
 
 				AddedAreas.Append( tempQEntry );
 			
@@ -1102,9 +1174,228 @@ bool CsndProp::ExpandWave(float volInit, idVec3 origin, float minAudThresh) // g
 	// return true if the expansion died out naturally rather than being stopped
 	returnval = ( !NextAreas.Num() );
 
+	// which portals a wave stopped by the node limit reaches depends on threshold
+	if ( returnval && cv_spr_cache.GetBool() )
+	{
+		StoreCachedWave( initArea, origin, maxLoss );
+	}
+
 	return returnval;
 } // end function
 
+float CsndProp::InitialPortalDist( SsndArea *pSndArea, int portal, const idVec3 &origin )
+{
+	// grayman #3660 - using the portal center can throw the loss
+	// results way off when a mission uses large portals. Instead of
+	// using the center, use an orthogonal projection of the origin onto the plane
+	// of the portal, then pull the projection onto the portal if it's not already there.
+	const idWinding *wind = pSndArea->portals[portal].winding;
+	idPlane WPlane;
+	wind->GetPlane(WPlane);
+	float scale;
+	WPlane.RayIntersection( origin, WPlane.Normal(), scale );
+	idVec3 portalCoord = origin + scale*WPlane.Normal();
+	if ( !wind->PointInside( WPlane.Normal(), portalCoord, 0.1f ))
+	{
+		// Not inside winding, so pull the point to the portal.
+		if (scale < 0.0f)
+		{
+			portalCoord -= 0.1f*WPlane.Normal();
+		}
+		else
+		{
+			portalCoord += 0.1f*WPlane.Normal();
+		}
+		portalCoord = SurfPoint( origin, portalCoord, &(pSndArea->portals[portal]));
+	}
+
+	// old way
+	//idVec3 portalCoord = pSndArea->portals[portal].center;
+
+	return (origin - portalCoord).LengthFast() * s_DOOM_TO_METERS;
+}
+
+bool CsndProp::ExpandCachedWave( int initArea, const idVec3 &origin, float maxLoss )
+{
+	// find the closest cached wave from the same area, expanded far enough
+	float radius = cv_spr_cache_radius.GetFloat();
+	SCachedWave *wave = NULL;
+	float bestDistSqr = radius * radius;
+	for ( int i = 0 ; i < m_WaveCache.Num() ; i++ )
+	{
+		SCachedWave &w = m_WaveCache[i];
+		if ( w.area != initArea || w.lossVersion != m_PortLossVersion || w.maxLoss < maxLoss )
+		{
+			continue;
+		}
+		float distSqr = ( w.origin - origin ).LengthSqr();
+		if ( distSqr <= bestDistSqr )
+		{
+			bestDistSqr = distSqr;
+			wave = &w;
+		}
+	}
+	if ( wave == NULL )
+	{
+		return false;
+	}
+	wave->lastUsed = ++m_WaveUseCounter;
+
+	// every path starts with one of the initial portals:
+	// when sound origin moves a bit, only distance to it changes
+	// note: paths are not re-minimized, that's why cache radius must be small
+	SsndArea *pSndAreas = &m_sndAreas[ initArea ];
+	float lossMult = m_AreaPropsG[ initArea ].LossMult;
+	idList<float> distShift;
+	distShift.SetNum( pSndAreas->numPortals );
+	for ( int i = 0 ; i < pSndAreas->numPortals ; i++ )
+	{
+		distShift[i] = ( bestDistSqr == 0.0f ? 0.0f : InitialPortalDist( pSndAreas, i, origin ) - wave->initDist[i] );
+	}
+
+	for ( int i = 0 ; i < wave->events.Num() ; i++ )
+	{
+		const SCachedPortEvent &cached = wave->events[i];
+		SPortEvent *pPortEv = cached.pEvent;
+		*pPortEv = cached.value;
+
+		float shift = distShift[ pPortEv->Root ];
+		if ( shift != 0.0f )
+		{
+			pPortEv->Dist += shift;
+			pPortEv->Att += shift * lossMult;
+			pPortEv->Loss = m_SndGlobals.Falloff_Ind * s_invLog10*idMath::Log16(pPortEv->Dist) + pPortEv->Att + 8;
+		}
+		m_EventAreas[ cached.area ].bVisited = true;
+	}
+
+	// mark populated areas which the wave floods into with current threshold
+	for ( int i = 0 ; i < wave->entered.Num() ; i++ )
+	{
+		const SCachedPortEvent &cached = wave->events[ wave->entered[i] ];
+		if ( cached.pEvent->Loss > maxLoss )
+		{
+			continue;
+		}
+		SPopArea *pPopArea = &m_PopAreas[ cached.area ];
+		if ( pPopArea->addedTime == m_TimeStampProp )
+		{
+			pPopArea->bVisited = true;
+			pPopArea->VisitedPorts.AddUnique( cached.localPort );
+		}
+	}
+
+	return true;
+}
+
+void CsndProp::StoreCachedWave( int initArea, const idVec3 &origin, float maxLoss )
+{
+	// replace a wave made obsolete by portal loss change, or the least recently used one
+	SCachedWave *wave = NULL;
+	if ( m_WaveCache.Num() < s_WAVE_CACHE_SIZE )
+	{
+		wave = &m_WaveCache.Alloc();
+	}
+	else
+	{
+		for ( int i = 0 ; i < m_WaveCache.Num() ; i++ )
+		{
+			SCachedWave &w = m_WaveCache[i];
+			if ( w.lossVersion != m_PortLossVersion )
+			{
+				wave = &w;
+				break;
+			}
+			if ( wave == NULL || w.lastUsed < wave->lastUsed )
+			{
+				wave = &w;
+			}
+		}
+	}
+
+	wave->area = initArea;
+	wave->lossVersion = m_PortLossVersion;
+	wave->origin = origin;
+	wave->maxLoss = maxLoss;
+	wave->lastUsed = ++m_WaveUseCounter;
+	wave->initDist = m_WaveInitDist;
+
+	wave->events = m_WaveEvents;
+	for ( int i = 0 ; i < wave->events.Num() ; i++ )
+	{
+		wave->events[i].value = *wave->events[i].pEvent;
+	}
+	wave->entered = m_WaveEntered;
+}
+
+void CsndProp::UpdateAreaAI( void )
+{
+	if ( m_AreaAIFrame == gameLocal.framenum )
+	{
+		return;
+	}
+	m_AreaAIFrame = gameLocal.framenum;
+
+	// counting sort of AI by area
+	idList<idAI *> ais;
+	idList<int> areas;
+	m_AreaAIFirst.SetNum( m_numAreas + 1 );
+	for ( int i = 0 ; i <= m_numAreas ; i++ )
+	{
+		m_AreaAIFirst[i] = 0;
+	}
+	m_AreaAIMaxEyeOffset = 0.0f;
+
+	for ( idAI* ai = gameLocal.spawnedAI.Next() ; ai != NULL ; ai = ai->aiNode.Next() )
+	{
+		int area = gameRenderWorld->GetAreaAtPoint( ai->GetPhysics()->GetOrigin() );
+		// Sometimes GetAreaAtPoint returns -1, don't know why
+		if ( area < 0 || area >= m_numAreas )
+		{
+			continue;
+		}
+		ais.Append( ai );
+		areas.Append( area );
+		m_AreaAIFirst[area + 1]++;
+		m_AreaAIMaxEyeOffset = Max( m_AreaAIMaxEyeOffset, ( ai->GetEyePosition() - ai->GetPhysics()->GetOrigin() ).LengthFast() );
+	}
+	for ( int i = 0 ; i < m_numAreas ; i++ )
+	{
+		m_AreaAIFirst[i + 1] += m_AreaAIFirst[i];
+	}
+
+	m_AreaAIList.SetNum( ais.Num() );
+	idList<int> fill = m_AreaAIFirst;
+	for ( int i = 0 ; i < ais.Num() ; i++ )
+	{
+		m_AreaAIList[ fill[ areas[i] ]++ ] = ais[i];
+	}
+
+	m_RangeAreas.SetNum( m_numAreas );
+}
+
+void CsndProp::UpdateStats( void )
+{
+	int elapsed = gameLocal.time - m_StatsTime;
+	if ( elapsed >= 0 && elapsed < 1000 )
+	{
+		return;
+	}
+
+	if ( cv_spr_stats.GetBool() && elapsed > 0 )
+	{
+		float perSecond = 1000.0f / elapsed;
+		gameLocal.Printf( "soundprop: %.1f sounds/s, %.1f propagations/s, %.1f cache hits/s (%.0f%%), %d cached waves\n",
+			m_StatsSounds * perSecond, m_StatsExpansions * perSecond, m_StatsCacheHits * perSecond,
+			100.0f * m_StatsCacheHits / Max( m_StatsExpansions + m_StatsCacheHits, 1 ), m_WaveCache.Num() );
+	}
+
+	m_StatsTime = gameLocal.time;
+	m_StatsSounds = 0;
+	m_StatsExpansions = 0;
+	m_StatsCacheHits = 0;
+}
+
 void CsndProp::ProcessPopulated( float volInit, idVec3 origin, SSprParms *propParms )
 {
 	float LeastLoss, TestLoss, tempDist, tempAtt, tempLoss;
@@ -1769,6 +2060,9 @@ void CsndProp::SetPortalAILoss( int handle, float value ) // grayman #3042 - spe
 
 	// update the portal loss info timestamp
 	m_TimeStampPortLoss = gameLocal.time;
+
+	// cached waves were expanded with old losses
+	m_PortLossVersion++;
 }
 
 void CsndProp::SetPortalPlayerLoss( int handle, float value ) // grayman #3042 - specific to Player
@@ -94,6 +94,10 @@ typedef struct SPortEvent_s
 
 	SPortEvent_s *PrevPort; // the portal visited immediately before each portal
 
+	int		Root; // local index of the initial area portal that starts the path to this portal
+
+	int		WaveIndex; // index in the list of portal events written by current expansion
+
 } SPortEvent;
 
 /**
@@ -124,8 +128,50 @@ typedef struct SExpQue_s
 
 	SPortEvent *PrevPort; // previous portal flooded through along path
 
+	int			root; // local index of the initial area portal the path started with
+
 } SExpQue;
 
+/**
+* Portal event written by wavefront expansion, stored in expansion cache
+**/
+typedef struct SCachedPortEvent_s
+{
+	SPortEvent	*pEvent; // points into m_EventAreas, valid until soundprop data is reloaded
+
+	SPortEvent	value; // contents of the event when expansion finished
+
+	int			area; // area the portal event belongs to
+
+	int			localPort; // local portal index in the area
+
+} SCachedPortEvent;
+
+/**
+* Result of a finished wavefront expansion.
+* Losses do not depend on the source volume, so the result can be reused
+* for any sound from (almost) the same point, until some portal AI loss changes.
+**/
+typedef struct SCachedWave_s
+{
+	int			area; // area of the sound origin
+
+	int			lossVersion; // m_PortLossVersion when the wave was expanded
+
+	idVec3		origin; // sound origin
+
+	float		maxLoss; // wave was expanded until its loss exceeded this [dB]
+
+	idList<float> initDist; // distance from origin to each portal of the initial area [m]
+
+	idList<SCachedPortEvent> events; // all portal events written by the expansion
+
+	idList<int>	entered; // indices of events the wave flooded into their area through
+
+	int			lastUsed; // LRU counter
+
+} SCachedWave;
+
 
 
 
@@ -184,6 +230,36 @@ protected:
 	**/
 	bool ExpandWave(float volInit, idVec3 origin, float minAudThresh);
 
+	/**
+	* Distance from origin to the point on the given portal of the area
+	* where the sound leaves the area [m]
+	**/
+	float InitialPortalDist( SsndArea *pSndArea, int portal, const idVec3 &origin );
+
+	/**
+	* Fills m_EventAreas and m_PopAreas from a cached wave expanded from
+	* a nearby origin in the same area, shifting losses by the change of
+	* distance to the initial portals. Returns false if no cached wave fits.
+	**/
+	bool ExpandCachedWave( int initArea, const idVec3 &origin, float maxLoss );
+
+	/**
+	* Stores the portal events written by the last expansion into the wave cache.
+	**/
+	void StoreCachedWave( int initArea, const idVec3 &origin, float maxLoss );
+
+	void ClearWaveCache( void );
+
+	/**
+	* Rebuilds area -> AI index if it was built on another frame
+	**/
+	void UpdateAreaAI( void );
+
+	/**
+	* Prints propagation statistics once per second (tdm_spr_stats)
+	**/
+	void UpdateStats( void );
+
 	/**
 	* Faster and less accurate wavefront expansion algorithm.
 	* Only visits areas once.
@@ -286,11 +362,57 @@ protected:
 	* current loss at each portal.  Size is the total number of areas
 	* Entries for areas not visited in this propagation are NULL
 	*
-	* For now, this is cleared and re-written for every new sound event
-	* later on, we might see if we can re-use it for multiple events that
-	* come from close to the same spot, for optimization.
+	* Cleared and re-written for every new sound event, either by wavefront
+	* expansion, or from m_WaveCache if a sound came from close to the same spot.
 	**/
 	SEventArea		*m_EventAreas;
+
+	/**
+	* Incremented every time AI loss of some portal changes
+	**/
+	int				m_PortLossVersion;
+
+	/**
+	* Recently expanded waves, reused for sounds from nearby points
+	**/
+	idList<SCachedWave> m_WaveCache;
+
+	/**
+	* Portal events written by current expansion, and those of them the wave
+	* flooded into their area through (may contain duplicates)
+	**/
+	idList<SCachedPortEvent> m_WaveEvents;
+	idList<int>		m_WaveEntered;
+	idList<float>	m_WaveInitDist;
+
+	int				m_WaveUseCounter;
+
+	/**
+	* AI in every area, sorted by area number.
+	* AI of area A are m_AreaAIList[m_AreaAIFirst[A] .. m_AreaAIFirst[A+1]).
+	* Rebuilt once per game frame, when the first sound is propagated.
+	**/
+	idList<int>		m_AreaAIFirst;
+	idList< idEntityPtr<idAI> > m_AreaAIList;
+	int				m_AreaAIFrame;
+
+	/**
+	* Max distance between origin and eye position among all AI in the index
+	**/
+	float			m_AreaAIMaxEyeOffset;
+
+	/**
+	* Temporary list of areas within range of a sound
+	**/
+	idList<int>		m_RangeAreas;
+
+	/**
+	* Statistics printed with tdm_spr_stats
+	**/
+	int				m_StatsTime;
+	int				m_StatsSounds;
+	int				m_StatsExpansions;
+	int				m_StatsCacheHits;
 };
 
 #endif
@@ -193,7 +193,7 @@ float CStim::GetRadius()
 
 CStimResponseTimer* CStim::AddTimerToGame()
 {
-	gameLocal.m_StimTimer.AddUnique(this);
+	gameLocal.AddStimTimer(this);
 	m_Timer.SetTicks(sys->ClockTicksPerSecond()/1000);
 
 	return(&m_Timer);
@@ -201,7 +201,7 @@ CStimResponseTimer* CStim::AddTimerToGame()
 
 void CStim::RemoveTimerFromGame()
 {
-	gameLocal.m_StimTimer.Remove(this);
+	gameLocal.RemoveStimTimer(this);
 }
 
 void CStim::PostFired (int numResponses)
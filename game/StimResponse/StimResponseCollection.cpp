@@ -271,6 +271,7 @@ int CStimResponseCollection::RemoveResponse(StimType type)
 			{
 				owner = response->m_Owner.GetEntity();
 				m_Responses.RemoveIndex(i);
+				gameLocal.InvalidateResponseBuckets();
 			}
 
 			break;
@@ -216,6 +216,11 @@ void CStimResponseTimer::Reset(void)
 
 void CStimResponseTimer::SetState(TimerState State)
 {
+	if (State == SRTS_RUNNING && m_State != SRTS_RUNNING)
+	{
+		// let game know that some stim timer may need ticking now
+		gameLocal.InvalidateStimTimerDue();
+	}
 	m_State = State;
 }
 
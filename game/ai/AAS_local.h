@@ -42,12 +42,35 @@ private:
 	idRoutingCache *			prev;					// previous in list
 	idRoutingCache *			time_next;				// next in time based list
 	idRoutingCache *			time_prev;				// previous in time based list
+	bool						pinned;					// precomputed: not in time based list, never evicted
 	unsigned short				startTravelTime;		// travel time to start with
 	unsigned char *				reachabilities;			// reachabilities used for routing
 	unsigned short *			travelTimes;			// travel time for every area
 };
 
 
+// edges of abstract routing graph inside one cluster.
+// Stores travel times between every pair of portals of the cluster for given travel flags.
+// The values are the same as in area routing cache of portal areas,
+// but the matrix is small and is not evicted together with area cache.
+class idClusterPortalCosts {
+	friend class idAASLocal;
+
+public:
+								idClusterPortalCosts( int numPortals );
+								~idClusterPortalCosts( void );
+
+	int							Size( void ) const;
+
+private:
+	int							travelFlags;			// combinations of the travel flags
+	int							numPortals;				// number of portals of the cluster
+	unsigned short *			travelTimes;			// [to * numPortals + from]: travel time between portal areas, 0 if unreachable
+	unsigned char *				reachabilities;			// [to * numPortals + from]: reachability used to leave portal area 'from'
+	idClusterPortalCosts *		next;					// next in list of cluster
+};
+
+
 class idRoutingUpdate {
 	friend class idAASLocal;
 
@@ -179,6 +202,25 @@ public:
 	// Accessor function for the EAS
 	virtual eas::tdmEAS* GetEAS() override { return elevatorSystem; }
 
+	/**
+	 * Builds area routing cache for all areas of all clusters in parallel jobs.
+	 * Precomputed tables are not evicted by memory limit (see aas_precomputeRouting).
+	 * When area or obstacle state changes, affected clusters are dropped and queued for rebuild.
+	 */
+	void PrecomputeRouting( int travelFlags );
+
+	/**
+	 * Rebuilds precomputed routing tables of the clusters dropped since last call.
+	 * Called once per game frame, until then the clusters use lazy routing cache.
+	 */
+	void UpdatePrecomputedRouting( void );
+
+	/**
+	 * Runs given number of routes between random areas and prints latency percentiles.
+	 * If flush is set, lazy routing cache is dropped before every query (worst case).
+	 */
+	void RouteBenchmark( int numQueries, bool flush );
+
 	// Save/Restore routines
 	virtual void Save(idSaveGame* savefile) const override;
 	virtual void Restore(idRestoreGame* savefile) override;
@@ -204,6 +246,12 @@ private:	// routing data
 	mutable idRoutingCache *	cacheListStart;			// start of list with cache sorted from oldest to newest
 	mutable idRoutingCache *	cacheListEnd;			// end of list with cache sorted from oldest to newest
 	mutable int					totalCacheMemory;		// total cache memory used
+	mutable idClusterPortalCosts **	clusterPortalCosts;	// for each cluster: travel times between its portals
+	mutable int					portalCostsMemory;		// memory used by portal costs
+	int							precomputedCacheMemory;	// memory used by precomputed (pinned) cache
+	int							numPrecomputedCaches;	// number of precomputed (pinned) caches
+	int							precomputedTravelFlags;	// travel flags of precomputed cache, 0 if routing is not precomputed
+	idList<int>					precomputeQueue;		// clusters which lost precomputed cache and should be rebuilt
 	idList<idRoutingObstacle *>	obstacleList;			// list with obstacles
 
 	// greebo: This is TDM's EAS "Elevator Awareness System" :)
@@ -227,12 +275,22 @@ private:	// routing
 	void						DeleteOldestCache( void ) const;
 	idReachability *			GetAreaReachability( int areaNum, int reachabilityNum ) const;
 	int							ClusterAreaNum( int clusterNum, int areaNum ) const;
-	void						UpdateAreaRoutingCache( idRoutingCache *areaCache ) const;
+	void						UpdateAreaRoutingCache( idRoutingCache *areaCache, idRoutingUpdate *updates ) const;
 	idRoutingCache *			GetAreaRoutingCache( int clusterNum, int areaNum, int travelFlags ) const;
 	void						UpdatePortalRoutingCache( idRoutingCache *portalCache ) const;
 	idRoutingCache *			GetPortalRoutingCache( int clusterNum, int areaNum, int travelFlags ) const;
+	const idClusterPortalCosts *GetClusterPortalCosts( int clusterNum, int travelFlags ) const;
+	void						DeleteClusterPortalCosts( int clusterNum );
 	void						RemoveRoutingCacheUsingArea( int areaNum );
 
+	struct routingPrecomputeWork_t {
+		const idAASLocal *		aas;
+		int						numClusterAreas;		// number of reachable areas in the cluster
+		idList<idRoutingCache *> caches;				// new caches to fill, all of one cluster
+	};
+	static void					PrecomputeRoutingJob( void *data );
+	bool						PrecomputeClusters( const idList<bool> &clusterSelected );
+
 public:
 	virtual void				DisableArea( int areaNum ) override;
 	virtual void				EnableArea( int areaNum ) override;
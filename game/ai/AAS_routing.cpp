@@ -46,6 +46,7 @@ idRoutingCache::idRoutingCache( int size ) {
 	cluster = 0;
 	next = prev = NULL;
 	time_next = time_prev = NULL;
+	pinned = false;
 	travelFlags = 0;
 	startTravelTime = 0;
 	type = 0;
@@ -75,6 +76,40 @@ int idRoutingCache::Size( void ) const {
 	return sizeof( idRoutingCache ) + size * sizeof( reachabilities[0] ) + size * sizeof( travelTimes[0] );
 }
 
+/*
+============
+idClusterPortalCosts::idClusterPortalCosts
+============
+*/
+idClusterPortalCosts::idClusterPortalCosts( int numPortals ) {
+	travelFlags = 0;
+	next = NULL;
+	this->numPortals = numPortals;
+	reachabilities = new byte[numPortals * numPortals];
+	memset( reachabilities, 0, numPortals * numPortals * sizeof( reachabilities[0] ) );
+	travelTimes = new unsigned short[numPortals * numPortals];
+	memset( travelTimes, 0, numPortals * numPortals * sizeof( travelTimes[0] ) );
+}
+
+/*
+============
+idClusterPortalCosts::~idClusterPortalCosts
+============
+*/
+idClusterPortalCosts::~idClusterPortalCosts( void ) {
+	delete [] reachabilities;
+	delete [] travelTimes;
+}
+
+/*
+============
+idClusterPortalCosts::Size
+============
+*/
+int idClusterPortalCosts::Size( void ) const {
+	return sizeof( idClusterPortalCosts ) + numPortals * numPortals * ( sizeof( reachabilities[0] ) + sizeof( travelTimes[0] ) );
+}
+
 /*
 ============
 idAASLocal::AreaTravelTime
@@ -249,8 +284,16 @@ void idAASLocal::SetupRoutingCache( void ) {
 	// greebo: For each area in the map, allocate a traveltime integer and initialise them to 0
 	goalAreaTravelTimes = (unsigned short *) Mem_ClearedAlloc( file->GetNumAreas() * sizeof(unsigned short) );
 
+	// portal costs of every cluster are computed on demand
+	clusterPortalCosts = (idClusterPortalCosts**) Mem_ClearedAlloc( file->GetNumClusters() * sizeof(idClusterPortalCosts*) );
+	portalCostsMemory = 0;
+
 	cacheListStart = cacheListEnd = NULL;
 	totalCacheMemory = 0;
+	precomputedCacheMemory = 0;
+	numPrecomputedCaches = 0;
+	precomputedTravelFlags = 0;
+	precomputeQueue.Clear();
 }
 
 /*
@@ -265,10 +308,33 @@ void idAASLocal::DeleteClusterCache( int clusterNum ) {
 	for ( i = 0; i < file->GetCluster( clusterNum ).numReachableAreas; i++ ) {
 		for ( cache = areaCacheIndex[clusterNum][i]; cache; cache = areaCacheIndex[clusterNum][i] ) {
 			areaCacheIndex[clusterNum][i] = cache->next;
+			if ( cache->pinned ) {
+				precomputedCacheMemory -= cache->Size();
+				numPrecomputedCaches--;
+				// travel times are valid again after state change is over
+				precomputeQueue.AddUnique( clusterNum );
+			}
 			UnlinkCache( cache );
 			delete cache;
 		}
 	}
+
+	DeleteClusterPortalCosts( clusterNum );
+}
+
+/*
+============
+idAASLocal::DeleteClusterPortalCosts
+============
+*/
+void idAASLocal::DeleteClusterPortalCosts( int clusterNum ) {
+	idClusterPortalCosts *costs;
+
+	for ( costs = clusterPortalCosts[clusterNum]; costs; costs = clusterPortalCosts[clusterNum] ) {
+		clusterPortalCosts[clusterNum] = costs->next;
+		portalCostsMemory -= costs->Size();
+		delete costs;
+	}
 }
 
 /*
@@ -315,9 +381,16 @@ void idAASLocal::ShutdownRoutingCache( void ) {
 	portalUpdate = NULL;
 	Mem_Free( goalAreaTravelTimes );
 	goalAreaTravelTimes = NULL;
+	Mem_Free( clusterPortalCosts );
+	clusterPortalCosts = NULL;
+	portalCostsMemory = 0;
 
 	cacheListStart = cacheListEnd = NULL;
 	totalCacheMemory = 0;
+	precomputedCacheMemory = 0;
+	numPrecomputedCaches = 0;
+	precomputedTravelFlags = 0;
+	precomputeQueue.Clear();
 }
 
 /*
@@ -366,6 +439,8 @@ void idAASLocal::RoutingStats( void ) const {
 	gameLocal.Printf( "%6d area cache (%d KB)\n", numAreaCache, totalAreaCacheMemory >> 10 );
 	gameLocal.Printf( "%6d portal cache (%d KB)\n", numPortalCache, totalPortalCacheMemory >> 10 );
 	gameLocal.Printf( "%6d total cache (%d KB)\n", numAreaCache + numPortalCache, totalCacheMemory >> 10 );
+	gameLocal.Printf( "%6d precomputed area cache (%d KB)\n", numPrecomputedCaches, precomputedCacheMemory >> 10 );
+	gameLocal.Printf( "       cluster portal costs (%d KB)\n", portalCostsMemory >> 10 );
 	gameLocal.Printf( "%6d area travel times (%lld KB)\n", numAreaTravelTimes, int64( numAreaTravelTimes * sizeof( unsigned short ) ) >> 10 );
 	gameLocal.Printf( "%6d area cache entries (%lld KB)\n", areaCacheIndexSize, int64( areaCacheIndexSize * sizeof( idRoutingCache * ) ) >> 10 );
 	gameLocal.Printf( "%6d portal cache entries (%lld KB)\n", portalCacheIndexSize, int64( portalCacheIndexSize * sizeof( idRoutingCache * ) ) >> 10 );
@@ -647,6 +722,11 @@ idAASLocal::LinkCache
 */
 void idAASLocal::LinkCache( idRoutingCache *cache ) const {
 
+	// precomputed cache is never evicted
+	if ( cache->pinned ) {
+		return;
+	}
+
 	// if the cache is already linked
 	if ( cache->time_next || cache->time_prev || cacheListStart == cache ) {
 		UnlinkCache( cache );
@@ -673,6 +753,10 @@ idAASLocal::UnlinkCache
 */
 void idAASLocal::UnlinkCache( idRoutingCache *cache ) const {
 
+	if ( cache->pinned ) {
+		return;
+	}
+
 	totalCacheMemory -= cache->Size();
 
 	// unlink the cache
@@ -759,7 +843,7 @@ ID_INLINE int idAASLocal::ClusterAreaNum( int clusterNum, int areaNum ) const {
 idAASLocal::UpdateAreaRoutingCache
 ============
 */
-void idAASLocal::UpdateAreaRoutingCache( idRoutingCache *areaCache ) const {
+void idAASLocal::UpdateAreaRoutingCache( idRoutingCache *areaCache, idRoutingUpdate *updates ) const {
 	// number of reachability areas within this cluster
 	int numReachableAreas = file->GetCluster(areaCache->cluster).numReachableAreas;
 
@@ -777,7 +861,7 @@ void idAASLocal::UpdateAreaRoutingCache( idRoutingCache *areaCache ) const {
 	memset( startAreaTravelTimes, 0, sizeof( startAreaTravelTimes ) );
 
 	// initialize first update
-	idRoutingUpdate* curUpdate = &areaUpdate[clusterAreaNum];
+	idRoutingUpdate* curUpdate = &updates[clusterAreaNum];
 
 	curUpdate->areaNum = areaCache->areaNum;
 	curUpdate->areaTravelTimes = startAreaTravelTimes;
@@ -843,7 +927,7 @@ void idAASLocal::UpdateAreaRoutingCache( idRoutingCache *areaCache ) const {
 
 				areaCache->travelTimes[clusterAreaNum] = t;
 				areaCache->reachabilities[clusterAreaNum] = reach->number; // reversed reachability used to get into this area
-				idRoutingUpdate* nextUpdate = &areaUpdate[clusterAreaNum];
+				idRoutingUpdate* nextUpdate = &updates[clusterAreaNum];
 				nextUpdate->areaNum = nextAreaNum;
 				nextUpdate->tmpTravelTime = t;
 				nextUpdate->areaTravelTimes = reach->areaTravelTimes;
@@ -906,12 +990,173 @@ idRoutingCache *idAASLocal::GetAreaRoutingCache( int clusterNum, int areaNum, in
 			clusterCache->prev = cache;
 		}
 		areaCacheIndex[clusterNum][clusterAreaNum] = cache;
-		UpdateAreaRoutingCache( cache );
+		UpdateAreaRoutingCache( cache, areaUpdate );
 	}
 	LinkCache( cache );
 	return cache;
 }
 
+/*
+============
+idAASLocal::PrecomputeRoutingJob
+============
+*/
+void idAASLocal::PrecomputeRoutingJob( void *data ) {
+	routingPrecomputeWork_t *work = (routingPrecomputeWork_t *)data;
+
+	// every job floods its own caches, so it needs its own update memory
+	idRoutingUpdate *updates = (idRoutingUpdate *) Mem_ClearedAlloc( work->numClusterAreas * sizeof( idRoutingUpdate ) );
+	for ( int i = 0; i < work->caches.Num(); i++ ) {
+		work->aas->UpdateAreaRoutingCache( work->caches[i], updates );
+	}
+	Mem_Free( updates );
+}
+
+/*
+============
+idAASLocal::PrecomputeClusters
+
+  builds pinned area cache with precomputedTravelFlags for all areas in selected clusters
+  returns false if memory limit was reached
+============
+*/
+bool idAASLocal::PrecomputeClusters( const idList<bool> &clusterSelected ) {
+	// so many caches are filled by one job
+	static const int CACHES_PER_JOB = 32;
+
+	// allocate caches on main thread, jobs only fill them
+	idList<routingPrecomputeWork_t> work;
+	int memoryLimit = aas_precomputeRoutingMB.GetInteger() << 20;
+	bool outOfMemory = false;
+	auto AddArea = [&]( int clusterNum, int areaNum ) {
+		if ( clusterNum <= 0 || !clusterSelected[clusterNum] ) {
+			return;
+		}
+		int numClusterAreas = file->GetCluster( clusterNum ).numReachableAreas;
+		int clusterAreaNum = ClusterAreaNum( clusterNum, areaNum );
+		if ( clusterAreaNum >= numClusterAreas ) {
+			return;
+		}
+		for ( idRoutingCache *cache = areaCacheIndex[clusterNum][clusterAreaNum]; cache; cache = cache->next ) {
+			if ( cache->travelFlags == precomputedTravelFlags ) {
+				return;		// already computed, maybe lazily
+			}
+		}
+		idRoutingCache *cache = new idRoutingCache( numClusterAreas );
+		if ( precomputedCacheMemory + cache->Size() > memoryLimit ) {
+			delete cache;
+			outOfMemory = true;
+			return;
+		}
+		cache->type = CACHETYPE_AREA;
+		cache->cluster = clusterNum;
+		cache->areaNum = areaNum;
+		cache->startTravelTime = 1;
+		cache->travelFlags = precomputedTravelFlags;
+		cache->pinned = true;
+		cache->prev = NULL;
+		cache->next = areaCacheIndex[clusterNum][clusterAreaNum];
+		if ( cache->next ) {
+			cache->next->prev = cache;
+		}
+		areaCacheIndex[clusterNum][clusterAreaNum] = cache;
+		precomputedCacheMemory += cache->Size();
+		numPrecomputedCaches++;
+
+		// areas of one cluster come in a row, except for portal areas
+		routingPrecomputeWork_t *last = ( work.Num() > 0 ? &work[work.Num() - 1] : NULL );
+		if ( !last || last->caches[0]->cluster != clusterNum || last->caches.Num() >= CACHES_PER_JOB ) {
+			last = &work.Alloc();
+			last->aas = this;
+			last->numClusterAreas = numClusterAreas;
+		}
+		last->caches.Append( cache );
+	};
+	for ( int areaNum = 1; areaNum < file->GetNumAreas() && !outOfMemory; areaNum++ ) {
+		int clusterNum = file->GetArea( areaNum ).cluster;
+		if ( clusterNum >= 0 ) {
+			AddArea( clusterNum, areaNum );
+		} else {
+			// portal area belongs to both clusters
+			const aasPortal_t &portal = file->GetPortal( -clusterNum );
+			AddArea( portal.clusters[0], areaNum );
+			AddArea( portal.clusters[1], areaNum );
+		}
+	}
+
+	if ( work.Num() > 0 ) {
+		idParallelJobList *jobList = parallelJobManager->AllocJobList( JOBLIST_UTILITY, JOBLIST_PRIORITY_MEDIUM, work.Num(), 0, nullptr );
+		RegisterJob( PrecomputeRoutingJob, "AASPrecomputeRouting" );
+		for ( int w = 0; w < work.Num(); w++ ) {
+			jobList->AddJob( PrecomputeRoutingJob, &work[w] );
+		}
+		jobList->Submit( nullptr, JOBLIST_PARALLELISM_NONINTERACTIVE );
+		jobList->Wait();
+		parallelJobManager->FreeJobList( jobList );
+	}
+
+	return !outOfMemory;
+}
+
+/*
+============
+idAASLocal::PrecomputeRouting
+============
+*/
+void idAASLocal::PrecomputeRouting( int travelFlags ) {
+	if ( !file || !aas_precomputeRouting.GetBool() ) {
+		return;
+	}
+
+	TRACE_CPU_SCOPE( "AAS:PrecomputeRouting" )
+
+	idTimer timer;
+	timer.Clear();
+	timer.Start();
+
+	precomputedTravelFlags = travelFlags;
+	precomputeQueue.Clear();
+
+	idList<bool> clusterSelected;
+	clusterSelected.SetNum( file->GetNumClusters() );
+	for ( int c = 0; c < clusterSelected.Num(); c++ ) {
+		clusterSelected[c] = true;
+	}
+	bool outOfMemory = !PrecomputeClusters( clusterSelected );
+
+	timer.Stop();
+	common->Printf( "%s: precomputed %d routing tables (%d KB) in %.1lf ms%s\n", name.c_str(),
+		numPrecomputedCaches, precomputedCacheMemory >> 10, timer.Milliseconds(),
+		outOfMemory ? ", out of memory (see aas_precomputeRoutingMB)" : ""
+	);
+}
+
+/*
+============
+idAASLocal::UpdatePrecomputedRouting
+============
+*/
+void idAASLocal::UpdatePrecomputedRouting( void ) {
+	if ( precomputeQueue.Num() == 0 || precomputedTravelFlags == 0 ) {
+		return;
+	}
+
+	TRACE_CPU_SCOPE( "AAS:UpdatePrecomputedRouting" )
+
+	// all doors and obstacles changed during last frame are handled together
+	idList<bool> clusterSelected;
+	clusterSelected.SetNum( file->GetNumClusters() );
+	for ( int c = 0; c < clusterSelected.Num(); c++ ) {
+		clusterSelected[c] = false;
+	}
+	for ( int i = 0; i < precomputeQueue.Num(); i++ ) {
+		clusterSelected[precomputeQueue[i]] = true;
+	}
+	precomputeQueue.Clear();
+
+	PrecomputeClusters( clusterSelected );
+}
+
 /*
 ============
 idAASLocal::UpdatePortalRoutingCache
@@ -952,7 +1197,20 @@ void idAASLocal::UpdatePortalRoutingCache( idRoutingCache *portalCache ) const {
 		curUpdate->isInList = false;
 
 		cluster = &file->GetCluster( curUpdate->cluster );
-		cache = GetAreaRoutingCache( curUpdate->cluster, curUpdate->areaNum, portalCache->travelFlags );
+
+		// when flooding from a portal, take travel times from abstract graph of the cluster
+		const idClusterPortalCosts *costs = NULL;
+		int costsRow = -1;
+		if ( aas_hierarchicalRouting.GetBool() && file->GetArea( curUpdate->areaNum ).cluster < 0 ) {
+			for ( i = 0; i < cluster->numPortals; i++ ) {
+				if ( file->GetPortal( file->GetPortalIndex( cluster->firstPortal + i ) ).areaNum == curUpdate->areaNum ) {
+					costs = GetClusterPortalCosts( curUpdate->cluster, portalCache->travelFlags );
+					costsRow = i * cluster->numPortals;
+					break;
+				}
+			}
+		}
+		cache = ( costs ? NULL : GetAreaRoutingCache( curUpdate->cluster, curUpdate->areaNum, portalCache->travelFlags ) );
 
 		// take all portals of the cluster
 		for ( i = 0; i < cluster->numPortals; i++ ) {
@@ -971,12 +1229,19 @@ void idAASLocal::UpdatePortalRoutingCache( idRoutingCache *portalCache ) const {
 			DM_LOG(LC_AI, LT_DEBUG)LOGSTRING("     |       maxAreaTravelTime %d\r",portal->maxAreaTravelTime);
 			DM_LOG(LC_AI, LT_DEBUG)LOGSTRING("     ----------------------------------\r");
 #endif
-			clusterAreaNum = ClusterAreaNum( curUpdate->cluster, portal->areaNum );
-			if ( clusterAreaNum >= cluster->numReachableAreas ) {
-				continue;
+			int reachNum;
+			if ( costs ) {
+				t = costs->travelTimes[costsRow + i];
+				reachNum = costs->reachabilities[costsRow + i];
+			}
+			else {
+				clusterAreaNum = ClusterAreaNum( curUpdate->cluster, portal->areaNum );
+				if ( clusterAreaNum >= cluster->numReachableAreas ) {
+					continue;
+				}
+				t = cache->travelTimes[clusterAreaNum];
+				reachNum = cache->reachabilities[clusterAreaNum];
 			}
-
-			t = cache->travelTimes[clusterAreaNum];
 			if ( t == 0 )
 			{
 				continue;
@@ -987,7 +1252,7 @@ void idAASLocal::UpdatePortalRoutingCache( idRoutingCache *portalCache ) const {
 			if ( !portalCache->travelTimes[portalNum] || ( t < portalCache->travelTimes[portalNum] ) )
 			{
 				portalCache->travelTimes[portalNum] = t;
-				portalCache->reachabilities[portalNum] = cache->reachabilities[clusterAreaNum];
+				portalCache->reachabilities[portalNum] = reachNum;
 				nextUpdate = &portalUpdate[portalNum];
 				if ( portal->clusters[0] == curUpdate->cluster ) {
 					nextUpdate->cluster = portal->clusters[1];
@@ -1051,6 +1316,49 @@ idRoutingCache *idAASLocal::GetPortalRoutingCache( int clusterNum, int areaNum,
 	return cache;
 }
 
+/*
+============
+idAASLocal::GetClusterPortalCosts
+============
+*/
+const idClusterPortalCosts *idAASLocal::GetClusterPortalCosts( int clusterNum, int travelFlags ) const {
+	idClusterPortalCosts *costs;
+
+	for ( costs = clusterPortalCosts[clusterNum]; costs; costs = costs->next ) {
+		if ( costs->travelFlags == travelFlags ) {
+			return costs;
+		}
+	}
+
+	const aasCluster_t *cluster = &file->GetCluster( clusterNum );
+	int n = cluster->numPortals;
+	costs = new idClusterPortalCosts( n );
+	costs->travelFlags = travelFlags;
+
+	// every row is taken from area cache of the portal area
+	for ( int to = 0; to < n; to++ ) {
+		const aasPortal_t *toPortal = &file->GetPortal( file->GetPortalIndex( cluster->firstPortal + to ) );
+		if ( ClusterAreaNum( clusterNum, toPortal->areaNum ) >= cluster->numReachableAreas ) {
+			continue;
+		}
+		const idRoutingCache *cache = GetAreaRoutingCache( clusterNum, toPortal->areaNum, travelFlags );
+		for ( int from = 0; from < n; from++ ) {
+			const aasPortal_t *fromPortal = &file->GetPortal( file->GetPortalIndex( cluster->firstPortal + from ) );
+			int clusterAreaNum = ClusterAreaNum( clusterNum, fromPortal->areaNum );
+			if ( clusterAreaNum >= cluster->numReachableAreas ) {
+				continue;
+			}
+			costs->travelTimes[to * n + from] = cache->travelTimes[clusterAreaNum];
+			costs->reachabilities[to * n + from] = cache->reachabilities[clusterAreaNum];
+		}
+	}
+
+	costs->next = clusterPortalCosts[clusterNum];
+	clusterPortalCosts[clusterNum] = costs;
+	portalCostsMemory += costs->Size();
+	return costs;
+}
+
 /*
 ============
 idAASLocal::RouteToGoalArea
@@ -1796,3 +2104,63 @@ int	idAASLocal::GetAreaInCluster(int clusterNum)
 
 	return -1;
 }
+
+/*
+============
+idAASLocal::RouteBenchmark
+============
+*/
+void idAASLocal::RouteBenchmark( int numQueries, bool flush ) {
+	if ( !file ) {
+		return;
+	}
+
+	idList<int> areas;
+	for ( int i = 1; i < file->GetNumAreas(); i++ ) {
+		if ( file->GetArea( i ).flags & AREA_REACHABLE_WALK ) {
+			areas.Append( i );
+		}
+	}
+	if ( areas.Num() < 2 || numQueries <= 0 ) {
+		common->Printf( "%s: nothing to benchmark\n", name.c_str() );
+		return;
+	}
+
+	// fixed seed: same queries on every run
+	idRandom random( 0 );
+	idList<double> times;
+	times.SetNum( numQueries );
+	int numFound = 0;
+	double total = 0.0;
+	idTimer timer;
+	for ( int q = 0; q < numQueries; q++ ) {
+		int areaNum = areas[random.RandomInt( areas.Num() )];
+		int goalAreaNum = areas[random.RandomInt( areas.Num() )];
+		if ( flush ) {
+			while ( cacheListStart ) {
+				DeleteOldestCache();
+			}
+		}
+
+		int travelTime;
+		idReachability *reach;
+		timer.Clear();
+		timer.Start();
+		bool found = RouteToGoalArea( areaNum, AreaCenter( areaNum ), goalAreaNum, TFL_WALK|TFL_AIR|TFL_DOOR, travelTime, &reach, NULL, NULL );
+		timer.Stop();
+
+		times[q] = timer.Milliseconds();
+		total += times[q];
+		numFound += ( found && ( reach || areaNum == goalAreaNum ) );
+	}
+
+	std::sort( times.begin(), times.end() );
+	auto Percentile = [&]( double p ) -> double {
+		return times[Min( int( p * numQueries ), numQueries - 1 )];
+	};
+	common->Printf( "%s: %d route queries%s, %d found\n", name.c_str(), numQueries, flush ? " (flushed cache)" : "", numFound );
+	common->Printf( "  avg %.4lf ms, p50 %.4lf ms, p99 %.4lf ms, max %.4lf ms, total %.1lf ms\n",
+		total / numQueries, Percentile( 0.5 ), Percentile( 0.99 ), times[numQueries - 1], total
+	);
+	RoutingStats();
+}
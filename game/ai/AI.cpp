@@ -38,6 +38,7 @@ Project: The Dark Mod (http://www.thedarkmod.com/)
 #include "Tasks/HandleDoorTask.h" // grayman #3647
 #include "Tasks/HandleElevatorTask.h" // grayman #3647
 #include "Conversation/ConversationSystem.h"
+#include "PerceptionScheduler.h"
 #include "../Relations.h"
 #include "../Objectives/MissionData.h"
 #include "../StimResponse/StimResponseCollection.h"
@@ -658,6 +659,11 @@ idAI::~idAI()
  		
 	DM_LOG(LC_AI, LT_DEBUG)LOGSTRING("Destroying AI: 0x%p\r", this);
 
+	if (gameLocal.m_PerceptionScheduler)
+	{
+		gameLocal.m_PerceptionScheduler->Forget(this);
+	}
+
 	DeconstructScriptObject();
 	scriptObject.Free();
 	if ( worldMuzzleFlashHandle != -1 )
@@ -10518,6 +10524,36 @@ void idAI::PerformVisualScan(float timecheck)
 		return;
 	}
 
+	if ( cv_ai_opt_perception_scheduler.GetBool() )
+	{
+		// visibility checks are done later this frame (or on next frames), within time budget
+		gameLocal.m_PerceptionScheduler->RequestVisualScan(this);
+		return;
+	}
+
+	PerformVisualScanNow(1);
+}
+
+void idAI::PerformVisualScanImmediately()
+{
+	if ( ( GetAcuity("vis") <= 0 ) || !gameLocal.InPlayerPVS(this) )
+	{
+		return;
+	}
+
+	// scheduled request of this AI is served by this scan too
+	int merged = gameLocal.m_PerceptionScheduler->TakeRequest(this);
+	PerformVisualScanNow(1 + merged);
+}
+
+void idAI::PerformVisualScanNow(int numScans)
+{
+	// recheck: scheduled scan may be executed much later
+	if ( ( GetAcuity("vis") <= 0 ) || !gameLocal.InPlayerPVS(this) )
+	{
+		return;
+	}
+
 	idActor* player = gameLocal.GetLocalPlayer();
 	if (m_bIgnoreAlerts || player->fl.notarget || player->fl.invisible) // grayman #3857 - added 'invisible'
 	{
@@ -10604,7 +10640,8 @@ void idAI::PerformVisualScan(float timecheck)
 		break;
 	}
 
-	float alertInc = visionFactor*vis;
+	// merged scans would each increase alert level if executed separately
+	float alertInc = visionFactor*vis*numScans;
 	float newAlertLevel = AI_AlertLevel + alertInc;
 
 	if (newAlertLevel >= thresh_5)
@@ -390,6 +390,18 @@ public:
 	**/
 	void PerformVisualScan( float time = 1.0f/60.0f );
 
+	/**
+	* Same as PerformVisualScan, but never deferred by PerceptionScheduler.
+	* Must be used when the outcome of the scan is checked right after it.
+	**/
+	void PerformVisualScanImmediately();
+
+	/**
+	* Does the actual visual scan requested by PerformVisualScan.
+	* Called by PerceptionScheduler, numScans is how many requests it stands for.
+	**/
+	void PerformVisualScanNow( int numScans );
+
 	/**
 	* Checks to see if the AI is being blocked by an actor when it tries to move,
 	* call HadTactile this AI and if this is the case.
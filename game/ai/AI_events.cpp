@@ -3227,10 +3227,8 @@ void idAI::Event_GetTactEnt( void )
 
 void idAI::Event_VisScan( void )
 {
-	// assume we are checking over one frame
-	float time(1.0f/60.0f);
-
-	PerformVisualScan(time);
+	// script checks the enemy right away, so scan can't be deferred
+	PerformVisualScanImmediately();
 	
 	idThread::ReturnEntity(GetEnemy());
 }
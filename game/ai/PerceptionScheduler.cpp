@@ -0,0 +1,220 @@
+/*****************************************************************************
+The Dark Mod GPL Source Code
+
+This file is part of the The Dark Mod Source Code, originally based
+on the Doom 3 GPL Source Code as published in 2011.
+
+The Dark Mod Source Code is free software: you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version. For details, see LICENSE.TXT.
+
+Project: The Dark Mod (http://www.thedarkmod.com/)
+
+******************************************************************************/
+#include "precompiled.h"
+#include "game/ai/PerceptionScheduler.h"
+
+#include "game/Game_local.h"
+#include "game/ai/AI.h"
+
+void PerceptionScheduler::Clear() {
+	pending.ClearFree();
+	pendingIndex.ClearFree();
+	batch.ClearFree();
+	batchIndex.ClearFree();
+	stats.ClearFree();
+	frameExecuted = 0;
+	frameDeferred = 0;
+	frameMilliseconds = 0.0;
+}
+
+void PerceptionScheduler::RequestVisualScan(idAI *ai) {
+	int entNum = ai->entityNumber;
+	if (pendingIndex.Num() <= entNum) {
+		int oldNum = pendingIndex.Num();
+		pendingIndex.SetNum(entNum + 1);
+		for (int i = oldNum; i <= entNum; i++)
+			pendingIndex[i] = -1;
+	}
+
+	int idx = pendingIndex[entNum];
+	if (idx < 0) {
+		idx = pendingIndex[entNum] = pending.AddGrow(Request());
+		pending[idx].ai = ai;
+		pending[idx].requestTime = gameLocal.time;
+	}
+	pending[idx].numRequests++;
+}
+
+int PerceptionScheduler::TakeRequest(idAI *ai) {
+	int entNum = ai->entityNumber;
+	int numRequests = 0;
+	if (entNum < 0)
+		return 0;
+	// entity pointer becomes NULL, so request will be dropped in Think
+	if (entNum < pendingIndex.Num() && pendingIndex[entNum] >= 0) {
+		Request &req = pending[pendingIndex[entNum]];
+		numRequests += req.numRequests;
+		req.ai = nullptr;
+		pendingIndex[entNum] = -1;
+	}
+	// scan of one AI in batch can trigger immediate scan of another one which is not executed yet
+	if (entNum < batchIndex.Num() && batchIndex[entNum] >= 0) {
+		Request &req = batch[batchIndex[entNum]];
+		numRequests += req.numRequests;
+		req.ai = nullptr;
+		batchIndex[entNum] = -1;
+	}
+	return numRequests;
+}
+
+void PerceptionScheduler::Forget(idAI *ai) {
+	int entNum = ai->entityNumber;
+	if (entNum < 0)
+		return;
+	if (entNum < pendingIndex.Num() && pendingIndex[entNum] >= 0) {
+		// entity pointer becomes NULL, so request will be dropped in Think
+		pending[pendingIndex[entNum]].ai = nullptr;
+		pendingIndex[entNum] = -1;
+	}
+	if (entNum < batchIndex.Num() && batchIndex[entNum] >= 0) {
+		batch[batchIndex[entNum]].ai = nullptr;
+		batchIndex[entNum] = -1;
+	}
+	if (entNum < stats.Num())
+		stats[entNum] = LatencyStats();
+}
+
+float PerceptionScheduler::ComputePriority(idAI *ai, int waitTime, const idVec3 &viewerPos) const {
+	// alerted AI go first: alert level relative to combat threshold
+	float alert = idMath::ClampFloat(0.0f, 1.0f, float(ai->AI_AlertLevel) / Max(ai->thresh_5, 1.0f));
+	// close AI go first: priority halves at 10 meters
+	float dist = (ai->GetEyePosition() - viewerPos).LengthFast() * DOOM_TO_METERS;
+	float priority = (1.0f + alert) / (1.0f + dist * 0.1f);
+	// waiting raises priority, so that calm distant AI get their turn too
+	return priority * (1.0f + waitTime * 0.01f);
+}
+
+void PerceptionScheduler::Think() {
+	frameExecuted = 0;
+	frameDeferred = 0;
+	frameMilliseconds = 0.0;
+	if (pending.Num() == 0)
+		return;
+
+	TRACE_CPU_SCOPE("PerceptionScheduler")
+
+	idPlayer *player = gameLocal.GetLocalPlayer();
+	idVec3 viewerPos = player ? player->GetEyePosition() : vec3_zero;
+
+	// take current requests out: executed scans may issue new ones
+	batch.Clear();
+	batch.Swap(pending);
+	for (Request &req : batch) {
+		idAI *ai = req.ai.GetEntity();
+		if (ai)
+			pendingIndex[ai->entityNumber] = -1;
+		req.priority = ai ? ComputePriority(ai, gameLocal.time - req.requestTime, viewerPos) : -1.0f;
+	}
+	std::stable_sort(batch.begin(), batch.end(), [](const Request &a, const Request &b) {
+		return a.priority > b.priority;
+	});
+	if (batchIndex.Num() < pendingIndex.Num()) {
+		int oldNum = batchIndex.Num();
+		batchIndex.SetNum(pendingIndex.Num());
+		for (int i = oldNum; i < batchIndex.Num(); i++)
+			batchIndex[i] = -1;
+	}
+	for (int i = 0; i < batch.Num(); i++) {
+		if (idAI *ai = batch[i].ai.GetEntity())
+			batchIndex[ai->entityNumber] = i;
+	}
+
+	float budget = cv_ai_opt_perception_budget.GetFloat();
+	int maxLatency = cv_ai_opt_perception_maxlatency.GetInteger();
+
+	idTimer timer;
+	timer.Clear();
+	timer.Start();
+
+	idList<Request> carried;
+	for (int i = 0; i < batch.Num(); i++) {
+		const Request &req = batch[i];
+		idAI *ai = req.ai.GetEntity();
+		if (!ai)
+			continue;
+		int entNum = ai->entityNumber;
+		// executed or carried over: immediate scans must not take it anymore
+		batchIndex[entNum] = -1;
+		int latency = gameLocal.time - req.requestTime;
+
+		if (budget > 0.0f && frameExecuted > 0 && latency < maxLatency) {
+			timer.Stop();
+			double elapsed = timer.Milliseconds();
+			timer.Start();
+			if (elapsed >= budget) {
+				// out of budget: try again on next frame
+				carried.AddGrow(req);
+				frameDeferred++;
+				continue;
+			}
+		}
+
+		ai->PerformVisualScanNow(req.numRequests);
+		frameExecuted++;
+
+		while (stats.Num() <= entNum)
+			stats.Append(LatencyStats());
+		LatencyStats &st = stats[entNum];
+		st.numScans++;
+		st.numRequests += req.numRequests;
+		st.sumLatency += latency;
+		st.maxLatency = Max(st.maxLatency, latency);
+		st.lastLatency = latency;
+	}
+
+	// put deferred requests back, merging with the ones issued meanwhile
+	for (const Request &req : carried) {
+		idAI *ai = req.ai.GetEntity();
+		if (!ai)
+			continue;
+		int &idx = pendingIndex[ai->entityNumber];
+		if (idx >= 0) {
+			pending[idx].requestTime = req.requestTime;
+			pending[idx].numRequests += req.numRequests;
+		} else {
+			idx = pending.AddGrow(req);
+		}
+	}
+	batch.Clear();
+
+	timer.Stop();
+	frameMilliseconds = timer.Milliseconds();
+}
+
+void PerceptionScheduler::PrintStats() const {
+	common->Printf("Last frame: %d scans executed, %d deferred, %.3lf ms\n", frameExecuted, frameDeferred, frameMilliseconds);
+	common->Printf("%-32s %8s %8s %8s %8s %8s %8s\n", "AI", "scans", "merged", "avg ms", "max ms", "last ms", "waiting");
+
+	int worstLatency = 0;
+	for (int entNum = 0; entNum < stats.Num(); entNum++) {
+		const LatencyStats &st = stats[entNum];
+		idEntity *ent = gameLocal.entities[entNum];
+		if (!ent || !ent->IsType(idAI::Type))
+			continue;
+
+		int waiting = -1;
+		if (entNum < pendingIndex.Num() && pendingIndex[entNum] >= 0)
+			waiting = gameLocal.time - pending[pendingIndex[entNum]].requestTime;
+		if (st.numScans == 0 && waiting < 0)
+			continue;
+
+		common->Printf("%-32s %8d %8d %8.1f %8d %8d %8d\n",
+			ent->name.c_str(), st.numScans, st.numRequests, float(st.sumLatency) / Max(st.numScans, 1),
+			st.maxLatency, st.lastLatency, waiting
+		);
+		worstLatency = Max(worstLatency, Max(st.maxLatency, waiting));
+	}
+	common->Printf("Worst latency: %d ms\n", worstLatency);
+}
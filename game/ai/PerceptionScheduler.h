@@ -0,0 +1,73 @@
+/*****************************************************************************
+The Dark Mod GPL Source Code
+
+This file is part of the The Dark Mod Source Code, originally based
+on the Doom 3 GPL Source Code as published in 2011.
+
+The Dark Mod Source Code is free software: you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version. For details, see LICENSE.TXT.
+
+Project: The Dark Mod (http://www.thedarkmod.com/)
+
+******************************************************************************/
+#pragma once
+
+class idAI;
+
+// time-sliced scheduler for AI visual perception.
+// AI request visual scans while thinking, but expensive part (visibility traces, lighting)
+// is executed after all entities have thought, most urgent requests first,
+// until per-frame time budget is exhausted. The rest is carried over to next frames.
+class PerceptionScheduler {
+public:
+	// drops all pending requests and statistics
+	void Clear();
+
+	// called by AI instead of performing visual scan immediately
+	// repeated requests of the same AI are merged until it is executed
+	void RequestVisualScan(idAI *ai);
+
+	// removes pending request of the AI, because it is going to scan right now
+	// returns number of merged requests it stood for (0 if there was none)
+	int TakeRequest(idAI *ai);
+
+	// drops pending work and statistics of the AI (e.g. when it is destroyed)
+	void Forget(idAI *ai);
+
+	// executes pending requests within budget
+	// must be called once per frame after entities think
+	void Think();
+
+	// prints perception latency of every AI to console
+	void PrintStats() const;
+
+private:
+	struct Request {
+		idEntityPtr<idAI> ai;
+		int requestTime = 0;		// game time when first unserved request was issued
+		int numRequests = 0;		// how many scans are merged into this request
+		float priority = 0.0f;
+	};
+	struct LatencyStats {
+		int numScans = 0;			// executed requests
+		int numRequests = 0;		// merged requests (>= numScans)
+		int sumLatency = 0;			// in milliseconds of game time
+		int maxLatency = 0;
+		int lastLatency = 0;
+	};
+
+	float ComputePriority(idAI *ai, int waitTime, const idVec3 &viewerPos) const;
+
+	idList<Request> pending;
+	idList<int> pendingIndex;		// entity number -> index in pending (-1 if none)
+	idList<Request> batch;			// requests being executed by Think
+	idList<int> batchIndex;			// entity number -> index in batch (-1 if none or already executed)
+	idList<LatencyStats> stats;		// indexed by entity number
+
+	// last frame
+	int frameExecuted = 0;
+	int frameDeferred = 0;
+	double frameMilliseconds = 0.0;
+};
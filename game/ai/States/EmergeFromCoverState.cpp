@@ -62,7 +62,7 @@ void EmergeFromCoverState::Think(idAI* owner)
 	Memory& memory = owner->GetMemory();
 
 	// Let the AI check its senses
-	owner->PerformVisualScan();
+	owner->PerformVisualScanImmediately();
 
 	// grayman #3507 - if alerted, drop back to Combat
 	if (owner->AI_ALERTED && owner->AI_ENEMY_VISIBLE)
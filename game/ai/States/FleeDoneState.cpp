@@ -110,7 +110,7 @@ void FleeDoneState::Think(idAI* owner)
 	}
 
 	// Let the AI check its senses
-	owner->PerformVisualScan();
+	owner->PerformVisualScanImmediately();
 	if (owner->AI_ALERTED)
 	{
 		// terminate FleeDoneState when the AI is alerted
@@ -167,7 +167,7 @@ void HitByMoveableState::Think(idAI* owner)
 		return;
 	}
 
-	owner->PerformVisualScan();	// Let the AI check its senses
+	owner->PerformVisualScanImmediately();	// Let the AI check its senses
 	if (owner->AI_AlertLevel >= owner->thresh_5) // finished if alert level is too high
 	{
 		Wrapup(owner);
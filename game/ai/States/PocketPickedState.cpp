@@ -73,7 +73,8 @@ void PocketPickedState::Init(idAI* owner)
 // Gets called each time the mind is thinking
 void PocketPickedState::Think(idAI* owner)
 {
-	owner->PerformVisualScan();	// Let the AI check its senses
+	// Let the AI check its senses: alert index is checked right below
+	owner->PerformVisualScanImmediately();
 
 	// Check conditions for continuing.
 	
@@ -38,6 +38,25 @@ darkModLAS LAS;
 
 //----------------------------------------------------------------------------
 
+// conservative bounds of point light volume, which is centered at origin + light_center
+// (same as ellipsoid in IntersectLineEllipsoid)
+// radius vector is used as a whole, so that rotated lights are covered too
+static void UpdateLightBounds( darkModLightRecord_t* p_LASLight )
+{
+	idLight* light = p_LASLight->p_idLight;
+	if ( !light->IsPointlight() )
+	{
+		p_LASLight->lightBounds.Clear();
+		return;
+	}
+	idVec3 origin, radius, center;
+	light->GetLightCone( origin, radius, center );
+	float extent = radius.Length() + 1.0f;
+	p_LASLight->lightBounds = idBounds( origin + center ).Expand( extent );
+}
+
+//----------------------------------------------------------------------------
+
 bool darkModLAS::Disabled() const
 {
 	return g_lightQuotientAlgo.GetInteger() == 2;
@@ -51,6 +70,7 @@ darkModLAS::darkModLAS()
 	// No areas
 	m_numAreas = 0;
 	m_pp_areaLightLists = NULL;
+	m_lightPathCacheFrame = -1;
 
 	INIT_TIMER_HANDLE(queryLightingAlongLineTimer);
 }
@@ -144,6 +164,7 @@ void darkModLAS::Restore(idRestoreGame *savefile)
 			savefile->ReadInt(p_record->areaIndex);
 			savefile->ReadVec3(p_record->lastWorldPos);
 			savefile->ReadUnsignedInt(p_record->lastFrameUpdated);
+			UpdateLightBounds(p_record);
 
 			if (m_pp_areaLightLists[i] != NULL)
 			{
@@ -326,26 +347,347 @@ bool darkModLAS::traceLightPath( idVec3 from, idVec3 to, idEntity* ignore, idLig
 
 //----------------------------------------------------------------------------
 
-void darkModLAS::accumulateEffectOfLightsInArea 
-( 
+bool darkModLAS::lightPathReaches( const idVec3 &from, const idVec3 &to, idEntity* ignore, idLight* light )
+{
+	float cellSize = cv_las_traceCacheCell.GetFloat();
+	if ( cellSize < 0.0f )
+	{
+		return traceLightPath( from, to, ignore, light );
+	}
+	// zero cell size: only reuse traces from exactly the same point
+	bool exact = ( cellSize == 0.0f );
+
+	// cached results are valid for one game frame
+	if ( m_lightPathCacheFrame != gameLocal.framenum )
+	{
+		m_lightPathCacheFrame = gameLocal.framenum;
+		m_lightPathCache.Clear();
+		m_lightPathHash.Clear();
+	}
+
+	lightPathCacheEntry_t key;
+	key.lightNum = light->entityNumber;
+	key.ignoreNum = ( ignore ? ignore->entityNumber : -1 );
+	for ( int i = 0; i < 3; i++ )
+	{
+		key.cell[i] = idMath::FtoiTrunc( idMath::Floor( exact ? from[i] : from[i] / cellSize ) );
+	}
+	key.point = ( exact ? from : vec3_zero );
+	key.lightOrigin = to;
+
+	int hash = m_lightPathHash.GenerateKey( key.cell[0] * 73856093 ^ key.cell[1] * 19349663 ^ key.cell[2] * 83492791, key.lightNum );
+	for ( int i = m_lightPathHash.First( hash ); i != -1; i = m_lightPathHash.Next( i ) )
+	{
+		const lightPathCacheEntry_t &entry = m_lightPathCache[i];
+		if ( entry.lightNum == key.lightNum && entry.ignoreNum == key.ignoreNum &&
+			entry.cell[0] == key.cell[0] && entry.cell[1] == key.cell[1] && entry.cell[2] == key.cell[2] &&
+			entry.point == key.point && entry.lightOrigin == key.lightOrigin )
+		{
+			return entry.reaches;
+		}
+	}
+
+	key.reaches = traceLightPath( from, to, ignore, light );
+	m_lightPathHash.Add( hash, m_lightPathCache.Append( key ) );
+	return key.reaches;
+}
+
+//----------------------------------------------------------------------------
+
+float darkModLAS::computeIllumination( idLight* light, const idVec3 &vLight, const idVec3 &p_illumination )
+{
+	// Compute illumination value
+	// We want the illumination at p_illumination.
+
+	float fx, fy;
+
+	if ( light->IsPointlight() )
+	{
+		fx = p_illumination.x - vLight.x;
+		fy = p_illumination.y - vLight.y;
+
+		// ELA_AXIS contains the radii [x,y,z]
+	}
+	else // projected light
+	{
+		// p_illumination needs to be relative to the vector
+		// from the light origin to the light target. Since the
+		// original code assumed that vector pointed down along
+		// the z axis, we'll rotate the target vector to that axis
+		// and apply the same rotation to p_illumination so it stays
+		// relative.
+
+		// Re-get the light cone parameters, some of which were clobbered in IntersectLineLightCone().
+		idVec3 vLightCone[ELC_COUNT];
+		light->GetLightCone(vLightCone[ELC_ORIGIN], vLightCone[ELA_TARGET], vLightCone[ELA_RIGHT], vLightCone[ELA_UP], vLightCone[ELA_START], vLightCone[ELA_END]);
+		idVec3 target = vLightCone[ELA_TARGET]; // direction of light cone, already relative to vLight
+
+		// TODO: need to map p_illumination[x,y] to p_illumination[right,up]
+		// then right is the new x and up is the new y
+
+		if ( ( target.x == 0 ) && ( target.y == 0 ) ) // transform only if 'target' is not already on the z axis
+		{
+			fx = p_illumination.x - vLight.x;
+			fy = p_illumination.y - vLight.y;
+		}
+		else
+		{
+			idVec3 p = p_illumination - vLight; // p is now p_illumination relative to the light origin
+
+			// Matrices and steps are from http://inside.mines.edu/fs_home/gmurray/ArbitraryAxisRotation/
+
+			// rotate 'target' to XY plane
+			idVec2 target2 = target.ToVec2();
+			float d = target2.LengthFast();
+			float a = target.x/d;
+			float b = target.y/d;
+			idMat4 T1( idVec4(  a, b, 0, 0 ),
+					   idVec4( -b, a, 0, 0 ),
+					   idVec4(  0, 0, 1, 0 ),
+					   idVec4(  0, 0, 0, 1 ) );
+			idVec3 target_xy = T1*target; // the 'target' vector rotated to the XY plane
+
+			// rotate 'target_xy' to the Z axis
+			float c = target.LengthFast();
+			float e = target.z/c;
+			float f = d/c;
+			idMat4 T2( idVec4(  e, 0, -f, 0 ),
+					   idVec4(  0, 1,  0, 0 ),
+					   idVec4(  f, 0,  e, 0 ),
+					   idVec4(  0, 0,  0, 1 ) );
+			idVec3 target_z = -(T2*target_xy);
+
+			// apply T1 and T2 to p
+			idVec3 p_z = -(T2*(T1*p));
+			fx = p_z.x;
+			fy = p_z.y;
+		}
+	}
+
+	float illumination = light->GetDistanceColor( (p_illumination - vLight).LengthFast(), fx, fy );
+	DM_LOG(LC_LIGHT, LT_DEBUG)LOGSTRING
+	(
+		"%s in x/y: %f/%f   Distance: %f/%f   Brightness: %f\r",
+		light->name.c_str(),
+		fx,
+		fy,
+		(p_illumination - vLight).LengthFast(),
+		light->m_MaxLightRadius,
+		illumination
+	);
+	return illumination;
+}
+
+//----------------------------------------------------------------------------
+
+void darkModLAS::accumulateEffectOfLight
+(
 	float& inout_totalIllumination,
-	int areaIndex, 
-	idVec3 testPoint1,
-	idVec3 testPoint2,
-	idEntity* p_ignoredEntity,
+	idList<darkModLightPath_t>& inout_lightPaths,
+	idLight* light,
+	const idVec3 &testPoint1,
+	const idVec3 &testPoint2,
 	bool b_useShadows
 )
 {
-	/*
-	* Note most of this code is adopted from SparHawk's lightgem alpha code.
-	* And then heavily modified by grayman.
+	/*!
+	// What follows in the rest of this method is mostly Sparkhawk's lightgem code.
+	// grayman #3584 - though by this point, it probably no longer looks like that
+	// code, given the number of things that needed to be fixed.
 	*/
 
+	idVec3 vLightCone[ELC_COUNT]; // Holds data on the light shape (point ellipsoid or projected cone).
+	idVec3 vLight; // The real origin of the light (origin + offset).
+	EIntersection inter;
+	idVec3 vResult[2]; // If there's an intersection, [0] holds one point, [1] holds a second
+	bool inside[LSG_COUNT]; // inside[0] is true if testPoint1 is inside the light volume, inside[1] ditto for testPoint2
+
 	// Set up target segment: Origin and Delta
 	idVec3 vTargetSeg[LSG_COUNT];
 	vTargetSeg[0] = testPoint1;
 	vTargetSeg[1] = testPoint2 - testPoint1;
 
+	if ( light->IsPointlight() )
+	{
+		light->GetLightCone
+		(
+			vLightCone[ELL_ORIGIN],
+			vLightCone[ELA_AXIS],
+			vLightCone[ELA_CENTER]
+		);
+
+		// If this is a centerlight we have to move the origin from the original origin to where the
+		// center of the light is supposed to be.
+		// Centerlight means that the center of the ellipsoid is not the same as the origin. It has to
+		// be adjusted because if it casts shadows we have to trace to it, and in this case the light
+		// might be inside geometry and would be reported as not being visible even though it casts
+		// a visible light outside the geometry it is embedded in. If it is not a centerlight and has
+		// cast shadows enabled, it wouldn't cast any light at all in such a case because it would
+		// be blocked by the geometry.
+
+		vLight = vLightCone[ELL_ORIGIN] + vLightCone[ELA_CENTER];
+
+		// grayman #3584 - IntersectLineEllipsoid() provides no information on whether
+		// the line segment ends are inside or outside the ellipsoid. Let's use
+		// IntersectLinesegmentLightEllipsoid() to get that information.
+
+		inter = IntersectLinesegmentLightEllipsoid(	vTargetSeg, vLightCone, vResult, inside	);
+
+		DM_LOG(LC_LIGHT, LT_DEBUG)LOGSTRING("IntersectLinesegmentLightEllipsoid() returned %u\r", inter);
+	}
+	else // projected light
+	{
+		light->GetLightCone(vLightCone[ELC_ORIGIN], vLightCone[ELA_TARGET], vLightCone[ELA_RIGHT], vLightCone[ELA_UP], vLightCone[ELA_START], vLightCone[ELA_END]);
+		inter = IntersectLineLightCone(vTargetSeg, vLightCone, vResult, inside);
+		vLight = vLightCone[ELC_ORIGIN]; // grayman #3524
+		DM_LOG(LC_LIGHT, LT_DEBUG)LOGSTRING("IntersectLineLightCone returned %u\r", inter);
+	}
+
+	// The line intersection returns one of four states. Either the line is entirely inside
+	// the light cone (inter = INTERSECT_NONE), it's passing through the lightcone (inter = INTERSECT_FULL), the line
+	// is not passing through which means that the test line is fully outside (inter = INTERSECT_OUTSIDE), or the line
+	// is touching the cone in exactly one point (inter = INTERSECT_PARTIAL).
+
+	if ( inter == INTERSECT_OUTSIDE ) // grayman #3584 - exclude the uninteresting case
+	{
+		return;
+	}
+	if ( ( inter == INTERSECT_PARTIAL ) && !inside[0] && !inside[1] )
+	{
+		// both line ends outside, line touches volume at one intersection point
+		// Since the only point we can test is at the edge of the light volume,
+		// we can safely assume the illumination there is zero.
+		return;
+	}
+
+	// grayman #3584 - the two points chosen for raytracing should be inside the light cone.
+	// There are a few cases:
+
+	// 1 - INTERSECT_NONE - Both ends of the line segment (testPoint1 and testPoint2) are inside the
+	//     light cone, and should be tested for both visibility and illumination.
+	//     Determine a third point, testPoint3, which is the midpoint between them.
+	//
+	//     a - If testPoint1 is visible from the light origin, use testPoint3 to determine illumination.
+	//     b - If testPoint1 is not visible, move on to testPoint2. If testPoint2
+	//         is visible from the light origin, use testPoint3 to determine illumination.
+	//     c - If neither testPoint1 or testPoint2 is visible, move on to testPoint3.
+	//         If testPoint3 is visible from the light origin, use it to determine illumination.
+	//     d - If none of these points is visible from the light origin, exclude the light.
+	//
+	// 2 - INTERSECT_PARTIAL - One end of the line segment (either testPoint1 or testPoint2) is inside the
+	//     light cone, and the second point is the point of intersection with the line cone
+	//     that lies on the line segment. Make the third point, testPoint3, the midpoint between the
+	//     first two.
+	//
+	//     a - Let p1 be whichever of testPoint1 and testPoint2 is inside the light cone. It it's
+	//         visible from the light origin, use it to determine illumination.
+	//     b - If 'a' fails, move on to the point of intersection. If it's visible from the light
+	//         origin, use testPoint3 to determine illumination.
+	//     c - If 'b' fails, move on to testPoint3. If testPoint3 is visible from the light origin, use it
+	//         to determine illumination.
+	//     d - If none of these points is visible from the light origin, exclude the light.
+	//
+	// 3 - INTERSECT_FULL - Both ends of the line segment lie outside the light cone. Treat the first intersection
+	//     point as testPoint1, the second intersection point as testPoint2, and the midpoint
+	//     between them as testPoint3.
+	//
+	//     a - If testPoint1 is visible from the light origin, use testPoint3 to determine illumination.
+	//     b - If testPoint1 is not visible, move on to testPoint2. If testPoint2
+	//         is visible from the light origin, use testPoint3 to determine illumination.
+	//     c - If neither testPoint1 or testPoint2 is visible, move on to testPoint3.
+	//         If testPoint3 is visible from the light origin, use it to determine illumination.
+	//     d - If none of these points is visible from the light origin, exclude the light.
+	//
+
+	idVec3 p1, p2, p3; // test points for testing visibility to light source
+	idVec3 p_illumination; // point where we determine illumination if p1 is visible
+
+	if ( inter == INTERSECT_NONE ) // the line segment is entirely inside the light volume
+	{
+		p1 = testPoint1;
+		p2 = testPoint2;
+		p3 = (testPoint1 + testPoint2)/2.0f;
+		p_illumination = p3;
+	}
+	else if ( inter == INTERSECT_PARTIAL ) // one line end inside, one outside
+	{
+		// either testPoint1 or testPoint2 is inside the ellipsoid
+		if ( inside[0] )
+		{
+			p1 = testPoint1;
+		}
+		else
+		{
+			p1 = testPoint2;
+		}
+
+		p2 = vResult[0]; // the single point of intersection
+		p3 = (p1 + p2)/2.0f;
+		p_illumination = p1;
+	}
+	else // INTERSECT_FULL
+	{
+		p1 = vResult[0]; // the first point of intersection
+		p2 = vResult[1]; // the second point of intersection
+		p3 = (p1 + p2)/2.0f;
+		p_illumination = p3;
+	}
+
+	if ( !b_useShadows || !light->CastsShadow() )
+	{
+		// no shadows, so assume visibility between the light origin and the point of illumination
+		inout_totalIllumination += computeIllumination( light, vLight, p_illumination );
+		return;
+	}
+
+	// grayman #2853 - If the trace hits something before completing, that thing has to be checked to see if
+	// it casts shadows. If it doesn't, then it has to be ignored and the trace must be run again from the struck
+	// point to the end. This has to be done iteratively, since there might be several non-shadow-casting entities
+	// in the way. For example, a candleflame in a candle in a chandelier, and the latter two are marked with 'noshadows'.
+	// Light holders must also be taken into account, since the holder entity in DR can be marked 'noshadows', which
+	// also applies to the candle holding the flame.
+
+	// the traces are postponed until all lights of the query are collected
+	darkModLightPath_t path;
+	path.light = light;
+	path.lightOrigin = vLight;
+	path.points[0] = p1;
+	path.points[1] = p2;
+	path.points[2] = p3;
+	path.illumFirst = computeIllumination( light, vLight, p_illumination );
+	path.illumOther = ( p_illumination == p3 ? path.illumFirst : computeIllumination( light, vLight, p3 ) );
+	inout_lightPaths.Append( path );
+}
+
+//----------------------------------------------------------------------------
+
+bool darkModLAS::lightMayReachSegment( const darkModLightRecord_t* p_LASLight, const idVec3 &testPoint1, const idVec3 &testPoint2 ) const
+{
+	if ( p_LASLight->lightBounds.IsCleared() )
+	{
+		// no bounds for projected lights
+		return true;
+	}
+	return p_LASLight->lightBounds.LineIntersection( testPoint1, testPoint2 );
+}
+
+//----------------------------------------------------------------------------
+
+void darkModLAS::accumulateEffectOfLightsInArea
+(
+	float& inout_totalIllumination,
+	idList<darkModLightPath_t>& inout_lightPaths,
+	int areaIndex,
+	idVec3 testPoint1,
+	idVec3 testPoint2,
+	bool b_useShadows
+)
+{
+	/*
+	* Note most of this code is adopted from SparHawk's lightgem alpha code.
+	* And then heavily modified by grayman.
+	*/
+
 	if (cv_las_showtraces.GetBool())
 	{
 		gameRenderWorld->DebugArrow(colorBlue, testPoint1, testPoint2, 2, 1000);
@@ -361,7 +703,7 @@ void darkModLAS::accumulateEffectOfLightsInArea
 	inout_totalIllumination += gameLocal.GetAmbientIllumination(testPoint1);
 	*/
 	// Iterate lights in this area
-	while (p_cursor != NULL)
+	for ( ; p_cursor != NULL ; p_cursor = p_cursor->NextNode() )
 	{
 		// Get the light to be tested
 		darkModLightRecord_t* p_LASLight = p_cursor->Owner();
@@ -379,7 +721,7 @@ void darkModLAS::accumulateEffectOfLightsInArea
 
 		DM_LOG(LC_LIGHT, LT_DEBUG)LOGSTRING
 		(
-			"accumulateEffectOfLightsInArea (area = %d): accounting for light '%s'.\r", 
+			"accumulateEffectOfLightsInArea (area = %d): accounting for light '%s'.\r",
 			areaIndex,
 			light->name.c_str()
 		);
@@ -388,8 +730,6 @@ void darkModLAS::accumulateEffectOfLightsInArea
 
 		if ( light->GetLightLevel() == 0 )
 		{
-			// Iterate to next light in area
-			p_cursor = p_cursor->NextNode();
 			continue;
 		}
 
@@ -397,381 +737,25 @@ void darkModLAS::accumulateEffectOfLightsInArea
 		// SteveL  #4128 - let mapper use lights that ai can't see.
 		if ( light->IsBlend() || light->IsFog() || !light->IsSeenByAI() )
 		{
-			// Iterate to next light in area
-			p_cursor = p_cursor->NextNode();
 			continue;
 		}
 
-		/*!
-		// What follows in the rest of this method is mostly Sparkhawk's lightgem code.
-		// grayman #3584 - though by this point, it probably no longer looks like that
-		// code, given the number of things that needed to be fixed.
-		*/
-
-		idVec3 vLightCone[ELC_COUNT]; // Holds data on the light shape (point ellipsoid or projected cone).
-		idVec3 vLight; // The real origin of the light (origin + offset).
-		EIntersection inter;
-		idVec3 vResult[2]; // If there's an intersection, [0] holds one point, [1] holds a second
-		bool inside[LSG_COUNT]; // inside[0] is true if testPoint1 is inside the light volume, inside[1] ditto for testPoint2
-		bool b_excludeLight = false;
-		idVec3 p1, p2, p3; // test points for testing visibility to light source
-		idVec3 p_illumination; // point where we determine illumination
-
-		if ( light->IsPointlight() )
-		{
-			light->GetLightCone
-			(
-				vLightCone[ELL_ORIGIN], 
-				vLightCone[ELA_AXIS], 
-				vLightCone[ELA_CENTER]
-			);
-
-			// If this is a centerlight we have to move the origin from the original origin to where the
-			// center of the light is supposed to be.
-			// Centerlight means that the center of the ellipsoid is not the same as the origin. It has to
-			// be adjusted because if it casts shadows we have to trace to it, and in this case the light
-			// might be inside geometry and would be reported as not being visible even though it casts
-			// a visible light outside the geometry it is embedded in. If it is not a centerlight and has
-			// cast shadows enabled, it wouldn't cast any light at all in such a case because it would
-			// be blocked by the geometry.
-
-			vLight = vLightCone[ELL_ORIGIN] + vLightCone[ELA_CENTER];
-
-			// grayman #3584 - IntersectLineEllipsoid() provides no information on whether
-			// the line segment ends are inside or outside the ellipsoid. Let's use
-			// IntersectLinesegmentLightEllipsoid() to get that information.
-
-			inter = IntersectLinesegmentLightEllipsoid(	vTargetSeg, vLightCone, vResult, inside	);
-			//inter = IntersectLineEllipsoid(	vTargetSeg, vLightCone, vResult	);
-
-			DM_LOG(LC_LIGHT, LT_DEBUG)LOGSTRING("IntersectLinesegmentLightEllipsoid() returned %u\r", inter);
-		}
-		else // projected light
-		{
-			light->GetLightCone(vLightCone[ELC_ORIGIN], vLightCone[ELA_TARGET], vLightCone[ELA_RIGHT], vLightCone[ELA_UP], vLightCone[ELA_START], vLightCone[ELA_END]);
-			inter = IntersectLineLightCone(vTargetSeg, vLightCone, vResult, inside);
-			vLight = vLightCone[ELC_ORIGIN]; // grayman #3524
-			DM_LOG(LC_LIGHT, LT_DEBUG)LOGSTRING("IntersectLineLightCone returned %u\r", inter);
-		}
-
-		// The line intersection returns one of four states. Either the line is entirely inside
-		// the light cone (inter = INTERSECT_NONE), it's passing through the lightcone (inter = INTERSECT_FULL), the line
-		// is not passing through which means that the test line is fully outside (inter = INTERSECT_OUTSIDE), or the line
-		// is touching the cone in exactly one point (inter = INTERSECT_PARTIAL).
-
-		if ( inter == INTERSECT_OUTSIDE ) // grayman #3584 - exclude the uninteresting case
-		//if ( ( inter == INTERSECT_PARTIAL ) || ( inter == INTERSECT_OUTSIDE) ) // grayman #2853 - exclude the two uninteresting cases
+		// cheap rejection of lights which are far away
+		if ( !lightMayReachSegment( p_LASLight, testPoint1, testPoint2 ) )
 		{
-			b_excludeLight = true;
-		}
-		else
-		{
-			// grayman #3584 - the two points chosen for raytracing should be inside the light cone.
-			// There are a few cases:
-
-			// 1 - INTERSECT_NONE - Both ends of the line segment (testPoint1 and testPoint2) are inside the
-			//     light cone, and should be tested for both visibility and illumination.
-			//     Determine a third point, testPoint3, which is the midpoint between them.
-			//
-			//     a - If testPoint1 is visible from the light origin, use testPoint3 to determine illumination.
-			//     b - If testPoint1 is not visible, move on to testPoint2. If testPoint2
-			//         is visible from the light origin, use testPoint3 to determine illumination.
-			//     c - If neither testPoint1 or testPoint2 is visible, move on to testPoint3.
-			//         If testPoint3 is visible from the light origin, use it to determine illumination.
-			//     d - If none of these points is visible from the light origin, exclude the light.
-			//
-			// 2 - INTERSECT_PARTIAL - One end of the line segment (either testPoint1 or testPoint2) is inside the
-			//     light cone, and the second point is the point of intersection with the line cone
-			//     that lies on the line segment. Make the third point, testPoint3, the midpoint between the
-			//     first two.
-			//
-			//     a - Let p1 be whichever of testPoint1 and testPoint2 is inside the light cone. It it's
-			//         visible from the light origin, use it to determine illumination.
-			//     b - If 'a' fails, move on to the point of intersection. If it's visible from the light
-			//         origin, use testPoint3 to determine illumination.
-			//     c - If 'b' fails, move on to testPoint3. If testPoint3 is visible from the light origin, use it
-			//         to determine illumination.
-			//     d - If none of these points is visible from the light origin, exclude the light.
-			//
-			// 3 - INTERSECT_FULL - Both ends of the line segment lie outside the light cone. Treat the first intersection
-			//     point as testPoint1, the second intersection point as testPoint2, and the midpoint
-			//     between them as testPoint3.
-			//
-			//     a - If testPoint1 is visible from the light origin, use testPoint3 to determine illumination.
-			//     b - If testPoint1 is not visible, move on to testPoint2. If testPoint2
-			//         is visible from the light origin, use testPoint3 to determine illumination.
-			//     c - If neither testPoint1 or testPoint2 is visible, move on to testPoint3.
-			//         If testPoint3 is visible from the light origin, use it to determine illumination.
-			//     d - If none of these points is visible from the light origin, exclude the light.
-			//
-
-			if (b_useShadows && light->CastsShadow()) 
-			{
-				// grayman #2853 - If the trace hits something before completing, that thing has to be checked to see if
-				// it casts shadows. If it doesn't, then it has to be ignored and the trace must be run again from the struck
-				// point to the end. This has to be done iteratively, since there might be several non-shadow-casting entities
-				// in the way. For example, a candleflame in a candle in a chandelier, and the latter two are marked with 'noshadows'.
-				// Light holders must also be taken into account, since the holder entity in DR can be marked 'noshadows', which
-				// also applies to the candle holding the flame.
-
-				bool lightReaches;
-
-				if ( inter == INTERSECT_NONE ) // the line segment is entirely inside the light volume
-				{
-					p3 = (testPoint1 + testPoint2)/2.0f;
-					lightReaches = traceLightPath( testPoint1, vLight, p_ignoredEntity, light );
-					if ( !lightReaches )
-					{
-						lightReaches = traceLightPath( testPoint2, vLight, p_ignoredEntity, light );
-						if ( !lightReaches )
-						{
-							lightReaches = traceLightPath( p3, vLight, p_ignoredEntity, light );
-						}
-					}
-					p_illumination = p3;
-				}
-				else if ( ( inter == INTERSECT_PARTIAL ) && ( inside[0] || inside[1] ) ) // one line end inside, one outside
-				{
-					// either testPoint1 or testPoint2 is inside the ellipsoid
-					if ( inside[0] )
-					{
-						p1 = testPoint1;
-					}
-					else
-					{
-						p1 = testPoint2;
-					}
-
-					p2 = vResult[0]; // the single point of intersection
-					p3 = (p1 + p2)/2.0f;
-					lightReaches = traceLightPath( p1, vLight, p_ignoredEntity, light );
-					if ( lightReaches )
-					{
-						p_illumination = p1;
-					}
-					else
-					{
-						p_illumination = p3;
-						lightReaches = traceLightPath( p2, vLight, p_ignoredEntity, light );
-						if ( !lightReaches )
-						{
-							lightReaches = traceLightPath( p3, vLight, p_ignoredEntity, light );
-						}
-					}
-				}
-				else if ( inter == INTERSECT_PARTIAL ) // both line ends outside, line touches volume at one intersection point
-				{
-					// Since the only point we can test is at the edge of the light volume,
-					// we can safely assume the illumination there is zero. No need to test
-					// LOS to the light origin or determine brightness.
-					lightReaches = false;
-				}
-				else // INTERSECT_FULL
-				{
-					p1 = vResult[0]; // the first point of intersection
-					p2 = vResult[1]; // the second point of intersection
-					p3 = (p1 + p2)/2.0f;
-					p_illumination = p3;
-					lightReaches = traceLightPath( p1, vLight, p_ignoredEntity, light );
-					if ( !lightReaches )
-					{
-						lightReaches = traceLightPath( p2, vLight, p_ignoredEntity, light );
-						if ( !lightReaches )
-						{
-							lightReaches = traceLightPath( p3, vLight, p_ignoredEntity, light );
-						}
-					}
-				}
-				
-				b_excludeLight = !lightReaches;
-
-				// end of new code
-
-				/* old code
-
-				trace_t trace;
-				gameLocal.clip.TracePoint(trace, testPoint1, p_LASLight->lastWorldPos, CONTENTS_OPAQUE, p_ignoredEntity);
-				if ( cv_las_showtraces.GetBool() )
-				{
-					gameRenderWorld->DebugArrow(
-							trace.fraction == 1 ? colorGreen : colorRed, 
-							trace.fraction == 1 ? testPoint1 : trace.endpos, 
-							p_LASLight->lastWorldPos, 1, 1000);
-				}
-				DM_LOG(LC_LIGHT, LT_DEBUG)LOGSTRING("TraceFraction: %f\r", trace.fraction);
-				if ( trace.fraction < 1.0f )
-				{
-					gameLocal.clip.TracePoint (trace, testPoint2, p_LASLight->lastWorldPos, CONTENTS_OPAQUE, p_ignoredEntity);
-					if (cv_las_showtraces.GetBool())
-					{
-						gameRenderWorld->DebugArrow(
-							trace.fraction == 1 ? colorGreen : colorRed, 
-							trace.fraction == 1 ? testPoint2 : trace.endpos, 
-							p_LASLight->lastWorldPos, 1, 1000);
-					}
-					DM_LOG(LC_LIGHT, LT_DEBUG)LOGSTRING("TraceFraction: %f\r", trace.fraction);
-					if ( trace.fraction < 1.0f )
-					{
-						DM_LOG(LC_LIGHT, LT_DEBUG)LOGSTRING("Light [%s]: test point is in a shadow of the light\r", light->name.c_str());
-						b_excludeLight = true;
-					}
-				}
-				*/
-			}
-			else // no shadows, so assume visibility between the light origin and the point of illumination
-			{
-				if ( inter == INTERSECT_NONE ) // the line segment is entirely inside the light volume
-				{
-					p_illumination = (testPoint1 + testPoint2)/2.0f;
-				}
-				else if ( ( inter == INTERSECT_PARTIAL ) && ( inside[0] || inside[1] ) ) // one line end inside, one outside
-				{
-					// either testPoint1 or testPoint2 is inside the ellipsoid
-					if ( inside[0] )
-					{
-						p_illumination = testPoint1;
-					}
-					else
-					{
-						p_illumination = testPoint2;
-					}
-				}
-				else if ( inter == INTERSECT_PARTIAL ) // both line ends outside, line touches volume at one intersection point
-				{
-					b_excludeLight = true; // not interested in this case, since illumination is zero at the volume edges
-				}
-				else // INTERSECT_FULL
-				{
-					p_illumination = (vResult[0] + vResult[1])/2.0f; // halfway between the points of intersection
-				}
-			}
-		}
-
-		// Process light if not excluded
-		if (!b_excludeLight)
-		{
-			// Compute illumination value
-			// We want the illumination at p_illumination.
-
-			float fx, fy;
-
-			if ( light->IsPointlight() )
-			{
-				fx = p_illumination.x - vLight.x;
-				fy = p_illumination.y - vLight.y;
-
-				// ELA_AXIS contains the radii [x,y,z]
-			}
-			else // projected light
-			{
-				// p_illumination needs to be relative to the vector
-				// from the light origin to the light target. Since the
-				// original code assumed that vector pointed down along
-				// the z axis, we'll rotate the target vector to that axis
-				// and apply the same rotation to p_illumination so it stays
-				// relative.
-
-				// Re-get the light cone parameters, some of which were clobbered in IntersectLineLightCone().
-				light->GetLightCone(vLightCone[ELC_ORIGIN], vLightCone[ELA_TARGET], vLightCone[ELA_RIGHT], vLightCone[ELA_UP], vLightCone[ELA_START], vLightCone[ELA_END]);
-				idVec3 target = vLightCone[ELA_TARGET]; // direction of light cone, already relative to vLight
-
-				// TODO: need to map p_illumination[x,y] to p_illumination[right,up]
-				// then right is the new x and up is the new y
-
-				if ( ( target.x == 0 ) && ( target.y == 0 ) ) // transform only if 'target' is not already on the z axis
-				{
-					fx = p_illumination.x - vLight.x;
-					fy = p_illumination.y - vLight.y;
-				}
-				else
-				{
-					idVec3 p = p_illumination - vLight; // p is now p_illumination relative to the light origin
-
-					// Matrices and steps are from http://inside.mines.edu/fs_home/gmurray/ArbitraryAxisRotation/
-
-					// rotate 'target' to XY plane
-					idVec2 target2 = target.ToVec2();
-					float d = target2.LengthFast();
-					float a = target.x/d;
-					float b = target.y/d;
-					idMat4 T1( idVec4(  a, b, 0, 0 ),
-							   idVec4( -b, a, 0, 0 ),
-							   idVec4(  0, 0, 1, 0 ),
-							   idVec4(  0, 0, 0, 1 ) );
-					idVec3 target_xy = T1*target; // the 'target' vector rotated to the XY plane
-
-					// rotate 'target_xy' to the Z axis
-					float c = target.LengthFast();
-					float e = target.z/c;
-					float f = d/c;
-					idMat4 T2( idVec4(  e, 0, -f, 0 ),
-							   idVec4(  0, 1,  0, 0 ),
-							   idVec4(  f, 0,  e, 0 ),
-							   idVec4(  0, 0,  0, 1 ) );
-					idVec3 target_z = -(T2*target_xy);
-
-					// apply T1 and T2 to p
-					idVec3 p_z = -(T2*(T1*p));
-					fx = p_z.x;
-					fy = p_z.y;
-				}
-			}
-
-
-/*			int index;
-			if (vResult[0].z < vResult[1].z)
-			{
-				index = 0;
-			}
-			else
-			{
-				index = 1;
-			}
-
-			if (vResult[index].z < testPoint1.z)
-			{
-				fx = testPoint1.x;
-				fy = testPoint1.y;
-			}
-			else
-			{
-				fx = vResult[index].x;
-				fy = vResult[index].y;
-			}
-*/
-			inout_totalIllumination += light->GetDistanceColor(	(p_illumination - vLight).LengthFast(),fx,fy );
-			DM_LOG(LC_LIGHT, LT_DEBUG)LOGSTRING
-			(
-				"%s in x/y: %f/%f   Distance: %f/%f   Brightness: %f\r",
-				light->name.c_str(), 
-				fx, 
-				fy, 
-				(p_illumination - vLight).LengthFast(), 
-				light->m_MaxLightRadius,
-				inout_totalIllumination
-			);
+			continue;
 		}
 
-		// If total illumination is 1.0 or greater, we are done
-		if (inout_totalIllumination >= 1.0f)
-		{
-			// Exit early as it's really really bright as is
-			p_cursor = NULL;
-		}
-		else
-		{
-			// Iterate to next light in area
-			p_cursor = p_cursor->NextNode();
-		}
+		accumulateEffectOfLight( inout_totalIllumination, inout_lightPaths, light, testPoint1, testPoint2, b_useShadows );
 	}
 }
 
-void darkModLAS::accumulateEffectOfLightsInArea2 
-( 
+void darkModLAS::accumulateEffectOfLightsInArea2
+(
 	float& inout_totalIllumination,
-	int areaIndex, 
+	idList<darkModLightPath_t>& inout_lightPaths,
+	int areaIndex,
 	idBox box,
-	idEntity* p_ignoredEntity,
 	bool b_useShadows
 )
 {
@@ -789,12 +773,14 @@ void darkModLAS::accumulateEffectOfLightsInArea2
 
 	inout_totalIllumination += gameLocal.GetAmbientIllumination(box.GetCenter());
 	*/
-	
+
 	idVec3 verts[8];
 	box.GetVerts(verts);
+	idBounds boxBounds;
+	boxBounds.FromPoints(verts, 8);
 
 	// Iterate lights in this area
-	while (p_cursor != NULL)
+	for ( ; p_cursor != NULL ; p_cursor = p_cursor->NextNode() )
 	{
 		// Get the light to be tested
 		darkModLightRecord_t* p_LASLight = p_cursor->Owner();
@@ -812,7 +798,7 @@ void darkModLAS::accumulateEffectOfLightsInArea2
 
 		DM_LOG(LC_LIGHT, LT_DEBUG)LOGSTRING
 		(
-			"accumulateEffectOfLightsInArea2 (area = %d): accounting for light '%s'.\r", 
+			"accumulateEffectOfLightsInArea2 (area = %d): accounting for light '%s'.\r",
 			areaIndex,
 			light->name.c_str()
 		);
@@ -823,8 +809,6 @@ void darkModLAS::accumulateEffectOfLightsInArea2
 
 		if ( ( light->GetLightLevel() == 0 ) || light->IsAmbient() )
 		{
-			// Iterate to next light in area
-			p_cursor = p_cursor->NextNode();
 			continue;
 		}
 
@@ -832,49 +816,31 @@ void darkModLAS::accumulateEffectOfLightsInArea2
 		// SteveL  #4128 - let mapper use lights that ai can't see too.
 		if ( light->IsBlend() || light->IsFog() || !light->IsSeenByAI() )
 		{
-			// Iterate to next light in area
-			p_cursor = p_cursor->NextNode();
 			continue;
 		}
 
+		// cheap rejection of lights which are far away
+		if ( !p_LASLight->lightBounds.IsCleared() && !p_LASLight->lightBounds.IntersectsBounds( boxBounds ) )
+		{
+			continue;
+		}
 
+		// grayman #3584 - for each corner of the bounding box, determine which 2
+		// are closest to the light center. Use those 2 corners as the ends of the
+		// line segment to be tested.
 
-		// What follows in the rest of this method is mostly Sparkhawk's lightgem code.
-		// grayman #3584 - Though by this point, it probably no longer looks like that
-		// code, given the number of things that needed to be fixed.
-
-		idVec3 vLightCone[ELC_COUNT]; // Holds data on the light shape (point ellipsoid or projected cone).
 		idVec3 vLight; // The real origin of the light (origin + offset).
-		EIntersection inter;
-		idVec3 vResult[2]; // If there's an intersection, [0] holds one point, [1] holds a second
-		bool inside[LSG_COUNT]; // inside[0] is true if testPoint1 is inside the light volume, inside[1] ditto for testPoint2
-		bool b_excludeLight = false;
-		idVec3 p1, p2, p3; // test points for testing visibility to light source
-		idVec3 p_illumination; // point where we determine illumination
-
 		if ( light->IsPointlight() )
 		{
-			light->GetLightCone
-			(
-				vLightCone[ELL_ORIGIN], 
-				vLightCone[ELA_AXIS], 
-				vLightCone[ELA_CENTER]
-			);
-			vLight = vLightCone[ELL_ORIGIN] + vLightCone[ELA_CENTER];
+			idVec3 lightOrigin, lightAxis, lightCenter;
+			light->GetLightCone( lightOrigin, lightAxis, lightCenter );
+			vLight = lightOrigin + lightCenter;
 		}
 		else // projected light
 		{
-			light->GetLightCone(vLightCone[ELC_ORIGIN], vLightCone[ELA_TARGET], vLightCone[ELA_RIGHT], vLightCone[ELA_UP], vLightCone[ELA_START], vLightCone[ELA_END]);
-			vLight = vLightCone[ELC_ORIGIN]; // grayman #3524
+			vLight = light->GetPhysics()->GetOrigin(); // grayman #3524
 		}
 
-		// Set up target segment: Origin and Delta
-		idVec3 vTargetSeg[LSG_COUNT];
-
-		// grayman #3584 - for each corner of the bounding box, determine which 2
-		// are closest to the light center. Use those 2 corners as the ends of the
-		// line segment to be tested.
-
 		idVec3 testPoint1, testPoint2, tempPoint, p;
 		float shortestDistanceSqr(idMath::INFINITY);
 		float nextShortestDistanceSqr(idMath::INFINITY);
@@ -905,291 +871,52 @@ void darkModLAS::accumulateEffectOfLightsInArea2
 
 		// testPoint1 -> testPoint2 is the boundary edge closest to the light center
 
-		vTargetSeg[0] = testPoint1;
-		vTargetSeg[1] = testPoint2 - testPoint1;
-
 		if (cv_las_showtraces.GetBool())
 		{
 			gameRenderWorld->DebugArrow(colorBlue, testPoint1, testPoint2, 2, 1000);
 		}
 
-		if ( light->IsPointlight() )
-		{
-			// If this is a centerlight we have to move the origin from the original origin to where the
-			// center of the light is supposed to be.
-			// Centerlight means that the center of the ellipsoid is not the same as the origin. It has to
-			// be adjusted because if it casts shadows we have to trace to it, and in this case the light
-			// might be inside geometry and would be reported as not being visible even though it casts
-			// a visible light outside the geometry it is embedded in. If it is not a centerlight and has
-			// cast shadows enabled, it wouldn't cast any light at all in such a case because it would
-			// be blocked by the geometry.
-
-			// grayman #3584 - IntersectLineEllipsoid() provides no information on whether
-			// the line segment ends are inside or outside the ellipsoid. Let's use
-			// IntersectLinesegmentLightEllipsoid() to get that information.
-
-			inter = IntersectLinesegmentLightEllipsoid(	vTargetSeg, vLightCone, vResult, inside	);
-
-			DM_LOG(LC_LIGHT, LT_DEBUG)LOGSTRING("IntersectLinesegmentLightEllipsoid() returned %u\r", inter);
-		}
-		else // projected light
-		{
-			inter = IntersectLineLightCone(vTargetSeg, vLightCone, vResult, inside);
-			DM_LOG(LC_LIGHT, LT_DEBUG)LOGSTRING("IntersectLineLightCone returned %u\r", inter);
-		}
-
-		// The line intersection returns one of four states. Either the line is entirely inside
-		// the light cone (inter = INTERSECT_NONE), it's passing through the lightcone (inter = INTERSECT_FULL), the line
-		// is not passing through which means that the test line is fully outside (inter = INTERSECT_OUTSIDE), or the line
-		// is touching the cone in exactly one point (inter = INTERSECT_PARTIAL).
-
-		if ( inter == INTERSECT_OUTSIDE ) // grayman #3584 - exclude the uninteresting case
+		if ( !lightMayReachSegment( p_LASLight, testPoint1, testPoint2 ) )
 		{
-			b_excludeLight = true;
-		}
-		else
-		{
-			// grayman #3584 - the two points chosen for raytracing should be inside the light cone.
-			// There are a few cases:
-
-			// 1 - INTERSECT_NONE - Both ends of the line segment (testPoint1 and testPoint2) are inside the
-			//     light cone, and should be tested for both visibility and illumination.
-			//     Determine a third point, testPoint3, which is the midpoint between them.
-			//
-			//     a - If testPoint1 is visible from the light origin, use testPoint3 to determine illumination.
-			//     b - If testPoint1 is not visible, move on to testPoint2. If testPoint2
-			//         is visible from the light origin, use testPoint3 to determine illumination.
-			//     c - If neither testPoint1 or testPoint2 is visible, move on to testPoint3.
-			//         If testPoint3 is visible from the light origin, use it to determine illumination.
-			//     d - If none of these points is visible from the light origin, exclude the light.
-			//
-			// 2 - INTERSECT_PARTIAL - One end of the line segment (either testPoint1 or testPoint2) is inside the
-			//     light cone, and the second point is the point of intersection with the line cone
-			//     that lies on the line segment. Make the third point, testPoint3, the midpoint between the
-			//     first two.
-			//
-			//     a - Let p1 be whichever of testPoint1 and testPoint2 is inside the light cone. It it's
-			//         visible from the light origin, use it to determine illumination.
-			//     b - If 'a' fails, move on to the point of intersection. If it's visible from the light
-			//         origin, use testPoint3 to determine illumination.
-			//     c - If 'b' fails, move on to testPoint3. If testPoint3 is visible from the light origin, use it
-			//         to determine illumination.
-			//     d - If none of these points is visible from the light origin, exclude the light.
-			//
-			// 3 - INTERSECT_FULL - Both ends of the line segment lie outside the light cone. Treat the first intersection
-			//     point as testPoint1, the second intersection point as testPoint2, and the midpoint
-			//     between them as testPoint3.
-			//
-			//     a - If testPoint1 is visible from the light origin, use testPoint3 to determine illumination.
-			//     b - If testPoint1 is not visible, move on to testPoint2. If testPoint2
-			//         is visible from the light origin, use testPoint3 to determine illumination.
-			//     c - If neither testPoint1 or testPoint2 is visible, move on to testPoint3.
-			//         If testPoint3 is visible from the light origin, use it to determine illumination.
-			//     d - If none of these points is visible from the light origin, exclude the light.
-			//
-
-			if (b_useShadows && light->CastsShadow()) 
-			{
-				// grayman #2853 - If the trace hits something before completing, that thing has to be checked to see if
-				// it casts shadows. If it doesn't, then it has to be ignored and the trace must be run again from the struck
-				// point to the end. This has to be done iteratively, since there might be several non-shadow-casting entities
-				// in the way. For example, a candleflame in a candle in a chandelier, and the latter two are marked with 'noshadows'.
-				// Light holders must also be taken into account, since the holder entity in DR can be marked 'noshadows', which
-				// also applies to the candle holding the flame.
-
-				bool lightReaches;
-
-				if ( inter == INTERSECT_NONE ) // the line segment is entirely inside the light volume
-				{
-					p3 = (testPoint1 + testPoint2)/2.0f;
-					lightReaches = traceLightPath( testPoint1, vLight, p_ignoredEntity, light );
-					if ( !lightReaches )
-					{
-						lightReaches = traceLightPath( testPoint2, vLight, p_ignoredEntity, light );
-						if ( !lightReaches )
-						{
-							lightReaches = traceLightPath( p3, vLight, p_ignoredEntity, light );
-						}
-					}
-					p_illumination = p3;
-				}
-				else if ( ( inter == INTERSECT_PARTIAL ) && ( inside[0] || inside[1] ) ) // one line end inside, one outside
-				{
-					// either testPoint1 or testPoint2 is inside the ellipsoid
-					if ( inside[0] )
-					{
-						p1 = testPoint1;
-					}
-					else
-					{
-						p1 = testPoint2;
-					}
-
-					p2 = vResult[0]; // the single point of intersection
-					p3 = (p1 + p2)/2.0f;
-					lightReaches = traceLightPath( p1, vLight, p_ignoredEntity, light );
-					if ( lightReaches )
-					{
-						p_illumination = p1;
-					}
-					else
-					{
-						p_illumination = p3;
-						lightReaches = traceLightPath( p2, vLight, p_ignoredEntity, light );
-						if ( !lightReaches )
-						{
-							lightReaches = traceLightPath( p3, vLight, p_ignoredEntity, light );
-						}
-					}
-				}
-				else if ( inter == INTERSECT_PARTIAL ) // both line ends outside, line touches volume at one intersection point
-				{
-					// Since the only point we can test is at the edge of the light volume,
-					// we can safely assume the illumination there is zero. No need to test
-					// LOS to the light origin or determine brightness.
-					lightReaches = false;
-				}
-				else // INTERSECT_FULL
-				{
-					p1 = vResult[0]; // the first point of intersection
-					p2 = vResult[1]; // the second point of intersection
-					p3 = (p1 + p2)/2.0f;
-					p_illumination = p3;
-					lightReaches = traceLightPath( p1, vLight, p_ignoredEntity, light );
-					if ( !lightReaches )
-					{
-						lightReaches = traceLightPath( p2, vLight, p_ignoredEntity, light );
-						if ( !lightReaches )
-						{
-							lightReaches = traceLightPath( p3, vLight, p_ignoredEntity, light );
-						}
-					}
-				}
-				
-				b_excludeLight = !lightReaches;
-			}
-			else // no shadows, so assume visibility between the light origin and the point of illumination
-			{
-				if ( inter == INTERSECT_NONE ) // the line segment is entirely inside the light volume
-				{
-					p_illumination = (testPoint1 + testPoint2)/2.0f;
-				}
-				else if ( ( inter == INTERSECT_PARTIAL ) && ( inside[0] || inside[1] ) ) // one line end inside, one outside
-				{
-					// either testPoint1 or testPoint2 is inside the ellipsoid
-					if ( inside[0] )
-					{
-						p_illumination = testPoint1;
-					}
-					else
-					{
-						p_illumination = testPoint2;
-					}
-				}
-				else if ( inter == INTERSECT_PARTIAL ) // both line ends outside, line touches volume at one intersection point
-				{
-					b_excludeLight = true; // not interested in this case, since illumination is zero at the volume edges
-				}
-				else // INTERSECT_FULL
-				{
-					p_illumination = (vResult[0] + vResult[1])/2.0f; // halfway between the points of intersection
-				}
-			}
+			continue;
 		}
 
-		// Process light if not excluded
-		if (!b_excludeLight)
-		{
-			// Compute illumination value
-			// We want the illumination at p_illumination.
-
-			float fx, fy;
-
-			if ( light->IsPointlight() )
-			{
-				fx = p_illumination.x - vLight.x;
-				fy = p_illumination.y - vLight.y;
-
-				// ELA_AXIS contains the radii [x,y,z]
-			}
-			else // projected light
-			{
-				// p_illumination needs to be relative to the vector
-				// from the light origin to the light target. Since the
-				// original code assumed that vector pointed down along
-				// the z axis, we'll rotate the target vector to that axis
-				// and apply the same rotation to p_illumination so it stays
-				// relative.
-
-				// Re-get the light cone parameters, some of which were clobbered in IntersectLineLightCone().
-				light->GetLightCone(vLightCone[ELC_ORIGIN], vLightCone[ELA_TARGET], vLightCone[ELA_RIGHT], vLightCone[ELA_UP], vLightCone[ELA_START], vLightCone[ELA_END]);
-				idVec3 target = vLightCone[ELA_TARGET]; // direction of light cone, already relative to vLight
-
-				// TODO: need to map p_illumination[x,y] to p_illumination[right,up]
-				// then right is the new x and up is the new y
+		accumulateEffectOfLight( inout_totalIllumination, inout_lightPaths, light, testPoint1, testPoint2, b_useShadows );
+	}
+}
 
-				if ( ( target.x == 0 ) && ( target.y == 0 ) ) // transform only if 'target' is not already on the z axis
-				{
-					fx = p_illumination.x - vLight.x;
-					fy = p_illumination.y - vLight.y;
-				}
-				else
-				{
-					idVec3 p = p_illumination - vLight; // p is now p_illumination relative to the light origin
-
-					// Matrices and steps are from http://inside.mines.edu/fs_home/gmurray/ArbitraryAxisRotation/
-
-					// rotate 'target' to XY plane
-					idVec2 target2 = target.ToVec2();
-					float d = target2.LengthFast();
-					float a = target.x/d;
-					float b = target.y/d;
-					idMat4 T1( idVec4(  a, b, 0, 0 ),
-							   idVec4( -b, a, 0, 0 ),
-							   idVec4(  0, 0, 1, 0 ),
-							   idVec4(  0, 0, 0, 1 ) );
-					idVec3 target_xy = T1*target; // the 'target' vector rotated to the XY plane
-
-					// rotate 'target_xy' to the Z axis
-					float c = target.LengthFast();
-					float e = target.z/c;
-					float f = d/c;
-					idMat4 T2( idVec4(  e, 0, -f, 0 ),
-							   idVec4(  0, 1,  0, 0 ),
-							   idVec4(  f, 0,  e, 0 ),
-							   idVec4(  0, 0,  0, 1 ) );
-					idVec3 target_z = -(T2*target_xy);
-
-					// apply T1 and T2 to p
-					idVec3 p_z = -(T2*(T1*p));
-					fx = p_z.x;
-					fy = p_z.y;
-				}
-			}
+//----------------------------------------------------------------------------
 
-			inout_totalIllumination += light->GetDistanceColor(	(p_illumination - vLight).LengthFast(),fx,fy );
-			DM_LOG(LC_LIGHT, LT_DEBUG)LOGSTRING
-			(
-				"%s in x/y: %f/%f   Distance: %f/%f   Brightness: %f\r",
-				light->name.c_str(), 
-				fx, 
-				fy, 
-				(p_illumination - vLight).LengthFast(), 
-				light->m_MaxLightRadius,
-				inout_totalIllumination
-			);
-		}
+void darkModLAS::resolveLightPaths
+(
+	float& inout_totalIllumination,
+	idList<darkModLightPath_t>& lightPaths,
+	idEntity* p_ignoredEntity
+)
+{
+	// trace brightest lights first, so that we can stop
+	// as soon as the total illumination is saturated
+	std::sort( lightPaths.begin(), lightPaths.end(), []( const darkModLightPath_t &a, const darkModLightPath_t &b ) {
+		return Max( a.illumFirst, a.illumOther ) > Max( b.illumFirst, b.illumOther );
+	} );
 
+	for ( int i = 0 ; i < lightPaths.Num() ; i++ )
+	{
 		// If total illumination is 1.0 or greater, we are done
-		if (inout_totalIllumination >= 1.0f)
+		if ( inout_totalIllumination >= 1.0f )
 		{
 			// Exit early as it's really really bright as is
-			p_cursor = NULL;
+			break;
 		}
-		else
+
+		const darkModLightPath_t &path = lightPaths[i];
+		for ( int k = 0 ; k < 3 ; k++ )
 		{
-			// Iterate to next light in area
-			p_cursor = p_cursor->NextNode();
+			if ( lightPathReaches( path.points[k], path.lightOrigin, p_ignoredEntity, path.light ) )
+			{
+				inout_totalIllumination += ( k == 0 ? path.illumFirst : path.illumOther );
+				break;
+			}
 		}
 	}
 }
@@ -1303,6 +1030,7 @@ void darkModLAS::addLight (idLight* p_idLight)
 	p_record->lastWorldPos = lightPos;
 	p_record->p_idLight = p_idLight;
 	p_record->areaIndex = containingAreaIndex;
+	UpdateLightBounds(p_record);
 
 	if (m_pp_areaLightLists[containingAreaIndex] != NULL)
 	{
@@ -1477,6 +1205,10 @@ void darkModLAS::shutDown()
 	// No areas
 	m_numAreas = 0;
 
+	m_lightPathCacheFrame = -1;
+	m_lightPathCache.ClearFree();
+	m_lightPathHash.ClearFree();
+
 	DM_LOG(LC_LIGHT, LT_DEBUG)LOGSTRING("LAS shutdown deleted array of per-area list pointers...\r");
 
 	// Log activity
@@ -1556,6 +1288,9 @@ void darkModLAS::updateLASState()
 					}  // Light changed areas
 				
 				} // Light moved
+
+				// radius may change even if light stays in place
+				UpdateLightBounds(p_LASLight);
 			
 				// Mark light as updated this LAS frame
 				p_LASLight->lastFrameUpdated = m_updateFrameIndex;
@@ -1686,19 +1421,22 @@ float darkModLAS::queryLightingAlongLine
 	totalIllumination = gameLocal.GetAmbientIllumination(testPoint1);
 	
 	// Check all the lights in the PVS areas and factor them in
+	idList<darkModLightPath_t> lightPaths;
 	for ( int pvsTestResultIndex = 0 ; pvsTestResultIndex < numPVSTestAreas ; pvsTestResultIndex++ )
 	{
 		// Add the effect of lights in this visible area to the effect at the point
 		accumulateEffectOfLightsInArea 
 		(
 			totalIllumination,
+			lightPaths,
 			pvsTestAreaIndices[pvsTestResultIndex],
 			testPoint1,
 			testPoint2,
-			p_ignoreEntity,
 			b_useShadows
 		);
 	}
+	// trace shadowed lights in one batch
+	resolveLightPaths( totalIllumination, lightPaths, p_ignoreEntity );
 
 	// Done with PVS test
 	gameLocal.pvs.FreeCurrentPVS( h_lightPVS );
@@ -1789,18 +1527,21 @@ float darkModLAS::queryLightingAlongBestLine
 	totalIllumination += gameLocal.GetAmbientIllumination(box.GetCenter());
 	
 	// Check all the lights in the PVS areas and factor them in
+	idList<darkModLightPath_t> lightPaths;
 	for ( int pvsTestResultIndex = 0 ; pvsTestResultIndex < numPVSTestAreas ; pvsTestResultIndex++ )
 	{
 		// Add the effect of lights in this visible area to the effect at the point
 		accumulateEffectOfLightsInArea2 
 		(
 			totalIllumination,
+			lightPaths,
 			pvsTestAreaIndices[pvsTestResultIndex],
 			box,
-			p_ignoreEntity,
 			b_useShadows
 		);
 	}
+	// trace shadowed lights in one batch
+	resolveLightPaths( totalIllumination, lightPaths, p_ignoreEntity );
 
 	// Done with PVS test
 	gameLocal.pvs.FreeCurrentPVS( h_lightPVS );
@@ -54,9 +54,31 @@ typedef struct darkModLightRecord_s
 	* A flag used to track if this light has been updated yet this frame
 	*/
     unsigned int lastFrameUpdated;
+
+    /*!
+	* Bounds of point light volume, updated every frame
+	* Cleared for projected lights, which are never rejected by bounds
+	*/
+    idBounds lightBounds;
         
 } darkModLightRecord_t;
 
+/*!
+* Shadowed light whose contribution to a query depends on occlusion traces.
+* The traces are postponed until all lights of the query are collected,
+* so that the brightest lights are traced first.
+*/
+typedef struct darkModLightPath_s
+{
+	idLight* light;
+	idVec3 lightOrigin;
+	// points of the lit segment to be traced to, in order
+	idVec3 points[3];
+	// illumination if the first point is lit / if only another point is lit
+	float illumFirst;
+	float illumOther;
+} darkModLightPath_t;
+
 //---------------------------------------------------------------------------
 
 class darkModLAS
@@ -91,6 +113,66 @@ protected:
 
     bool traceLightPath( idVec3 to, idVec3 from, idEntity* ignore, idLight* light); // grayman #2853 // grayman #3584
 
+    /*!
+    * Same as traceLightPath, but results are cached for the current frame.
+    * The start point is quantized to cells of tdm_las_traceCacheCell size,
+    * or matched exactly if the cell size is zero.
+    */
+    bool lightPathReaches( const idVec3 &from, const idVec3 &to, idEntity* ignore, idLight* light );
+
+    // result of traceLightPath for one cell of the per-frame trace cache
+    struct lightPathCacheEntry_t
+    {
+        int lightNum;
+        int ignoreNum;
+        int cell[3];
+        idVec3 point;           // exact start point if cell size is zero
+        idVec3 lightOrigin;
+        bool reaches;
+    };
+    int m_lightPathCacheFrame;
+    idList<lightPathCacheEntry_t> m_lightPathCache;
+    idHashIndex m_lightPathHash;
+
+    /*!
+    * Computes illumination of a point by the light located at vLight,
+    * ignoring occlusion.
+    */
+    float computeIllumination( idLight* light, const idVec3 &vLight, const idVec3 &p_illumination );
+
+    /*!
+    * Adds the effect of a single light upon the line between the two test points.
+    * Lights without shadows are added to the total immediately,
+    * shadowed lights are appended to the list of paths to be traced.
+    */
+    void accumulateEffectOfLight
+	(
+		float& inout_totalIllumination,
+		idList<darkModLightPath_t>& inout_lightPaths,
+		idLight* light,
+		const idVec3 &testPoint1,
+		const idVec3 &testPoint2,
+		bool b_useShadows
+	);
+
+    /*!
+    * Quick rejection of lights whose volume cannot touch the segment.
+    */
+    bool lightMayReachSegment( const darkModLightRecord_t* p_LASLight, const idVec3 &testPoint1, const idVec3 &testPoint2 ) const;
+
+    /*!
+    * Traces the collected light paths, brightest first, and adds the lit ones
+    * to the total. Stops as soon as the total illumination is saturated.
+    *
+    * @param p_ignoredEntity An entity whose occlusion of a light should not be considered
+    */
+    void resolveLightPaths
+	(
+		float& inout_totalIllumination,
+		idList<darkModLightPath_t>& lightPaths,
+		idEntity* p_ignoredEntity
+	);
+
     /*!
     * This method is used to add up all the light intensities contributed from
     * a specific region apon the line between the two test points.
@@ -99,17 +181,16 @@ protected:
     *     be accumulated
     * @param testPoint1 first point along the line whose lighting is being tested
     * @param testPoint2 second point along the line whose lighting is being tested
-    * @param p_ignoreEntity An entity whose occlusion of a light should not be considered
     * @param b_useShadows if true, then shadow volumes are considered
-    * @returns the total intensity on the point from lights in the test area
+    * Shadowed lights are appended to inout_lightPaths, see resolveLightPaths
     */
     void accumulateEffectOfLightsInArea 
 	( 
 		float& inout_totalIllumination,
+		idList<darkModLightPath_t>& inout_lightPaths,
 		int areaIndex, 
 		idVec3 testPoint1,
 		idVec3 testPoint2,
-		idEntity* p_ignoreEntity,
 		bool b_useShadows
 	);
 
@@ -120,16 +201,15 @@ protected:
     * @param areaIndex index of the area within the Area System whose lights should
     *     be accumulated
     * @param box boundary of volume being tested
-    * @param p_ignoreEntity An entity whose occlusion of a light should not be considered
     * @param b_useShadows if true, then shadow volumes are considered
-    * @returns the total intensity on the point from lights in the test area
+    * Shadowed lights are appended to inout_lightPaths, see resolveLightPaths
     */
 	void accumulateEffectOfLightsInArea2 
 	( 
 		float& inout_totalIllumination,
+		idList<darkModLightPath_t>& inout_lightPaths,
 		int areaIndex, 
 		idBox box,
-		idEntity* p_ignoreEntity,
 		bool b_useShadows
 	);
 
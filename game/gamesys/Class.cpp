@@ -158,9 +158,9 @@ void idTypeInfo::Init( void ) {
 	// are events.  NOTE: could save some space by keeping track of the maximum
 	// event that the class responds to and doing range checking.
 	num = idEventDef::NumEventCommands();
-	eventMap = new eventCallback_t[ num ];
-	memset( eventMap, 0, sizeof( eventCallback_t ) * num );
-	eventCallbackMemory += sizeof( eventCallback_t ) * num;
+	eventMap = new const idEventFunc<idClass> *[ num ];
+	memset( eventMap, 0, sizeof( eventMap[ 0 ] ) * num );
+	eventCallbackMemory += sizeof( eventMap[ 0 ] ) * num;
 
 	// allocate temporary memory for flags so that the subclass's event callbacks
 	// override the superclass's event callback
@@ -180,17 +180,42 @@ void idTypeInfo::Init( void ) {
 		for( i = 0; def[ i ].event != NULL; i++ )	{
 			ev = def[ i ].event->GetEventNum();
 
+			if ( c == this ) {
+				CheckEventSignature( def[ i ] );
+			}
+
 			if ( set[ ev ] ) {
 				continue;
 			}
 			set[ ev ] = true;
-			eventMap[ ev ] = def[ i ].function;
+			eventMap[ ev ] = &def[ i ];
 		}
 	}
 
 	delete[] set;
 }
 
+/*
+================
+idTypeInfo::CheckEventSignature
+
+Arguments are passed to handler according to its signature,
+so it must match argument format of the event.
+================
+*/
+void idTypeInfo::CheckEventSignature( const idEventFunc<idClass> &def ) const {
+	const char *format = def.event->GetArgFormat();
+	const char *kinds = def.thunk->argKinds;
+	bool match = ( strlen( format ) == strlen( kinds ) );
+	for ( int i = 0; match && format[ i ]; i++ ) {
+		char expected = ( format[ i ] == D_EVENT_INTEGER ? 'i' : format[ i ] == D_EVENT_FLOAT ? 'f' : 'p' );
+		match = ( kinds[ i ] == expected );
+	}
+	if ( !match ) {
+		gameLocal.Warning( "Handler of event '%s' in class %s has signature '%s' incompatible with format '%s'", def.event->GetName(), classname, kinds, format );
+	}
+}
+
 /*
 ================
 idTypeInfo::Shutdown
@@ -941,7 +966,7 @@ idClass::ProcessEventArgPtr
 bool idClass::ProcessEventArgPtr(const idEventDef *ev, intptr_t *data) {
 	idTypeInfo	*c;
 	int			num;
-	eventCallback_t	callback;
+	const idEventFunc<idClass> *handler;
 
 	assert( ev );
 	assert( idEvent::initialized );
@@ -958,93 +983,8 @@ bool idClass::ProcessEventArgPtr(const idEventDef *ev, intptr_t *data) {
 		return false;
 	}
 
-	callback = c->eventMap[ num ];
-
-#if !CPU_EASYARGS
-
-/*
-on ppc architecture, floats are passed in a seperate set of registers
-the function prototypes must have matching float declaration
-
-http://developer.apple.com/documentation/DeveloperTools/Conceptual/MachORuntime/2rt_powerpc_abi/chapter_9_section_5.html
-
-stgatilov: the same applies for x64 architecture.
-Windows x64 calling convention requires passing:
-  first 4 integers in: RCX, RDX, R8, R9
-  first 4 floats   in: XMM0, XMM1, XMM2, XMM3  (SSE)
-              rest on: stack
-*/
-
-	switch( ev->GetFormatspecIndex() ) {
-	case 1 << D_EVENT_MAXARGS :
-		( this->*callback )();
-		break;
-
-// generated file - see CREATE_EVENT_CODE
-#include "Callbacks.cpp"
-
-	default:
-		gameLocal.Warning( "Invalid formatspec on event '%s'", ev->GetName() );
-		break;
-	}
-
-#else
-
-	//stgatilov: CPU_EASYARGS way is known to work properly only with cdecl calling convention!
-
-	assert( D_EVENT_MAXARGS == 8 );
-
-	switch( ev->GetNumArgs() ) {
-	case 0 :
-		( this->*callback )();
-		break;
-
-	case 1 :
-		typedef void ( idClass::*eventCallback_1_t )( const intptr_t );
-		( this->*( eventCallback_1_t )callback )( data[ 0 ] );
-		break;
-
-	case 2 :
-		typedef void ( idClass::*eventCallback_2_t )( const intptr_t, const intptr_t );
-		( this->*( eventCallback_2_t )callback )( data[ 0 ], data[ 1 ] );
-		break;
-
-	case 3 :
-		typedef void ( idClass::*eventCallback_3_t )( const intptr_t, const intptr_t, const intptr_t );
-		( this->*( eventCallback_3_t )callback )( data[ 0 ], data[ 1 ], data[ 2 ] );
-		break;
-
-	case 4 :
-		typedef void ( idClass::*eventCallback_4_t )( const intptr_t, const intptr_t, const intptr_t, const intptr_t );
-		( this->*( eventCallback_4_t )callback )( data[ 0 ], data[ 1 ], data[ 2 ], data[ 3 ] );
-		break;
-
-	case 5 :
-		typedef void ( idClass::*eventCallback_5_t )( const intptr_t, const intptr_t, const intptr_t, const intptr_t, const intptr_t );
-		( this->*( eventCallback_5_t )callback )( data[ 0 ], data[ 1 ], data[ 2 ], data[ 3 ], data[ 4 ] );
-		break;
-
-	case 6 :
-		typedef void ( idClass::*eventCallback_6_t )( const intptr_t, const intptr_t, const intptr_t, const intptr_t, const intptr_t, const intptr_t );
-		( this->*( eventCallback_6_t )callback )( data[ 0 ], data[ 1 ], data[ 2 ], data[ 3 ], data[ 4 ], data[ 5 ] );
-		break;
-
-	case 7 :
-		typedef void ( idClass::*eventCallback_7_t )( const intptr_t, const intptr_t, const intptr_t, const intptr_t, const intptr_t, const intptr_t, const intptr_t );
-		( this->*( eventCallback_7_t )callback )( data[ 0 ], data[ 1 ], data[ 2 ], data[ 3 ], data[ 4 ], data[ 5 ], data[ 6 ] );
-		break;
-
-	case 8 :
-		typedef void ( idClass::*eventCallback_8_t )( const intptr_t, const intptr_t, const intptr_t, const intptr_t, const intptr_t, const intptr_t, const intptr_t, const intptr_t );
-		( this->*( eventCallback_8_t )callback )( data[ 0 ], data[ 1 ], data[ 2 ], data[ 3 ], data[ 4 ], data[ 5 ], data[ 6 ], data[ 7 ] );
-		break;
-
-	default:
-		gameLocal.Warning( "Invalid formatspec on event '%s'", ev->GetName() );
-		break;
-	}
-
-#endif
+	handler = c->eventMap[ num ];
+	handler->thunk->Call( this, data );
 
 	return true;
 }
@@ -25,6 +25,9 @@ instancing of objects.
 #ifndef __SYS_CLASS_H__
 #define __SYS_CLASS_H__
 
+#include <type_traits>
+#include <utility>
+
 class idClass;
 class idTypeInfo;
 
@@ -33,15 +36,100 @@ extern const idEventDef EV_SafeRemove;
 
 typedef void ( idClass::*eventCallback_t )( void );
 
+/*
+================
+idEventThunk
+
+Typed caller of event handler, generated at compile time for every handler.
+The handler is a template parameter of the thunk, so it is called through its own
+member function pointer type, without casting it from eventCallback_t.
+It reads arguments from event data array (see idClass::ProcessEventArgPtr) and passes them
+to the handler with proper types, so calling convention does not matter.
+argKinds has one char per handler parameter: 'i' for integers, 'f' for floats, 'p' for data passed by pointer.
+================
+*/
+struct idEventThunk {
+	void				( *Call )( idClass *object, const intptr_t *data );
+	const char *		argKinds;
+};
+
+// converts event argument from its slot in data array to the type of handler parameter
+// integers, floats, enums and pointers are stored at the beginning of the slot
+template< class T, class Enable = void >
+struct idEventArgCast {
+	static_assert( sizeof( T ) <= sizeof( intptr_t ), "event argument does not fit into slot" );
+	static const char kind = std::is_floating_point<T>::value ? 'f' : std::is_pointer<T>::value ? 'p' : 'i';
+	static T Get( const intptr_t &slot ) {
+		T value;
+		memcpy( &value, &slot, sizeof( T ) );
+		return value;
+	}
+};
+// vectors and angles passed by value
+template< class T >
+struct idEventArgCast< T, std::enable_if_t< std::is_class<T>::value > > {
+	static const char kind = 'p';
+	static const T &Get( const intptr_t &slot ) { return *reinterpret_cast<const T *>( slot ); }
+};
+// vectors and angles passed by reference
+template< class T >
+struct idEventArgCast< T & > {
+	static const char kind = 'p';
+	static T &Get( const intptr_t &slot ) { return *reinterpret_cast<T *>( slot ); }
+};
+// booleans are passed as integers
+template<>
+struct idEventArgCast< bool > {
+	static const char kind = 'i';
+	static bool Get( const intptr_t &slot ) { return *reinterpret_cast<const int *>( &slot ) != 0; }
+};
+// strings are passed as char pointers
+template<>
+struct idEventArgCast< const idStr & > {
+	static const char kind = 'p';
+	static idStr Get( const intptr_t &slot ) { return idStr( reinterpret_cast<const char *>( slot ) ); }
+};
+
+template< class Handler, Handler handler, class Class, class... Args >
+struct idEventThunkImpl {
+	static const idEventThunk	thunk;
+	static const char			argKinds[];
+
+	static void Call( idClass *object, const intptr_t *data ) {
+		Invoke( static_cast<Class *>( object ), data, std::index_sequence_for<Args...>() );
+	}
+	template< size_t... Index >
+	static void Invoke( Class *object, const intptr_t *data, std::index_sequence<Index...> ) {
+		( object->*handler )( idEventArgCast<Args>::Get( data[ Index ] )... );
+	}
+};
+template< class Handler, Handler handler, class Class, class... Args >
+const char idEventThunkImpl< Handler, handler, Class, Args... >::argKinds[] = { idEventArgCast<Args>::kind..., '\0' };
+template< class Handler, Handler handler, class Class, class... Args >
+const idEventThunk idEventThunkImpl< Handler, handler, Class, Args... >::thunk = { &idEventThunkImpl::Call, idEventThunkImpl::argKinds };
+
+// extracts class and argument types from the type of handler
+template< class Handler, Handler handler >
+struct idEventThunkFor;
+template< class Class, class Ret, class... Args, Ret ( Class::*handler )( Args... ) >
+struct idEventThunkFor< Ret ( Class::* )( Args... ), handler > {
+	typedef idEventThunkImpl< Ret ( Class::* )( Args... ), handler, Class, Args... > type;
+};
+template< class Class, class Ret, class... Args, Ret ( Class::*handler )( Args... ) const >
+struct idEventThunkFor< Ret ( Class::* )( Args... ) const, handler > {
+	typedef idEventThunkImpl< Ret ( Class::* )( Args... ) const, handler, Class, Args... > type;
+};
+
 template< class Type >
 struct idEventFunc {
 	const idEventDef	*event;
 	eventCallback_t		function;
+	const idEventThunk	*thunk;
 };
 
 // added & so gcc could compile this
-#define EVENT( event, function )	{ &( event ), ( void ( idClass::* )( void ) )( &function ) },
-#define END_CLASS					{ NULL, NULL } };
+#define EVENT( event, function )	{ &( event ), ( void ( idClass::* )( void ) )( &function ), &idEventThunkFor< decltype( &function ), &function >::type::thunk },
+#define END_CLASS					{ NULL, NULL, NULL } };
 
 
 class idEventArg {
@@ -248,6 +336,9 @@ private:
 
 	void						Event_SafeRemove( void );
 
+	friend class idEvent;
+	idEventObjectList			scheduledEvents;	// see idEvent::CancelEvents
+
 	static bool					initialized;
 	static idList<idTypeInfo *>	types;
 	static idList<idTypeInfo *>	typenums;
@@ -272,7 +363,7 @@ public:
 	void						( idClass::*Restore )( idRestoreGame *savefile );
 
 	idEventFunc<idClass> *		eventCallbacks;
-	eventCallback_t *			eventMap;
+	const idEventFunc<idClass> **eventMap;		// event number -> handler (NULL if not responding)
 	idTypeInfo *				super;
 	idTypeInfo *				next;
 	bool						freeEventMap;
@@ -288,6 +379,7 @@ public:
 
 	void						Init( void );
 	void						Shutdown( void );
+	void						CheckEventSignature( const idEventFunc<idClass> &def ) const;
 
 	bool						IsType( const idTypeInfo &superclass ) const;
 	bool						RespondsTo( const idEventDef &ev ) const;
@@ -31,7 +31,6 @@ Event are used for scheduling tasks and for linking script commands.
 #include "../Game_local.h"
 
 #define MAX_EVENTSPERFRAME			(10<<10)
-//#define CREATE_EVENT_CODE
 
 idCVar g_eventAliveSoftLimit(
 	"g_eventAliveSoftLimit", "2048", CVAR_INTEGER | CVAR_GAME,
@@ -79,7 +78,6 @@ void idEventDef::Construct()
 {
 	idEventDef		*ev;
 	int				i;
-	unsigned int	bits;
 
 	assert(name != NULL);
 	assert(!idEvent::initialized);
@@ -101,8 +99,7 @@ void idEventDef::Construct()
 		description = "No description";
 	}
 
-	// make sure the format for the args is valid, calculate the formatspecindex, and the offsets for each arg
-	bits = 0;
+	// make sure the format for the args is valid, and calculate the offsets for each arg
 	argsize = 0;
 	memset( argOffset, 0, sizeof( argOffset ) );
 
@@ -113,7 +110,6 @@ void idEventDef::Construct()
 		switch( formatspec[ i ] )
 		{
 		case D_EVENT_FLOAT :
-			bits |= 1 << i;
 			argsize += sizeof(float);
 			break;
 
@@ -146,9 +142,6 @@ void idEventDef::Construct()
 		}
 	}
 
-	// calculate the formatspecindex
-	formatspecIndex = ( 1 << ( numargs + D_EVENT_MAXARGS ) ) | bits;
-
 	// go through the list of defined events and check for duplicates
 	// and mismatched format strings
 	eventnum = numEventDefs;
@@ -248,8 +241,11 @@ void idEventDef::SortEventDefs() {
 
 static idLinkList<idEvent> FreeEvents;
 static int FreeEventsNum = 0;
-static idLinkList<idEvent> EventQueue;
 static idEvent EventPool[ MAX_EVENTS ];
+// binary min-heap of scheduled events (replaces sorted linked list)
+static idEvent *EventHeap[ MAX_EVENTS ];
+static int EventHeapNum = 0;
+static uint64 EventSequence = 0;
 
 bool idEvent::initialized = false;
 
@@ -282,7 +278,7 @@ idEvent *idEvent::Alloc( const idEventDef *evdef, int numargs, va_list args ) {
 #if _DEBUG
 	//stgatilov: check that free events counter is valid
 	if (nonFreeNum <= 100) {	//avoid wasting too much time
-		int aliveNum = EventQueue.Num();
+		int aliveNum = EventHeapNum;
 		assert(aliveNum == nonFreeNum || aliveNum + 1 == nonFreeNum);
 	}
 #endif
@@ -415,6 +411,8 @@ idEvent::Free
 ================
 */
 void idEvent::Free( void ) {
+	Unschedule();
+
 	if ( data ) {
 		eventDataAllocator.Free( data );
 		data = NULL;
@@ -432,35 +430,140 @@ void idEvent::Free( void ) {
 
 /*
 ================
-idEvent::Schedule
+idEvent::HeapMoveUp
 ================
 */
-void idEvent::Schedule( idClass *obj, const idTypeInfo *type, int time ) {
-	idEvent *event;
+void idEvent::HeapMoveUp( int index ) {
+	idEvent *event = EventHeap[ index ];
+	while ( index > 0 ) {
+		int parent = ( index - 1 ) >> 1;
+		if ( !event->FiresBefore( EventHeap[ parent ] ) ) {
+			break;
+		}
+		EventHeap[ index ] = EventHeap[ parent ];
+		EventHeap[ index ]->heapIndex = index;
+		index = parent;
+	}
+	EventHeap[ index ] = event;
+	event->heapIndex = index;
+}
 
-	assert( initialized );
-	if ( !initialized ) {
+/*
+================
+idEvent::HeapMoveDown
+================
+*/
+void idEvent::HeapMoveDown( int index ) {
+	idEvent *event = EventHeap[ index ];
+	while ( true ) {
+		int child = 2 * index + 1;
+		if ( child >= EventHeapNum ) {
+			break;
+		}
+		if ( child + 1 < EventHeapNum && EventHeap[ child + 1 ]->FiresBefore( EventHeap[ child ] ) ) {
+			child++;
+		}
+		if ( !EventHeap[ child ]->FiresBefore( event ) ) {
+			break;
+		}
+		EventHeap[ index ] = EventHeap[ child ];
+		EventHeap[ index ]->heapIndex = index;
+		index = child;
+	}
+	EventHeap[ index ] = event;
+	event->heapIndex = index;
+}
+
+/*
+================
+idEvent::HeapRemove
+================
+*/
+void idEvent::HeapRemove( int index ) {
+	EventHeap[ index ]->heapIndex = -1;
+	EventHeapNum--;
+	if ( index == EventHeapNum ) {
 		return;
 	}
+	EventHeap[ index ] = EventHeap[ EventHeapNum ];
+	EventHeap[ index ]->heapIndex = index;
+	if ( index > 0 && EventHeap[ index ]->FiresBefore( EventHeap[ ( index - 1 ) >> 1 ] ) ) {
+		HeapMoveUp( index );
+	} else {
+		HeapMoveDown( index );
+	}
+}
+
+/*
+================
+idEvent::Insert
+
+Puts the event into the heap and into the object's list.
+Events with same time fire in the order they were inserted.
+================
+*/
+void idEvent::Insert( idClass *obj, int time ) {
+	assert( heapIndex < 0 );
 
 	object = obj;
-	typeinfo = type;
+	this->time = time;
+	sequence = EventSequence++;
 
-	// wraps after 24 days...like I care. ;)
-	this->time = gameLocal.time + time;
+	objectPrev = NULL;
+	objectNext = obj->scheduledEvents.first;
+	if ( objectNext ) {
+		objectNext->objectPrev = this;
+	}
+	obj->scheduledEvents.first = this;
 
-	eventNode.Remove();
+	EventHeap[ EventHeapNum ] = this;
+	EventHeapNum++;
+	HeapMoveUp( EventHeapNum - 1 );
+}
+
+/*
+================
+idEvent::Unschedule
 
-	event = EventQueue.Next();
-	while( ( event != NULL ) && ( this->time >= event->time ) ) {
-		event = event->eventNode.Next();
+Removes the event from the heap and from the object's list, if it is scheduled.
+================
+*/
+void idEvent::Unschedule( void ) {
+	if ( heapIndex < 0 ) {
+		return;
 	}
+	HeapRemove( heapIndex );
 
-	if ( event ) {
-		eventNode.InsertBefore( event->eventNode );
+	if ( objectPrev ) {
+		objectPrev->objectNext = objectNext;
 	} else {
-		eventNode.AddToEnd( EventQueue );
+		assert( object->scheduledEvents.first == this );
+		object->scheduledEvents.first = objectNext;
+	}
+	if ( objectNext ) {
+		objectNext->objectPrev = objectPrev;
+	}
+	objectPrev = objectNext = NULL;
+}
+
+/*
+================
+idEvent::Schedule
+================
+*/
+void idEvent::Schedule( idClass *obj, const idTypeInfo *type, int time ) {
+	assert( initialized );
+	if ( !initialized ) {
+		return;
 	}
+
+	eventNode.Remove();
+	Unschedule();
+
+	typeinfo = type;
+
+	// wraps after 24 days...like I care. ;)
+	Insert( obj, gameLocal.time + time );
 }
 
 /*
@@ -476,12 +579,12 @@ void idEvent::CancelEvents( const idClass *obj, const idEventDef *evdef ) {
 		return;
 	}
 
-	for( event = EventQueue.Next(); event != NULL; event = next ) {
-		next = event->eventNode.Next();
-		if ( event->object == obj ) {
-			if ( !evdef || ( evdef == event->eventdef ) ) {
-				event->Free();
-			}
+	// only events of this object are checked
+	for( event = obj->scheduledEvents.first; event != NULL; event = next ) {
+		next = event->objectNext;
+		assert( event->object == obj );
+		if ( !evdef || ( evdef == event->eventdef ) ) {
+			event->Free();
 		}
 	}
 }
@@ -494,21 +597,52 @@ idEvent::ClearEventList
 void idEvent::ClearEventList( void ) {
 	int i;
 
+	// detach pending events from their objects
+	while ( EventHeapNum > 0 ) {
+		EventHeap[ 0 ]->Unschedule();
+	}
+
 	//
 	// initialize lists
 	//
 	FreeEvents.Clear();
-	EventQueue.Clear();
 	FreeEventsNum = 0;
+	EventSequence = 0;
    
 	// 
 	// add the events to the free list
 	//
 	for( i = 0; i < MAX_EVENTS; i++ ) {
+		EventPool[ i ].heapIndex = -1;
+		EventPool[ i ].objectPrev = EventPool[ i ].objectNext = NULL;
 		EventPool[ i ].Free();
 	}
 }
 
+/*
+================
+idEvent::NumScheduled
+================
+*/
+int idEvent::NumScheduled( void ) {
+	return EventHeapNum;
+}
+
+/*
+================
+idEvent::GetScheduledEvents
+================
+*/
+void idEvent::GetScheduledEvents( idList<idEvent*> &events ) {
+	events.SetNum( EventHeapNum );
+	for ( int i = 0; i < EventHeapNum; i++ ) {
+		events[i] = EventHeap[i];
+	}
+	std::sort( events.begin(), events.end(), []( const idEvent *a, const idEvent *b ) {
+		return a->FiresBefore( b );
+	});
+}
+
 //stgatilov: some informative labels suitable for tracing
 //ideally, it should match natvis definitions...
 idStr GetTraceLabel(const idEvent &evt) {
@@ -544,8 +678,8 @@ void idEvent::ServiceEvents( void ) {
 	TRACE_CPU_SCOPE( "idEvent::ServiceEvents" )
 
 	num = 0;
-	while( !EventQueue.IsListEmpty() ) {
-		event = EventQueue.Next();
+	while( EventHeapNum > 0 ) {
+		event = EventHeap[ 0 ];
 		assert( event );
 
 		if ( event->time > gameLocal.time ) {
@@ -611,7 +745,7 @@ void idEvent::ServiceEvents( void ) {
 
 		// the event is removed from its list so that if then object
 		// is deleted, the event won't be freed twice
-		event->eventNode.Remove();
+		event->Unschedule();
 		assert( event->object );
 		event->object->ProcessEventArgPtr( ev, args );
 
@@ -642,12 +776,6 @@ void idEvent::Init( void ) {
 		gameLocal.Error( "%s", eventErrorMsg );
 	}
 
-#ifdef CREATE_EVENT_CODE
-	void CreateEventCallbackHandler();
-	CreateEventCallbackHandler();
-	gameLocal.Error( "Wrote event callback handler" );
-#endif
-
 	if ( initialized ) {
 		gameLocal.Printf( "...already initialized\n" );
 		ClearEventList();
@@ -703,10 +831,13 @@ void idEvent::Save( idSaveGame *savefile ) {
 	bool validTrace;
 	const char	*format;
 
-	savefile->WriteInt( EventQueue.Num() );
+	// events are saved in the order of firing
+	idList<idEvent*> events;
+	GetScheduledEvents( events );
+	savefile->WriteInt( events.Num() );
 
-	event = EventQueue.Next();
-	while( event != NULL ) {
+	for ( int e = 0; e < events.Num(); e++ ) {
+		event = events[e];
 		savefile->WriteInt( event->time );
 		savefile->WriteString( event->eventdef->GetName() );
 		savefile->WriteString( event->typeinfo->classname );
@@ -758,7 +889,6 @@ void idEvent::Save( idSaveGame *savefile ) {
 			}
 		}
 		assert( size == event->eventdef->GetArgSize() );
-		event = event->eventNode.Next();
 	}
 }
 
@@ -784,10 +914,10 @@ void idEvent::Restore( idRestoreGame *savefile ) {
 
 		event = FreeEvents.Next();
 		event->eventNode.Remove();
-		event->eventNode.AddToEnd( EventQueue );
 		FreeEventsNum--;
 
-		savefile->ReadInt( event->time );
+		int time;
+		savefile->ReadInt( time );
 
 		// read the event name
 		savefile->ReadString( name );
@@ -803,7 +933,13 @@ void idEvent::Restore( idRestoreGame *savefile ) {
 			savefile->Error( "idEvent::Restore: unknown class '%s' on event '%s'", name.c_str(), event->eventdef->GetName() );
 		}
 
-		savefile->ReadObject( event->object );
+		idClass *object;
+		savefile->ReadObject( object );
+		if ( !object ) {
+			savefile->Error( "idEvent::Restore: missing object on event '%s'", event->eventdef->GetName() );
+		}
+		// events were saved in order of firing, so sequence numbers restore the same order
+		event->Insert( object, time );
 
 		// read the args
 		savefile->ReadInt( argsize );
@@ -933,7 +1069,9 @@ void Cmd_EventList_f(const idCmdArgs &args) {
 		limit = atoi(args.Argv(1));
 	}
 
-	int num = EventQueue.Num();
+	idList<idEvent*> events;
+	idEvent::GetScheduledEvents(events);
+	int num = events.Num();
 	if (limit >= num/2)
 		limit = -1;
 
@@ -948,70 +1086,214 @@ void Cmd_EventList_f(const idCmdArgs &args) {
 			printIds.Set(rnd.RandomInt(num), 0);
 	}
 
-	int idx = 0;
-	for (idLinkList<idEvent> *node = EventQueue.NextNode(); node; node = node->NextNode()) {
+	for (int idx = 0; idx < num; idx++) {
 		if (limit < 0 || printIds.Find(idx))
-			node->Owner()->Print();
-		idx++;
+			events[idx]->Print();
 	}
 	common->Printf("Total: %d/%d events alive\n", num, MAX_EVENTS);
 }
 
-
-#ifdef CREATE_EVENT_CODE
 /*
 ================
-CreateEventCallbackHandler
+Cmd_EventBenchmark_f
+
+Measures scheduling and cancellation of many events.
+Events are posted on temporary objects and cancelled before they can fire.
 ================
 */
-void CreateEventCallbackHandler( void ) {
-	int num;
-	int count;
-	int i, j, k;
-	char argString[ D_EVENT_MAXARGS + 1 ];
-	idStr string1;
-	idStr string2;
-	idFile *file;
+void Cmd_EventBenchmark_f( const idCmdArgs &args ) {
+	int total = 100000;
+	if ( args.Argc() > 1 ) {
+		total = atoi( args.Argv( 1 ) );
+	}
+	const int NUM_OBJECTS = 256;
+
+	if ( !idEvent::initialized ) {
+		common->Printf( "Event system is not initialized\n" );
+		return;
+	}
+
+	int oldSoftLimit = g_eventAliveSoftLimit.GetInteger();
+	g_eventAliveSoftLimit.SetInteger( MAX_EVENTS );
+
+	idList<idClass*> objects;
+	for ( int i = 0; i < NUM_OBJECTS; i++ ) {
+		objects.Append( new idClass() );
+	}
+
+	idRandom rnd( 1234 );
+	idTimer scheduleTimer, cancelTimer;
+	int done = 0, maxAlive = 0;
+	while ( done < total ) {
+		// fill the pool as much as possible, leaving some events to the game
+		int batch = idMath::Imin( total - done, MAX_EVENTS - idEvent::NumScheduled() - 256 );
+		if ( batch <= 0 ) {
+			common->Printf( "Not enough free events\n" );
+			break;
+		}
+
+		scheduleTimer.Start();
+		for ( int i = 0; i < batch; i++ ) {
+			// many equal times to stress FIFO ordering
+			objects[ rnd.RandomInt( NUM_OBJECTS ) ]->PostEventMS( &EV_Remove, 1000 + rnd.RandomInt( 100 ) * 16 );
+		}
+		scheduleTimer.Stop();
+		maxAlive = idMath::Imax( maxAlive, idEvent::NumScheduled() );
+
+		cancelTimer.Start();
+		for ( int i = 0; i < NUM_OBJECTS; i++ ) {
+			objects[ i ]->CancelEvents( &EV_Remove );
+		}
+		cancelTimer.Stop();
+
+		done += batch;
+	}
 
-	file = fileSystem->OpenFileWrite( "Callbacks.cpp" );
+	objects.DeleteContents( true );
+	g_eventAliveSoftLimit.SetInteger( oldSoftLimit );
 
-	file->Printf( "// generated file - see CREATE_EVENT_CODE\n\n" );
+	common->Printf( "Events: %d scheduled, up to %d alive\n", done, maxAlive );
+	common->Printf( "Schedule: %.3lf ms total, %.1lf ns per event\n", scheduleTimer.Milliseconds(), scheduleTimer.Milliseconds() * 1e6 / idMath::Imax( done, 1 ) );
+	common->Printf( "Cancel:   %.3lf ms total, %.1lf ns per event\n", cancelTimer.Milliseconds(), cancelTimer.Milliseconds() * 1e6 / idMath::Imax( done, 1 ) );
+}
 
-	for( i = 1; i <= D_EVENT_MAXARGS; i++ ) {
+/*
+================
+Cmd_ScriptEventBenchmark_f
 
-		file->Printf( "\t/*******************************************************\n\n\t\t%d args\n\n\t*******************************************************/\n\n", i );
+Measures calling script events from script code, through the interpreter and typed thunks.
+Runs compiled loops calling sys.getTime() and $world.getOrigin(), and an empty loop for reference.
+================
+*/
+void Cmd_ScriptEventBenchmark_f( const idCmdArgs &args ) {
+	int total = 1000000;
+	if ( args.Argc() > 1 ) {
+		total = atoi( args.Argv( 1 ) );
+	}
+	if ( !idEvent::initialized || !gameLocal.world ) {
+		common->Printf( "No map loaded\n" );
+		return;
+	}
 
-		for ( j = 0; j < ( 1 << i ); j++ ) {
-			for ( k = 0; k < i; k++ ) {
-				argString[ k ] = j & ( 1 << k ) ? 'f' : 'i';
+	// every thread runs a limited number of iterations to stay below interpreter's runaway loop limit
+	const int CALLS_PER_THREAD = 10000;
+	const int NUM_LOOPS = 3;
+	static const char *const loopNames[ NUM_LOOPS ] = { "empty loop", "sys.getTime()", "$world.getOrigin()" };
+	static const char *const loopBodies[ NUM_LOOPS ] = { "", "t = sys.getTime();", "v = $world.getOrigin();" };
+
+	const function_t *funcs[ NUM_LOOPS ];
+	for ( int k = 0; k < NUM_LOOPS; k++ ) {
+		idStr funcName = va( "ScriptEventBenchmark_%d_%d", k, CALLS_PER_THREAD );
+		funcs[ k ] = gameLocal.program.FindFunction( funcName );
+		if ( !funcs[ k ] ) {
+			idStr text = va( "void %s() { float i; float t; vector v; for (i = 0; i < %d; i++) { %s } }\n", funcName.c_str(), CALLS_PER_THREAD, loopBodies[ k ] );
+			if ( !gameLocal.program.CompileText( "scriptEventBenchmark", text, true ) ) {
+				return;
 			}
-			argString[ i ] = '\0';
-			
-			string1.Empty();
-			string2.Empty();
-
-			for( k = 0; k < i; k++ ) {
-				if ( j & ( 1 << k ) ) {
-					string1 += "const float";
-					string2 += va( "*( float * )&data[ %d ]", k );
-				} else {
-					string1 += "const intptr_t";
-					string2 += va( "data[ %d ]", k );
-				}
+			funcs[ k ] = gameLocal.program.FindFunction( funcName );
+		}
+	}
+	// $world could be unreferenced by map scripts before
+	gameLocal.program.SetEntity( gameLocal.world->name, gameLocal.world );
+
+	int numThreads = idMath::Imax( ( total + CALLS_PER_THREAD - 1 ) / CALLS_PER_THREAD, 1 );
+	int numCalls = numThreads * CALLS_PER_THREAD;
+	double loopMs[ NUM_LOOPS ];
+	for ( int k = 0; k < NUM_LOOPS; k++ ) {
+		idTimer timer;
+		for ( int t = 0; t < numThreads; t++ ) {
+			idThread *thread = new idThread( funcs[ k ] );
+			thread->ManualDelete();
+			thread->ManualControl();
+			timer.Start();
+			thread->Execute();
+			timer.Stop();
+			delete thread;
+		}
+		loopMs[ k ] = timer.Milliseconds();
+	}
+
+	common->Printf( "%d calls per loop\n", numCalls );
+	for ( int k = 0; k < NUM_LOOPS; k++ ) {
+		common->Printf( "%-20s %.3lf ms total, %.1lf ns per iteration", loopNames[ k ], loopMs[ k ], loopMs[ k ] * 1e6 / numCalls );
+		if ( k > 0 ) {
+			common->Printf( ", %.1lf ns per call without loop", ( loopMs[ k ] - loopMs[ 0 ] ) * 1e6 / numCalls );
+		}
+		common->Printf( "\n" );
+	}
+}
+
+
+#include "../../tests/testing.h"
 
-				if ( k < i - 1 ) {
-					string1 += ", ";
-					string2 += ", ";
+TEST_CASE("Events:HeapOrderMatchesList") {
+	REQUIRE( idEvent::initialized );
+
+	const int NUM_OBJECTS = 16;
+	const int NUM_POSTS = 2000;
+
+	int oldSoftLimit = g_eventAliveSoftLimit.GetInteger();
+	g_eventAliveSoftLimit.SetInteger( MAX_EVENTS );
+
+	idList<idClass*> objects;
+	for ( int i = 0; i < NUM_OBJECTS; i++ ) {
+		objects.Append( new idClass() );
+	}
+
+	// emulates old sorted linked list: new event goes after all events with same or smaller time
+	struct expected_t {
+		int object;
+		int time;
+	};
+	idList<expected_t> expected;
+
+	idRandom rnd( 5678 );
+	for ( int k = 0; k < NUM_POSTS; k++ ) {
+		int o = rnd.RandomInt( NUM_OBJECTS );
+		// few different delays, so that many events have equal time
+		int delay = 1000 + rnd.RandomInt( 8 ) * 16;
+		objects[ o ]->PostEventMS( &EV_Remove, delay );
+
+		expected_t exp = { o, gameLocal.time + delay };
+		int pos = expected.Num();
+		while ( pos > 0 && expected[ pos - 1 ].time > exp.time ) {
+			pos--;
+		}
+		expected.Insert( exp, pos );
+
+		if ( k % 7 == 6 ) {
+			// remove events from the middle of the heap
+			int c = rnd.RandomInt( NUM_OBJECTS );
+			objects[ c ]->CancelEvents( &EV_Remove );
+			for ( int i = expected.Num() - 1; i >= 0; i-- ) {
+				if ( expected[ i ].object == c ) {
+					expected.RemoveIndex( i );
 				}
 			}
+		}
+	}
 
-			file->Printf( "\tcase %d :\n\t\ttypedef void ( idClass::*eventCallback_%s_t )( %s );\n", ( 1 << ( i + D_EVENT_MAXARGS ) ) + j, argString, string1.c_str() );
-			file->Printf( "\t\t( this->*( eventCallback_%s_t )callback )( %s );\n\t\tbreak;\n\n", argString, string2.c_str() );
+	idList<idEvent*> events;
+	idEvent::GetScheduledEvents( events );
+	idList<expected_t> actual;
+	for ( int i = 0; i < events.Num(); i++ ) {
+		int o = objects.FindIndex( events[ i ]->GetEventObject() );
+		if ( o >= 0 ) {
+			expected_t act = { o, events[ i ]->GetTime() };
+			actual.Append( act );
+		}
+	}
 
+	REQUIRE( actual.Num() == expected.Num() );
+	int numMismatches = 0;
+	for ( int i = 0; i < actual.Num(); i++ ) {
+		if ( actual[ i ].object != expected[ i ].object || actual[ i ].time != expected[ i ].time ) {
+			numMismatches++;
 		}
 	}
+	CHECK( numMismatches == 0 );
 
-	fileSystem->CloseFile( file );
+	objects.DeleteContents( true );
+	g_eventAliveSoftLimit.SetInteger( oldSoftLimit );
+	CHECK( idEvent::NumScheduled() == events.Num() - actual.Num() );
 }
-
-#endif
@@ -27,8 +27,7 @@ Event are used for scheduling tasks and for linking script commands.
 #include <cstring>
 #include "EventArgs.h"
 
-#define D_EVENT_MAXARGS				8			// if changed, enable the CREATE_EVENT_CODE define in Event.cpp to generate switch statement for idClass::ProcessEventArgPtr.
-												// running the game will then generate c:\doom\base\events.txt, the contents of which should be copied into the switch statement.
+#define D_EVENT_MAXARGS				8			// maximum number of event arguments, see idEventThunk for how they are passed to handlers
 
 //stgatilov: this is required to make 32-bit an 64-bit scripting systems compatible on binary level
 static_assert(sizeof(idVec3) == 12, "Scripting system assumes idVec3 has 12-bytes size on every platform");
@@ -54,7 +53,6 @@ class idEventDef
 private:
 	const char					*name;
 	char					formatspec [D_EVENT_MAXARGS + 2 ];
-	unsigned int				formatspecIndex;
 	int							returnType;
 	int							numargs;
 	size_t						argsize;
@@ -80,7 +78,6 @@ public:
 	const char*					GetName() const;
 	const char*					GetDescription() const;
 	const char*					GetArgFormat() const;
-	unsigned int				GetFormatspecIndex() const;
 	char						GetReturnType() const;
 	int							GetEventNum() const;
 	int							GetNumArgs() const;
@@ -104,6 +101,20 @@ private:
 class idSaveGame;
 class idRestoreGame;
 typedef struct trace_s trace_t;
+class idEvent;
+
+// head of intrusive list of events scheduled on an object (embedded into idClass)
+// copying the object does not copy its pending events
+class idEventObjectList {
+public:
+								idEventObjectList() : first( NULL ) {}
+								idEventObjectList( const idEventObjectList & ) : first( NULL ) {}
+	idEventObjectList &			operator=( const idEventObjectList & ) { return *this; }
+
+private:
+	friend class idEvent;
+	idEvent *					first;
+};
 
 class idEvent {
 private:
@@ -113,7 +124,14 @@ private:
 	idClass						*object;
 	const idTypeInfo			*typeinfo;
 
-	idLinkList<idEvent>			eventNode;
+	idLinkList<idEvent>			eventNode;			// only used for free events
+
+	// scheduled events are kept in binary heap ordered by (time, sequence)
+	// sequence grows with every Schedule call, which gives FIFO order for equal times
+	int							heapIndex;			// -1 if not scheduled
+	uint64						sequence;
+	idEvent						*objectPrev;		// list of events scheduled on same object
+	idEvent						*objectNext;
 
 	static idDynamicBlockAlloc<byte, 16 * 1024, 256> eventDataAllocator;
 
@@ -129,6 +147,8 @@ public:
 	void						Free( void );
 	void						Schedule( idClass *object, const idTypeInfo *cls, int time );
 	byte						*GetData( void );
+	int							GetTime( void ) const;
+	idClass						*GetEventObject( void ) const;
 	void						Print();
 
 	static void					CancelEvents( const idClass *obj, const idEventDef *evdef = NULL );
@@ -143,10 +163,22 @@ public:
 
 	static void					SaveTrace( idSaveGame *savefile, const trace_t &trace );
 	static void					RestoreTrace( idRestoreGame *savefile, trace_t &trace );
-	
+
+	static int					NumScheduled( void );
+	static void					GetScheduledEvents( idList<idEvent*> &events );	// in order of firing
+
+private:
+	void						Insert( idClass *obj, int time );
+	void						Unschedule( void );
+	bool						FiresBefore( const idEvent *other ) const;
+	static void					HeapMoveUp( int index );
+	static void					HeapMoveDown( int index );
+	static void					HeapRemove( int index );
 };
 
 void Cmd_EventList_f(const idCmdArgs &args);
+void Cmd_EventBenchmark_f(const idCmdArgs &args);
+void Cmd_ScriptEventBenchmark_f(const idCmdArgs &args);
 
 /*
 ================
@@ -157,6 +189,36 @@ ID_INLINE byte *idEvent::GetData( void ) {
 	return data;
 }
 
+/*
+================
+idEvent::GetTime
+================
+*/
+ID_INLINE int idEvent::GetTime( void ) const {
+	return time;
+}
+
+/*
+================
+idEvent::GetEventObject
+================
+*/
+ID_INLINE idClass *idEvent::GetEventObject( void ) const {
+	return object;
+}
+
+/*
+================
+idEvent::FiresBefore
+================
+*/
+ID_INLINE bool idEvent::FiresBefore( const idEvent *other ) const {
+	if ( time != other->time ) {
+		return time < other->time;
+	}
+	return sequence < other->sequence;
+}
+
 /*
 ================
 idEventDef::GetName
@@ -180,15 +242,6 @@ ID_INLINE const char *idEventDef::GetArgFormat( void ) const {
 	return formatspec;
 }
 
-/*
-================
-idEventDef::GetFormatspecIndex
-================
-*/
-ID_INLINE unsigned int idEventDef::GetFormatspecIndex( void ) const {
-	return formatspecIndex;
-}
-
 /*
 ================
 idEventDef::GetReturnType
@@ -72,8 +72,58 @@ The InitializeCache must be called before any ordinary data is read from the fil
 It uses fseek to get offset to cache image, then reads it, probably decompresses it.
 Afterwards it fseeks to the file position on the moment of call.
 Then all the Read* happens which reads ordinary data from cache and special data from file.
+
+Cache image is now split into independent zlib chunks, which are (de)compressed in parallel.
+Image starts with negated number of chunks instead of compressed size, followed by total uncompressed size
+and (compressed, uncompressed) sizes of every chunk. Old single-stream images (positive size) are still readable.
+When saving asynchronously (see idSaveGameWriter), cache image is compressed and written by worker thread.
 */
 
+static const int SAVEGAME_CACHE_CHUNK_SIZE = 1 << 20;
+
+struct savegameCacheChunk_t {
+	const char *	src;
+	int				srcSize;
+	char *			dst;
+	int				dstSize;		// capacity on input, actual size on output
+	int				error;
+};
+
+static void CompressCacheChunkJob( savegameCacheChunk_t *chunk ) {
+	uLongf size = chunk->dstSize;
+	chunk->error = ExtLibs::compress( (Bytef *)chunk->dst, &size, (const Bytef *)chunk->src, (uLongf)chunk->srcSize );
+	chunk->dstSize = size;
+}
+REGISTER_PARALLEL_JOB( CompressCacheChunkJob, "SaveGameCompressChunk" );
+
+static void DecompressCacheChunkJob( savegameCacheChunk_t *chunk ) {
+	if ( chunk->dstSize == 0 ) {
+		//empty image, e.g. delta with no new data
+		chunk->error = Z_OK;
+		return;
+	}
+	uLongf size = chunk->dstSize;
+	chunk->error = ExtLibs::uncompress( (Bytef *)chunk->dst, &size, (const Bytef *)chunk->src, (uLongf)chunk->srcSize );
+	if ( chunk->error == Z_OK && (int)size != chunk->dstSize ) {
+		chunk->error = Z_DATA_ERROR;
+	}
+}
+REGISTER_PARALLEL_JOB( DecompressCacheChunkJob, "SaveGameDecompressChunk" );
+
+static void RunCacheChunkJobs( idList<savegameCacheChunk_t> &chunks, jobRun_t function, idParallelJobList *jobList ) {
+	if ( !jobList || chunks.Num() <= 1 ) {
+		for ( int i = 0; i < chunks.Num(); i++ ) {
+			function( &chunks[i] );
+		}
+		return;
+	}
+	for ( int i = 0; i < chunks.Num(); i++ ) {
+		jobList->AddJob( function, &chunks[i] );
+	}
+	jobList->Submit( nullptr, JOBLIST_PARALLELISM_REALTIME );
+	jobList->Wait();
+}
+
 idSaveGame::idSaveGame( idFile *savefile ) {
 
 	file = savefile;
@@ -97,8 +147,14 @@ void idSaveGame::Close( void ) {
 	// read trace models
 	idClipModel::SaveTraceModels( this );
 
+	// remember where every object is serialized, see idSaveGameDelta
+	blobEnds.Clear();
+	blobEnds.Append( cache.size() );
 	for( i = 1; i < objects.Num(); i++ ) {
 		CallSave_r( objects[ i ]->GetType(), objects[ i ] );
+		if ( isCompressed ) {
+			blobEnds.Append( cache.size() );
+		}
 	}
 
 	objects.Clear();
@@ -112,32 +168,89 @@ void idSaveGame::Close( void ) {
 
 void idSaveGame::FinalizeCache( void ) {
 	if (!isCompressed) return;
-		
-	int offset = sizeof(int);
 
-	//resize destination buffer
+	//everything after the last object is one more blob
+	if (blobEnds.Num() == 0 || blobEnds[blobEnds.Num() - 1] != cache.size())
+		blobEnds.Append(cache.size());
+
+	if (saveGameWriter.IsCollecting(file)) {
+		//worker thread will compress it
+		saveGameWriter.TakeCache(cache, blobEnds);
+		return;
+	}
+
+	idParallelJobList *jobList = parallelJobManager->AllocJobList( JOBLIST_UTILITY, JOBLIST_PRIORITY_MEDIUM, cache.size() / SAVEGAME_CACHE_CHUNK_SIZE + 1, 0, nullptr );
+	bool ok = WriteCacheImage(cache, blobEnds, file, jobList);
+	parallelJobManager->FreeJobList( jobList );
+	if (!ok)
+		gameLocal.Error("idSaveGame::FinalizeCache: compress failed");
+
+	cache.clear();
+	blobEnds.Clear();
+}
+
+//writes data as chunked compressed image, returns number of bytes written or -1 on failure
+static int WriteCacheChunks( const char *data, int size, idFile *file, idParallelJobList *jobList ) {
+	int numChunks = ( size + SAVEGAME_CACHE_CHUNK_SIZE - 1 ) / SAVEGAME_CACHE_CHUNK_SIZE;
+	numChunks = idMath::Imax( numChunks, 1 );
+
+	//split cache into chunks, each one gets its own part of destination buffer
+	idList<savegameCacheChunk_t> chunks;
+	chunks.SetNum( numChunks );
 	CRawVector zipped;
-	uLongf zipsize = ExtLibs::compressBound((uLongf)cache.size());
-	zipped.resize(zipsize);
+	int zippedCapacity = 0;
+	for (int i = 0; i < numChunks; i++) {
+		savegameCacheChunk_t &chunk = chunks[i];
+		chunk.srcSize = idMath::Imin( size - i * SAVEGAME_CACHE_CHUNK_SIZE, SAVEGAME_CACHE_CHUNK_SIZE );
+		chunk.dstSize = ExtLibs::compressBound( (uLongf)chunk.srcSize );
+		zippedCapacity += chunk.dstSize;
+	}
+	zipped.resize(zippedCapacity);
+	for (int i = 0, pos = 0; i < numChunks; i++) {
+		chunks[i].src = data + i * SAVEGAME_CACHE_CHUNK_SIZE;
+		chunks[i].dst = zipped.data() + pos;
+		chunks[i].error = Z_OK;
+		pos += chunks[i].dstSize;
+	}
 
 	//compress the cache
-	int err = ExtLibs::compress(
-		(Bytef *)&zipped[0], &zipsize,
-		(const Bytef *)&cache[0], (uLongf)cache.size()
-	);
-	if (err != Z_OK)
-		gameLocal.Error("idSaveGame::FinalizeCache: compress failed with code %d", err);
-	zipped.resize(zipsize);
-
-	//write compressed size and uncompressed size
-	file->WriteInt(zipped.size());				offset += sizeof(int);
-	file->WriteInt(cache.size());				offset += sizeof(int);
+	RunCacheChunkJobs( chunks, (jobRun_t)CompressCacheChunkJob, jobList );
+	for (int i = 0; i < numChunks; i++) {
+		if (chunks[i].error != Z_OK) {
+			saveGameWriter.Warning("WriteCacheChunks: compress failed with code %d", chunks[i].error);
+			return -1;
+		}
+	}
+
+	int offset = 0;
+	//write number of chunks and uncompressed size
+	file->WriteInt(-numChunks);					offset += sizeof(int);
+	file->WriteInt(size);						offset += sizeof(int);
+	//write compressed and uncompressed size of every chunk
+	for (int i = 0; i < numChunks; i++) {
+		file->WriteInt(chunks[i].dstSize);		offset += sizeof(int);
+		file->WriteInt(chunks[i].srcSize);		offset += sizeof(int);
+	}
 	//write compressed data
-	file->Write(&zipped[0], zipped.size());		offset += zipped.size();
-	//write offset from EOF to cache start
-	file->WriteInt(-offset);
+	for (int i = 0; i < numChunks; i++) {
+		file->Write(chunks[i].dst, chunks[i].dstSize);
+		offset += chunks[i].dstSize;
+	}
+	return offset;
+}
 
-	cache.clear();
+bool idSaveGame::WriteCacheImage( const CRawVector &cache, const idList<int> &blobEnds, idFile *file, idParallelJobList *jobList ) {
+	int offset;
+	if (saveGameDelta.IsTargeted())
+		offset = saveGameDelta.WriteDeltaImage(cache, blobEnds, file, jobList);
+	else
+		offset = WriteCacheChunks(cache.data(), cache.size(), file, jobList);
+	if (offset < 0)
+		return false;
+
+	//write offset from EOF to cache start
+	file->WriteInt(-int(offset + sizeof(int)));
+	return true;
 }
 
 void idSaveGame::WriteObjectList( void ) {
@@ -599,40 +712,136 @@ void idRestoreGame::InitializeCache() {
 		Error( "idRestoreGame::InitializeCache: bad cache offset (%d)", offset);
 	file->Seek(offset, FS_SEEK_CUR);
 
-	//read compressed cache size
-	int zipSize = -1;
-	file->ReadInt(zipSize);
-	if (zipSize <= 0)
-		Error("idRestoreGame::InitializeCache: bad compressed cache size (%d)", zipSize);
+	ReadCacheImage(file, cache, true);
+
+	//set cache pointer
+	cachePointer = 0;
+	//return file pointer
+	file->Seek(position, FS_SEEK_SET);
+}
+
+void idRestoreGame::ReadCacheImage( idFile *imageFile, CRawVector &image, bool allowDelta ) {
+	//read compressed cache size (or negated number of chunks, or zero for delta)
+	int zipSize = 0;
+	imageFile->ReadInt(zipSize);
+	if (zipSize == 0) {
+		if (!allowDelta)
+			Error("idRestoreGame::InitializeCache: nested delta image");
+		ReadDeltaImage(imageFile, image);
+		return;
+	}
 
 	//read decompressed cache size
 	int cacheSize = -1;
-	file->ReadInt(cacheSize);
-	if (cacheSize <= 0)
+	imageFile->ReadInt(cacheSize);
+	if (cacheSize < 0)
 		Error("idRestoreGame::InitializeCache: bad uncompressed cache size (%d)", cacheSize);
 
+	//old savegames have single chunk without size table
+	idList<savegameCacheChunk_t> chunks;
+	chunks.SetNum(zipSize > 0 ? 1 : -zipSize);
+	if (zipSize > 0) {
+		chunks[0].srcSize = zipSize;
+		chunks[0].dstSize = cacheSize;
+	}
+	else {
+		for (int i = 0; i < chunks.Num(); i++) {
+			imageFile->ReadInt(chunks[i].srcSize);
+			imageFile->ReadInt(chunks[i].dstSize);
+		}
+	}
+	int totalZipped = 0, totalSize = 0;
+	for (int i = 0; i < chunks.Num(); i++) {
+		if (chunks[i].srcSize <= 0 || chunks[i].dstSize < 0)
+			Error("idRestoreGame::InitializeCache: bad size of chunk %d", i);
+		totalZipped += chunks[i].srcSize;
+		totalSize += chunks[i].dstSize;
+	}
+	if (totalSize != cacheSize)
+		Error("idRestoreGame::InitializeCache: uncompressed size is %d instead of %d", totalSize, cacheSize);
+
 	//read compressed data
 	CRawVector zipped;
-	zipped.resize(zipSize);
-	cache.resize(cacheSize);
-	file->Read(&zipped[0], zipped.size());
+	zipped.resize(totalZipped);
+	image.resize(cacheSize);
+	imageFile->Read(&zipped[0], zipped.size());
+	for (int i = 0, srcPos = 0, dstPos = 0; i < chunks.Num(); i++) {
+		chunks[i].src = zipped.data() + srcPos;
+		chunks[i].dst = image.data() + dstPos;
+		chunks[i].error = Z_OK;
+		srcPos += chunks[i].srcSize;
+		dstPos += chunks[i].dstSize;
+	}
 
 	//decompress data
-	uLongf cacheSizeL = cacheSize;
-	int err = ExtLibs::uncompress(
-		(Bytef *)&cache[0], &cacheSizeL,
-		(const Bytef *)&zipped[0], (uLongf)zipped.size()
-	);
-	cacheSize = cacheSizeL;
-	if (err != Z_OK)
-		Error("idRestoreGame::InitializeCache: uncompress failed with code %d", err);
-	if (cacheSize != cache.size())
-		Error("idRestoreGame::InitializeCache: uncompressed size is %d instead of %d", cacheSize, cache.size());
+	idParallelJobList *jobList = parallelJobManager->AllocJobList( JOBLIST_UTILITY, JOBLIST_PRIORITY_MEDIUM, chunks.Num(), 0, nullptr );
+	RunCacheChunkJobs( chunks, (jobRun_t)DecompressCacheChunkJob, jobList );
+	parallelJobManager->FreeJobList( jobList );
+	for (int i = 0; i < chunks.Num(); i++) {
+		if (chunks[i].error != Z_OK)
+			Error("idRestoreGame::InitializeCache: uncompress of chunk %d failed with code %d", i, chunks[i].error);
+	}
+}
 
-	//set cache pointer
-	cachePointer = 0;
-	//return file pointer
-	file->Seek(position, FS_SEEK_SET);
+void idRestoreGame::ReadDeltaImage( idFile *imageFile, CRawVector &image ) {
+	idStr baseName;
+	int baseId = 0, cacheSize = -1, numSegments = -1;
+	imageFile->ReadString(baseName);
+	imageFile->ReadInt(baseId);
+	imageFile->ReadInt(cacheSize);
+	imageFile->ReadInt(numSegments);
+	if (cacheSize < 0 || numSegments < 0)
+		Error("idRestoreGame::InitializeCache: bad delta header");
+	idList<int> segmentOffset, segmentSize;
+	segmentOffset.SetNum(numSegments);
+	segmentSize.SetNum(numSegments);
+	for (int i = 0; i < numSegments; i++) {
+		imageFile->ReadInt(segmentOffset[i]);
+		imageFile->ReadInt(segmentSize[i]);
+	}
+
+	//read base cache image from its own file
+	idStr game = cvarSystem->GetCVarString("fs_currentfm");
+	idFile *baseFile = fileSystem->OpenFileRead(baseName, game.Length() ? game.c_str() : NULL);
+	if (!baseFile)
+		Error("idRestoreGame::InitializeCache: base savegame %s not found", baseName.c_str());
+	int fileBaseId = 0;
+	baseFile->ReadInt(fileBaseId);
+	if (fileBaseId != baseId) {
+		fileSystem->CloseFile(baseFile);
+		Error("idRestoreGame::InitializeCache: base savegame %s was overwritten", baseName.c_str());
+	}
+	CRawVector base;
+	ReadCacheImage(baseFile, base, false);
+	fileSystem->CloseFile(baseFile);
+
+	//read data not present in base
+	CRawVector literals;
+	ReadCacheImage(imageFile, literals, false);
+
+	//compose full cache
+	image.resize(cacheSize);
+	int pos = 0, literalPos = 0;
+	for (int i = 0; i < numSegments; i++) {
+		int offset = segmentOffset[i], size = segmentSize[i];
+		bool bad = (size < 0 || pos + size > cacheSize);
+		if (offset < 0)
+			bad = bad || (literalPos + size > literals.size());
+		else
+			bad = bad || (offset + size > base.size());
+		if (bad)
+			Error("idRestoreGame::InitializeCache: bad delta segment %d", i);
+		if (offset < 0) {
+			memcpy(image.data() + pos, literals.data() + literalPos, size);
+			literalPos += size;
+		}
+		else {
+			memcpy(image.data() + pos, base.data() + offset, size);
+		}
+		pos += size;
+	}
+	if (pos != cacheSize)
+		Error("idRestoreGame::InitializeCache: delta covers %d bytes instead of %d", pos, cacheSize);
 }
 
 void idRestoreGame::CreateObjects( void ) {
@@ -1223,3 +1432,401 @@ DEFINE_READWRITE_VECMAT(idVec6, Vec6)
 DEFINE_READWRITE_VECMAT(idMat3, Mat3)
 DEFINE_READWRITE_VECMAT(idAngles, Angles)
 
+
+/***********************************************************************
+
+	idSaveGameWriter
+	
+***********************************************************************/
+
+idSaveGameWriter saveGameWriter;
+
+void idSaveGameWriter::Shutdown() {
+	Wait();
+	if ( jobList ) {
+		parallelJobManager->FreeJobList( jobList );
+		jobList = nullptr;
+	}
+}
+
+double idSaveGameWriter::Wait() {
+	if ( !thread.joinable() ) {
+		return 0.0;
+	}
+	TRACE_CPU_SCOPE( "SaveGameWriter:Wait" )
+	double startTicks = Sys_GetClockTicks();
+	thread.join();
+	// worker has renamed the file behind file system's back
+	fileSystem->ClearDirCache();
+	PrintMessages();
+	return ( Sys_GetClockTicks() - startTicks ) * 1000.0 / Sys_ClockTicksPerSecond();
+}
+
+void idSaveGameWriter::Update() {
+	if ( thread.joinable() && finished.load( std::memory_order_acquire ) ) {
+		Wait();
+	}
+}
+
+// set on savegame writer thread
+static thread_local bool isSaveGameWorker = false;
+
+void idSaveGameWriter::Printf( const char *fmt, ... ) {
+	va_list argptr;
+	char text[MAX_STRING_CHARS];
+	va_start( argptr, fmt );
+	idStr::vsnPrintf( text, sizeof( text ), fmt, argptr );
+	va_end( argptr );
+	if ( isSaveGameWorker ) {
+		messages.Append( text );
+		messageIsWarning.Append( false );
+	} else {
+		common->Printf( "%s", text );
+	}
+}
+
+void idSaveGameWriter::Warning( const char *fmt, ... ) {
+	va_list argptr;
+	char text[MAX_STRING_CHARS];
+	va_start( argptr, fmt );
+	idStr::vsnPrintf( text, sizeof( text ), fmt, argptr );
+	va_end( argptr );
+	if ( isSaveGameWorker ) {
+		messages.Append( text );
+		messageIsWarning.Append( true );
+	} else {
+		common->Warning( "%s", text );
+	}
+}
+
+void idSaveGameWriter::PrintMessages() {
+	for ( int i = 0; i < messages.Num(); i++ ) {
+		if ( messageIsWarning[i] ) {
+			common->Warning( "%s", messages[i].c_str() );
+		} else {
+			common->Printf( "%s", messages[i].c_str() );
+		}
+	}
+	messages.Clear();
+	messageIsWarning.Clear();
+}
+
+void idSaveGameWriter::Begin( const idFile *file ) {
+	assert( !thread.joinable() );
+	collecting = true;
+	collectFile = file;
+	hasCache = false;
+}
+
+void idSaveGameWriter::TakeCache( CRawVector &gameCache, idList<int> &gameBlobEnds ) {
+	assert( collecting );
+	std::swap( cache, gameCache );
+	blobEnds.Swap( gameBlobEnds );
+	hasCache = true;
+}
+
+void idSaveGameWriter::Cancel() {
+	collecting = false;
+	collectFile = nullptr;
+	hasCache = false;
+	cache.clear();
+}
+
+bool idSaveGameWriter::Submit( idFile_Memory *file, const char *relativePath ) {
+	assert( collecting && file == collectFile );
+	collecting = false;
+	collectFile = nullptr;
+
+	idStr tempName = idStr( relativePath ) + ".tmp";
+	tempFile = fileSystem->OpenFileWrite( tempName );
+	if ( !tempFile ) {
+		common->Warning( "Failed to open save file '%s'", tempName.c_str() );
+		delete file;
+		Cancel();
+		return false;
+	}
+	tempPath = tempFile->GetFullPath();
+	finalPath = tempPath;
+	finalPath.CapLength( finalPath.Length() - 4 );
+
+	if ( !jobList ) {
+		jobList = parallelJobManager->AllocJobList( JOBLIST_UTILITY, JOBLIST_PRIORITY_LOW, 1024, 0, nullptr );
+	}
+	memFile = file;
+	submitTicks = Sys_GetClockTicks();
+	finished.store( false );
+	thread = std::thread( [this]() {
+		isSaveGameWorker = true;
+		Run();
+		finished.store( true, std::memory_order_release );
+	} );
+	return true;
+}
+
+void idSaveGameWriter::Run() {
+	bool ok = true;
+	if ( hasCache ) {
+		ok = idSaveGame::WriteCacheImage( cache, blobEnds, memFile, jobList );
+		CRawVector empty;
+		std::swap( cache, empty );
+		blobEnds.Clear();
+		hasCache = false;
+	}
+	if ( ok ) {
+		ok = ( tempFile->Write( memFile->GetDataPtr(), memFile->Length() ) == memFile->Length() );
+	}
+	delete tempFile;
+	tempFile = nullptr;
+	delete memFile;
+	memFile = nullptr;
+
+	if ( ok ) {
+		// replaces existing file atomically, except on Windows where it has to be removed first
+		if ( rename( tempPath.c_str(), finalPath.c_str() ) != 0 ) {
+			remove( finalPath.c_str() );
+			ok = ( rename( tempPath.c_str(), finalPath.c_str() ) == 0 );
+		}
+	}
+	if ( !ok ) {
+		Warning( "Failed to write save file '%s'", finalPath.c_str() );
+		remove( tempPath.c_str() );
+		return;
+	}
+	Printf( "Savegame written in background: %.1lf ms\n", ( Sys_GetClockTicks() - submitTicks ) * 1000.0 / Sys_ClockTicksPerSecond() );
+}
+
+/***********************************************************************
+
+	idSaveGameDelta
+	
+***********************************************************************/
+
+idSaveGameDelta saveGameDelta;
+
+void idSaveGameDelta::Clear() {
+	CloseBaseFile();
+	targetName.Clear();
+	targetBase = nullptr;
+	bases.DeleteContents( true );
+}
+
+int idSaveGameDelta::FindBase( const char *relativePath ) const {
+	for ( int i = 0; i < bases.Num(); i++ ) {
+		if ( bases[i]->name == relativePath ) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+void idSaveGameDelta::CloseBaseFile() {
+	if ( !baseFile ) {
+		return;
+	}
+	idStr tempPath = baseFile->GetFullPath();
+	delete baseFile;
+	baseFile = nullptr;
+	remove( tempPath.c_str() );
+}
+
+void idSaveGameDelta::SetTarget( const char *relativePath ) {
+	// base file opened for previous save is not used if game failed to save
+	CloseBaseFile();
+	targetBase = nullptr;
+	if ( !relativePath ) {
+		targetName.Clear();
+		return;
+	}
+	targetName = relativePath;
+	targetBaseName = targetName;
+	targetBaseName.SetFileExtension( ".savebase" );
+	targetBaseOSPath = fileSystem->RelativePathToOSPath( targetBaseName, "fs_modSavePath" );
+
+	int index = FindBase( targetName );
+	if ( index < 0 ) {
+		// every base holds full cache: keep as many as there are quicksave slots
+		int maxBases = idMath::Imax( cvarSystem->GetCVarInteger( "com_numQuickSaves" ), 1 );
+		while ( bases.Num() >= maxBases ) {
+			int oldest = 0;
+			for ( int i = 1; i < bases.Num(); i++ ) {
+				if ( bases[i]->lastUsed < bases[oldest]->lastUsed ) {
+					oldest = i;
+				}
+			}
+			delete bases[oldest];
+			bases.RemoveIndex( oldest );
+		}
+		Base *base = new Base();
+		base->name = targetName;
+		index = bases.Append( base );
+	}
+	targetBase = bases[index];
+	targetBase->lastUsed = ++useCounter;
+	if ( targetBase->id != 0 && targetBase->numDeltas < cv_savegame_delta.GetInteger() ) {
+		return;
+	}
+
+	// base has to be rewritten: file system is not thread-safe, so open the file now
+	idStr tempPath = targetBaseOSPath + ".tmp";
+	baseFile = fileSystem->OpenExplicitFileWrite( tempPath );
+	if ( !baseFile ) {
+		common->Warning( "Failed to open file '%s'", tempPath.c_str() );
+	}
+}
+
+void idSaveGameDelta::RemoveBase( const char *relativePath ) {
+	// writer thread may be using the base right now
+	saveGameWriter.Wait();
+
+	int index = FindBase( relativePath );
+	if ( index >= 0 ) {
+		if ( targetBase == bases[index] ) {
+			CloseBaseFile();
+			targetName.Clear();
+			targetBase = nullptr;
+		}
+		delete bases[index];
+		bases.RemoveIndex( index );
+	}
+	idStr baseName = relativePath;
+	baseName.SetFileExtension( ".savebase" );
+	fileSystem->RemoveFile( baseName );
+}
+
+bool idSaveGameDelta::WriteBase( const CRawVector &cache, const idList<int> &blobEnds, idParallelJobList *jobList ) {
+	if ( !baseFile ) {
+		return false;
+	}
+	// never returns zero, which means base was never written
+	int id = ( int( Sys_GetClockTicks() ) ^ ( targetBase->id + 1 ) ) | 1;
+
+	idStr tempPath = baseFile->GetFullPath();
+	baseFile->WriteInt( id );
+	bool ok = ( WriteCacheChunks( cache.data(), cache.size(), baseFile, jobList ) >= 0 );
+	// file is closed without file system, like temporary file of savegame writer
+	delete baseFile;
+	baseFile = nullptr;
+	if ( ok && rename( tempPath.c_str(), targetBaseOSPath.c_str() ) != 0 ) {
+		remove( targetBaseOSPath.c_str() );
+		ok = ( rename( tempPath.c_str(), targetBaseOSPath.c_str() ) == 0 );
+	}
+	if ( !ok ) {
+		remove( tempPath.c_str() );
+		return false;
+	}
+
+	// remember base and index its blobs by contents
+	Base &base = *targetBase;
+	base.cache.resize( cache.size() );
+	memcpy( base.cache.data(), cache.data(), cache.size() );
+	base.blobStart.SetNum( blobEnds.Num() );
+	base.blobSize.SetNum( blobEnds.Num() );
+	base.blobHash.ClearFree( 4096, blobEnds.Num() );
+	for ( int i = 0; i < blobEnds.Num(); i++ ) {
+		int start = ( i > 0 ? blobEnds[i - 1] : 0 );
+		base.blobStart[i] = start;
+		base.blobSize[i] = blobEnds[i] - start;
+		base.blobHash.Add( MD5_BlockChecksum( cache.data() + start, base.blobSize[i] ), i );
+	}
+	base.id = id;
+	base.numDeltas = 0;
+	return true;
+}
+
+int idSaveGameDelta::WriteDeltaImage( const CRawVector &cache, const idList<int> &blobEnds, idFile *file, idParallelJobList *jobList ) {
+	if ( baseFile || targetBase->id == 0 ) {
+		if ( !WriteBase( cache, blobEnds, jobList ) ) {
+			saveGameWriter.Warning( "Failed to write base savegame, saving full state" );
+			return WriteCacheChunks( cache.data(), cache.size(), file, jobList );
+		}
+	}
+	const Base &base = *targetBase;
+
+	// unchanged blobs are referenced from base, the rest is copied to literals
+	idList<int> segmentOffset, segmentSize;
+	CRawVector literals;
+	for ( int i = 0; i < blobEnds.Num(); i++ ) {
+		int start = ( i > 0 ? blobEnds[i - 1] : 0 );
+		int size = blobEnds[i] - start;
+		if ( size == 0 ) {
+			continue;
+		}
+		int offset = -1;
+		int key = MD5_BlockChecksum( cache.data() + start, size );
+		for ( int j = base.blobHash.First( key ); j != -1; j = base.blobHash.Next( j ) ) {
+			if ( base.blobSize[j] == size && memcmp( base.cache.data() + base.blobStart[j], cache.data() + start, size ) == 0 ) {
+				offset = base.blobStart[j];
+				break;
+			}
+		}
+		if ( offset < 0 ) {
+			int pos = literals.size();
+			literals.resize( pos + size );
+			memcpy( literals.data() + pos, cache.data() + start, size );
+		}
+
+		// merge with previous segment if contiguous
+		int last = segmentOffset.Num() - 1;
+		if ( last >= 0 && ( offset < 0 ? segmentOffset[last] < 0 : segmentOffset[last] >= 0 && segmentOffset[last] + segmentSize[last] == offset ) ) {
+			segmentSize[last] += size;
+		} else {
+			segmentOffset.Append( offset );
+			segmentSize.Append( size );
+		}
+	}
+
+	int written = 0;
+	file->WriteInt( 0 );								written += sizeof( int );
+	file->WriteString( targetBaseName );				written += sizeof( int ) + targetBaseName.Length();
+	file->WriteInt( base.id );							written += sizeof( int );
+	file->WriteInt( cache.size() );						written += sizeof( int );
+	file->WriteInt( segmentOffset.Num() );				written += sizeof( int );
+	for ( int i = 0; i < segmentOffset.Num(); i++ ) {
+		file->WriteInt( segmentOffset[i] );				written += sizeof( int );
+		file->WriteInt( segmentSize[i] );				written += sizeof( int );
+	}
+	int literalsWritten = WriteCacheChunks( literals.data(), literals.size(), file, jobList );
+	if ( literalsWritten < 0 ) {
+		return -1;
+	}
+	targetBase->numDeltas++;
+	return written + literalsWritten;
+}
+
+
+#include "../../tests/testing.h"
+
+TEST_CASE("SaveGame:CacheImageRoundTrip") {
+	// compressible data spanning several chunks, last one partial
+	CRawVector cache;
+	cache.resize( SAVEGAME_CACHE_CHUNK_SIZE * 5 / 2 + 123 );
+	idRandom rnd( 1337 );
+	for ( size_t i = 0; i < cache.size(); i++ ) {
+		cache[i] = char( ( i % 251 ) < 200 ? i % 7 : rnd.RandomInt( 256 ) );
+	}
+	idList<int> blobEnds;
+	for ( int pos = 1000; pos < (int)cache.size(); pos += 77777 ) {
+		blobEnds.Append( pos );
+	}
+	blobEnds.Append( cache.size() );
+
+	saveGameDelta.SetTarget( NULL );
+	idFile_Memory written( "test.save" );
+	written.WriteInt( 0 );			// code revision
+	written.WriteBool( true );		// compressed
+	REQUIRE( idSaveGame::WriteCacheImage( cache, blobEnds, &written, nullptr ) );
+
+	idFile_Memory readFile( "test.save", written.GetDataPtr(), written.Length() );
+	idRestoreGame restore( &readFile );
+	restore.ReadHeader();
+	restore.InitializeCache();
+	int mismatches = 0;
+	for ( size_t i = 0; i < cache.size(); i++ ) {
+		byte value;
+		restore.ReadByte( value );
+		if ( char( value ) != cache[i] ) {
+			mismatches++;
+		}
+	}
+	CHECK( mismatches == 0 );
+}
@@ -22,6 +22,9 @@ Save game related helper classes.
 
 */
 
+#include <thread>
+#include <atomic>
+
 #include "../RawVector.h"
 
 const int INITIAL_RELEASE_BUILD_NUMBER = 1262;
@@ -106,6 +109,11 @@ public:
 	// Dump the contents of cache buffer to file
 	void					FinalizeCache();
 
+	// compresses cache image in independent chunks using given job list, and writes it to file
+	// blobEnds are offsets in cache where serialized objects end, they are used by delta savegames
+	// returns false if compression failed
+	static bool				WriteCacheImage( const CRawVector &cache, const idList<int> &blobEnds, idFile *file, idParallelJobList *jobList );
+
 private:
 	idFile *				file;
 
@@ -113,6 +121,7 @@ private:
 
 	bool					isCompressed;
 	CRawVector				cache;
+	idList<int>				blobEnds;
 
 	void					CallSave_r( const idTypeInfo *cls, const idClass *obj );
 };
@@ -199,6 +208,122 @@ private:
 	int						cachePointer;
 
 	void					CallRestore_r( const idTypeInfo *cls, idClass *obj );
+
+	void					ReadCacheImage( idFile *imageFile, CRawVector &image, bool allowDelta );
+	void					ReadDeltaImage( idFile *imageFile, CRawVector &image );
+};
+
+/*
+Writes savegames to disk in background.
+Game state is serialized into memory file on main thread, then worker thread compresses the cache image
+and writes everything to temporary file, which is renamed to the final name when complete.
+Only one savegame is written at once: next save or load waits until the previous one is finished.
+*/
+class idSaveGameWriter {
+public:
+	void					Shutdown();
+
+	// waits until previous savegame is written, returns time spent waiting in milliseconds
+	double					Wait();
+	bool					IsWriting() const { return thread.joinable(); }
+	// called every frame on main thread: finishes savegame written in background and prints its messages
+	void					Update();
+
+	// can be called from any thread, messages of worker thread are printed by main thread when it finishes
+	// (only console is thread-safe, log file and redirect buffer are not)
+	void					Printf( const char *fmt, ... ) id_attribute((format(printf,2,3)));
+	void					Warning( const char *fmt, ... ) id_attribute((format(printf,2,3)));
+
+	// between Begin and Submit/Cancel, idSaveGame::FinalizeCache of the given file hands cache over instead of compressing it
+	// Cancel must be called if game fails to save after Begin
+	void					Begin( const idFile *file );
+	bool					IsCollecting( const idFile *file ) const { return collecting && file == collectFile; }
+	void					TakeCache( CRawVector &cache, idList<int> &blobEnds );
+	void					Cancel();
+
+	// starts writing contents of memory file into savegame file (path relative to fs_savepath)
+	// takes ownership of memory file
+	bool					Submit( idFile_Memory *memFile, const char *relativePath );
+
+private:
+	void					Run();
+	void					PrintMessages();
+
+	bool					collecting = false;
+	const idFile *			collectFile = nullptr;	// memory file of the save which started collecting
+	std::thread				thread;
+	idParallelJobList *		jobList = nullptr;
+
+	// data of the savegame being written, owned by worker thread
+	idFile_Memory *			memFile = nullptr;
+	CRawVector				cache;
+	idList<int>				blobEnds;
+	bool					hasCache = false;
+	idFile *				tempFile = nullptr;
+	idStr					tempPath;				// OS path
+	idStr					finalPath;				// OS path
+	double					submitTicks = 0.0;
+	idStrList				messages;				// appended by worker thread
+	idList<bool>			messageIsWarning;
+	std::atomic<bool>		finished{ false };
 };
 
+extern idSaveGameWriter		saveGameWriter;
+
+/*
+Incremental (delta) savegames.
+Cache image of delta savegame stores only the blobs (serialized objects) which are not found in its base,
+everything else is referenced by offset in the cache of base. Base is a full cache image stored in
+separate file (<savename>.savebase), and all deltas of one savegame name refer to the same base.
+Quicksaves rotate over several names, so every name keeps its own base in memory (up to com_numQuickSaves).
+Base of a name is rewritten on its first save after game start and after every N deltas (see tdm_savegame_delta),
+so restoring a savegame never needs more than one extra file.
+SetTarget and RemoveBase are called on main thread, WriteDeltaImage may run on savegame writer thread.
+*/
+class idSaveGameDelta {
+public:
+	void					Clear();
+
+	// called before game is saved: delta is written only if save name is set
+	// opens base file for writing if base has to be rewritten by this save
+	void					SetTarget( const char *relativePath );
+	bool					IsTargeted() const { return targetName.Length() > 0; }
+
+	// writes delta cache image of the target savegame, rewrites base if necessary
+	// returns number of bytes written, or -1 on failure
+	int						WriteDeltaImage( const CRawVector &cache, const idList<int> &blobEnds, idFile *file, idParallelJobList *jobList );
+
+	// forgets base of the savegame and deletes its file, called when savegame is deleted or saved without delta
+	void					RemoveBase( const char *relativePath );
+
+private:
+	struct Base {
+		idStr				name;					// savegame path relative to fs_modSavePath
+		int					id = 0;
+		int					numDeltas = 0;
+		int					lastUsed = 0;			// for evicting least recently used base
+		CRawVector			cache;
+		idList<int>			blobStart;
+		idList<int>			blobSize;
+		idHashIndex			blobHash;
+	};
+
+	int						FindBase( const char *relativePath ) const;
+	bool					WriteBase( const CRawVector &cache, const idList<int> &blobEnds, idParallelJobList *jobList );
+	void					CloseBaseFile();
+
+	// target of current save
+	idStr					targetName;				// savegame path relative to fs_modSavePath
+	idStr					targetBaseName;			// base path relative to fs_modSavePath
+	idStr					targetBaseOSPath;
+	Base *					targetBase = nullptr;	// null if base has to be rewritten
+	idFile *				baseFile = nullptr;		// temporary file for new base, opened on main thread
+	int						useCounter = 0;
+
+	// bases kept in memory after they were written, one per savegame name
+	idList<Base *>			bases;
+};
+
+extern idSaveGameDelta		saveGameDelta;
+
 #endif /* !__SAVEGAME_H__*/
@@ -28,12 +28,14 @@ Project: The Dark Mod (http://www.thedarkmod.com/)
 #include "../Inventory/InventoryItem.h"
 #include "../TimerManager.h"
 #include "../ai/Conversation/ConversationSystem.h"
+#include "../ai/PerceptionScheduler.h"
 #include "../Missions/MissionManager.h"
 #include "../Missions/ModInfo.h"
 #include "../FrobDoorHandle.h"
 #include "../FrobLockHandle.h"
 #include "../FrobLever.h"
 #include "../Grabber.h"
+#include "../LogWriter.h"
 
 #include "TypeInfo.h"
 
@@ -75,6 +77,19 @@ void Cmd_PrintAIRelations_f( const idCmdArgs &args )
 	return;
 }
 
+/*
+==================
+Cmd_PrintAIPerceptionStats_f
+==================
+*/
+void Cmd_PrintAIPerceptionStats_f( const idCmdArgs &args ) 
+{
+	if ( gameLocal.m_PerceptionScheduler )
+	{
+		gameLocal.m_PerceptionScheduler->PrintStats();
+	}
+}
+
 /**
  * greebo: This is a helper command, used in mainmenu_failure.gui
  */
@@ -645,6 +660,44 @@ void Cmd_Script_f( const idCmdArgs &args ) {
 	}
 }
 
+/*
+===================
+Cmd_ScriptProfile_f
+===================
+*/
+void Cmd_ScriptProfile_f( const idCmdArgs &args ) {
+	idStr cmd = args.Argv( 1 );
+	if ( cmd == "start" ) {
+		scriptProfiler.Start();
+		gameLocal.Printf( "Script profiling started\n" );
+	} else if ( cmd == "stop" ) {
+		scriptProfiler.Stop();
+		gameLocal.Printf( "Script profiling stopped\n" );
+	} else if ( cmd == "dump" ) {
+		scriptProfiler.Dump( args.Argc() > 2 ? args.Argv( 2 ) : "scriptProfile" );
+	} else {
+		gameLocal.Printf( "usage: scriptProfile start|stop|dump [filename]\n" );
+	}
+}
+
+/*
+===================
+Cmd_ScriptTrace_f
+===================
+*/
+void Cmd_ScriptTrace_f( const idCmdArgs &args ) {
+	idStr cmd = args.Argv( 1 );
+	if ( cmd == "start" ) {
+		scriptTrace.Start( args.Argc() > 2 ? args.Argv( 2 ) : "scriptTrace", args.Argc() > 3 ? atoi( args.Argv( 3 ) ) : 0 );
+	} else if ( cmd == "stop" ) {
+		scriptTrace.Stop();
+	} else if ( cmd == "compare" && args.Argc() > 3 ) {
+		idScriptTrace::Compare( args.Argv( 2 ), args.Argv( 3 ) );
+	} else {
+		gameLocal.Printf( "usage: scriptTrace start [filename] [frames] | stop | compare filename1 filename2\n" );
+	}
+}
+
 /*
 ==================
 KillEntities
@@ -725,6 +778,63 @@ void Cmd_KillRagdolls_f( const idCmdArgs &args ) {
 	KillEntities( args, idAFEntity_WithAttachedHead::Type );
 }
 
+/*
+==================
+Cmd_AFStressTest_f
+
+Spawns a grid of ragdolls in front of the player to measure AF island solver.
+==================
+*/
+void Cmd_AFStressTest_f( const idCmdArgs &args ) {
+	idPlayer *player = gameLocal.GetLocalPlayer();
+	if ( !player || !gameLocal.CheatsOk( false ) ) {
+		return;
+	}
+	if ( args.Argc() < 3 ) {
+		gameLocal.Printf( "usage: af_stressTest <ragdoll classname> <count> [spacing]\n" );
+		return;
+	}
+
+	const char *classname = args.Argv( 1 );
+	int count = idMath::ClampInt( 1, 1024, atoi( args.Argv( 2 ) ) );
+	float spacing = args.Argc() > 3 ? atof( args.Argv( 3 ) ) : 64.0f;
+	int side = (int)idMath::Ceil( idMath::Sqrt( (float)count ) );
+
+	float yaw = player->viewAngles.yaw;
+	idVec3 forward = idAngles( 0, yaw, 0 ).ToForward();
+	idVec3 right = idAngles( 0, yaw - 90, 0 ).ToForward();
+	idVec3 base = player->GetEyePosition() + forward * 96.0f - right * ( ( side - 1 ) * spacing * 0.5f );
+
+	int spawned = 0;
+	for ( int i = 0; i < count; i++ ) {
+		idVec3 org = base + forward * ( ( i / side ) * spacing ) + right * ( ( i % side ) * spacing );
+		idDict dict;
+		dict.Set( "classname", classname );
+		dict.Set( "origin", org.ToString() );
+		dict.Set( "angle", va( "%f", yaw + 180 ) );
+		idEntity *ent = NULL;
+		if ( gameLocal.SpawnEntityDef( dict, &ent ) && ent ) {
+			ent->ActivatePhysics( player );
+			spawned++;
+		}
+	}
+
+	gameLocal.afIslandSolver.ResetStats();
+	gameLocal.Printf( "Spawned %d x %s, run af_islandStats after they settle (toggle af_parallelIslands to compare)\n", spawned, classname );
+}
+
+/*
+==================
+Cmd_AFIslandStats_f
+==================
+*/
+void Cmd_AFIslandStats_f( const idCmdArgs &args ) {
+	gameLocal.afIslandSolver.PrintStats();
+	if ( args.Argc() > 1 && idStr::Icmp( args.Argv( 1 ), "reset" ) == 0 ) {
+		gameLocal.afIslandSolver.ResetStats();
+	}
+}
+
 /*
 ==================
 Cmd_Give_f
@@ -2663,6 +2773,24 @@ void Cmd_ShowReachabilities_f(const idCmdArgs& args)
 	}
 }
 
+void Cmd_AASRouteBenchmark_f(const idCmdArgs& args)
+{
+	if (args.Argc() < 2)
+	{
+		common->Printf( "usage: aas_routeBenchmark <numQueries> [aasName] [flush]\n" );
+		return;
+	}
+
+	idAASLocal* aas = dynamic_cast<idAASLocal*>(gameLocal.GetAAS(args.Argc() > 2 ? args.Argv(2) : "aas32"));
+	if (aas == NULL)
+	{
+		common->Printf( "AAS not found\n" );
+		return;
+	}
+
+	aas->RouteBenchmark(atoi(args.Argv(1)), args.Argc() > 3 && atoi(args.Argv(3)) != 0);
+}
+
 void Cmd_ShowAASStats_f(const idCmdArgs& args)
 {
 	for (int i = 0; i < gameLocal.NumAAS(); i++)
@@ -3626,6 +3754,9 @@ void idGameLocal::InitConsoleCommands( void ) {
 	cmdSystem->AddCommand( "listClasses",			idClass::ListClasses_f,		CMD_FL_GAME,				"lists game classes" );
 	cmdSystem->AddCommand( "listThreads",			idThread::ListThreads_f,	CMD_FL_GAME|CMD_FL_CHEAT,	"lists script threads" );
 	cmdSystem->AddCommand( "listEvents",			Cmd_EventList_f,			CMD_FL_GAME|CMD_FL_CHEAT,	"lists game events currently alive" );
+	cmdSystem->AddCommand( "eventBenchmark",		Cmd_EventBenchmark_f,		CMD_FL_GAME|CMD_FL_CHEAT,	"measures scheduling and cancelling of many events, usage: eventBenchmark [numEvents]" );
+	cmdSystem->AddCommand( "scriptEventBenchmark",	Cmd_ScriptEventBenchmark_f,	CMD_FL_GAME|CMD_FL_CHEAT,	"measures calling script events from compiled script loops, usage: scriptEventBenchmark [numCalls]" );
+	cmdSystem->AddCommand( "logBenchmark",			Cmd_LogBenchmark_f,			CMD_FL_GAME|CMD_FL_CHEAT,	"compares writing log lines directly and through background log writer, usage: logBenchmark [numLines]" );
 	cmdSystem->AddCommand( "listEntities",			Cmd_EntityList_f,			CMD_FL_GAME | CMD_FL_CHEAT, "lists game entities" );
 	cmdSystem->AddCommand( "countEntities",			Cmd_EntityCount_f,			CMD_FL_GAME | CMD_FL_CHEAT, "counts game entities by class" ); // #3924
 	cmdSystem->AddCommand( "listActiveEntities",	Cmd_ActiveEntityList_f,		CMD_FL_GAME|CMD_FL_CHEAT,	"lists active game entities" );
@@ -3652,6 +3783,8 @@ void idGameLocal::InitConsoleCommands( void ) {
 	cmdSystem->AddCommand( "killMonsters",			Cmd_KillMonsters_f,			CMD_FL_GAME|CMD_FL_CHEAT,	"removes all monsters" );
 	cmdSystem->AddCommand( "killMoveables",			Cmd_KillMovables_f,			CMD_FL_GAME|CMD_FL_CHEAT,	"removes all moveables" );
 	cmdSystem->AddCommand( "killRagdolls",			Cmd_KillRagdolls_f,			CMD_FL_GAME|CMD_FL_CHEAT,	"removes all ragdolls" );
+	cmdSystem->AddCommand( "af_stressTest",			Cmd_AFStressTest_f,			CMD_FL_GAME|CMD_FL_CHEAT,	"spawns a grid of ragdolls: af_stressTest <classname> <count> [spacing]", idCmdSystem::ArgCompletion_Decl<DECL_ENTITYDEF> );
+	cmdSystem->AddCommand( "af_islandStats",		Cmd_AFIslandStats_f,		CMD_FL_GAME,				"prints timings of parallel ragdoll evaluation, pass 'reset' to start over" );
 	cmdSystem->AddCommand( "addline",				Cmd_AddDebugLine_f,			CMD_FL_GAME|CMD_FL_CHEAT,	"adds a debug line" );
 	cmdSystem->AddCommand( "addarrow",				Cmd_AddDebugLine_f,			CMD_FL_GAME|CMD_FL_CHEAT,	"adds a debug arrow" );
 	cmdSystem->AddCommand( "removeline",			Cmd_RemoveDebugLine_f,		CMD_FL_GAME|CMD_FL_CHEAT,	"removes a debug line" );
@@ -3681,6 +3814,8 @@ void idGameLocal::InitConsoleCommands( void ) {
 	cmdSystem->AddCommand( "tdm_lod_bias_changed",		Cmd_LODBiasChanged_f,			CMD_FL_GAME,	"Updates entity visibility according to tdm_lod_bias." );
 
 	cmdSystem->AddCommand( "script",				Cmd_Script_f,				CMD_FL_GAME|CMD_FL_CHEAT,	"executes a line of script" );
+	cmdSystem->AddCommand( "scriptProfile",			Cmd_ScriptProfile_f,		CMD_FL_GAME,				"profiles game scripts: scriptProfile start|stop|dump [filename], dump writes <filename>.txt report and <filename>.folded stacks" );
+	cmdSystem->AddCommand( "scriptTrace",			Cmd_ScriptTrace_f,			CMD_FL_GAME,				"records executed script statements: scriptTrace start [filename] [frames] | stop | compare filename1 filename2" );
 	cmdSystem->AddCommand( "listCollisionModels",	Cmd_ListCollisionModels_f,	CMD_FL_GAME,				"lists collision models" );
 	cmdSystem->AddCommand( "collisionModelInfo",	Cmd_CollisionModelInfo_f,	CMD_FL_GAME,				"shows collision model info" );
 	cmdSystem->AddCommand( "reexportmodels",		Cmd_ReexportModels_f,		CMD_FL_GAME|CMD_FL_CHEAT,	"reexports models", ArgCompletion_DefFile );
@@ -3702,6 +3837,7 @@ void idGameLocal::InitConsoleCommands( void ) {
 
 	cmdSystem->AddCommand( "tdm_spr_testIO",		Cmd_TestSndIO_f,			CMD_FL_GAME,				"test soundprop file IO (needs a .spr file)" );
 	cmdSystem->AddCommand( "tdm_ai_rel_print",		Cmd_PrintAIRelations_f,		CMD_FL_GAME,				"print the relationship matrix determining relations between AI teams." );
+	cmdSystem->AddCommand( "tdm_ai_perception_stats",	Cmd_PrintAIPerceptionStats_f,	CMD_FL_GAME,			"print latency of scheduled visual scans for every AI (see tdm_ai_opt_perception_budget)." );
 
 	cmdSystem->AddCommand( "tdm_attach_offset",		Cmd_AttachmentOffset_f,		CMD_FL_GAME,				"Set the vector offset (x y z) for an attachment on an AI you are looking at.  Usage: tdm_attach_offset <attachment index> <x> <y> <z>" );
 	cmdSystem->AddCommand( "tdm_attach_rot",		Cmd_AttachmentRot_f,		CMD_FL_GAME,				"Set the rotation (pitch yaw roll) for an attachment on an AI you are looking at.  Usage: tdm_attach_rot <atachment index> <pitch> <yaw> <roll>  (NOTE: Rotation is applied before translation, angles are relative to the joint orientation)" );
@@ -3715,6 +3851,7 @@ void idGameLocal::InitConsoleCommands( void ) {
 
 	cmdSystem->AddCommand( "aas_showWalkPath",		Cmd_ShowWalkPath_f,			CMD_FL_GAME,				"Shows the walk path from the player to the given area number (AAS32)." );
 	cmdSystem->AddCommand( "aas_showReachabilities",Cmd_ShowReachabilities_f,			CMD_FL_GAME,				"Shows the reachabilities for the given area number (AAS32)." );
+	cmdSystem->AddCommand( "aas_routeBenchmark",	Cmd_AASRouteBenchmark_f,	CMD_FL_GAME,				"runs route queries between random areas and prints latency percentiles: aas_routeBenchmark <numQueries> [aasName] [flush]" );
 	cmdSystem->AddCommand( "aas_showStats",			Cmd_ShowAASStats_f,			CMD_FL_GAME,				"Shows the AAS statistics." );
 	cmdSystem->AddCommand( "eas_showRoute",			Cmd_ShowEASRoute_f,			CMD_FL_GAME,				"Shows the EAS route to the goal area." );
 
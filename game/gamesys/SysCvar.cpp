@@ -83,6 +83,9 @@ idCVar cv_ai_acuity_L5	(			"tdm_ai_acuity_L5",			"1.5",			CVAR_GAME | CVAR_ARCHI
 idCVar cv_sndprop_disable(			"tdm_sndprop_disable",		"0",			CVAR_GAME | CVAR_ARCHIVE | CVAR_BOOL,  "If set to true, sound propagation will not be calculated." );
 idCVar cv_spr_debug(				"tdm_spr_debug",			"0",			CVAR_GAME | CVAR_ARCHIVE | CVAR_BOOL,  "If set to true, sound propagation debugging information will be sent to the console, and the log information will become more detailed." );
 idCVar cv_spr_show(					"tdm_showsprop",			"0",			CVAR_GAME | CVAR_ARCHIVE | CVAR_BOOL,  "If set to true, sound propagation paths to nearby AI will be shown as lines. The volume of the sound heard by the AI and the alert increase will be displayed." );
+idCVar cv_spr_cache(				"tdm_spr_cache",			"1",			CVAR_GAME | CVAR_BOOL,  "If set to true, results of sound wavefront expansion are cached per source area and reused for sounds from nearby points until portal losses change." );
+idCVar cv_spr_cache_radius(			"tdm_spr_cache_radius",		"16",			CVAR_GAME | CVAR_FLOAT, "Max distance between origins of sounds which can share cached wavefront expansion. Losses are adjusted for new distances to the portals of source area, but paths are not re-minimized." );
+idCVar cv_spr_stats(				"tdm_spr_stats",			"0",			CVAR_GAME | CVAR_BOOL,  "If set to true, the number of propagated sounds, wavefront expansions and expansion cache hits per second is printed to the console." );
 idCVar cv_spr_radius_show(			"tdm_showsprop_radius",		"0",			CVAR_GAME | CVAR_ARCHIVE | CVAR_BOOL,  "If set to true, sound ranges are drawn." );
 
 idCVar cv_ko_show(					"tdm_showko",				"0",			CVAR_GAME | CVAR_ARCHIVE | CVAR_BOOL,  "If set to true, knockout zones will be shown for debugging." );
@@ -108,6 +111,9 @@ idCVar cv_ai_opt_interleavethinkmaxdist (		"tdm_ai_opt_interleavethinkmaxdist",
 idCVar cv_ai_opt_interleavethinkskippvscheck (	"tdm_ai_opt_interleavethinkskipPVS",		"0",	CVAR_GAME | CVAR_ARCHIVE | CVAR_BOOL, "If true (nonzero), the player PVS check for interleaved thinking will be skipped, so that the AI can also do interleaved thinking while in view." );
 idCVar cv_ai_opt_interleavethinkframes (		"tdm_ai_opt_interleavethinkframes",			"0",	CVAR_GAME | CVAR_ARCHIVE | CVAR_INTEGER, "If true (nonzero), this is the maximum interleaved thinking frame number." );
 idCVar cv_ai_opt_update_enemypos_interleave (	"tdm_ai_opt_update_enemypos_interleave",	"48",	CVAR_GAME | CVAR_ARCHIVE | CVAR_INTEGER, "Time to pass between enemy position updates. Set this to 0 for updates each frame." );
+idCVar cv_ai_opt_perception_scheduler (			"tdm_ai_opt_perception_scheduler",			"1",	CVAR_GAME | CVAR_BOOL, "If true (nonzero), AI visual scans are queued and executed after all entities think, most urgent first, within time budget." );
+idCVar cv_ai_opt_perception_budget (			"tdm_ai_opt_perception_budget",				"1.5",	CVAR_GAME | CVAR_FLOAT, "Time budget per frame for queued AI visual scans (in ms). Set this to 0 for unlimited budget." );
+idCVar cv_ai_opt_perception_maxlatency (		"tdm_ai_opt_perception_maxlatency",			"200",	CVAR_GAME | CVAR_INTEGER, "Visual scan request waiting for this long (in ms of game time) is executed regardless of the budget." );
 
 idCVar cv_ai_opt_nomind (						"tdm_ai_opt_nomind",				"0",			CVAR_GAME | CVAR_BOOL, "If true (nonzero), AI has its Mind thinking routines disabled." );
 idCVar cv_ai_opt_novisualstim (					"tdm_ai_opt_novisualstim",			"0",			CVAR_GAME | CVAR_BOOL, "If true (nonzero), AI will not process any incoming visual stimuli." );
@@ -116,6 +122,7 @@ idCVar cv_ai_opt_nopresent (					"tdm_ai_opt_nopresent",				"0",			CVAR_GAME | C
 idCVar cv_ai_opt_noobstacleavoidance (			"tdm_ai_opt_noobstacleavoidance",	"0",			CVAR_GAME | CVAR_BOOL, "If true (nonzero), AI will not check for obstacles." );
 idCVar cv_ai_hiding_spot_max_light_quotient(	"tdm_ai_hiding_spot_max_light_quotient",	"2.0",	CVAR_GAME | CVAR_FLOAT, "Hiding spot search light quotient." );
 idCVar cv_ai_max_hiding_spot_tests_per_frame(	"tdm_ai_max_hiding_spot_tests_per_frame",	"10",	CVAR_GAME | CVAR_INTEGER, "This is the maximum number of hiding spot point tests to do in a single AI frame." );
+idCVar cv_ai_hiding_spot_frame_budget(	"tdm_ai_hiding_spot_frame_budget",	"0",	CVAR_GAME | CVAR_FLOAT, "If positive, all hiding spot searches together spend about this many milliseconds of game thread time per frame: searches stop testing points when it is used up, and the searches which waited longest continue first in the next frame. The budget is exceeded by at most one point test. tdm_ai_max_hiding_spot_tests_per_frame is ignored then." );
 idCVar cv_ai_debug_transition_barks(			"tdm_ai_debug_transition_barks",			"0",	CVAR_GAME | CVAR_BOOL | CVAR_ARCHIVE, "If set to 1, prints to the console the AI barks during alert level transitions, and events that would cause the AI to use Alert Idle");
 idCVar cv_ai_debug_greetings(					"tdm_ai_debug_greetings",			"0",			CVAR_GAME | CVAR_BOOL | CVAR_ARCHIVE, "If set to 1, prints to the console the AI greeting and response barks");
 idCVar cv_ai_debug_anims (						"tdm_ai_debug_anims",				"0",			CVAR_GAME | CVAR_BOOL, "If true (nonzero), show debug info about AI anims in the console and log file." );
@@ -165,6 +172,7 @@ idCVar cv_tdm_http_base_url( "tdm_http_base_url", "", CVAR_GAME, "If set, this U
 
 idCVar cv_debug_aastype( "tdm_debug_aastype", "aas32", CVAR_GAME | CVAR_ARCHIVE, "Sets the AAS type used for visualisation with impulse 27");
 
+idCVar cv_las_traceCacheCell( "tdm_las_traceCacheCell", "0", CVAR_GAME | CVAR_FLOAT, "Size of cells in which results of light occlusion traces are reused within one frame.\n0 (default) means results are only reused for exactly the same points, negative value disables reuse. Positive value makes queries approximate." );
 idCVar cv_las_showtraces( "tdm_las_showtraces", "0", CVAR_GAME | CVAR_BOOL, "If true (nonzero), traces from light origin to testpoints used for visibility testiung are drawn." );
 
 idCVar cv_show_gameplay_time(		"tdm_show_gameplaytime",	"0",			CVAR_GAME | CVAR_BOOL, "If true (nonzero), the gameplay time is shown in the player HUD." );
@@ -173,12 +181,17 @@ idCVar cv_tdm_difficulty(			"tdm_difficulty",	"-1",					CVAR_GAME | CVAR_INTEGER
 
 idCVar cv_sr_disable (				"tdm_sr_disable",           "0",           CVAR_GAME | CVAR_BOOL, "Set to 1 to disable all stim/response processing." );
 idCVar cv_sr_show(					"tdm_show_stimresponse",    "0",           CVAR_GAME | CVAR_INTEGER, "Set to 1 to show all successful stims, set to 2 to show all including failed ones." );
+idCVar cv_sr_broadphase(			"tdm_sr_broadphase",        "1",           CVAR_GAME | CVAR_BOOL, "Use per-stim-type buckets of response entities to skip stims nobody responds to and reject non-matching entities early." );
+idCVar cv_sr_stats(					"tdm_sr_stats",             "0",           CVAR_GAME | CVAR_BOOL, "Print number of stim/response spatial queries and checks every frame." );
 
 idCVar cv_debug_mainmenu(			"tdm_debug_mainmenu",      "0",            CVAR_BOOL, "Set to 1 to enable main menu GUI debugging in the console." );
 idCVar cv_mainmenu_confirmquit(		"tdm_mainmenu_confirmquit",      "1", CVAR_ARCHIVE | CVAR_BOOL, "Set to 0 to disable the 'Quit Game' confirmation dialog when exiting the game." );
 
 idCVar cv_force_savegame_load(		"tdm_force_savegame_load", "0",   CVAR_BOOL|CVAR_ARCHIVE, "Set to 1 to enable force loading of save games in case of version mismatch." );
 idCVar cv_savegame_compress(		"tdm_savegame_compress", "1",   CVAR_BOOL|CVAR_ARCHIVE, "Set to 0 to disable savegame file compression." );
+idCVar cv_savegame_delta(			"tdm_savegame_delta", "5",      CVAR_INTEGER|CVAR_ARCHIVE, "Quicksaves only store data changed since full base save, which is rewritten after this many quicksaves. Set to 0 to always save full state.", 0, 100 );
+idCVar cv_savegame_async(			"tdm_savegame_async", "1",      CVAR_BOOL|CVAR_ARCHIVE, "Compress and write savegame file in background thread after game state is serialized into memory." );
+idCVar cv_log_async(				"tdm_log_async", "1",           CVAR_BOOL|CVAR_ARCHIVE, "Write DarkMod.log in background thread. Disable to write and flush every line immediately, e.g. when tracking down a crash." );
 
 /**
 * Dark Mod player movement
@@ -595,6 +608,7 @@ idCVar cv_lg_interleave("tdm_lg_interleave",	"1",	CVAR_GAME | CVAR_INTEGER | CVA
 // nbohr1more #4369 Dynamic Lightgem Interleave
 idCVar cv_lg_interleave_min("tdm_lg_interleave_min",	"40",	CVAR_GAME | CVAR_INTEGER | CVAR_ARCHIVE,	"The minimum FPS to activate Lightgem Interleave. Defaults to 40FPS" );
 idCVar cv_lg_weak("tdm_lg_weak",			"0",		CVAR_GAME | CVAR_BOOL | CVAR_ARCHIVE,		"Switches to the weaker algorithm, but may be faster." );
+idCVar cv_lg_estimate("tdm_lg_estimate",	"0",		CVAR_GAME | CVAR_BOOL | CVAR_ARCHIVE,		"If set, lightgem is computed on CPU from light samples on player model (see g_les* cvars), and lightgem view is not rendered. Faster on low-end GPUs." );
 
 idCVar cv_lg_model("tdm_lg_model",		"models/darkmod/misc/system/lightgem.lwo",	CVAR_GAME | CVAR_ARCHIVE,	"Set the lightgem model file. Map has to be restarted to take effect." );
 idCVar cv_lg_adjust("tdm_lg_adjust",		"0",		CVAR_GAME | CVAR_FLOAT,	"Adds a constant value to the lightgem." );
@@ -703,6 +717,7 @@ idCVar g_skipFX(					"g_skipFX",					"0",			CVAR_GAME | CVAR_BOOL, "" );
 //idCVar g_skipParticles(				"g_skipParticles",			"0",			CVAR_GAME | CVAR_BOOL, "" );
 
 idCVar g_disasm(					"g_disasm",					"0",			CVAR_GAME | CVAR_BOOL, "disassemble script into base/script/disasm.txt on the local drive when script is compiled" );
+idCVar g_scriptSuperInstructions(	"g_scriptSuperInstructions",	"0",		CVAR_GAME | CVAR_BOOL, "execute common pairs of script statements (compare + jump, push + event call) as one superinstruction. Takes effect when map is loaded. Use scriptTrace to compare execution in both modes" );
 idCVar g_debugBounds(				"g_debugBounds",			"0",			CVAR_GAME | CVAR_BOOL, "checks for models with bounds > 2048" );
 idCVar g_debugAnim(					"g_debugAnim",				"-1",			CVAR_GAME | CVAR_INTEGER, "displays information on which animations are playing on the specified entity number.  set to -1 to disable." );
 idCVar g_debugMove(					"g_debugMove",				"0",			CVAR_GAME | CVAR_BOOL, "" );
@@ -723,6 +738,7 @@ idCVar g_showCollisionWorld(		"g_showCollisionWorld",		"0",			CVAR_GAME | CVAR_B
 idCVar g_showCollisionModels(		"g_showCollisionModels",	"0",			CVAR_GAME | CVAR_BOOL, "" );
 idCVar g_showCollisionTraces(		"g_showCollisionTraces",	"0",			CVAR_GAME | CVAR_BOOL, "" );
 idCVar g_showCollisionAlongView(		"g_showCollisionAlongView",	"0",			CVAR_GAME | CVAR_INTEGER, "Sends a ray along player's view direction and highlights first hit (using idClip::Translation). The value specifies contents mask for clipping (1 = solid, 2 = opaque, ...)." );
+idCVar g_clipTraceCache(			"g_clipTraceCache",			"0",			CVAR_GAME | CVAR_BOOL, "Reuse results of identical point traces within one game tic. Cached trace is dropped when any clip model in its region moves or changes. Hit rate is printed by g_showCollisionTraces." );
 idCVar g_maxShowDistance(			"g_maxShowDistance",		"128",			CVAR_GAME | CVAR_FLOAT, "" );
 idCVar g_showEntityInfo(			"g_showEntityInfo",			"0",			CVAR_GAME | CVAR_BOOL, "" );
 idCVar g_showviewpos(				"g_showviewpos",			"0",			CVAR_GAME | CVAR_BOOL, "" );
@@ -831,7 +847,9 @@ idCVar af_showInertia(				"af_showInertia",			"0",			CVAR_GAME | CVAR_BOOL, "sho
 idCVar af_showVelocity(				"af_showVelocity",			"0",			CVAR_GAME | CVAR_BOOL, "show the velocity of each body" );
 idCVar af_showActive(				"af_showActive",			"0",			CVAR_GAME | CVAR_BOOL, "show tree-like structures of articulated figures not at rest" );
 idCVar af_testSolid(				"af_testSolid",				"1",			CVAR_GAME | CVAR_BOOL, "test for bodies initially stuck in solid" );
+idCVar af_parallelIslands(			"af_parallelIslands",		"1",			CVAR_GAME | CVAR_BOOL, "solve constraints of non-interacting articulated figures in parallel jobs" );
 
+idCVar rb_sleepIslands(				"rb_sleepIslands",			"1",			CVAR_GAME | CVAR_BOOL, "rigid bodies touching each other are put to rest and woken up together" );
 idCVar rb_showTimings(				"rb_showTimings",			"0",			CVAR_GAME | CVAR_BOOL, "show rigid body cpu usage" );
 idCVar rb_showBodies(				"rb_showBodies",			"0",			CVAR_GAME | CVAR_BOOL, "show rigid bodies" );
 idCVar rb_showMass(					"rb_showMass",				"0",			CVAR_GAME | CVAR_BOOL, "show the mass of each rigid body" );
@@ -938,6 +956,9 @@ idCVar aas_showHideArea(			"aas_showHideArea",			"0",			CVAR_GAME | CVAR_INTEGER
 idCVar aas_pullPlayer(				"aas_pullPlayer",			"0",			CVAR_GAME | CVAR_INTEGER, "" );
 idCVar aas_randomPullPlayer(		"aas_randomPullPlayer",		"0",			CVAR_GAME | CVAR_BOOL, "" );
 idCVar aas_goalArea(				"aas_goalArea",				"0",			CVAR_GAME | CVAR_INTEGER, "" );
+idCVar aas_hierarchicalRouting(		"aas_hierarchicalRouting",	"1",			CVAR_GAME | CVAR_BOOL, "Route between clusters over graph of portals with cached travel times between portals of every cluster. Results are the same, but less area routing cache is needed." );
+idCVar aas_precomputeRouting(		"aas_precomputeRouting",	"0",			CVAR_GAME | CVAR_BOOL | CVAR_ARCHIVE, "Build routing tables of all areas inside every cluster in parallel on map load, so that AI starting new routes do not cause spikes. Clusters changed by doors or obstacles are rebuilt in the next frame." );
+idCVar aas_precomputeRoutingMB(		"aas_precomputeRoutingMB",	"64",			CVAR_GAME | CVAR_INTEGER | CVAR_ARCHIVE, "Memory limit for routing tables precomputed on map load (per AAS), in megabytes." );
 idCVar aas_showPushIntoArea(		"aas_showPushIntoArea",		"0",			CVAR_GAME | CVAR_BOOL, "" );
 
 idCVar g_password(					"g_password",				"",				CVAR_GAME | CVAR_ARCHIVE, "game password" );
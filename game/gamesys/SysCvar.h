@@ -63,6 +63,9 @@ extern idCVar cv_ai_opt_interleavethinkmaxdist;
 extern idCVar cv_ai_opt_interleavethinkskippvscheck;
 extern idCVar cv_ai_opt_interleavethinkframes;
 extern idCVar cv_ai_opt_update_enemypos_interleave;
+extern idCVar cv_ai_opt_perception_scheduler;
+extern idCVar cv_ai_opt_perception_budget;
+extern idCVar cv_ai_opt_perception_maxlatency;
 extern idCVar cv_ai_opt_nomind;
 extern idCVar cv_ai_opt_novisualstim;
 extern idCVar cv_ai_opt_nolipsync;
@@ -70,6 +73,7 @@ extern idCVar cv_ai_opt_nopresent;
 extern idCVar cv_ai_opt_noobstacleavoidance;
 extern idCVar cv_ai_hiding_spot_max_light_quotient;
 extern idCVar cv_ai_max_hiding_spot_tests_per_frame;
+extern idCVar cv_ai_hiding_spot_frame_budget;
 extern idCVar cv_ai_debug_anims;
 
 extern idCVar cv_show_health;
@@ -106,6 +110,7 @@ extern idCVar cv_tdm_http_base_url;
 
 extern idCVar cv_debug_aastype;
 
+extern idCVar cv_las_traceCacheCell;
 extern idCVar cv_las_showtraces;
 extern idCVar cv_show_gameplay_time;
 
@@ -113,11 +118,16 @@ extern idCVar cv_tdm_difficulty;
 
 extern idCVar cv_sr_disable;
 extern idCVar cv_sr_show;
+extern idCVar cv_sr_broadphase;
+extern idCVar cv_sr_stats;
 
 extern idCVar cv_sndprop_disable;
 extern idCVar cv_spr_debug;
 extern idCVar cv_spr_show;
 extern idCVar cv_spr_radius_show;
+extern idCVar cv_spr_cache;
+extern idCVar cv_spr_cache_radius;
+extern idCVar cv_spr_stats;
 extern idCVar cv_ko_show;
 extern idCVar cv_ai_animstate_show;
 
@@ -213,6 +223,9 @@ extern idCVar cv_ai_search_type; // grayman #4220 - control type of search
 
 extern idCVar cv_force_savegame_load;
 extern idCVar cv_savegame_compress;
+extern idCVar cv_savegame_async;
+extern idCVar cv_log_async;
+extern idCVar cv_savegame_delta;
 
 // Daft Mugi #6257: Auto-search bodies
 extern idCVar cv_tdm_autosearch_bodies;
@@ -389,6 +402,7 @@ extern idCVar cv_lg_interleave;
 // nbohr1more #4369 Dynamic Lightgem Interleave
 extern idCVar cv_lg_interleave_min;
 extern idCVar cv_lg_weak;
+extern idCVar cv_lg_estimate;
 extern idCVar cv_lg_model;
 extern idCVar cv_lg_adjust;
 extern idCVar cv_lg_crouch_modifier;
@@ -492,6 +506,7 @@ extern idCVar	g_doubleVision;
 extern idCVar	g_muzzleFlash;
 
 extern idCVar	g_disasm;
+extern idCVar	g_scriptSuperInstructions;
 extern idCVar	g_debugBounds;
 extern idCVar	g_debugAnim;
 extern idCVar	g_debugMove;
@@ -511,6 +526,7 @@ extern idCVar	g_showCollisionWorld;
 extern idCVar	g_showCollisionModels;
 extern idCVar	g_showCollisionTraces;
 extern idCVar	g_showCollisionAlongView;
+extern idCVar	g_clipTraceCache;
 extern idCVar	g_maxShowDistance;
 extern idCVar	g_showEntityInfo;
 extern idCVar	g_showviewpos;
@@ -595,7 +611,9 @@ extern idCVar	af_showInertia;
 extern idCVar	af_showVelocity;
 extern idCVar	af_showActive;
 extern idCVar	af_testSolid;
+extern idCVar	af_parallelIslands;
 
+extern idCVar	rb_sleepIslands;
 extern idCVar	rb_showTimings;
 extern idCVar	rb_showBodies;
 extern idCVar	rb_showMass;
@@ -685,6 +703,9 @@ extern idCVar	aas_showHideArea;
 extern idCVar	aas_pullPlayer;
 extern idCVar	aas_randomPullPlayer;
 extern idCVar	aas_goalArea;
+extern idCVar	aas_hierarchicalRouting;
+extern idCVar	aas_precomputeRouting;
+extern idCVar	aas_precomputeRoutingMB;
 extern idCVar	aas_showPushIntoArea;
 
 extern idCVar	net_clientPredictGUI;
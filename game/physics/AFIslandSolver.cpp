@@ -0,0 +1,272 @@
+/*****************************************************************************
+The Dark Mod GPL Source Code
+
+This file is part of the The Dark Mod Source Code, originally based
+on the Doom 3 GPL Source Code as published in 2011.
+
+The Dark Mod Source Code is free software: you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version. For details, see LICENSE.TXT.
+
+Project: The Dark Mod (http://www.thedarkmod.com/)
+
+******************************************************************************/
+#include "precompiled.h"
+#include "game/physics/AFIslandSolver.h"
+
+#include "game/Game_local.h"
+#include "game/ai/AI.h"
+
+// extra space around swept bounds: contacts are collected a bit beyond touching
+static const float AF_ISLAND_MARGIN = 8.0f;
+
+void idAFIslandSolver::Shutdown() {
+	if ( jobList ) {
+		parallelJobManager->FreeJobList( jobList );
+		jobList = nullptr;
+	}
+	Clear();
+}
+
+void idAFIslandSolver::Clear() {
+	items.ClearFree();
+	parent.ClearFree();
+	islandSize.ClearFree();
+	ResetStats();
+}
+
+void idAFIslandSolver::ResetStats() {
+	stats = Stats();
+}
+
+void idAFIslandSolver::CollectCandidates() {
+	items.Clear();
+
+	for ( auto iter = gameLocal.activeEntities.Begin(); iter; gameLocal.activeEntities.Next( iter ) ) {
+		idEntity *ent = iter.entity;
+		if ( !( ent->thinkFlags & TH_PHYSICS ) ) {
+			continue;
+		}
+		// team slaves are moved by team master
+		if ( ent->GetTeamMaster() && ent->GetTeamMaster() != ent ) {
+			continue;
+		}
+		idPhysics *physics = ent->GetPhysics();
+		if ( !physics || !physics->IsType( idPhysics_AF::Type ) ) {
+			continue;
+		}
+		idPhysics_AF *af = static_cast<idPhysics_AF *>( physics );
+		if ( af->IsAtRest() ) {
+			continue;
+		}
+
+		// same time step as in idEntity::RunPhysics
+		int startTime = gameLocal.previousTime;
+		if ( ent->IsType( idAI::Type ) ) {
+			idAI *ai = static_cast<idAI *>( ent );
+			startTime = ai->m_lastThinkTime;
+		}
+		int deltaTime = gameLocal.time - startTime;
+
+		// expand bounds by possible motion of bodies during the step
+		float maxMove = 0.0f;
+		for ( int i = 0; i < af->GetNumClipModels(); i++ ) {
+			float radius = af->GetBounds( i ).GetRadius();
+			float speed = af->GetLinearVelocity( i ).LengthFast() + af->GetAngularVelocity( i ).LengthFast() * radius;
+			maxMove = Max( maxMove, speed );
+		}
+		maxMove = maxMove * MS2SEC( Max( deltaTime, 0 ) ) + AF_ISLAND_MARGIN;
+
+		Item &item = items.Alloc();
+		item = Item();
+		item.ent = ent;
+		item.af = af;
+		item.bounds = af->GetAbsBounds();
+		item.bounds.ExpandSelf( maxMove );
+		item.startTime = startTime;
+
+		// figures which can't be solved independently still take part in islands
+		bool parallel = af->CanSolveInParallel() && deltaTime > 0;
+		if ( parallel && ent->IsType( idAI::Type ) ) {
+			// only ragdolls are guaranteed to think on every frame
+			idAI *ai = static_cast<idAI *>( ent );
+			parallel = ( ai->health <= 0 || ai->IsKnockedOut() );
+		}
+		if ( !parallel ) {
+			item.af = nullptr;
+		}
+	}
+	stats.numCandidates += items.Num();
+}
+
+int idAFIslandSolver::FindRoot( int i ) {
+	while ( parent[i] != i ) {
+		parent[i] = parent[parent[i]];
+		i = parent[i];
+	}
+	return i;
+}
+
+void idAFIslandSolver::FindIslands() {
+	int n = items.Num();
+	parent.SetNum( n );
+	islandSize.SetNum( n );
+	for ( int i = 0; i < n; i++ ) {
+		parent[i] = i;
+		islandSize[i] = 0;
+	}
+
+	// ragdolls are usually few, so quadratic pass is fine
+	for ( int i = 0; i < n; i++ ) {
+		for ( int j = i + 1; j < n; j++ ) {
+			if ( !items[i].bounds.IntersectsBounds( items[j].bounds ) ) {
+				continue;
+			}
+			int ri = FindRoot( i );
+			int rj = FindRoot( j );
+			if ( ri != rj ) {
+				// smaller index is root: result does not depend on anything but entity order
+				parent[Max( ri, rj )] = Min( ri, rj );
+			}
+		}
+	}
+
+	for ( int i = 0; i < n; i++ ) {
+		items[i].island = FindRoot( i );
+		islandSize[items[i].island]++;
+	}
+}
+
+void idAFIslandSolver::SolveJob( void *data ) {
+	Item *item = (Item *)data;
+	idTimer timer;
+	timer.Clear();
+	timer.Start();
+	item->af->EvaluateSolve();
+	timer.Stop();
+	item->solveMilliseconds = timer.Milliseconds();
+}
+
+void idAFIslandSolver::Evaluate() {
+	if ( !af_parallelIslands.GetBool() || gameLocal.inCinematic ) {
+		return;
+	}
+
+	TRACE_CPU_SCOPE( "AFIslandSolver" )
+
+	idTimer timerPrepare, timerSolve, timerFinish;
+	timerPrepare.Clear();
+	timerSolve.Clear();
+	timerFinish.Clear();
+
+	timerPrepare.Start();
+	CollectCandidates();
+	FindIslands();
+
+	// disables collision for team parts, just like idEntity::RunPhysics does
+	auto DisableTeamClip = []( idEntity *ent ) {
+		for ( idEntity *part = ent; part != NULL; part = part->GetNextTeamEntity() ) {
+			if ( part->GetPhysics() && !part->fl.solidForTeam ) {
+				part->GetPhysics()->DisableClip();
+			}
+		}
+	};
+	auto EnableTeamClip = []( idEntity *ent ) {
+		for ( idEntity *part = ent; part != NULL; part = part->GetNextTeamEntity() ) {
+			if ( part->GetPhysics() ) {
+				part->GetPhysics()->EnableClip();
+			}
+		}
+	};
+
+	// stage 1: collect contacts
+	int numPrepared = 0;
+	for ( int i = 0; i < items.Num(); i++ ) {
+		Item &item = items[i];
+		if ( !item.af ) {
+			continue;
+		}
+		if ( islandSize[item.island] > 1 ) {
+			stats.numInteracting++;
+			continue;
+		}
+		DisableTeamClip( item.ent );
+		item.prepared = item.af->EvaluatePrepare( gameLocal.time - item.startTime, gameLocal.time );
+		EnableTeamClip( item.ent );
+		if ( item.prepared ) {
+			numPrepared++;
+		} else {
+			// prepare stage was done, so it must not be repeated
+			item.af->SetPreEvaluated( gameLocal.time, false );
+		}
+	}
+	timerPrepare.Stop();
+
+	// stage 2: solve constraints in parallel
+	timerSolve.Start();
+	if ( numPrepared > 1 ) {
+		if ( !jobList ) {
+			jobList = parallelJobManager->AllocJobList( JOBLIST_UTILITY, JOBLIST_PRIORITY_HIGH, MAX_GENTITIES, 0, nullptr );
+			RegisterJob( SolveJob, "AFIslandSolve" );
+		}
+		for ( int i = 0; i < items.Num(); i++ ) {
+			if ( items[i].prepared ) {
+				jobList->AddJob( SolveJob, &items[i] );
+			}
+		}
+		jobList->Submit( nullptr, JOBLIST_PARALLELISM_REALTIME );
+		jobList->Wait();
+	} else {
+		for ( int i = 0; i < items.Num(); i++ ) {
+			if ( items[i].prepared ) {
+				SolveJob( &items[i] );
+			}
+		}
+	}
+	timerSolve.Stop();
+
+	// stage 3: apply results in entity order
+	timerFinish.Start();
+	for ( int i = 0; i < items.Num(); i++ ) {
+		Item &item = items[i];
+		if ( !item.prepared ) {
+			continue;
+		}
+		DisableTeamClip( item.ent );
+		item.af->EvaluateFinish();
+		EnableTeamClip( item.ent );
+		item.af->SetPreEvaluated( gameLocal.time, true );
+
+		stats.numParallel++;
+		stats.solveSerialMilliseconds += item.solveMilliseconds;
+	}
+	timerFinish.Stop();
+
+	stats.numFrames++;
+	stats.prepareMilliseconds += timerPrepare.Milliseconds();
+	stats.solveMilliseconds += timerSolve.Milliseconds();
+	stats.finishMilliseconds += timerFinish.Milliseconds();
+	double frameMilliseconds = timerPrepare.Milliseconds() + timerSolve.Milliseconds() + timerFinish.Milliseconds();
+	stats.maxFrameMilliseconds = Max( stats.maxFrameMilliseconds, frameMilliseconds );
+}
+
+void idAFIslandSolver::PrintStats() const {
+	if ( stats.numFrames == 0 ) {
+		common->Printf( "No frames evaluated by AF island solver (see af_parallelIslands)\n" );
+		return;
+	}
+	double frames = stats.numFrames;
+	common->Printf( "AF island solver over %d frames (per frame averages):\n", stats.numFrames );
+	common->Printf( "  active figures:    %.1lf\n", stats.numCandidates / frames );
+	common->Printf( "  solved in jobs:    %.1lf\n", stats.numParallel / frames );
+	common->Printf( "  interacting:       %.1lf  (left to entity think)\n", stats.numInteracting / frames );
+	common->Printf( "  contacts:          %.3lf ms\n", stats.prepareMilliseconds / frames );
+	common->Printf( "  solve (wall):      %.3lf ms\n", stats.solveMilliseconds / frames );
+	common->Printf( "  solve (all jobs):  %.3lf ms\n", stats.solveSerialMilliseconds / frames );
+	common->Printf( "  collisions:        %.3lf ms\n", stats.finishMilliseconds / frames );
+	common->Printf( "  worst frame total: %.3lf ms\n", stats.maxFrameMilliseconds );
+	if ( stats.solveMilliseconds > 0.0 ) {
+		common->Printf( "  solve speedup:     %.2lfx\n", stats.solveSerialMilliseconds / stats.solveMilliseconds );
+	}
+}
@@ -0,0 +1,74 @@
+/*****************************************************************************
+The Dark Mod GPL Source Code
+
+This file is part of the The Dark Mod Source Code, originally based
+on the Doom 3 GPL Source Code as published in 2011.
+
+The Dark Mod Source Code is free software: you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version. For details, see LICENSE.TXT.
+
+Project: The Dark Mod (http://www.thedarkmod.com/)
+
+******************************************************************************/
+#pragma once
+
+class idPhysics_AF;
+class idParallelJobList;
+
+// evaluates active articulated figures (ragdolls) in parallel before entities think.
+// Figures are grouped into islands by overlap of swept bounds.
+// Every figure which is alone in its island is simulated in three stages:
+//   1) contacts are collected on main thread, in entity order
+//   2) constraints are solved in parallel jobs (every figure touches only its own data)
+//   3) collisions and results are applied on main thread, in entity order
+// Result does not depend on number of threads or scheduling of jobs.
+// Figures interacting with each other are left for normal evaluation in RunPhysics.
+class idAFIslandSolver {
+public:
+	void			Shutdown();
+	void			Clear();
+
+	// must be called once per frame before entities think
+	// evaluated figures skip simulation when their entity runs physics this frame
+	void			Evaluate();
+
+	// prints timings accumulated since last reset
+	void			PrintStats() const;
+	void			ResetStats();
+
+private:
+	struct Item {
+		idEntity *ent = nullptr;
+		idPhysics_AF *af = nullptr;
+		idBounds bounds;
+		int startTime = 0;
+		int island = -1;
+		bool prepared = false;
+		double solveMilliseconds = 0.0;		// measured by job
+	};
+	struct Stats {
+		int numFrames = 0;
+		int numCandidates = 0;				// active figures seen
+		int numParallel = 0;				// figures solved in jobs
+		int numInteracting = 0;				// figures left to RunPhysics because of shared island
+		double prepareMilliseconds = 0.0;
+		double solveMilliseconds = 0.0;		// wall time of parallel stage
+		double solveSerialMilliseconds = 0.0;	// sum of solve time of all jobs
+		double finishMilliseconds = 0.0;
+		double maxFrameMilliseconds = 0.0;
+	};
+
+	void			CollectCandidates();
+	void			FindIslands();
+	int				FindRoot( int i );
+
+	static void		SolveJob( void *data );
+
+	idList<Item>	items;
+	idList<int>		parent;					// union-find over items
+	idList<int>		islandSize;
+	idParallelJobList *jobList = nullptr;
+	Stats			stats;
+};
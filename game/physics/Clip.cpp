@@ -35,6 +35,9 @@ typedef struct trmCache_s {
 
 idVec3 vec3_boxEpsilon( CM_BOX_EPSILON, CM_BOX_EPSILON, CM_BOX_EPSILON );
 
+// max number of point traces cached during one game tic
+static const int MAX_TRACE_CACHE_ENTRIES = 8192;
+
 
 
 /*
@@ -500,6 +503,9 @@ void idClipModel::Unlink() {
 	// and storing additional pointer would be unnecessary waste of memory
 	idClip &clp = gameLocal.clip;
 
+	if ( octreeHandle.IsLinked() ) {
+		clp.InvalidateTraceCache( absBounds );
+	}
 	clp.octree.Remove( this );
 
 	assert( !octreeHandle.IsLinked() );
@@ -523,6 +529,10 @@ void idClipModel::Link( idClip &clp ) {
 		return;
 	}
 
+	if ( octreeHandle.IsLinked() ) {
+		clp.InvalidateTraceCache( absBounds );
+	}
+
 	// set the abs box
 	if ( axis.IsRotated() ) {
 		// expand for rotation
@@ -538,9 +548,21 @@ void idClipModel::Link( idClip &clp ) {
 	absBounds[0] -= vec3_boxEpsilon;
 	absBounds[1] += vec3_boxEpsilon;
 
+	clp.InvalidateTraceCache( absBounds );
 	clp.octree.Update( this, absBounds );
 }
 
+/*
+===============
+idClipModel::InvalidateTraceCache
+===============
+*/
+void idClipModel::InvalidateTraceCache( void ) const {
+	if ( octreeHandle.IsLinked() ) {
+		gameLocal.clip.InvalidateTraceCache( absBounds );
+	}
+}
+
 /*
 ===============
 idClipModel::Link
@@ -589,6 +611,11 @@ idClip::idClip
 idClip::idClip( void ) {
 	worldBounds.Zero();
 	numRotations = numTranslations = numMotions = numRenderModelTraces = numContents = numContacts = 0;
+	traceCache = NULL;
+	numTraceCache = 0;
+	traceCacheFrame = -1;
+	traceCacheBounds.Clear();
+	numTraceCacheLookups = numTraceCacheHits = numTraceCacheInvalidated = 0;
 }
 
 /*
@@ -597,6 +624,8 @@ idClip::idClip
 ===============
 */
 idClip::~idClip( void ) {
+	traceCacheOctree.Clear();
+	delete [] traceCache;
 }
 
 /*
@@ -627,11 +656,17 @@ void idClip::Init( void ) {
 		return ((idClipModel*)ptr)->GetOctreeHandle();
 	});
 
+	// cached traces are kept in separate octree of the same size
+	traceCacheOctreeBounds = worldCube;
+	traceCacheOctree.Init( traceCacheOctreeBounds, TraceCacheOctreeHandle );
+
 	// initialize a default clip model
 	defaultClipModel.LoadModel( idTraceModel( idBounds( idVec3( 0, 0, 0 ) ).Expand( 8 ) ) );
 
 	// set counters to zero
 	numRotations = numTranslations = numMotions = numRenderModelTraces = numContents = numContacts = 0;
+	numTraceCacheLookups = numTraceCacheHits = numTraceCacheInvalidated = 0;
+	ClearTraceCache();
 }
 
 /*
@@ -649,6 +684,8 @@ idClip::Shutdown
 ===============
 */
 void idClip::Shutdown( void ) {
+	ClearTraceCache();
+	traceCacheOctree.Clear();
 	octree.Clear();
 
 	// free the trace model used for the temporaryClipModel
@@ -993,6 +1030,13 @@ bool idClip::Translation( trace_t &results, const idVec3 &start, const idVec3 &e
 	if ( TestHugeTranslation( results, mdl, start, end, trmAxis ) ) {
 		return true;
 	}
+
+	// only point traces are cached, the rest depend on trace model
+	bool useCache = ( !mdl && g_clipTraceCache.GetBool() );
+	if ( useCache && FindCachedTrace( results, start, end, contentMask, passEntity, ignoreWorld ) ) {
+		return ( results.fraction < 1.0f );
+	}
+
 	TRACE_CPU_SCOPE("Clip:Translate");
 
 	trm = TraceModelForClipModel( mdl );
@@ -1013,6 +1057,9 @@ bool idClip::Translation( trace_t &results, const idVec3 &start, const idVec3 &e
 		collisionModelManager->Translation( &results, start, end, trm, trmAxis, contentMask, 0, vec3_origin, mat3_default );
 		results.c.entityNum = results.fraction != 1.0f ? ENTITYNUM_WORLD : ENTITYNUM_NONE;
 		if ( results.fraction == 0.0f ) {
+			if ( useCache ) {
+				StoreCachedTrace( results, start, end, contentMask, passEntity, ignoreWorld );
+			}
 			return true;		// blocked immediately by the world
 		}
 	} else {
@@ -1098,9 +1145,143 @@ bool idClip::Translation( trace_t &results, const idVec3 &start, const idVec3 &e
 		results.c.contents
 	)
 #endif
+	if ( useCache ) {
+		StoreCachedTrace( results, start, end, contentMask, passEntity, ignoreWorld );
+	}
 	return ( results.fraction < 1.0f );
 }
 
+/*
+============
+idClip::ClearTraceCache
+============
+*/
+void idClip::ClearTraceCache( void ) {
+	if ( numTraceCache > 0 ) {
+		// unlink all entries at once, but keep the bounds
+		traceCacheOctree.Init( traceCacheOctreeBounds, TraceCacheOctreeHandle );
+		numTraceCache = 0;
+		traceCacheHash.Clear();
+	}
+	traceCacheBounds.Clear();
+	traceCacheFrame = gameLocal.framenum;
+}
+
+/*
+============
+idClip::TraceCacheKey
+============
+*/
+int idClip::TraceCacheKey( const idVec3 &start, const idVec3 &end, int contentMask ) const {
+	// positions are quantized to whole units for hashing only, entries are compared exactly
+	return traceCacheHash.GenerateKey( traceCacheHash.GenerateKey( start ) * 31 + contentMask, traceCacheHash.GenerateKey( end ) );
+}
+
+/*
+============
+idClip::FindCachedTrace
+============
+*/
+bool idClip::FindCachedTrace( trace_t &results, const idVec3 &start, const idVec3 &end, int contentMask, const idEntity *passEntity, bool ignoreWorld ) {
+	if ( traceCacheFrame != gameLocal.framenum ) {
+		ClearTraceCache();
+	}
+	numTraceCacheLookups++;
+
+	int passSpawnId = passEntity ? gameLocal.GetSpawnId( passEntity ) : 0;
+	int key = TraceCacheKey( start, end, contentMask );
+	for ( int i = traceCacheHash.First( key ); i >= 0; i = traceCacheHash.Next( i ) ) {
+		const traceCacheEntry_t &entry = traceCache[i];
+		if ( entry.valid && entry.start == start && entry.end == end && entry.contentMask == contentMask &&
+			entry.passEntity == passEntity && entry.passSpawnId == passSpawnId && entry.ignoreWorld == ignoreWorld ) {
+			results = entry.results;
+			numTraceCacheHits++;
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+============
+idClip::StoreCachedTrace
+============
+*/
+void idClip::StoreCachedTrace( const trace_t &results, const idVec3 &start, const idVec3 &end, int contentMask, const idEntity *passEntity, bool ignoreWorld ) {
+	if ( traceCacheFrame != gameLocal.framenum ) {
+		ClearTraceCache();
+	}
+	if ( numTraceCache >= MAX_TRACE_CACHE_ENTRIES ) {
+		return;
+	}
+	if ( !traceCache ) {
+		traceCache = new traceCacheEntry_t[MAX_TRACE_CACHE_ENTRIES];
+	}
+
+	traceCacheEntry_t &entry = traceCache[numTraceCache++];
+	entry.start = start;
+	entry.end = end;
+	entry.contentMask = contentMask;
+	entry.passEntity = passEntity;
+	entry.passSpawnId = passEntity ? gameLocal.GetSpawnId( passEntity ) : 0;
+	entry.ignoreWorld = ignoreWorld;
+	entry.valid = true;
+	// result depends on everything along the whole segment
+	entry.bounds.Clear();
+	entry.bounds.AddPoint( start );
+	entry.bounds.AddPoint( end );
+	entry.bounds.ExpandSelf( CM_BOX_EPSILON );
+	entry.results = results;
+
+	traceCacheHash.Add( TraceCacheKey( start, end, contentMask ), numTraceCache - 1 );
+	traceCacheBounds.AddBounds( entry.bounds );
+	traceCacheOctree.Add( &entry, entry.bounds );
+}
+
+/*
+============
+idClip::TraceCacheOctreeHandle
+============
+*/
+idBoxOctreeHandle &idClip::TraceCacheOctreeHandle( idBoxOctree::Pointer ptr ) {
+	return ( (traceCacheEntry_t *)ptr )->octreeHandle;
+}
+
+/*
+============
+idClip::InvalidateTraceCache
+============
+*/
+void idClip::InvalidateTraceCache( const idBounds &bounds ) {
+	if ( numTraceCache == 0 || traceCacheFrame != gameLocal.framenum ) {
+		return;
+	}
+	if ( !bounds.IntersectsBounds( traceCacheBounds ) ) {
+		return;
+	}
+
+	idBoxOctree::QueryResult res;
+	traceCacheOctree.QueryInBox( bounds, res );
+
+	// entry can be linked to several octree nodes, and must not be unlinked while chunks are iterated
+	idFlexList<traceCacheEntry_t *, 128> invalidated;
+	for ( int i = 0; i < res.Num(); i++ ) {
+		const idBoxOctree::Chunk *chunk = res[i];
+		for ( int j = 0; j < chunk->num; j++ ) {
+			traceCacheEntry_t *entry = (traceCacheEntry_t *)chunk->arr[j].object;
+			if ( entry->valid && bounds.IntersectsBounds( chunk->arr[j].bounds ) ) {
+				entry->valid = false;
+				invalidated.AddGrow( entry );
+			}
+		}
+	}
+
+	for ( int i = 0; i < invalidated.Num(); i++ ) {
+		traceCacheOctree.Remove( invalidated[i] );
+	}
+	numTraceCacheInvalidated += invalidated.Num();
+}
+
 /*
 ============
 idClip::Rotation
@@ -1629,7 +1810,12 @@ idClip::PrintStatistics
 void idClip::PrintStatistics( void ) {
 	gameLocal.Printf( "t = %-3d, r = %-3d, m = %-3d, render = %-3d, contents = %-3d, contacts = %-3d\n",
 					numTranslations, numRotations, numMotions, numRenderModelTraces, numContents, numContacts );
+	if ( g_clipTraceCache.GetBool() ) {
+		gameLocal.Printf( "trace cache: lookups = %-3d, hits = %-3d (%.1f%%), invalidated = %-3d\n",
+					numTraceCacheLookups, numTraceCacheHits, 100.0f * numTraceCacheHits / Max( numTraceCacheLookups, 1 ), numTraceCacheInvalidated );
+	}
 	numRotations = numTranslations = numMotions = numRenderModelTraces = numContents = numContacts = 0;
+	numTraceCacheLookups = numTraceCacheHits = numTraceCacheInvalidated = 0;
 }
 
 /*
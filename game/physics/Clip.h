@@ -133,6 +133,7 @@ private:
 	int						touchCount;				// mutable counter to avoid double-reporting clipmodel
 
 	void					Init( void );			// initialize
+	void					InvalidateTraceCache( void ) const;	// drops cached traces which could be affected by this model
 
 	static int				AllocTraceModel( const idTraceModel &trm );
 	static void				FreeTraceModel( const int traceModelIndex );
@@ -165,11 +166,17 @@ ID_INLINE void idClipModel::Scale( const idVec3 &scale ) {
 }
 
 ID_INLINE void idClipModel::Enable( void ) {
-	enabled = true;
+	if ( !enabled ) {
+		enabled = true;
+		InvalidateTraceCache();
+	}
 }
 
 ID_INLINE void idClipModel::Disable( void ) {
-	enabled = false;
+	if ( enabled ) {
+		enabled = false;
+		InvalidateTraceCache();
+	}
 }
 
 ID_INLINE void idClipModel::SetMaterial( const idMaterial *m ) {
@@ -181,7 +188,10 @@ ID_INLINE const idMaterial * idClipModel::GetMaterial( void ) const {
 }
 
 ID_INLINE void idClipModel::SetContents( int newContents ) {
-	contents = newContents;
+	if ( contents != newContents ) {
+		contents = newContents;
+		InvalidateTraceCache();
+	}
 }
 
 ID_INLINE int idClipModel::GetContents( void ) const {
@@ -205,7 +215,10 @@ ID_INLINE int idClipModel::GetId( void ) const {
 }
 
 ID_INLINE void idClipModel::SetOwner( idEntity *newOwner ) {
-	owner = newOwner;
+	if ( owner != newOwner ) {
+		owner = newOwner;
+		InvalidateTraceCache();
+	}
 }
 
 ID_INLINE idEntity *idClipModel::GetOwner( void ) const {
@@ -343,6 +356,31 @@ private:
 	int						numContents;
 	int						numContacts;
 
+							// results of point traces done during current game tic (see g_clipTraceCache)
+							// cached trace is dropped when any clip model touching its bounds is linked, unlinked or changed
+	typedef struct traceCacheEntry_s {
+		idVec3				start;
+		idVec3				end;
+		int					contentMask;
+		const idEntity *	passEntity;
+		int					passSpawnId;
+		bool				ignoreWorld;
+		bool				valid;
+		idBounds			bounds;
+		trace_t				results;
+		idBoxOctreeHandle	octreeHandle;			// valid entries are linked to traceCacheOctree
+	} traceCacheEntry_t;
+	traceCacheEntry_t *		traceCache;				// allocated once for all entries, since octree points into it
+	int						numTraceCache;
+	idHashIndex				traceCacheHash;
+	idBounds				traceCacheBounds;		// union of bounds of all cached traces
+	idBoxOctree				traceCacheOctree;		// bounds of valid cached traces, to find ones touched by changed clip model
+	idBounds				traceCacheOctreeBounds;
+	int						traceCacheFrame;
+	int						numTraceCacheLookups;
+	int						numTraceCacheHits;
+	int						numTraceCacheInvalidated;
+
 private:
 	void					ClipModelsTouchingBounds_r( const struct clipSector_s *node, struct listParms_s &parms ) const;
 	const idTraceModel *	TraceModelForClipModel( const idClipModel *mdl ) const;
@@ -357,6 +395,13 @@ private:
 								int contentMask, idClip_ClipModelList &clipModelList, idClip_FloatList &fractionLowers ) const;
 	int						GetTraceClipModels( const idBounds &absBounds, const idBounds &stillBounds, const idVec3 &start, const idVec3 &end,
 								int contentMask, const idEntity *passEntity, idClip_ClipModelList &clipModelList, idClip_FloatList &fractionLowers ) const;
+
+	void					ClearTraceCache( void );
+	int						TraceCacheKey( const idVec3 &start, const idVec3 &end, int contentMask ) const;
+	bool					FindCachedTrace( trace_t &results, const idVec3 &start, const idVec3 &end, int contentMask, const idEntity *passEntity, bool ignoreWorld );
+	void					StoreCachedTrace( const trace_t &results, const idVec3 &start, const idVec3 &end, int contentMask, const idEntity *passEntity, bool ignoreWorld );
+	void					InvalidateTraceCache( const idBounds &bounds );
+	static idBoxOctreeHandle &TraceCacheOctreeHandle( idBoxOctree::Pointer ptr );
 };
 
 
@@ -63,7 +63,8 @@ static const float MAX_GRABBER_EXT_ANGVEL		= 5.0f;
 #ifdef AF_TIMINGS
 static int lastTimerReset = 0;
 static int numArticulatedFigures = 0;
-static idTimer timer_total, timer_pc, timer_ac, timer_collision, timer_lcp;
+// per-thread, since solving stage of AF can run in parallel jobs
+static thread_local idTimer timer_total, timer_pc, timer_ac, timer_collision, timer_lcp;
 #endif
 
 
@@ -6537,6 +6538,34 @@ idPhysics_AF::Evaluate
 ================
 */
 bool idPhysics_AF::Evaluate( int timeStepMSec, int endTimeMSec ) 
+{
+	bool moved = false;
+
+	// this step (or its beginning) was already simulated by island solver
+	if ( preEvaluatedTime >= 0 ) {
+		int evaluatedTime = preEvaluatedTime;
+		moved = preEvaluatedMoved;
+		preEvaluatedTime = -1;
+		if ( endTimeMSec <= evaluatedTime ) {
+			return moved;
+		}
+		timeStepMSec = Min( timeStepMSec, endTimeMSec - evaluatedTime );
+	}
+
+	if ( !EvaluatePrepare( timeStepMSec, endTimeMSec ) ) {
+		return moved;
+	}
+	EvaluateSolve();
+	EvaluateFinish();
+	return true;
+}
+
+/*
+================
+idPhysics_AF::EvaluatePrepare
+================
+*/
+bool idPhysics_AF::EvaluatePrepare( int timeStepMSec, int endTimeMSec )
 {
 	float timeStep;
 
@@ -6548,6 +6577,8 @@ bool idPhysics_AF::Evaluate( int timeStepMSec, int endTimeMSec )
 		timeStep = MS2SEC( timeStepMSec ) * timeScale;
 	}
 	current.lastTimeStep = timeStep;
+	evalTimeStep = timeStep;
+	evalEndTimeMSec = endTimeMSec;
 
 	// stgatilov #5992: compute total force/torque for all bodies
 	for ( int i = 0; i < bodies.Num(); i++ ) {
@@ -6595,7 +6626,7 @@ bool idPhysics_AF::Evaluate( int timeStepMSec, int endTimeMSec )
 	// TDM: Enable the clipmodels of all team members for collisions
 	idEntity *part = NULL;
 	
-	idList<bool> InitClipStates;
+	teamClipStates.Clear();
 	bool PartClipState = false;
 
 	if( ((idAFEntity_Base *) self )->CollidesWithTeam() )
@@ -6605,7 +6636,7 @@ bool idPhysics_AF::Evaluate( int timeStepMSec, int endTimeMSec )
 			if ( part != self && part->GetPhysics() ) 
 			{
 				PartClipState = part->GetPhysics()->GetClipModel()->IsEnabled();
-				InitClipStates.Append( PartClipState );
+				teamClipStates.Append( PartClipState );
 
 				part->GetPhysics()->EnableClip();
 			}
@@ -6628,24 +6659,44 @@ bool idPhysics_AF::Evaluate( int timeStepMSec, int endTimeMSec )
 
 #ifdef AF_TIMINGS
 	timer_collision.Stop();
+	timer_total.Stop();
+#endif
+
+	return true;
+}
+
+/*
+================
+idPhysics_AF::EvaluateSolve
+
+  Touches only this articulated figure, so it can run in a parallel job
+================
+*/
+void idPhysics_AF::EvaluateSolve( void )
+{
+	float timeStep = evalTimeStep;
+
+#ifdef AF_TIMINGS
+	timer_total.Start();
 #endif
 
 	// evaluate constraint equations
 	EvaluateConstraints( timeStep );
 
 	// apply friction
-	ApplyFriction( timeStep, endTimeMSec );
+	ApplyFriction( timeStep, evalEndTimeMSec );
 
 	// add frame constraints
 	AddFrameConstraints();
 
 #ifdef AF_TIMINGS
-	int i, numPrimary = 0, numAuxiliary = 0;
+	int i;
+	evalNumPrimary = evalNumAuxiliary = 0;
 	for ( i = 0; i < primaryConstraints.Num(); i++ ) {
-		numPrimary += primaryConstraints[i]->J1.GetNumRows();
+		evalNumPrimary += primaryConstraints[i]->J1.GetNumRows();
 	}
 	for ( i = 0; i < auxiliaryConstraints.Num(); i++ ) {
-		numAuxiliary += auxiliaryConstraints[i]->J1.GetNumRows();
+		evalNumAuxiliary += auxiliaryConstraints[i]->J1.GetNumRows();
 	}
 	timer_pc.Start();
 #endif
@@ -6671,6 +6722,26 @@ bool idPhysics_AF::Evaluate( int timeStepMSec, int endTimeMSec )
 	// evolve current state to next state
 	Evolve( timeStep );
 
+#ifdef AF_TIMINGS
+	timer_total.Stop();
+#endif
+}
+
+/*
+================
+idPhysics_AF::EvaluateFinish
+================
+*/
+void idPhysics_AF::EvaluateFinish( void )
+{
+	float timeStep = evalTimeStep;
+	int endTimeMSec = evalEndTimeMSec;
+	idEntity *part = NULL;
+
+#ifdef AF_TIMINGS
+	timer_total.Start();
+#endif
+
 	// debug graphics
 	DebugDraw();
 
@@ -6744,8 +6815,8 @@ bool idPhysics_AF::Evaluate( int timeStepMSec, int endTimeMSec )
 		gameLocal.Printf( "%12s: t %1.4f pc %2d, %1.4f ac %2d %1.4f lcp %1.4f cd %1.4f\n",
 						self->name.c_str(),
 						timer_total.Milliseconds(),
-						numPrimary, timer_pc.Milliseconds(),
-						numAuxiliary, timer_ac.Milliseconds() - timer_lcp.Milliseconds(),
+						evalNumPrimary, timer_pc.Milliseconds(),
+						evalNumAuxiliary, timer_ac.Milliseconds() - timer_lcp.Milliseconds(),
 						timer_lcp.Milliseconds(), timer_collision.Milliseconds() );
 	}
 	else if ( af_showTimings.GetInteger() == 2 ) {
@@ -6754,8 +6825,8 @@ bool idPhysics_AF::Evaluate( int timeStepMSec, int endTimeMSec )
 			gameLocal.Printf( "af %d: t %1.4f pc %2d, %1.4f ac %2d %1.4f lcp %1.4f cd %1.4f\n",
 							numArticulatedFigures,
 							timer_total.Milliseconds(),
-							numPrimary, timer_pc.Milliseconds(),
-							numAuxiliary, timer_ac.Milliseconds() - timer_lcp.Milliseconds(),
+							evalNumPrimary, timer_pc.Milliseconds(),
+							evalNumAuxiliary, timer_ac.Milliseconds() - timer_lcp.Milliseconds(),
 							timer_lcp.Milliseconds(), timer_collision.Milliseconds() );
 		}
 	}
@@ -6781,7 +6852,7 @@ bool idPhysics_AF::Evaluate( int timeStepMSec, int endTimeMSec )
 		{
 			if ( part != self && part->GetPhysics() ) 
 			{
-				if( !InitClipStates[count] )
+				if( !teamClipStates[count] )
 					part->GetPhysics()->DisableClip();
 
 				count++;
@@ -6789,6 +6860,23 @@ bool idPhysics_AF::Evaluate( int timeStepMSec, int endTimeMSec )
 		}
 	}
 
+}
+
+/*
+================
+idPhysics_AF::CanSolveInParallel
+================
+*/
+bool idPhysics_AF::CanSolveInParallel( void ) const {
+	if ( masterBody ) {
+		return false;
+	}
+	for ( int i = 0; i < constraints.Num(); i++ ) {
+		// suspension traces against collision world while evaluated
+		if ( constraints[i]->GetType() == CONSTRAINT_SUSPENSION ) {
+			return false;
+		}
+	}
 	return true;
 }
 
@@ -6992,6 +7080,13 @@ idPhysics_AF::idPhysics_AF( void ) {
 
 	lcp = idLCP::AllocSymmetric();
 
+	evalTimeStep = 0.0f;
+	evalEndTimeMSec = 0;
+	evalNumPrimary = 0;
+	evalNumAuxiliary = 0;
+	preEvaluatedTime = -1;
+	preEvaluatedMoved = false;
+
 	memset( &current, 0, sizeof( current ) );
 	current.atRest = -1;
 	current.lastTimeStep = USERCMD_MSEC;
@@ -950,6 +950,17 @@ public:	// common physics interface
 	virtual void			UpdateTime( int endTimeMSec ) override;
 	virtual int				GetTime( void ) const override;
 
+							// Evaluate split into stages for idAFIslandSolver
+							// Prepare and Finish use collision world and game state, so they must run on main thread
+							// Solve touches nothing but this articulated figure, so it can run in a parallel job
+	bool					EvaluatePrepare( int timeStepMSec, int endTimeMSec );	// returns false if there is nothing to solve
+	void					EvaluateSolve( void );
+	void					EvaluateFinish( void );
+							// true if Solve stage does not depend on other entities
+	bool					CanSolveInParallel( void ) const;
+							// next Evaluate up to the given time is no-op, since it has already been done
+	void					SetPreEvaluated( int endTimeMSec, bool moved ) { preEvaluatedTime = endTimeMSec; preEvaluatedMoved = moved; }
+
 	virtual void			GetImpactInfo( const int id, const idVec3 &point, impactInfo_t *info ) const override;
 	virtual void			ApplyImpulse( const int id, const idVec3 &point, const idVec3 &impulse ) override;
 	virtual void			AddForce( const int id, const idVec3 &point, const idVec3 &force, const idForceApplicationId &applId ) override;
@@ -1090,6 +1101,15 @@ private:
 	idAFBody *				masterBody;						// master body
 	idLCP *					lcp;							// linear complementarity problem solver
 
+							// state passed between evaluation stages
+	float					evalTimeStep;
+	int						evalEndTimeMSec;
+	int						evalNumPrimary;
+	int						evalNumAuxiliary;
+	idList<bool>			teamClipStates;					// TDM: initial clip state of team members enabled for collision
+	int						preEvaluatedTime;				// if >= 0, simulation was already done up to this time
+	bool					preEvaluatedMoved;
+
 private:
 	bool					IsClosedLoop( const idAFBody *body1, const idAFBody *body2 ) const;
 	void					PrimaryFactor( void );
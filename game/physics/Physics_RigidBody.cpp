@@ -1546,6 +1546,13 @@ idPhysics_RigidBody::Activate
 ================
 */
 void idPhysics_RigidBody::Activate( void ) {
+	if ( current.atRest >= 0 ) {
+		// wake up bodies which were put to rest together with this one
+		gameLocal.sleepIslands.Wake( self );
+	} else {
+		// impulse after the body deferred its rest would be lost
+		gameLocal.sleepIslands.CancelRest( self );
+	}
 	current.atRest = -1;
 	self->BecomeActive( TH_PHYSICS );
 }
@@ -1795,7 +1802,8 @@ bool idPhysics_RigidBody::Evaluate( int timeStepMSec, int endTimeMSec ) {
 #endif
 
 		// check if the body has come to rest
-		if ( ( externalForce.LengthSqr() == 0.0f ) && TestIfAtRest() )
+		// if it touches other bodies, it is put to rest together with them
+		if ( ( externalForce.LengthSqr() == 0.0f ) && TestIfAtRest() && !gameLocal.sleepIslands.DeferRest( this ) )
 		{
 			// put to rest
 			Rest();
@@ -0,0 +1,253 @@
+/*****************************************************************************
+The Dark Mod GPL Source Code
+
+This file is part of the The Dark Mod Source Code, originally based
+on the Doom 3 GPL Source Code as published in 2011.
+
+The Dark Mod Source Code is free software: you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version. For details, see LICENSE.TXT.
+
+Project: The Dark Mod (http://www.thedarkmod.com/)
+
+******************************************************************************/
+#include "precompiled.h"
+#include "game/physics/SleepIslands.h"
+
+#include "game/Game_local.h"
+
+static bool IsRigidBody( idEntity *ent ) {
+	return ent->GetPhysics() && ent->GetPhysics()->IsType( idPhysics_RigidBody::Type );
+}
+
+void idSleepIslands::Clear() {
+	candidates.ClearFree();
+	islands.ClearFree();
+	freeIslands.ClearFree();
+	entityIsland.ClearFree();
+	parent.ClearFree();
+	blocked.ClearFree();
+	candidateIndex.ClearFree();
+}
+
+int idSleepIslands::AllocIsland() {
+	if ( freeIslands.Num() > 0 ) {
+		int id = freeIslands[freeIslands.Num() - 1];
+		freeIslands.RemoveIndex( freeIslands.Num() - 1 );
+		return id;
+	}
+	return islands.Append( Island() );
+}
+
+void idSleepIslands::FreeIsland( int id ) {
+	islands[id].members.Clear();
+	freeIslands.Append( id );
+}
+
+int idSleepIslands::GetIsland( idEntity *ent ) const {
+	int num = ent->entityNumber;
+	if ( num < 0 || num >= entityIsland.Num() || entityIsland[num] < 0 ) {
+		return -1;
+	}
+	// entity number could have been reused by another entity
+	int id = entityIsland[num];
+	for ( const idEntityPtr<idEntity> &member : islands[id].members ) {
+		if ( member.GetEntity() == ent ) {
+			return id;
+		}
+	}
+	return -1;
+}
+
+int idSleepIslands::FindRoot( int i ) {
+	while ( parent[i] != i ) {
+		parent[i] = parent[parent[i]];
+		i = parent[i];
+	}
+	return i;
+}
+
+bool idSleepIslands::DeferRest( idPhysics_RigidBody *body ) {
+	if ( !rb_sleepIslands.GetBool() ) {
+		return false;
+	}
+
+	idEntity *self = body->GetSelf();
+	bool touchesBodies = false;
+	for ( int i = 0; i < body->GetNumContacts(); i++ ) {
+		idEntity *other = gameLocal.entities[body->GetContact( i ).entityNum];
+		if ( other && other != self && IsRigidBody( other ) ) {
+			touchesBodies = true;
+			break;
+		}
+	}
+	if ( !touchesBodies ) {
+		// resting on static geometry only: nobody to wait for
+		return false;
+	}
+
+	candidates.AddGrow( self );
+	return true;
+}
+
+void idSleepIslands::CancelRest( idEntity *ent ) {
+	for ( int i = 0; i < candidates.Num(); i++ ) {
+		if ( candidates[i].GetEntity() == ent ) {
+			// removed candidate also blocks its contact group in Update
+			candidates[i] = NULL;
+		}
+	}
+}
+
+void idSleepIslands::Update() {
+	if ( candidates.Num() == 0 ) {
+		return;
+	}
+
+	TRACE_CPU_SCOPE( "SleepIslands" )
+
+	if ( candidateIndex.Num() < MAX_GENTITIES ) {
+		candidateIndex.SetNum( MAX_GENTITIES );
+		for ( int i = 0; i < MAX_GENTITIES; i++ ) {
+			candidateIndex[i] = -1;
+		}
+	}
+
+	int n = candidates.Num();
+	parent.SetNum( n );
+	blocked.SetNum( n );
+	for ( int i = 0; i < n; i++ ) {
+		parent[i] = i;
+		blocked[i] = false;
+		idEntity *ent = candidates[i].GetEntity();
+		if ( !ent || !IsRigidBody( ent ) || ent->IsAtRest() || candidateIndex[ent->entityNumber] >= 0 ) {
+			// removed, put to rest by someone else, or duplicate from another game tic
+			candidates[i] = NULL;
+			continue;
+		}
+		candidateIndex[ent->entityNumber] = i;
+	}
+
+	// build contact groups, remember sleeping bodies which have to join them
+	idList<idEntity *> touchedSleeping;
+	idList<int> touchedBy;
+	for ( int i = 0; i < n; i++ ) {
+		idEntity *ent = candidates[i].GetEntity();
+		if ( !ent ) {
+			continue;
+		}
+		idPhysics *physics = ent->GetPhysics();
+		for ( int c = 0; c < physics->GetNumContacts(); c++ ) {
+			idEntity *other = gameLocal.entities[physics->GetContact( c ).entityNum];
+			if ( !other || other == ent || !IsRigidBody( other ) ) {
+				continue;
+			}
+			int j = candidateIndex[other->entityNumber];
+			if ( j >= 0 ) {
+				int ri = FindRoot( i );
+				int rj = FindRoot( j );
+				if ( ri != rj ) {
+					parent[Max( ri, rj )] = Min( ri, rj );
+				}
+			} else if ( other->IsAtRest() ) {
+				touchedSleeping.Append( other );
+				touchedBy.Append( i );
+			} else {
+				// touches a body which is still moving
+				blocked[i] = true;
+			}
+		}
+	}
+	for ( int i = 0; i < n; i++ ) {
+		if ( blocked[i] ) {
+			blocked[FindRoot( i )] = true;
+		}
+	}
+
+	// create islands for groups where everyone is ready
+	idList<int> rootIsland;
+	rootIsland.SetNum( n );
+	for ( int i = 0; i < n; i++ ) {
+		rootIsland[i] = -1;
+	}
+	auto AddMember = [this]( int id, idEntity *ent ) {
+		islands[id].members.Append( ent );
+		while ( entityIsland.Num() <= ent->entityNumber ) {
+			entityIsland.Append( -1 );
+		}
+		entityIsland[ent->entityNumber] = id;
+	};
+	for ( int i = 0; i < n; i++ ) {
+		idEntity *ent = candidates[i].GetEntity();
+		int r = FindRoot( i );
+		if ( !ent || blocked[r] ) {
+			continue;
+		}
+		if ( rootIsland[r] < 0 ) {
+			rootIsland[r] = AllocIsland();
+		}
+		AddMember( rootIsland[r], ent );
+	}
+	for ( int k = 0; k < touchedSleeping.Num(); k++ ) {
+		int r = FindRoot( touchedBy[k] );
+		int id = rootIsland[r];
+		if ( id < 0 ) {
+			continue;
+		}
+		idEntity *other = touchedSleeping[k];
+		int oldId = GetIsland( other );
+		if ( oldId == id ) {
+			continue;
+		}
+		if ( oldId >= 0 ) {
+			// merge the whole sleeping island
+			idList<idEntityPtr<idEntity>> members;
+			members.Swap( islands[oldId].members );
+			FreeIsland( oldId );
+			for ( const idEntityPtr<idEntity> &member : members ) {
+				if ( idEntity *ent = member.GetEntity() ) {
+					AddMember( id, ent );
+				}
+			}
+		} else {
+			AddMember( id, other );
+		}
+	}
+
+	for ( int i = 0; i < n; i++ ) {
+		idEntity *ent = candidates[i].GetEntity();
+		if ( !ent ) {
+			continue;
+		}
+		candidateIndex[ent->entityNumber] = -1;
+		if ( !blocked[FindRoot( i )] ) {
+			ent->GetPhysics()->PutToRest();
+		}
+	}
+	candidates.Clear();
+}
+
+void idSleepIslands::Wake( idEntity *ent ) {
+	int id = GetIsland( ent );
+	if ( id < 0 ) {
+		return;
+	}
+
+	idList<idEntityPtr<idEntity>> members;
+	members.Swap( islands[id].members );
+	FreeIsland( id );
+	for ( const idEntityPtr<idEntity> &member : members ) {
+		idEntity *other = member.GetEntity();
+		if ( other && entityIsland[other->entityNumber] == id ) {
+			entityIsland[other->entityNumber] = -1;
+		}
+	}
+
+	for ( const idEntityPtr<idEntity> &member : members ) {
+		idEntity *other = member.GetEntity();
+		if ( other && other != ent ) {
+			other->ActivatePhysics( ent );
+		}
+	}
+}
@@ -0,0 +1,61 @@
+/*****************************************************************************
+The Dark Mod GPL Source Code
+
+This file is part of the The Dark Mod Source Code, originally based
+on the Doom 3 GPL Source Code as published in 2011.
+
+The Dark Mod Source Code is free software: you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version. For details, see LICENSE.TXT.
+
+Project: The Dark Mod (http://www.thedarkmod.com/)
+
+******************************************************************************/
+#pragma once
+
+class idPhysics_RigidBody;
+
+// sleeping islands of rigid bodies.
+// A body touching other rigid bodies does not go to rest on its own:
+// it waits until every body in its contact group is ready to rest, then the whole group sleeps at once.
+// Sleeping group is remembered, and activating any of its bodies (contact, push, impulse) wakes all of them.
+// This way piles of junk don't keep waking each other up with tiny jitters.
+class idSleepIslands {
+public:
+	void			Clear();
+
+	// called by rigid body which is ready to rest
+	// returns true if rest is deferred until the whole contact group is ready
+	bool			DeferRest( idPhysics_RigidBody *body );
+	// called when awake rigid body is activated (impulse, force, collision) after it deferred rest:
+	// contacts it was evaluated with are no longer valid, so it must not be put to rest on this frame
+	void			CancelRest( idEntity *ent );
+
+	// must be called once per frame after entities think
+	// puts to rest every contact group where all awake bodies are ready
+	void			Update();
+
+	// called when sleeping rigid body is activated
+	void			Wake( idEntity *ent );
+
+private:
+	struct Island {
+		idList<idEntityPtr<idEntity>> members;
+	};
+
+	int				AllocIsland();
+	void			FreeIsland( int id );
+	int				GetIsland( idEntity *ent ) const;
+	int				FindRoot( int i );
+
+	idList<idEntityPtr<idEntity>> candidates;	// bodies ready to rest on this frame
+	idList<Island>	islands;
+	idList<int>		freeIslands;
+	idList<int>		entityIsland;				// entity number -> sleeping island (-1 if none)
+
+	// temporary data of Update
+	idList<int>		parent;
+	idList<bool>	blocked;
+	idList<int>		candidateIndex;				// entity number -> index in candidates (-1 if none)
+};
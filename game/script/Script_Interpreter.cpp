@@ -29,15 +29,10 @@ idInterpreter::idInterpreter() {
 	localstackUsed = 0;
 	terminateOnExit = true;
 	debug = 0;
+	numInstructions = 0;
 	memset( localstack, 0, sizeof( localstack ) );
 	memset( callStack, 0, sizeof( callStack ) );
 	Reset();
-#ifdef PROFILE_SCRIPT
-	while (functionTimers.size() > 0)
-	{
-		functionTimers.pop();
-	}
-#endif
 }
 
 /*
@@ -151,20 +146,6 @@ idInterpreter::Reset
 ================
 */
 void idInterpreter::Reset( void ) {
-#ifdef PROFILE_SCRIPT
-	// Clear out any function timers
-	while (functionTimers.size() > 0)
-	{
-		idTimer& topMost = functionTimers.top();
-		if (topMost.Running())
-		{
-			topMost.Stop();
-		}
-		DM_LOG(LC_AI, LT_INFO)LOGSTRING("Resetting script stack, Timer: %lf\n", functionTimers.top().Milliseconds());
-		functionTimers.pop();
-	}
-#endif
-
 	callStackDepth = 0;
 	localstackUsed = 0;
 	localstackBase = 0;
@@ -589,6 +570,10 @@ void idInterpreter::EnterFunction( const function_t *func, bool clearStack ) {
 		Error( "call stack overflow" );
 	}
 
+	if ( scriptProfiler.IsActive() && func ) {
+		scriptProfiler.EnterFunction( this, func );
+	}
+
 	stack = &callStack[ callStackDepth ];
 
 	stack->s			= instructionPointer + 1;	// point to the next instruction to execute
@@ -682,6 +667,10 @@ void idInterpreter::LeaveFunction( idVarDef *returnDef ) {
 		}
 	}
 
+	if ( scriptProfiler.IsActive() ) {
+		scriptProfiler.LeaveFunction( this );
+	}
+
 	// up stack
 	callStackDepth--;
 	stack = &callStack[ callStackDepth ]; 
@@ -814,7 +803,15 @@ void idInterpreter::CallEvent( const function_t *func, int argsize ) {
 	}
 
 	popParms = argsize;
-	eventEntity->ProcessEventArgPtr( evdef, data );
+	{
+		TRACE_CPU_SCOPE_TEXT( "Script:Event", evdef->GetName() )
+		bool profile = scriptProfiler.IsActive();
+		double profileTicks = ( profile ? scriptProfiler.BeginEvent() : 0.0 );
+		eventEntity->ProcessEventArgPtr( evdef, data );
+		if ( profile ) {
+			scriptProfiler.EndEvent( evdef, profileTicks );
+		}
+	}
 
 	if ( !multiFrameEvent ) {
 		if ( popParms ) {
@@ -945,7 +942,15 @@ void idInterpreter::CallSysEvent( const function_t *func, int argsize ) {
 	}
 
 	popParms = argsize;
-	thread->ProcessEventArgPtr( evdef, data );
+	{
+		TRACE_CPU_SCOPE_TEXT( "Script:SysEvent", evdef->GetName() )
+		bool profile = scriptProfiler.IsActive();
+		double profileTicks = ( profile ? scriptProfiler.BeginEvent() : 0.0 );
+		thread->ProcessEventArgPtr( evdef, data );
+		if ( profile ) {
+			scriptProfiler.EndEvent( evdef, profileTicks );
+		}
+	}
 	if ( popParms ) {
 		PopParms( popParms );
 	}
@@ -978,25 +983,36 @@ bool idInterpreter::Execute( void ) {
 		instructionPointer--;
 	}
 
-#ifdef PROFILE_SCRIPT
-	if (debug && functionTimers.size() == 0) {
-		// Create a new function timer, as we don't appear to have one
-		functionTimers.push(idTimer());
-	}
-	if (debug) {
-		functionTimers.top().Start();
+	TRACE_CPU_SCOPE_TEXT( "Script:Execute", currentFunction->Name() )
+	// script errors unwind out of Execute, profiler context must be popped anyway
+	struct ProfileExecuteGuard {
+		idInterpreter *interp = nullptr;
+		~ProfileExecuteGuard() {
+			if ( interp ) {
+				scriptProfiler.EndExecute( interp );
+			}
+		}
+	} profileGuard;
+	if ( scriptProfiler.IsActive() ) {
+		scriptProfiler.BeginExecute( this );
+		profileGuard.interp = this;
 	}
-#endif
 
 	//stgatilov #4520: shortcuts for pointer-offset conversion
 #define PACK(ptr) gameLocal.program.ScriptObjectMemory_Pack(ptr)
 #define UNPACK(offset) gameLocal.program.ScriptObjectMemory_Unpack(offset)
+	// every statement is traced, including the second one of superinstruction
+#define SCRIPT_TRACE_STATEMENT() \
+	if ( scriptTrace.IsActive() ) { \
+		scriptTrace.Statement( thread ? thread->GetThreadNum() : 0, instructionPointer, localstackUsed ); \
+	}
 
 	runaway = 5000000;
 
 	doneProcessing = false;
 	while( !doneProcessing && !threadDying ) {
 		instructionPointer++;
+		numInstructions++;
 
 		if ( !--runaway ) {
 			Error( "runaway loop error" );
@@ -1004,34 +1020,12 @@ bool idInterpreter::Execute( void ) {
 
 		// next statement
 		st = &gameLocal.program.GetStatement( instructionPointer );
+		SCRIPT_TRACE_STATEMENT()
 
-		switch( st->op ) {
+		switch( st->fused ? st->fused : st->op ) {
 		case OP_RETURN:
-
-#ifdef PROFILE_SCRIPT
-			if (debug && functionTimers.size() > 0)
-			{
-				// greebo: End the current timer, before adding a new one
-				functionTimers.top().Stop();
-
-				DM_LOG(LC_AI, LT_INFO)LOGSTRING("Spent %lf msec in function %s.", functionTimers.top().Milliseconds(), currentFunction->Name());
-
-				// Remove the stopped timer
-				functionTimers.pop();
-			}
-#endif
 			// Actually leave the function
 			LeaveFunction( st->a );
-
-#ifdef PROFILE_SCRIPT
-			// greebo: Maybe we have a timer of a previous function?
-			if (debug && functionTimers.size() > 0)
-			{
-				//DM_LOG(LC_AI, LT_INFO)LOGSTRING("Restarting timer of previous function: %s", currentFunction->Name());
-				// Start the timer of the previous thread
-				functionTimers.top().Start();
-			}
-#endif
 			break;
 
 		case OP_THREAD:
@@ -1062,32 +1056,10 @@ bool idInterpreter::Execute( void ) {
 			break;
 
 		case OP_CALL:
-
-#ifdef PROFILE_SCRIPT
-			if (debug && functionTimers.size() > 0)
-			{
-				// End the current timer, before leaving the current one
-				functionTimers.top().Stop();
-				//DM_LOG(LC_AI, LT_INFO)LOGSTRING("Stopping timer of %s at %lf msec.", currentFunction->Name(), functionTimers.top().Milliseconds());
-			}
-#endif
 			EnterFunction( st->a->value.functionPtr, false );
-#ifdef PROFILE_SCRIPT
-			if (debug) {
-				// Add and start a new timer
-				functionTimers.push(idTimer());
-
-				functionTimers.top().Clear();
-				functionTimers.top().Start();
-				//DM_LOG(LC_AI, LT_INFO)LOGSTRING("Starting new timer on entering function %s.", currentFunction->Name());
-			}
-#endif
 			break;
 
 		case OP_EVENTCALL:
-#ifdef PROFILE_SCRIPT
-			//DM_LOG(LC_AI, LT_INFO)LOGSTRING("Calling script event.");
-#endif
 			CallEvent( st->a->value.functionPtr, st->b->value.argSize );
 			break;
 
@@ -1096,26 +1068,7 @@ bool idInterpreter::Execute( void ) {
 			obj = GetScriptObject( *var_a.entityNumberPtr );
 			if ( obj ) {
 				func = obj->GetTypeDef()->GetFunction( st->b->value.virtualFunction );
-
-#ifdef PROFILE_SCRIPT
-				if (debug && functionTimers.size() > 0)
-				{
-					// End the current timer, before leaving the current one
-					functionTimers.top().Stop();
-					//DM_LOG(LC_AI, LT_INFO)LOGSTRING("Stopping timer of %s at %lf msec.", currentFunction->Name(), functionTimers.top().Milliseconds());
-				}
-#endif
 				EnterFunction( func, false );
-#ifdef PROFILE_SCRIPT
-				if (debug) {
-					// Add and start a new timer
-					functionTimers.push(idTimer());
-
-					functionTimers.top().Clear();
-					functionTimers.top().Start();
-					//DM_LOG(LC_AI, LT_INFO)LOGSTRING("Starting new timer on entering function %s.", currentFunction->Name());
-				}
-#endif
 			} else {
 				int entNum = *var_a.entityNumberPtr;
 				idEntity *ent = GetEntity(entNum);
@@ -1948,6 +1901,63 @@ bool idInterpreter::Execute( void ) {
 			Push( *var_a.entityNumberPtr );
 			break;
 
+		// superinstructions execute the second statement right away
+		//all the state is updated exactly as if it went through the loop
+#define SUPER_NEXT_STATEMENT() \
+			instructionPointer++; \
+			numInstructions++; \
+			if ( !--runaway ) { \
+				Error( "runaway loop error" ); \
+			} \
+			st = &gameLocal.program.GetStatement( instructionPointer ); \
+			SCRIPT_TRACE_STATEMENT()
+#define SUPER_COMPARE_BRANCH( sop, compare, jumpIfTrue ) \
+		case sop: \
+			var_a = GetVariable( st->a ); \
+			var_b = GetVariable( st->b ); \
+			var_c = GetVariable( st->c ); \
+			*var_c.floatPtr = ( compare ); \
+			SUPER_NEXT_STATEMENT() \
+			var_a = GetVariable( st->a ); \
+			if ( ( *var_a.intPtr != 0 ) == jumpIfTrue ) { \
+				NextInstruction( instructionPointer + st->b->value.jumpOffset ); \
+			} \
+			break;
+
+		SUPER_COMPARE_BRANCH( SOP_EQ_F_IF,		*var_a.floatPtr == *var_b.floatPtr,					true )
+		SUPER_COMPARE_BRANCH( SOP_EQ_F_IFNOT,	*var_a.floatPtr == *var_b.floatPtr,					false )
+		SUPER_COMPARE_BRANCH( SOP_NE_F_IF,		*var_a.floatPtr != *var_b.floatPtr,					true )
+		SUPER_COMPARE_BRANCH( SOP_NE_F_IFNOT,	*var_a.floatPtr != *var_b.floatPtr,					false )
+		SUPER_COMPARE_BRANCH( SOP_EQ_E_IF,		*var_a.entityNumberPtr == *var_b.entityNumberPtr,	true )
+		SUPER_COMPARE_BRANCH( SOP_EQ_E_IFNOT,	*var_a.entityNumberPtr == *var_b.entityNumberPtr,	false )
+		SUPER_COMPARE_BRANCH( SOP_NE_E_IF,		*var_a.entityNumberPtr != *var_b.entityNumberPtr,	true )
+		SUPER_COMPARE_BRANCH( SOP_NE_E_IFNOT,	*var_a.entityNumberPtr != *var_b.entityNumberPtr,	false )
+		SUPER_COMPARE_BRANCH( SOP_LT_IF,		*var_a.floatPtr < *var_b.floatPtr,					true )
+		SUPER_COMPARE_BRANCH( SOP_LT_IFNOT,		*var_a.floatPtr < *var_b.floatPtr,					false )
+		SUPER_COMPARE_BRANCH( SOP_LE_IF,		*var_a.floatPtr <= *var_b.floatPtr,					true )
+		SUPER_COMPARE_BRANCH( SOP_LE_IFNOT,		*var_a.floatPtr <= *var_b.floatPtr,					false )
+		SUPER_COMPARE_BRANCH( SOP_GT_IF,		*var_a.floatPtr > *var_b.floatPtr,					true )
+		SUPER_COMPARE_BRANCH( SOP_GT_IFNOT,		*var_a.floatPtr > *var_b.floatPtr,					false )
+		SUPER_COMPARE_BRANCH( SOP_GE_IF,		*var_a.floatPtr >= *var_b.floatPtr,					true )
+		SUPER_COMPARE_BRANCH( SOP_GE_IFNOT,		*var_a.floatPtr >= *var_b.floatPtr,					false )
+
+		case SOP_PUSH_ENT_EVENTCALL:
+			var_a = GetVariable( st->a );
+			Push( *var_a.entityNumberPtr );
+			SUPER_NEXT_STATEMENT()
+			CallEvent( st->a->value.functionPtr, st->b->value.argSize );
+			break;
+
+		case SOP_PUSH_F_SYSCALL:
+			var_a = GetVariable( st->a );
+			Push( *var_a.intPtr );
+			SUPER_NEXT_STATEMENT()
+			CallSysEvent( st->a->value.functionPtr, st->b->value.argSize );
+			break;
+
+#undef SUPER_COMPARE_BRANCH
+#undef SUPER_NEXT_STATEMENT
+
 		case OP_BREAK:
 		case OP_CONTINUE:
 		default:
@@ -1958,12 +1968,7 @@ bool idInterpreter::Execute( void ) {
 
 #undef PACK
 #undef UNPACK
-
-#ifdef PROFILE_SCRIPT
-	if (debug && functionTimers.size() > 0) {
-		functionTimers.top().Stop();
-	}
-#endif
+#undef SCRIPT_TRACE_STATEMENT
 
 	return threadDying;
 }
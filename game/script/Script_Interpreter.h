@@ -16,13 +16,11 @@ Project: The Dark Mod (http://www.thedarkmod.com/)
 #ifndef __SCRIPT_INTERPRETER_H__
 #define __SCRIPT_INTERPRETER_H__
 
-#ifdef PROFILE_SCRIPT
-#include <stack>
-#endif
-
 #define MAX_STACK_DEPTH 	64
 #define LOCALSTACK_SIZE 	6144
 
+#include "Script_Profiler.h"
+
 typedef struct prstack_s {
 	int 				s;
 	const function_t	*f;
@@ -49,10 +47,10 @@ private:
 
 	idThread			*thread;
 
-#ifdef PROFILE_SCRIPT
-	typedef std::stack<idTimer> TimerStack;
-	TimerStack			functionTimers;
-#endif
+	// number of executed instructions, used only by profiler
+	unsigned int		numInstructions;
+	scriptProfileStack_t profileStack;
+	friend class idScriptProfiler;
 
 	void				PopParms( int numParms );
 	void				PushString( const char *string );
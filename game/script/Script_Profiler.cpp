@@ -0,0 +1,464 @@
+/*****************************************************************************
+The Dark Mod GPL Source Code
+
+This file is part of the The Dark Mod Source Code, originally based
+on the Doom 3 GPL Source Code as published in 2011.
+
+The Dark Mod Source Code is free software: you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version. For details, see LICENSE.TXT.
+
+Project: The Dark Mod (http://www.thedarkmod.com/)
+
+******************************************************************************/
+#include "precompiled.h"
+
+#include "game/Game_local.h"
+
+idScriptProfiler scriptProfiler;
+
+void idScriptProfiler::Start() {
+	if ( active ) {
+		return;
+	}
+	Clear();
+	active = true;
+	startTicks = lastTicks = Sys_GetClockTicks();
+}
+
+void idScriptProfiler::Stop() {
+	if ( !active ) {
+		return;
+	}
+	Charge();
+	active = false;
+	totalTicks += Sys_GetClockTicks() - startTicks;
+	contexts.Clear();
+}
+
+void idScriptProfiler::ResetContexts() {
+	contexts.Clear();
+}
+
+void idScriptProfiler::Clear() {
+	// interpreters will rebuild their profile stacks when they see new session
+	session++;
+	contexts.Clear();
+	functions.Clear();
+	events.Clear();
+	threads.Clear();
+	threadNames.Clear();
+	threadHash.Clear();
+	nodes.Clear();
+	nodeHash.Clear();
+	totalTicks = 0.0;
+	startTicks = lastTicks = Sys_GetClockTicks();
+
+	// root of call tree
+	Node root = { -1, -1, 0.0 };
+	nodes.Append( root );
+}
+
+idScriptProfiler::FunctionStats &idScriptProfiler::GetFunctionStats( int function ) {
+	if ( function >= functions.Num() ) {
+		functions.SetNum( function + 1 );
+	}
+	return functions[function];
+}
+
+int idScriptProfiler::ChildNode( int parent, int function ) {
+	int key = nodeHash.GenerateKey( parent, function );
+	for ( int i = nodeHash.First( key ); i != -1; i = nodeHash.Next( i ) ) {
+		if ( nodes[i].parent == parent && nodes[i].function == function ) {
+			return i;
+		}
+	}
+	Node node = { parent, function, 0.0 };
+	int idx = nodes.Append( node );
+	nodeHash.Add( key, idx );
+	return idx;
+}
+
+void idScriptProfiler::Sync( idInterpreter *interp ) {
+	scriptProfileStack_t &ps = interp->profileStack;
+	if ( ps.session == session ) {
+		return;
+	}
+
+	// interpreter was running before profiling started: take its current call stack
+	ps.session = session;
+	ps.instructionsMark = interp->numInstructions;
+	ps.activeTicks = 0.0;
+	ps.node[0] = 0;
+	ps.enterTicks[0] = 0.0;
+	for ( int d = 1; d <= interp->callStackDepth; d++ ) {
+		const function_t *f = ( d == interp->callStackDepth ? interp->currentFunction : interp->callStack[d].f );
+		ps.node[d] = ( f ? ChildNode( ps.node[d - 1], gameLocal.program.GetFunctionIndex( f ) ) : ps.node[d - 1] );
+		ps.enterTicks[d] = 0.0;
+	}
+}
+
+void idScriptProfiler::Charge() {
+	double now = Sys_GetClockTicks();
+	double delta = now - lastTicks;
+	lastTicks = now;
+
+	if ( contexts.Num() == 0 ) {
+		return;
+	}
+	// outer interpreters are waiting for the inner one inside event call
+	for ( int i = 0; i < contexts.Num(); i++ ) {
+		contexts[i].interp->profileStack.activeTicks += delta;
+	}
+
+	idInterpreter *interp = contexts[contexts.Num() - 1].interp;
+	scriptProfileStack_t &ps = interp->profileStack;
+	unsigned int instructions = interp->numInstructions - ps.instructionsMark;
+	ps.instructionsMark = interp->numInstructions;
+
+	int depth = interp->callStackDepth;
+	if ( depth <= 0 ) {
+		return;
+	}
+	Node &node = nodes[ps.node[depth]];
+	node.exclusiveTicks += delta;
+	if ( node.function >= 0 ) {
+		FunctionStats &stats = GetFunctionStats( node.function );
+		stats.exclusiveTicks += delta;
+		stats.instructions += instructions;
+	}
+}
+
+void idScriptProfiler::BeginExecute( idInterpreter *interp ) {
+	Charge();
+	Sync( interp );
+	Context ctx = { interp, lastTicks, interp->numInstructions };
+	contexts.Append( ctx );
+}
+
+void idScriptProfiler::EndExecute( idInterpreter *interp ) {
+	if ( contexts.Num() == 0 || contexts[contexts.Num() - 1].interp != interp ) {
+		// profiling was started during execution
+		return;
+	}
+	Charge();
+	Context ctx = contexts[contexts.Num() - 1];
+	contexts.RemoveIndex( contexts.Num() - 1 );
+
+	const char *name = ( interp->thread ? interp->thread->GetThreadName() : "<no thread>" );
+	int key = threadHash.GenerateKey( name );
+	int idx;
+	for ( idx = threadHash.First( key ); idx != -1; idx = threadHash.Next( idx ) ) {
+		if ( threadNames[idx] == name ) {
+			break;
+		}
+	}
+	if ( idx == -1 ) {
+		idx = threadNames.Append( name );
+		threads.Append( ThreadStats() );
+		threadHash.Add( key, idx );
+	}
+	ThreadStats &stats = threads[idx];
+	stats.executes++;
+	stats.ticks += lastTicks - ctx.startTicks;
+	stats.instructions += interp->numInstructions - ctx.startInstructions;
+}
+
+void idScriptProfiler::EnterFunction( idInterpreter *interp, const function_t *func ) {
+	Charge();
+	Sync( interp );
+
+	scriptProfileStack_t &ps = interp->profileStack;
+	int function = gameLocal.program.GetFunctionIndex( func );
+	int depth = interp->callStackDepth + 1;
+	ps.node[depth] = ChildNode( ps.node[depth - 1], function );
+	ps.enterTicks[depth] = ps.activeTicks;
+	GetFunctionStats( function ).calls++;
+}
+
+void idScriptProfiler::LeaveFunction( idInterpreter *interp ) {
+	Charge();
+	Sync( interp );
+
+	scriptProfileStack_t &ps = interp->profileStack;
+	int depth = interp->callStackDepth;
+	const function_t *func = interp->currentFunction;
+	if ( depth <= 0 || !func ) {
+		return;
+	}
+	// recursive call: outermost call already includes this time
+	for ( int d = 1; d < depth; d++ ) {
+		if ( interp->callStack[d].f == func ) {
+			return;
+		}
+	}
+	GetFunctionStats( gameLocal.program.GetFunctionIndex( func ) ).inclusiveTicks += ps.activeTicks - ps.enterTicks[depth];
+}
+
+double idScriptProfiler::BeginEvent() {
+	return Sys_GetClockTicks();
+}
+
+void idScriptProfiler::EndEvent( const idEventDef *evdef, double startTicks ) {
+	int num = evdef->GetEventNum();
+	if ( num >= events.Num() ) {
+		events.SetNum( Max( num + 1, idEventDef::NumEventCommands() ) );
+	}
+	events[num].calls++;
+	events[num].ticks += Sys_GetClockTicks() - startTicks;
+}
+
+idStr idScriptProfiler::GetNodeStack( int node ) const {
+	idList<int> chain;
+	for ( int n = node; n > 0; n = nodes[n].parent ) {
+		chain.Append( nodes[n].function );
+	}
+	idStr res;
+	for ( int i = chain.Num() - 1; i >= 0; i-- ) {
+		res += gameLocal.program.GetFunction( chain[i] )->Name();
+		if ( i > 0 ) {
+			res += ";";
+		}
+	}
+	return res;
+}
+
+void idScriptProfiler::Dump( const char *filename ) {
+	if ( active ) {
+		Charge();
+	}
+	double msPerTick = 1000.0 / Sys_ClockTicksPerSecond();
+	double totalMs = ( totalTicks + ( active ? Sys_GetClockTicks() - startTicks : 0.0 ) ) * msPerTick;
+
+	idStr reportName = idStr( filename ) + ".txt";
+	idStr foldedName = idStr( filename ) + ".folded";
+	idFile *report = fileSystem->OpenFileWrite( reportName, "fs_savepath" );
+	idFile *folded = fileSystem->OpenFileWrite( foldedName, "fs_savepath" );
+	if ( !report || !folded ) {
+		common->Warning( "Failed to open %s for writing", !report ? reportName.c_str() : foldedName.c_str() );
+		fileSystem->CloseFile( report );
+		fileSystem->CloseFile( folded );
+		return;
+	}
+
+	idList<int> order;
+	auto SortOrder = [&order]( int num, auto less ) {
+		order.SetNum( num );
+		for ( int i = 0; i < num; i++ ) {
+			order[i] = i;
+		}
+		std::stable_sort( order.begin(), order.end(), less );
+	};
+
+	report->Printf( "Script profile: %.3lf ms of wall time\n\n", totalMs );
+
+	// functions by exclusive time
+	double scriptMs = 0.0;
+	for ( const FunctionStats &stats : functions ) {
+		scriptMs += stats.exclusiveTicks * msPerTick;
+	}
+	report->Printf( "Functions: %.3lf ms in scripts (%.1lf%%)\n", scriptMs, 100.0 * scriptMs / Max( totalMs, 1e-3 ) );
+	report->Printf( "%10s %10s %10s %6s %12s  %s\n", "calls", "incl ms", "excl ms", "excl %", "instructions", "function" );
+	SortOrder( functions.Num(), [this]( int a, int b ) {
+		return functions[a].exclusiveTicks > functions[b].exclusiveTicks;
+	} );
+	common->Printf( "%10s %10s %10s %12s  %s\n", "calls", "incl ms", "excl ms", "instructions", "function" );
+	for ( int k = 0; k < order.Num(); k++ ) {
+		const FunctionStats &stats = functions[order[k]];
+		if ( stats.calls == 0 && stats.exclusiveTicks == 0.0 ) {
+			continue;
+		}
+		const function_t *func = gameLocal.program.GetFunction( order[k] );
+		report->Printf( "%10d %10.3lf %10.3lf %6.2lf %12lld  %s (%s)\n",
+			stats.calls, stats.inclusiveTicks * msPerTick, stats.exclusiveTicks * msPerTick,
+			100.0 * stats.exclusiveTicks * msPerTick / Max( scriptMs, 1e-3 ), (long long)stats.instructions,
+			func->Name(), gameLocal.program.GetFilename( func->filenum )
+		);
+		if ( k < 20 ) {
+			common->Printf( "%10d %10.3lf %10.3lf %12lld  %s\n",
+				stats.calls, stats.inclusiveTicks * msPerTick, stats.exclusiveTicks * msPerTick, (long long)stats.instructions, func->Name()
+			);
+		}
+	}
+
+	// events by time
+	report->Printf( "\nEvents:\n" );
+	report->Printf( "%10s %10s %10s  %s\n", "calls", "total ms", "avg us", "event" );
+	SortOrder( events.Num(), [this]( int a, int b ) {
+		return events[a].ticks > events[b].ticks;
+	} );
+	for ( int k = 0; k < order.Num(); k++ ) {
+		const EventStats &stats = events[order[k]];
+		if ( stats.calls == 0 ) {
+			continue;
+		}
+		report->Printf( "%10d %10.3lf %10.3lf  %s\n",
+			stats.calls, stats.ticks * msPerTick, 1000.0 * stats.ticks * msPerTick / stats.calls,
+			idEventDef::GetEventCommand( order[k] )->GetName()
+		);
+	}
+
+	// threads by time
+	report->Printf( "\nThreads:\n" );
+	report->Printf( "%10s %10s %12s  %s\n", "executes", "total ms", "instructions", "thread" );
+	SortOrder( threads.Num(), [this]( int a, int b ) {
+		return threads[a].ticks > threads[b].ticks;
+	} );
+	for ( int k = 0; k < order.Num(); k++ ) {
+		const ThreadStats &stats = threads[order[k]];
+		report->Printf( "%10d %10.3lf %12lld  %s\n",
+			stats.executes, stats.ticks * msPerTick, (long long)stats.instructions, threadNames[order[k]].c_str()
+		);
+	}
+
+	// collapsed stacks in microseconds, suitable for flamegraph.pl and speedscope
+	for ( int n = 1; n < nodes.Num(); n++ ) {
+		long long us = (long long)( nodes[n].exclusiveTicks * msPerTick * 1000.0 );
+		if ( us > 0 ) {
+			folded->Printf( "%s %lld\n", GetNodeStack( n ).c_str(), us );
+		}
+	}
+
+	fileSystem->CloseFile( report );
+	fileSystem->CloseFile( folded );
+	common->Printf( "Script profile written to %s and %s\n", reportName.c_str(), foldedName.c_str() );
+}
+
+/*
+===============================================================================
+
+	idScriptTrace
+
+===============================================================================
+*/
+
+idScriptTrace scriptTrace;
+
+static const int SCRIPT_TRACE_BUFFER = 1 << 16;
+static const int SCRIPT_TRACE_MAGIC = 0x43525453;		// "STRC"
+
+void idScriptTrace::Start( const char *filename, int numFrames ) {
+	Stop();
+	idStr name = filename;
+	name.DefaultFileExtension( ".strace" );
+	file = fileSystem->OpenFileWrite( name );
+	if ( !file ) {
+		common->Warning( "Failed to open script trace file '%s'", name.c_str() );
+		return;
+	}
+	file->WriteInt( SCRIPT_TRACE_MAGIC );
+	buffer.SetGranularity( SCRIPT_TRACE_BUFFER );
+	buffer.Clear();
+	lastFrame = -1;
+	stopFrame = ( numFrames > 0 ? gameLocal.framenum + numFrames : 0 );
+	numStatements = 0;
+	common->Printf( "Script trace started: %s\n", file->GetFullPath() );
+}
+
+void idScriptTrace::Stop() {
+	if ( !file ) {
+		return;
+	}
+	WriteBuffer();
+	common->Printf( "Script trace stopped: %lld statements written to %s\n", (long long)numStatements, file->GetFullPath() );
+	fileSystem->CloseFile( file );
+	file = nullptr;
+	buffer.ClearFree();
+}
+
+void idScriptTrace::WriteBuffer() {
+	file->Write( buffer.Ptr(), buffer.Num() * sizeof( Record ) );
+	buffer.SetNum( 0, false );
+}
+
+void idScriptTrace::Statement( int threadNum, int statement, int stackUsed ) {
+	if ( gameLocal.framenum != lastFrame ) {
+		lastFrame = gameLocal.framenum;
+		if ( stopFrame && lastFrame >= stopFrame ) {
+			Stop();
+			return;
+		}
+		Record marker = { lastFrame, -1, 0 };
+		buffer.Append( marker );
+	}
+	Record rec = { threadNum, statement, stackUsed };
+	buffer.Append( rec );
+	numStatements++;
+	if ( buffer.Num() >= SCRIPT_TRACE_BUFFER ) {
+		WriteBuffer();
+	}
+}
+
+idStr idScriptTrace::DescribeRecord( const Record &rec ) {
+	if ( rec.statement < 0 ) {
+		return va( "frame %d", rec.thread );
+	}
+	if ( rec.statement >= gameLocal.program.NumStatements() ) {
+		return va( "thread %d: statement %d (not in current program)", rec.thread, rec.statement );
+	}
+	const statement_t &st = gameLocal.program.GetStatement( rec.statement );
+	return va( "thread %d: statement %d %s, stack %d (%s:%d)",
+		rec.thread, rec.statement, idCompiler::opcodes[st.op].name, rec.stackUsed,
+		gameLocal.program.GetFilenameForStatement( rec.statement ), gameLocal.program.GetLineNumberForStatement( rec.statement )
+	);
+}
+
+bool idScriptTrace::Compare( const char *filename1, const char *filename2 ) {
+	idStr names[2] = { filename1, filename2 };
+	idFile *files[2] = { nullptr, nullptr };
+	for ( int f = 0; f < 2; f++ ) {
+		names[f].DefaultFileExtension( ".strace" );
+		files[f] = fileSystem->OpenFileRead( names[f] );
+		int magic = 0;
+		if ( files[f] ) {
+			files[f]->ReadInt( magic );
+		}
+		if ( magic != SCRIPT_TRACE_MAGIC ) {
+			common->Warning( "'%s' is not a script trace", names[f].c_str() );
+			for ( int g = 0; g <= f; g++ ) {
+				if ( files[g] ) {
+					fileSystem->CloseFile( files[g] );
+				}
+			}
+			return false;
+		}
+	}
+
+	int64 numRecords = 0, numStatements = 0;
+	int frame = -1;
+	bool equal = true;
+	Record recs[2];
+	while ( true ) {
+		bool ok0 = ( files[0]->Read( &recs[0], sizeof( Record ) ) == sizeof( Record ) );
+		bool ok1 = ( files[1]->Read( &recs[1], sizeof( Record ) ) == sizeof( Record ) );
+		if ( !ok0 || !ok1 ) {
+			if ( ok0 != ok1 ) {
+				common->Printf( "Script traces differ: %s ends after %lld records\n", names[ok0 ? 1 : 0].c_str(), (long long)numRecords );
+				equal = false;
+			}
+			break;
+		}
+		if ( memcmp( &recs[0], &recs[1], sizeof( Record ) ) != 0 ) {
+			common->Printf( "Script traces differ at record %lld (after %lld statements, frame %d):\n", (long long)numRecords, (long long)numStatements, frame );
+			for ( int f = 0; f < 2; f++ ) {
+				common->Printf( "  %s: %s\n", names[f].c_str(), DescribeRecord( recs[f] ).c_str() );
+			}
+			equal = false;
+			break;
+		}
+		if ( recs[0].statement < 0 ) {
+			frame = recs[0].thread;
+		} else {
+			numStatements++;
+		}
+		numRecords++;
+	}
+	if ( equal ) {
+		common->Printf( "Script traces are equal: %lld statements, last frame %d\n", (long long)numStatements, frame );
+	}
+
+	fileSystem->CloseFile( files[0] );
+	fileSystem->CloseFile( files[1] );
+	return equal;
+}
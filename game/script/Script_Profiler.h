@@ -0,0 +1,146 @@
+/*****************************************************************************
+The Dark Mod GPL Source Code
+
+This file is part of the The Dark Mod Source Code, originally based
+on the Doom 3 GPL Source Code as published in 2011.
+
+The Dark Mod Source Code is free software: you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version. For details, see LICENSE.TXT.
+
+Project: The Dark Mod (http://www.thedarkmod.com/)
+
+******************************************************************************/
+#pragma once
+
+class idInterpreter;
+class idEventDef;
+class function_t;
+
+// per-interpreter state of script profiler, stored inside idInterpreter
+struct scriptProfileStack_t {
+	int					session = 0;				// profiling session this state belongs to (0 = none)
+	unsigned int		instructionsMark = 0;		// instructions counter of interpreter when it was last charged
+	double				activeTicks = 0.0;			// time charged while interpreter was executing, including nested calls
+	int					node[MAX_STACK_DEPTH + 1];	// call tree node for every depth of call stack
+	double				enterTicks[MAX_STACK_DEPTH + 1];	// activeTicks when function on this depth was entered
+};
+
+// instrumenting profiler for game scripts, toggled at runtime (see scriptProfile command).
+// Time is charged to the function on top of call stack of the running interpreter,
+// every time a function is entered or left, or interpreter starts/stops executing.
+// Waiting script threads are not charged, so inclusive time only counts time spent executing.
+// Script events are timed separately, their time is also included in the time of calling function.
+// When profiler is not active, interpreter only checks one flag per call.
+class idScriptProfiler {
+public:
+	bool				IsActive() const { return active; }
+
+	void				Start();
+	void				Stop();
+	// drops all collected data, must be called when functions of program are freed
+	void				Clear();
+	// forgets interpreters being executed, must be called when script threads are deleted
+	void				ResetContexts();
+
+	// writes sorted report to <filename>.txt and collapsed call stacks to <filename>.folded
+	void				Dump( const char *filename );
+
+	// hooks called by idInterpreter only when profiler is active
+	void				BeginExecute( idInterpreter *interp );
+	void				EndExecute( idInterpreter *interp );
+	void				EnterFunction( idInterpreter *interp, const function_t *func );
+	void				LeaveFunction( idInterpreter *interp );
+	double				BeginEvent();
+	void				EndEvent( const idEventDef *evdef, double startTicks );
+
+private:
+	struct FunctionStats {
+		int				calls = 0;
+		double			inclusiveTicks = 0.0;		// recursive calls are counted once
+		double			exclusiveTicks = 0.0;
+		int64			instructions = 0;
+	};
+	struct EventStats {
+		int				calls = 0;
+		double			ticks = 0.0;
+	};
+	struct ThreadStats {
+		int				executes = 0;
+		double			ticks = 0.0;				// including nested calls
+		int64			instructions = 0;
+	};
+	// node of call tree: unique call stack
+	struct Node {
+		int				parent;
+		int				function;
+		double			exclusiveTicks;
+	};
+	struct Context {
+		idInterpreter	*interp;
+		double			startTicks;
+		unsigned int	startInstructions;
+	};
+
+	void				Charge();
+	void				Sync( idInterpreter *interp );
+	int					ChildNode( int parent, int function );
+	FunctionStats &		GetFunctionStats( int function );
+	idStr				GetNodeStack( int node ) const;
+
+	bool				active = false;
+	int					session = 0;
+	double				lastTicks = 0.0;
+	double				startTicks = 0.0;
+	double				totalTicks = 0.0;			// wall time of finished sessions
+
+	idList<Context>		contexts;					// interpreters being executed, innermost last
+
+	idList<FunctionStats> functions;				// indexed by function number in program
+	idList<EventStats>	events;						// indexed by event number
+	idList<ThreadStats>	threads;
+	idStrList			threadNames;
+	idHashIndex			threadHash;
+	idList<Node>		nodes;
+	idHashIndex			nodeHash;
+};
+
+extern idScriptProfiler scriptProfiler;
+
+// records every executed statement into a binary file (see scriptTrace command).
+// Traces recorded with and without superinstructions (g_scriptSuperInstructions)
+// from the same savegame with com_fixedTic must be equal: superinstruction records both of its statements.
+class idScriptTrace {
+public:
+	bool				IsActive() const { return file != nullptr; }
+
+	// records given number of game frames (0 = until stopped)
+	void				Start( const char *filename, int numFrames );
+	void				Stop();
+
+	// hook called by idInterpreter only when trace is active
+	void				Statement( int threadNum, int statement, int stackUsed );
+
+	// prints first difference between two trace files, returns true if they are equal
+	static bool			Compare( const char *filename1, const char *filename2 );
+
+private:
+	// frame marker has statement = -1 and game frame number in thread
+	struct Record {
+		int				thread;
+		int				statement;
+		int				stackUsed;
+	};
+
+	void				WriteBuffer();
+	static idStr		DescribeRecord( const Record &rec );
+
+	idFile *			file = nullptr;
+	idList<Record>		buffer;
+	int					lastFrame = 0;
+	int					stopFrame = 0;
+	int64				numStatements = 0;
+};
+
+extern idScriptTrace scriptTrace;
@@ -1691,7 +1691,9 @@ statement_t *idProgram::AllocStatement( void ) {
 	if ( statements.Num() >= statements.NumAllocated() ) {
 		throw idCompileError( va( "Exceeded maximum allowed number of statements (%d)", statements.NumAllocated() ) );
 	}
-	return &statements.Alloc();
+	statement_t &statement = statements.Alloc();
+	statement.fused = SOP_NONE;
+	return &statement;
 }
 
 /*
@@ -1813,6 +1815,64 @@ void idProgram::FinishCompilation( void ) {
 
 	variableDefaults.SetNum(variables.Num(), false);
 	memcpy(variableDefaults.Ptr(), variables.Ptr(), variables.Num());
+
+	LowerStatements( 0 );
+}
+
+/*
+==============
+idProgram::LowerStatements
+
+Marks pairs of statements which interpreter executes as one superinstruction.
+Must be called after all jumps in the given statements are patched.
+==============
+*/
+void idProgram::LowerStatements( int firstStatement ) {
+	int numFused = 0;
+	for ( int i = firstStatement; i < statements.Num(); i++ ) {
+		statements[i].fused = SOP_NONE;
+	}
+	if ( !g_scriptSuperInstructions.GetBool() ) {
+		return;
+	}
+
+	for ( int i = firstStatement; i + 1 < statements.Num(); i++ ) {
+		statement_t &st = statements[i];
+		int next = statements[i + 1].op;
+		// first statements of pairs are never second ones, so pairs never overlap
+		if ( next == OP_IF || next == OP_IFNOT ) {
+			int ifnot = ( next == OP_IFNOT );
+			switch ( st.op ) {
+			case OP_EQ_F:	st.fused = SOP_EQ_F_IF + ifnot; break;
+			case OP_NE_F:	st.fused = SOP_NE_F_IF + ifnot; break;
+			case OP_EQ_E:
+			case OP_EQ_EO:
+			case OP_EQ_OE:
+			case OP_EQ_OO:	st.fused = SOP_EQ_E_IF + ifnot; break;
+			case OP_NE_E:
+			case OP_NE_EO:
+			case OP_NE_OE:
+			case OP_NE_OO:	st.fused = SOP_NE_E_IF + ifnot; break;
+			case OP_LT:		st.fused = SOP_LT_IF + ifnot; break;
+			case OP_LE:		st.fused = SOP_LE_IF + ifnot; break;
+			case OP_GT:		st.fused = SOP_GT_IF + ifnot; break;
+			case OP_GE:		st.fused = SOP_GE_IF + ifnot; break;
+			}
+		} else if ( next == OP_EVENTCALL ) {
+			if ( st.op == OP_PUSH_ENT || st.op == OP_PUSH_OBJ || st.op == OP_PUSH_OBJENT ) {
+				st.fused = SOP_PUSH_ENT_EVENTCALL;
+			}
+		} else if ( next == OP_SYSCALL ) {
+			if ( st.op == OP_PUSH_F ) {
+				st.fused = SOP_PUSH_F_SYSCALL;
+			}
+		}
+		if ( st.fused != SOP_NONE ) {
+			numFused++;
+		}
+	}
+
+	gameLocal.DPrintf( "Script superinstructions: %d of %d statements\n", numFused, statements.Num() - firstStatement );
 }
 
 /*
@@ -1879,6 +1939,8 @@ bool idProgram::CompileText( const char *source, const char *text, bool console
 	ospath = fileSystem->RelativePathToOSPath( source, "fs_savepath", "" );
 	filenum = GetFilenum( ospath );
 
+	int firstStatement = statements.Num();
+
 	try {
 		compiler.CompileFile( text, filename, console );
 
@@ -1904,6 +1966,9 @@ bool idProgram::CompileText( const char *source, const char *text, bool console
 
 	if ( !console ) {
 		CompileStats();
+	} else {
+		// FinishCompilation was called long ago
+		LowerStatements( firstStatement );
 	}
 
 	return true;
@@ -1964,6 +2029,10 @@ idProgram::FreeData
 void idProgram::FreeData( void ) {
 	int i;
 
+	// profiled functions are going away
+	scriptProfiler.Clear();
+	scriptTrace.Stop();
+
 	// free the defs
 	varDefs.DeleteContents( true );
 	varDefNames.DeleteContents( true );
@@ -2280,6 +2349,8 @@ Restores all variables to their initial value
 void idProgram::Restart( void ) {
 	int i;
 
+	// interpreters of deleted threads must not be charged anymore
+	scriptProfiler.ResetContexts();
 	idThread::Restart();
 
 	//
@@ -2312,6 +2383,9 @@ void idProgram::Restart( void ) {
 	variables.SetNum(variableDefaults.Num(), false);
 	assert(variables.NumAllocated() == MAX_GLOBALS);
 	memcpy(variables.Ptr(), variableDefaults.Ptr(), variables.Num());
+
+	// apply current g_scriptSuperInstructions to startup scripts too
+	LowerStatements( 0 );
 }
 
 /*
@@ -401,8 +401,40 @@ extern	idVarDef	def_jumpoffset;		// only used for jump opcodes
 extern	idVarDef	def_argsize;		// only used for function call and thread opcodes
 extern	idVarDef	def_boolean;
 
+// superinstructions, set by idProgram::LowerStatements.
+// Superinstruction executes its statement and the next one without going through dispatch in between.
+// The next statement is left intact, so jumping directly to it works as usual.
+enum {
+	SOP_NONE = 0,
+	SOP_FIRST = 0x100,			// must not overlap with opcodes
+
+	// comparison followed by conditional jump
+	SOP_EQ_F_IF = SOP_FIRST,
+	SOP_EQ_F_IFNOT,
+	SOP_NE_F_IF,
+	SOP_NE_F_IFNOT,
+	SOP_EQ_E_IF,
+	SOP_EQ_E_IFNOT,
+	SOP_NE_E_IF,
+	SOP_NE_E_IFNOT,
+	SOP_LT_IF,
+	SOP_LT_IFNOT,
+	SOP_LE_IF,
+	SOP_LE_IFNOT,
+	SOP_GT_IF,
+	SOP_GT_IFNOT,
+	SOP_GE_IF,
+	SOP_GE_IFNOT,
+
+	// object push followed by event call without arguments: obj.getOrigin()
+	SOP_PUSH_ENT_EVENTCALL,
+	// float push followed by sys event call with one argument: sys.wait(x)
+	SOP_PUSH_F_SYSCALL,
+};
+
 typedef struct statement_s {
 	unsigned short	op;
+	unsigned short	fused;		// superinstruction starting at this statement, or SOP_NONE
 	idVarDef		*a;
 	idVarDef		*b;
 	idVarDef		*c;
@@ -473,6 +505,7 @@ public:
 	void										CompileFile( const char *filename );
 	void										BeginCompilation( void );
 	void										FinishCompilation( void );
+	void										LowerStatements( int firstStatement );
 	void										DisassembleStatement( idFile *file, int instructionPointer ) const;
 	void										Disassemble( void ) const;
 	void										FreeData( void );
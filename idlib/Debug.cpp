@@ -89,8 +89,12 @@ const char *CleanupSourceCodeFileName(const char *fileName) {
 	static int index;
 
 	index = (index + 1) & 3;
-	char *path = newFileNames[index];
-	strcpy(path, fileName);
+	return CleanupSourceCodeFileName(fileName, newFileNames[index]);
+}
+
+const char *CleanupSourceCodeFileName(const char *fileName, char *buffer) {
+	char *path = buffer;
+	idStr::Copynz(path, fileName, MAX_STRING_CHARS);
 
 	for (int i = 0; path[i]; i++)
 		if (path[i] == '\\')
@@ -19,6 +19,8 @@ Project: The Dark Mod (http://www.thedarkmod.com/)
 #include <stdint.h>
 
 const char *CleanupSourceCodeFileName(const char *fileName);
+// reentrant version: cleans file name into given buffer of MAX_STRING_CHARS bytes
+const char *CleanupSourceCodeFileName(const char *fileName, char *buffer);
 
 // some utilities for getting debug information in runtime
 class idDebugSystem {
@@ -59,6 +59,10 @@ void idBvhCreator::SetAlgorithm(Algorithm algo) {
 
 void idBvhCreator::SetLeafSize(int leafSize) {
 	desiredLeafSize = leafSize;
+}
+
+void idBvhCreator::SetQuality(int factor) {
+	qualityFactor = idMath::Imax(factor, 1);
 }
 
 void idBvhCreator::Build(int elemsNum, bvhElement_t *elements) {
@@ -298,8 +302,8 @@ void idBvhCreator::BuildBvhByClustering() {
 
 bool idBvhCreator::KMeansClustering(int beg, int end, int *coloring) {
 	static const int ARITY = K_MEANS_ARITY;
-	static const int ITERS = 8;
-	static const int INIT_TRIES = 16;
+	const int ITERS = 8 * qualityFactor;
+	const int INIT_TRIES = 16 * qualityFactor;
 
 	// which elements are "heads" of clusters
 	int headStart[ARITY];
@@ -652,6 +656,71 @@ int bvhNode_t::HaveSameDirection( const idVec3 &origin, const idBounds &box ) co
 DEBUG_OPTIMIZE_OFF
 
 
+static const char BVH_FILE_MAGIC[4] = { 'T', 'B', 'V', 'H' };
+
+void idBvhFile::Write(int quality, const idList<int> &order, const idBounds &rootBounds, const idList<bvhNode_t> &nodes, idList<byte> &data) {
+	Header header;
+	memcpy(header.magic, BVH_FILE_MAGIC, sizeof(header.magic));
+	header.version = VERSION;
+	header.quality = quality;
+	header.numElements = order.Num();
+	header.numNodes = nodes.Num();
+	header.rootBounds = rootBounds;
+
+	data.SetNum(sizeof(header) + order.MemoryUsed() + nodes.MemoryUsed());
+	byte *ptr = data.Ptr();
+	memcpy(ptr, &header, sizeof(header));
+	ptr += sizeof(header);
+	memcpy(ptr, order.Ptr(), order.MemoryUsed());
+	ptr += order.MemoryUsed();
+	memcpy(ptr, nodes.Ptr(), nodes.MemoryUsed());
+}
+
+bool idBvhFile::Read(const byte *data, int size, int numElements, int &quality, idList<int> &order, idBounds &rootBounds, idList<bvhNode_t> &nodes) {
+	Header header;
+	if (size < (int)sizeof(header))
+		return false;
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.magic, BVH_FILE_MAGIC, sizeof(header.magic)) != 0 || header.version != VERSION)
+		return false;
+	if (header.numElements != numElements || header.numNodes <= 0)
+		return false;
+	if (size != int(sizeof(header) + numElements * sizeof(int) + header.numNodes * sizeof(bvhNode_t)))
+		return false;
+
+	const byte *ptr = data + sizeof(header);
+	quality = header.quality;
+	rootBounds = header.rootBounds;
+	order.SetNum(numElements);
+	memcpy(order.Ptr(), ptr, numElements * sizeof(int));
+	ptr += numElements * sizeof(int);
+	nodes.SetNum(header.numNodes);
+	memcpy(nodes.Ptr(), ptr, header.numNodes * sizeof(bvhNode_t));
+
+	// make sure data is consistent, otherwise we may crash on broken file
+	idList<bool> seen;
+	seen.SetNum(numElements);
+	memset(seen.Ptr(), 0, seen.MemoryUsed());
+	for (int i = 0; i < numElements; i++) {
+		int src = order[i];
+		if (src < 0 || src >= numElements || seen[src])
+			return false;
+		seen[src] = true;
+	}
+	for (int i = 0; i < nodes.Num(); i++) {
+		const bvhNode_t &node = nodes[i];
+		if (node.HasSons()) {
+			if (!(node.GetSon(i, 0) > i && node.GetSon(i, 1) < nodes.Num()))
+				return false;
+		} else {
+			if (!(node.firstElement >= 0 && node.numElements >= 0 && node.firstElement + node.numElements <= numElements))
+				return false;
+		}
+	}
+	return true;
+}
+
+
 #include "../tests/testing.h"
 
 TEST_CASE("BvhChecks:HaveSameDirection") {
@@ -719,3 +788,57 @@ TEST_CASE("BvhChecks:HaveSameDirection") {
 	CHECK(numErrors == 0);
 	CHECK(numConservative <= 0.3e-2 * TRIES);	// I got a bit more than 0.1%
 }
+
+TEST_CASE("BvhChecks:FileRoundTrip") {
+	static const int NUM = 1000;
+	idRandom rnd;
+
+	idList<bvhElement_t> elems;
+	elems.SetNum(NUM);
+	for (int i = 0; i < NUM; i++) {
+		idVec3 pos(rnd.CRandomFloat() * 100.0f, rnd.CRandomFloat() * 100.0f, rnd.CRandomFloat() * 10.0f);
+		elems[i].bounds = idBounds(pos).Expand(rnd.RandomFloat());
+		elems[i].center = elems[i].bounds.GetCenter();
+		elems[i].direction = idVec3(rnd.CRandomFloat(), rnd.CRandomFloat(), 1.0f);
+		elems[i].direction.Normalize();
+		elems[i].id = i;
+	}
+
+	idBvhCreator creator;
+	creator.SetLeafSize(16);
+	creator.SetQuality(2);
+	creator.Build(NUM, elems.Ptr());
+
+	idList<int> order;
+	order.SetNum(NUM);
+	for (int i = 0; i < NUM; i++)
+		order[i] = creator.GetIdAtPos(i);
+	idList<bvhNode_t> nodes;
+	nodes.SetNum(creator.GetNodesNumber());
+	creator.CopyNodes(nodes.Ptr());
+
+	idList<byte> data;
+	idBvhFile::Write(2, order, creator.GetRootBounds(), nodes, data);
+
+	int quality = 0;
+	idList<int> readOrder;
+	idBounds readBounds;
+	idList<bvhNode_t> readNodes;
+	REQUIRE(idBvhFile::Read(data.Ptr(), data.Num(), NUM, quality, readOrder, readBounds, readNodes));
+	CHECK(quality == 2);
+	CHECK(readBounds == creator.GetRootBounds());
+	REQUIRE(readOrder.Num() == NUM);
+	CHECK(memcmp(readOrder.Ptr(), order.Ptr(), order.MemoryUsed()) == 0);
+	REQUIRE(readNodes.Num() == nodes.Num());
+	CHECK(memcmp(readNodes.Ptr(), nodes.Ptr(), nodes.MemoryUsed()) == 0);
+
+	// other surface, truncated data, broken tree
+	CHECK(!idBvhFile::Read(data.Ptr(), data.Num(), NUM + 1, quality, readOrder, readBounds, readNodes));
+	CHECK(!idBvhFile::Read(data.Ptr(), data.Num() - 1, NUM, quality, readOrder, readBounds, readNodes));
+	int lastNode = data.Num() - sizeof(bvhNode_t);
+	bvhNode_t broken = nodes[nodes.Num() - 1];
+	broken.firstElement = NUM;
+	broken.numElements = 1;
+	memcpy(&data[lastNode], &broken, sizeof(broken));
+	CHECK(!idBvhFile::Read(data.Ptr(), data.Num(), NUM, quality, readOrder, readBounds, readNodes));
+}
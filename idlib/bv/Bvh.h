@@ -112,6 +112,8 @@ public:
 
 	void SetAlgorithm(Algorithm algo = aKmeansClustering);
 	void SetLeafSize(int leafSize = 32);
+	// multiplies number of K-means iterations and initialization tries (slower build, better tree)
+	void SetQuality(int factor = 1);
 	void Build(int elemsNum, bvhElement_t *elements);
 
 	ID_INLINE idBounds GetRootBounds() const { return rootBounds; }
@@ -136,6 +138,7 @@ private:
 	// input data
 	int desiredLeafSize = 0;
 	Algorithm algorithm = aUnknown;
+	int qualityFactor = 1;
 	int elemsNum = 0;
 	bvhElement_t *elements = nullptr;
 
@@ -152,4 +155,28 @@ private:
 	idList<bvhElement_t> tempElems;
 };
 
+
+// BVH tree stored as byte array (e.g. in a cache file):
+// header, then order of elements, then compressed nodes exactly as in memory
+// note: bump VERSION on any change to idBvhCreator algorithm or bvhNode_t layout!
+class idBvhFile {
+public:
+	static const int VERSION = 2;
+
+	// quality: factor passed to idBvhCreator::SetQuality when the tree was built
+	static void Write(int quality, const idList<int> &order, const idBounds &rootBounds, const idList<bvhNode_t> &nodes, idList<byte> &data);
+	// returns false if data is broken, was written by other version, or has other number of elements
+	static bool Read(const byte *data, int size, int numElements, int &quality, idList<int> &order, idBounds &rootBounds, idList<bvhNode_t> &nodes);
+
+private:
+	struct Header {
+		char magic[4];
+		int version;
+		int quality;
+		int numElements;
+		int numNodes;
+		idBounds rootBounds;
+	};
+};
+
 #endif
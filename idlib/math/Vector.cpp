@@ -433,9 +433,8 @@ const char *idVec6::ToString( int precision ) const {
 //
 //===============================================================
 
-float	idVecX::temp[VECX_MAX_TEMP+4];
-float *	idVecX::tempPtr = (float *)(((intptr_t)idVecX::temp + 15) & ~15);
-int		idVecX::tempIndex = 0;
+alignas(16) thread_local float	idVecX::temp[VECX_MAX_TEMP];
+thread_local int		idVecX::tempIndex = 0;
 
 /*
 =============
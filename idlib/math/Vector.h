@@ -1588,9 +1588,9 @@ private:
 	int				alloced;				// if -1 p points to data set with SetData
 	float *			p;						// memory the vector is stored
 
-	static float	temp[VECX_MAX_TEMP+4];	// used to store intermediate results
-	static float *	tempPtr;				// pointer to 16 byte aligned temporary memory
-	static int		tempIndex;				// index into memory pool, wraps around
+	// pool is per-thread, so that physics can be evaluated in parallel jobs
+	alignas(16) static thread_local float	temp[VECX_MAX_TEMP];	// used to store intermediate results
+	static thread_local int		tempIndex;				// index into memory pool, wraps around
 
 private:
 	void			SetTempSize( int size );
@@ -1616,7 +1616,7 @@ ID_INLINE idVecX::idVecX( int length, float *data ) {
 
 ID_INLINE idVecX::~idVecX( void ) {
 	// if not temp memory
-	if ( p && ( p < idVecX::tempPtr || p >= idVecX::tempPtr + VECX_MAX_TEMP ) && alloced != -1 ) {
+	if ( p && ( p < idVecX::temp || p >= idVecX::temp + VECX_MAX_TEMP ) && alloced != -1 ) {
 		Mem_Free16( p );
 	}
 }
@@ -1842,13 +1842,13 @@ ID_INLINE void idVecX::SetTempSize( int newSize ) {
 	if ( idVecX::tempIndex + alloced > VECX_MAX_TEMP ) {
 		idVecX::tempIndex = 0;
 	}
-	p = idVecX::tempPtr + idVecX::tempIndex;
+	p = idVecX::temp + idVecX::tempIndex;
 	idVecX::tempIndex += alloced;
 	VECX_CLEAREND();
 }
 
 ID_INLINE void idVecX::SetData( int length, float *data ) {
-	if ( p && ( p < idVecX::tempPtr || p >= idVecX::tempPtr + VECX_MAX_TEMP ) && alloced != -1 ) {
+	if ( p && ( p < idVecX::temp || p >= idVecX::temp + VECX_MAX_TEMP ) && alloced != -1 ) {
 		Mem_Free16( p );
 	}
     assert((((uintptr_t)data) & 15) == 0); // data must be 16 byte aligned
@@ -0,0 +1,206 @@
+/*****************************************************************************
+The Dark Mod GPL Source Code
+
+This file is part of the The Dark Mod Source Code, originally based
+on the Doom 3 GPL Source Code as published in 2011.
+
+The Dark Mod Source Code is free software: you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version. For details, see LICENSE.TXT.
+
+Project: The Dark Mod (http://www.thedarkmod.com/)
+
+******************************************************************************/
+#include "precompiled.h"
+#pragma hdrstop
+
+#include "renderer/FrameStats.h"
+
+FrameStatsRecorder frameStatsRecorder;
+
+idCVar r_frameStatsFile(
+	"r_frameStatsFile", "", CVAR_RENDERER,
+	"If set, per-frame render statistics are streamed to this file (relative to savepath). "
+	"Files with .json extension get one JSON object per line, otherwise CSV is written."
+);
+
+struct frameStatsField_t {
+	const char *name;
+	int offset;
+};
+#define FRAME_STATS_FIELD( name ) { #name, (int)offsetof( frameStats_t, name ) }
+static const frameStatsField_t FRAME_STATS_FIELDS[] = {
+	FRAME_STATS_FIELD( frameCount ),
+	FRAME_STATS_FIELD( frontEndUsec ),
+	FRAME_STATS_FIELD( backEndUsec ),
+	FRAME_STATS_FIELD( jobListUsec ),
+	FRAME_STATS_FIELD( jobListWaitUsec ),
+	FRAME_STATS_FIELD( numViews ),
+	FRAME_STATS_FIELD( numDrawSurfs ),
+	FRAME_STATS_FIELD( numInteractionsCreated ),
+	FRAME_STATS_FIELD( numInteractionsReused ),
+	FRAME_STATS_FIELD( numShadowMapPages ),
+	FRAME_STATS_FIELD( numViewFlowAreas ),
+	FRAME_STATS_FIELD( numViewFlowCacheHits ),
+	FRAME_STATS_FIELD( vertexCacheBytes ),
+	FRAME_STATS_FIELD( frameMemoryUsed ),
+	FRAME_STATS_FIELD( frameMemoryHighwater ),
+	FRAME_STATS_FIELD( frameArenaChunks ),
+	FRAME_STATS_FIELD( frameArenaWaste ),
+};
+#undef FRAME_STATS_FIELD
+static const int FRAME_STATS_NUM_FIELDS = sizeof( FRAME_STATS_FIELDS ) / sizeof( FRAME_STATS_FIELDS[0] );
+compile_time_assert( sizeof( frameStats_t ) == FRAME_STATS_NUM_FIELDS * sizeof( int ) );
+
+static ID_INLINE int GetField( const frameStats_t &stats, int field ) {
+	return *(const int*)( (const byte*)&stats + FRAME_STATS_FIELDS[field].offset );
+}
+
+// ==================================================================================
+
+void FrameStatsRecorder::Shutdown() {
+	if ( stream ) {
+		fileSystem->CloseFile( stream );
+		stream = nullptr;
+	}
+	streamFileName.Clear();
+	capturing = false;
+	history.ClearFree();
+}
+
+void FrameStatsRecorder::UpdateStream() {
+	const char *fileName = r_frameStatsFile.GetString();
+	if ( streamFileName == fileName )
+		return;
+
+	if ( stream ) {
+		fileSystem->CloseFile( stream );
+		stream = nullptr;
+	}
+	streamFileName = fileName;
+	if ( streamFileName.IsEmpty() )
+		return;
+
+	stream = fileSystem->OpenFileWrite( streamFileName.c_str() );
+	if ( !stream ) {
+		common->Warning( "FrameStats: failed to open %s for writing", streamFileName.c_str() );
+		return;
+	}
+	streamJson = streamFileName.CheckExtension( ".json" );
+
+	if ( !streamJson ) {
+		for ( int f = 0; f < FRAME_STATS_NUM_FIELDS; f++ )
+			stream->Printf( "%s%s", ( f > 0 ? "," : "" ), FRAME_STATS_FIELDS[f].name );
+		stream->Printf( "\n" );
+	}
+	common->Printf( "FrameStats: streaming to %s\n", streamFileName.c_str() );
+}
+
+void FrameStatsRecorder::Record( const frameStats_t &stats ) {
+	UpdateStream();
+
+	if ( stream ) {
+		if ( streamJson ) {
+			stream->Printf( "{" );
+			for ( int f = 0; f < FRAME_STATS_NUM_FIELDS; f++ )
+				stream->Printf( "%s\"%s\":%d", ( f > 0 ? "," : "" ), FRAME_STATS_FIELDS[f].name, GetField( stats, f ) );
+			stream->Printf( "}\n" );
+		} else {
+			for ( int f = 0; f < FRAME_STATS_NUM_FIELDS; f++ )
+				stream->Printf( "%s%d", ( f > 0 ? "," : "" ), GetField( stats, f ) );
+			stream->Printf( "\n" );
+		}
+	}
+
+	if ( capturing ) {
+		history.AddGrow( stats );
+	}
+}
+
+void FrameStatsRecorder::BeginCapture() {
+	capturing = true;
+	history.Clear();
+}
+
+void FrameStatsRecorder::EndCapture( const char *title ) {
+	if ( !capturing )
+		return;
+	capturing = false;
+	if ( stream ) {
+		stream->Flush();
+	}
+	if ( history.Num() > 0 ) {
+		WriteSummary( title );
+	}
+	history.Clear();
+}
+
+void FrameStatsRecorder::WriteSummary( const char *title ) const {
+	struct Summary {
+		int min, max, p95, p99;
+		double avg;
+	} summary[FRAME_STATS_NUM_FIELDS];
+
+	int n = history.Num();
+	idList<int> values;
+	values.SetNum( n );
+	for ( int f = 0; f < FRAME_STATS_NUM_FIELDS; f++ ) {
+		double sum = 0.0;
+		for ( int i = 0; i < n; i++ ) {
+			values[i] = GetField( history[i], f );
+			sum += values[i];
+		}
+		std::sort( values.begin(), values.end() );
+		auto Percentile = [&]( double p ) -> int {
+			int idx = (int)idMath::Ceil( float( p * n ) ) - 1;
+			return values[idMath::ClampInt( 0, n - 1, idx )];
+		};
+		Summary &s = summary[f];
+		s.min = values[0];
+		s.max = values[n - 1];
+		s.avg = sum / n;
+		s.p95 = Percentile( 0.95 );
+		s.p99 = Percentile( 0.99 );
+	}
+
+	common->Printf( "Frame stats for %s (%d frames):\n", title, n );
+	common->Printf( "%24s %10s %12s %10s %10s %10s\n", "", "min", "avg", "p95", "p99", "max" );
+	// skip frameCount: its distribution is meaningless
+	for ( int f = 1; f < FRAME_STATS_NUM_FIELDS; f++ ) {
+		const Summary &s = summary[f];
+		common->Printf( "%24s %10d %12.1lf %10d %10d %10d\n", FRAME_STATS_FIELDS[f].name, s.min, s.avg, s.p95, s.p99, s.max );
+	}
+
+	if ( !stream )
+		return;
+
+	// write summary into a separate file next to the stream
+	idStr summaryFileName = streamFileName;
+	summaryFileName.StripFileExtension();
+	summaryFileName += "_summary";
+	summaryFileName.SetFileExtension( streamJson ? ".json" : ".csv" );
+	idFile *file = fileSystem->OpenFileWrite( summaryFileName.c_str() );
+	if ( !file ) {
+		common->Warning( "FrameStats: failed to open %s for writing", summaryFileName.c_str() );
+		return;
+	}
+	if ( streamJson ) {
+		file->Printf( "{\"title\":\"%s\",\"frames\":%d", title, n );
+		for ( int f = 1; f < FRAME_STATS_NUM_FIELDS; f++ ) {
+			const Summary &s = summary[f];
+			file->Printf( ",\n\"%s\":{\"min\":%d,\"avg\":%.3lf,\"p95\":%d,\"p99\":%d,\"max\":%d}",
+				FRAME_STATS_FIELDS[f].name, s.min, s.avg, s.p95, s.p99, s.max
+			);
+		}
+		file->Printf( "\n}\n" );
+	} else {
+		file->Printf( "stat,min,avg,p95,p99,max\n" );
+		for ( int f = 1; f < FRAME_STATS_NUM_FIELDS; f++ ) {
+			const Summary &s = summary[f];
+			file->Printf( "%s,%d,%.3lf,%d,%d,%d\n", FRAME_STATS_FIELDS[f].name, s.min, s.avg, s.p95, s.p99, s.max );
+		}
+	}
+	fileSystem->CloseFile( file );
+	common->Printf( "FrameStats: summary written to %s\n", summaryFileName.c_str() );
+}
@@ -0,0 +1,63 @@
+/*****************************************************************************
+The Dark Mod GPL Source Code
+
+This file is part of the The Dark Mod Source Code, originally based
+on the Doom 3 GPL Source Code as published in 2011.
+
+The Dark Mod Source Code is free software: you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation, either version 3 of the License,
+or (at your option) any later version. For details, see LICENSE.TXT.
+
+Project: The Dark Mod (http://www.thedarkmod.com/)
+
+******************************************************************************/
+#pragma once
+
+// machine-readable counterpart of R_PerformanceCounters
+// one record is taken per frame, after backend has finished and frontend is idle
+struct frameStats_t {
+	int		frameCount;
+	int		frontEndUsec;			// sum of time in all RenderScene calls
+	int		backEndUsec;			// time spent executing backend commands
+	int		jobListUsec;			// total processing time of frontend jobs over all worker threads
+	int		jobListWaitUsec;		// time frontend thread was blocked waiting for its jobs
+	int		numViews;
+	int		numDrawSurfs;
+	int		numInteractionsCreated;
+	int		numInteractionsReused;
+	int		numShadowMapPages;
+	int		numViewFlowAreas;		// area visits by view flow through portals
+	int		numViewFlowCacheHits;	// views which reused cached portal flow
+	int		vertexCacheBytes;		// dynamic vertex + index data uploaded this frame
+	int		frameMemoryUsed;		// R_FrameAlloc usage on this frame
+	int		frameMemoryHighwater;
+	int		frameArenaChunks;		// chunks of frame memory carved for per-thread arenas
+	int		frameArenaWaste;		// bytes in arena chunks left unused
+};
+
+class FrameStatsRecorder {
+public:
+	void	Shutdown();
+
+	// called once per frame by idRenderSystemLocal::EndFrame
+	void	Record( const frameStats_t &stats );
+
+	// all records between these calls are kept in memory,
+	// then min/avg/p95/p99/max summary is printed (used by timeDemo)
+	void	BeginCapture();
+	void	EndCapture( const char *title );
+
+private:
+	void	UpdateStream();
+	void	WriteSummary( const char *title ) const;
+
+	idFile *stream = nullptr;
+	idStr streamFileName;
+	bool streamJson = false;
+
+	bool capturing = false;
+	idList<frameStats_t> history;
+};
+
+extern FrameStatsRecorder frameStatsRecorder;
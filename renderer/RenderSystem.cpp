@@ -19,6 +19,7 @@ Project: The Dark Mod (http://www.thedarkmod.com/)
 #include "renderer/backend/FrameBuffer.h"
 #include "renderer/backend/RenderBackend.h"
 #include "renderer/backend/FrameBufferManager.h"
+#include "renderer/FrameStats.h"
 
 idRenderSystemLocal	tr;
 idRenderSystem	*renderSystem = &tr;
@@ -129,7 +130,8 @@ static void R_PerformanceCounters( void ) {
 	if ( r_showMemory.GetBool() ) {
 		int m0 = frameData ? frameData->frameMemoryAllocated.load() : 0;
 		int	m1 = frameData ? frameData->memoryHighwater : 0;
-		common->Printf( "frameData: %i (%i)\n", m0, m1 );
+		int	w1 = frameData ? frameData->arenaWasteHighwater : 0;
+		common->Printf( "frameData: %i (%i) arenaWaste: (%i)\n", m0, m1, w1 );
 	}
 	if ( r_showSmp.GetBool() )
 	{ common->Printf( "%c", backEnd.pc.waitedFor ); }
@@ -139,6 +141,42 @@ static void R_PerformanceCounters( void ) {
 	memset( &backEnd.pc, 0, sizeof( backEnd.pc ) );
 }
 
+/*
+=====================
+R_RecordFrameStats
+
+Must be called when both front end and back end are idle,
+before frame data is toggled and counters are cleared.
+=====================
+*/
+static void R_RecordFrameStats( void ) {
+	frameStats_t stats;
+	stats.frameCount = tr.frameCount;
+	stats.frontEndUsec = tr.pc.frontEndUsec;
+	stats.backEndUsec = backEnd.pc.usec;
+	stats.jobListUsec = tr.pc.frontEndJobUsec;
+	stats.jobListWaitUsec = tr.pc.frontEndJobWaitUsec;
+	stats.numViews = tr.pc.c_numViews;
+	stats.numDrawSurfs = backEnd.pc.c_surfaces;
+	stats.numInteractionsCreated = tr.pc.c_createInteractions;
+	stats.numInteractionsReused = tr.pc.c_reusedInteractions;
+	stats.numShadowMapPages = tr.pc.c_shadowMapPages;
+	stats.numViewFlowAreas = tr.pc.c_viewFlowAreas;
+	stats.numViewFlowCacheHits = tr.pc.c_viewFlowCacheHits;
+	stats.vertexCacheBytes = vertexCache.GetDynamicBytesUsed();
+	if ( frameData ) {
+		R_UpdateFrameMemoryStats( frameData );
+		stats.frameMemoryUsed = frameData->frameMemoryAllocated;
+		stats.frameMemoryHighwater = frameData->memoryHighwater;
+		stats.frameArenaChunks = frameData->arenaChunks;
+		stats.frameArenaWaste = frameData->arenaWaste;
+	} else {
+		stats.frameMemoryUsed = stats.frameMemoryHighwater = 0;
+		stats.frameArenaChunks = stats.frameArenaWaste = 0;
+	}
+	frameStatsRecorder.Record( stats );
+}
+
 /*
 ====================
 R_IssueRenderCommands
@@ -790,6 +828,9 @@ void idRenderSystemLocal::EndFrame( int *frontEndMsec, int *backEndMsec ) {
 	GL_CheckErrors();
 #endif
 
+	// save machine-readable statistics while frame data is still intact
+	R_RecordFrameStats();
+
 	// use the other buffers next frame, because another CPU
 	// may still be rendering into the current buffers
 	R_ToggleSmpFrame();
@@ -819,6 +860,24 @@ void idRenderSystemLocal::EndFrame( int *frontEndMsec, int *backEndMsec ) {
 	R_PerformanceCounters();
 }
 
+/*
+=============
+BeginFrameStatsCapture
+=============
+*/
+void idRenderSystemLocal::BeginFrameStatsCapture() {
+	frameStatsRecorder.BeginCapture();
+}
+
+/*
+=============
+EndFrameStatsCapture
+=============
+*/
+void idRenderSystemLocal::EndFrameStatsCapture( const char *title ) {
+	frameStatsRecorder.EndCapture( title );
+}
+
 /*
 =====================
 RenderViewToViewport
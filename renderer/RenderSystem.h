@@ -193,6 +193,11 @@ public:
 	// if the pointers are not NULL, timing info will be returned
 	virtual void			EndFrame( int *frontEndMsec, int *backEndMsec ) = 0;
 
+	// per-frame statistics are kept between these calls (see r_frameStatsFile)
+	// summary with min/avg/p95/p99 values is reported at the end
+	virtual void			BeginFrameStatsCapture() = 0;
+	virtual void			EndFrameStatsCapture( const char *title ) = 0;
+
 	// aviDemo uses this.
 	// Will automatically tile render large screen shots if necessary
 	// Samples is the number of jittered frames for anti-aliasing
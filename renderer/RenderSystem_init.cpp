@@ -25,6 +25,7 @@ Project: The Dark Mod (http://www.thedarkmod.com/)
 #include "renderer/backend/stages/VolumetricStage.h"
 #include "renderer/backend/FrameBufferManager.h"
 #include "renderer/backend/VertexArrayState.h"
+#include "renderer/FrameStats.h"
 #include "sys/sys_padinput.h"
 
 // Vista OpenGL wrapper check
@@ -46,6 +47,7 @@ idCVar r_singleTriangle( "r_singleTriangle", "0", CVAR_RENDERER | CVAR_BOOL, "on
 idCVar r_checkBounds( "r_checkBounds", "0", CVAR_RENDERER | CVAR_BOOL, "compare all surface bounds with precalculated ones" );
 
 idCVar r_useConstantMaterials( "r_useConstantMaterials", "1", CVAR_RENDERER | CVAR_BOOL, "use pre-calculated material registers if possible" );
+idCVar r_useMaterialViewCache( "r_useMaterialViewCache", "1", CVAR_RENDERER | CVAR_BOOL, "evaluate material expressions which don't depend on entity parms only once per view time (cached per thread)" );
 idCVar r_useSilRemap( "r_useSilRemap", "1", CVAR_RENDERER | CVAR_BOOL, "consider verts with the same XYZ, but different ST the same for shadows" );
 idCVar r_useNodeCommonChildren( "r_useNodeCommonChildren", "1", CVAR_RENDERER | CVAR_BOOL, "stop pushing reference bounds early when possible" );
 idCVar r_useShadowProjectedCull( "r_useShadowProjectedCull", "1", CVAR_RENDERER | CVAR_BOOL, "discard triangles outside light volume before shadowing" );
@@ -1865,6 +1867,9 @@ void idRenderSystemLocal::Shutdown( void ) {
 		logFile = 0;
 	}
 
+	// close the r_frameStatsFile
+	frameStatsRecorder.Shutdown();
+
 	// free frame memory
 	R_ShutdownFrameData();
 
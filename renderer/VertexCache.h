@@ -107,6 +107,11 @@ public:
 		return basePointer;
 	}
 
+	// bytes of dynamic vertex + index data allocated on the current frame
+	int GetDynamicBytesUsed() const {
+		return dynamicData.vertexMemUsed.GetValue() + dynamicData.indexMemUsed.GetValue();
+	}
+
 public:
 	static idCVar	r_showVertexCache;
 	static idCVar	r_staticVertexMemory;
@@ -241,6 +241,7 @@ void FrameBufferManager::CopyRender( const copyRenderCommand_t &cmd ) {
 		return;	//no pixels to be read
 	}
 	int backEndStartTime = Sys_Milliseconds();
+	uint64 backEndStartTimeUsec = Sys_Microseconds();
 
 	if ( activeFbo == defaultFbo ) { // #4425: not applicable, raises gl errors
 		qglReadBuffer( GL_BACK );
@@ -262,6 +263,7 @@ void FrameBufferManager::CopyRender( const copyRenderCommand_t &cmd ) {
 
 	int backEndFinishTime = Sys_Milliseconds();
 	backEnd.pc.msec += backEndFinishTime - backEndStartTime;
+	backEnd.pc.usec += int( Sys_Microseconds() - backEndStartTimeUsec );
 }
 
 void FrameBufferManager::UpdateResolutionAndFormats() {
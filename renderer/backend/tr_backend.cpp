@@ -637,6 +637,7 @@ Always runs on the main thread
 */
 void RB_ExecuteBackEndCommands( const emptyCommand_t *cmds ) {
 	static int backEndStartTime, backEndFinishTime;
+	static uint64 backEndStartTimeUsec;
 
 	if ( cmds->commandId == RC_NOP && !cmds->next ) {
 		return;
@@ -647,6 +648,7 @@ void RB_ExecuteBackEndCommands( const emptyCommand_t *cmds ) {
 	int	c_draw3d = 0, c_draw2d = 0, c_setBuffers = 0, c_drawBloom = 0, c_copyRenders = 0;
 
 	backEndStartTime = Sys_Milliseconds();
+	backEndStartTimeUsec = Sys_Microseconds();
 
 	// needed for editor rendering
 	RB_SetDefaultGLState();
@@ -724,6 +726,7 @@ void RB_ExecuteBackEndCommands( const emptyCommand_t *cmds ) {
 	backEndFinishTime = Sys_Milliseconds();
 	backEnd.pc.msecLast = backEndFinishTime - backEndStartTime;
 	backEnd.pc.msec += backEnd.pc.msecLast;
+	backEnd.pc.usec += int( Sys_Microseconds() - backEndStartTimeUsec );
 
 	// revelator: added depthcopy to counters
 	if ( r_showRenderToTexture.GetBool() ) {
@@ -1445,6 +1445,8 @@ void idInteraction::AddActiveInteraction( void ) {
 	// actually create the interaction if needed, building light and shadow surfaces as needed
 	if ( IsDeferred() ) {
 		CreateInteraction( model );
+	} else {
+		tr.pc.c_reusedInteractions++;
 	}
 	R_GlobalPointToLocal( vEntity->modelMatrix, lightDef->globalLightOrigin, localLightOrigin );
 	R_GlobalPointToLocal( vEntity->modelMatrix, tr.viewDef->renderView.vieworg, localViewOrigin );
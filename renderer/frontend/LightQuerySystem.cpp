@@ -73,13 +73,24 @@ void LightQuerySystem::Forget( lightQuery_t query ) {
 void LightQuerySystem::Think( const viewDef_t *viewDef ) {
 	TRACE_CPU_SCOPE( "LQS::Think" );
 
+	// all queries on one entity are computed by one job:
+	// samples are close to each other, so they are lit by the same lights,
+	// and light registers are evaluated once per job instead of once per query
 	struct Job {
 		const LightQuerySystem *system;
 		const viewDef_t *viewDef;
-		LightQuery *query;
+		LightQuery **queries;
+		int count;
 
 		void Run() const {
-			system->RecomputeQuery( *query, viewDef );
+			// this temporary variable must be independent in each parallel thread
+			static thread_local Context ctx;
+			ctx.viewDef = viewDef;
+			ctx.evaluatedLights.SetNum( 0, false );
+			ctx.evaluatedOffsets.SetNum( 0, false );
+			ctx.lightRegisters.SetNum( 0, false );
+			for ( int i = 0; i < count; i++ )
+				system->RecomputeQuery( *queries[i], ctx );
 		}
 		static void Invoke( void *param ) {
 			const Job *job = (const Job*)(param);
@@ -87,8 +98,8 @@ void LightQuerySystem::Think( const viewDef_t *viewDef ) {
 		}
 	};
 
-	idList<Job> jobs;
-	jobs.Reserve( queries.Num() );
+	idList<LightQuery*> pending;
+	pending.Reserve( queries.Num() );
 
 	int count[3] = {0};
 	for ( int i = 0; i < queries.Num(); i++ ) {
@@ -96,9 +107,23 @@ void LightQuerySystem::Think( const viewDef_t *viewDef ) {
 		count[qr.status + 1]++;
 		if ( qr.status != 0 )
 			continue;
-		jobs.AddGrow( { this, viewDef, &qr } );
+		pending.AddGrow( &qr );
+	}
+	std::stable_sort( pending.begin(), pending.end(), []( const LightQuery *a, const LightQuery *b ) {
+		return a->entity < b->entity;
+	} );
+
+	idList<Job> jobs;
+	for ( int i = 0; i < pending.Num(); ) {
+		int j = i + 1;
+		while ( j < pending.Num() && pending[j]->entity == pending[i]->entity )
+			j++;
+		jobs.AddGrow( { this, viewDef, &pending[i], j - i } );
+		i = j;
 	}
 
+	double startTicks = Sys_GetClockTicks();
+
 	if ( r_lqsParallel.GetBool() ) {
 		RegisterJob( Job::Invoke, "lightQuery" );
 		idParallelJobList *joblist = tr.frontEndJobList;
@@ -106,22 +131,28 @@ void LightQuerySystem::Think( const viewDef_t *viewDef ) {
 			joblist->AddJob( Job::Invoke, &j );
 		joblist->Submit( nullptr, JOBLIST_PARALLELISM_REALTIME );
 		joblist->Wait();
+		tr.pc.frontEndJobUsec += (int)joblist->GetTotalProcessingTimeMicroSec();
+		tr.pc.frontEndJobWaitUsec += (int)joblist->GetWaitTimeMicroSec();
 	} else {
 		for ( Job &j : jobs )
 			j.Run();
 	}
 
-	TRACE_ATTACH_FORMAT( "dead: %d\npending: %d\nfinished: %d\n", count[0], count[1], count[2] )
+	if ( pending.Num() > 0 ) {
+		// game code adapts number of new queries per frame to this cost
+		float usec = float( ( Sys_GetClockTicks() - startTicks ) * 1000000.0 / Sys_ClockTicksPerSecond() );
+		float cost = usec / pending.Num();
+		averageCost = ( averageCost > 0.0f ? averageCost * 0.9f + cost * 0.1f : cost );
+	}
+
+	TRACE_ATTACH_FORMAT( "dead: %d\npending: %d\nfinished: %d\njobs: %d\n", count[0], count[1], count[2], jobs.Num() )
 }
 
 // ==================================================================================
 
-void LightQuerySystem::RecomputeQuery( LightQuery &query, const viewDef_t *viewDef ) const {
+void LightQuerySystem::RecomputeQuery( LightQuery &query, Context &ctx ) const {
 	TRACE_CPU_SCOPE_TEXT( "LQS::RecomputeQuery", GetTraceLabel( query.entity->parms ) )
 	query.position = UpdateSamplePos( query );
-	// this temporary variable must be independent in each parallel thread
-	static thread_local Context ctx;
-	ctx.viewDef = viewDef;
 	query.resultValue = ComputeQuery( query, ctx );
 	query.status = 1;
 }
@@ -161,12 +192,11 @@ idVec3 LightQuerySystem::ComputeQuery( const LightQuery &query, Context &ctx ) c
 		const portalArea_t &area = world->portalAreas[areaIdx];
 
 		for ( int lightIdx : area.lightRefs ) {
-			const idRenderLightLocal *light = world->lightDefs[lightIdx];
 			if ( processedLights.Find( lightIdx ) )
 				continue;
 			processedLights.AddGrow( lightIdx );
 
-			idVec3 addedColor = ComputeQueryLight( query, ctx, light );
+			idVec3 addedColor = ComputeQueryLight( query, ctx, lightIdx );
 			totalLight += addedColor;
 		}
 	}
@@ -174,7 +204,27 @@ idVec3 LightQuerySystem::ComputeQuery( const LightQuery &query, Context &ctx ) c
 	return totalLight;
 }
 
-idVec3 LightQuerySystem::ComputeQueryLight( const LightQuery &query, Context &ctx, const idRenderLightLocal *light ) const {
+const float *LightQuerySystem::GetLightRegisters( Context &ctx, int lightIdx ) const {
+	int k = ctx.evaluatedLights.FindIndex( lightIdx );
+	if ( k < 0 ) {
+		// follows code from R_AddLightSurfaces
+		// (where registers are evaluated during rendering)
+		const idRenderLightLocal *light = world->lightDefs[lightIdx];
+		const idMaterial *lightShader = light->lightShader;
+		int offset = ctx.lightRegisters.Num();
+		int newNum = offset + lightShader->GetNumRegisters();
+		if ( newNum > ctx.lightRegisters.NumAllocated() )
+			ctx.lightRegisters.Resize( idMath::Imax( newNum, 2 * ctx.lightRegisters.NumAllocated() ) );
+		ctx.lightRegisters.SetNum( newNum, false );
+		lightShader->EvaluateRegisters( ctx.lightRegisters.Ptr() + offset, light->parms.shaderParms, ctx.viewDef, light->parms.referenceSound );
+		k = ctx.evaluatedLights.AddGrow( lightIdx );
+		ctx.evaluatedOffsets.AddGrow( offset );
+	}
+	return ctx.lightRegisters.Ptr() + ctx.evaluatedOffsets[k];
+}
+
+idVec3 LightQuerySystem::ComputeQueryLight( const LightQuery &query, Context &ctx, int lightIdx ) const {
+	const idRenderLightLocal *light = world->lightDefs[lightIdx];
 	if ( !light->globalLightBounds.ContainsPoint( query.position ) )
 		return vec3_zero;
 
@@ -187,13 +237,8 @@ idVec3 LightQuerySystem::ComputeQueryLight( const LightQuery &query, Context &ct
 	if ( light->parms.suppressLightInViewID == VID_LIGHTGEM )
 		return vec3_zero;	// TODO: idLight::IsSeenByAI() is false
 
-	// follows code from R_AddLightSurfaces
-	// (where registers are evaluated during rendering)
-	ctx.lightRegisters.SetNum( lightShader->GetNumRegisters(), false );
-	lightShader->EvaluateRegisters( ctx.lightRegisters.Ptr(), light->parms.shaderParms, ctx.viewDef, light->parms.referenceSound );
-
 	// hack in order to call register-using methods...
-	ctx.viewLight.shaderRegisters = ctx.lightRegisters.Ptr();
+	ctx.viewLight.shaderRegisters = GetLightRegisters( ctx, lightIdx );
 
 	idVec3 res = vec3_zero;
 	for ( int lightStageNum = 0; lightStageNum < lightShader->GetNumStages(); lightStageNum++ ) {
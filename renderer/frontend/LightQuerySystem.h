@@ -29,6 +29,7 @@ public:
 	bool CheckResult( lightQuery_t query, idVec3 &outputValue, idVec3& outputPosition ) const;
 	void Forget( lightQuery_t query );
 	void Think( const viewDef_t *viewDef );
+	float GetAverageCost() const { return averageCost; }
 
 private:
 	struct LightQuery {
@@ -48,17 +49,22 @@ private:
 	struct Context {
 		const viewDef_t *viewDef = nullptr;
 		idList<float> lightRegisters;
+		// lights with registers already evaluated in lightRegisters (shared by queries of one job)
+		idList<int> evaluatedLights;
+		idList<int> evaluatedOffsets;
 		viewLight_t viewLight;		// note: we only fill a few members here
 	};
 
-	void RecomputeQuery( LightQuery &query, const viewDef_t *viewDef ) const;
+	void RecomputeQuery( LightQuery &query, Context &ctx ) const;
 	idVec3 ComputeQuery( const LightQuery &query, Context &ctx ) const;
-	idVec3 ComputeQueryLight( const LightQuery &query, Context &ctx, const idRenderLightLocal *light ) const;
+	idVec3 ComputeQueryLight( const LightQuery &query, Context &ctx, int lightIdx ) const;
+	const float *GetLightRegisters( Context &ctx, int lightIdx ) const;
 	idVec3 ComputeQueryLightStage( const LightQuery &query, Context &ctx, const idRenderLightLocal *light, const shaderStage_t *lightStage ) const;
 	idVec3 UpdateSamplePos( const LightQuery &query ) const;
 
 	const idRenderWorldLocal *world = nullptr;
 	idList<LightQuery> queries;
 	idList<int> deadQueryList;		// to accelerate AddQuery
+	float averageCost = 0.0f;		// smoothed time per computed query (in microseconds)
 };
 
@@ -268,6 +268,9 @@ idRenderWorldLocal::idRenderWorldLocal() {
 
 	interactionTable.Init();
 
+	viewPortalFlowCache = nullptr;
+	portalsVersion = 0;
+
 	lightQuerySystem = new LightQuerySystem();
 	lightQuerySystem->Init( this );
 }
@@ -817,6 +820,7 @@ void idRenderWorldLocal::RenderScene( const renderView_t &renderView ) {
 	tr.guiModel->Clear();*/
 
 	int startTime = Sys_Milliseconds();
+	uint64 startTimeUsec = Sys_Microseconds();
 
 	// setup view parms for the initial view
 	//
@@ -894,8 +898,10 @@ void idRenderWorldLocal::RenderScene( const renderView_t &renderView ) {
 	}
 
 	int endTime = Sys_Milliseconds();
+	uint64 endTimeUsec = Sys_Microseconds();
 
 	tr.pc.frontEndMsec += endTime - startTime;
+	tr.pc.frontEndUsec += int( endTimeUsec - startTimeUsec );
 
 	// prepare for any 2D drawing after this
 	//tr.guiModel->Clear();
@@ -966,6 +972,15 @@ exitPortal_t idRenderWorldLocal::GetPortal( int areaNum, int portalNum ) {
 	return ret;
 }
 
+/*
+==============
+GetPortalsVersion
+==============
+*/
+int idRenderWorldLocal::GetPortalsVersion( void ) const {
+	return portalsVersion;
+}
+
 /*
 ==============
 SetPortalPlayerLoss
@@ -982,6 +997,9 @@ void idRenderWorldLocal::SetPortalPlayerLoss( qhandle_t portal, float loss ) //
 	{
 		common->Error( "SetPortalPlayerLoss: bad portal number %i", portal );
 	}
+	if ( doublePortals[portal-1].lossPlayer != loss ) {
+		portalsVersion++;
+	}
 	doublePortals[portal-1].lossPlayer = loss; // grayman #3042
 
 	if ( session->writeDemo )
@@ -1768,6 +1786,10 @@ void idRenderWorldLocal::LightAtPointQuery_Forget( lightQuery_t query ) {
 	lightQuerySystem->Forget( query );
 }
 
+float idRenderWorldLocal::LightAtPointQuery_GetAverageCost() const {
+	return lightQuerySystem->GetAverageCost();
+}
+
 /*
 ==================
 idRenderWorldLocal::RecurseFullLineIntersectionBSP_r
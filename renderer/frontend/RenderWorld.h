@@ -385,6 +385,10 @@ public:
 	// grayman #3042 - set portal sound loss (in dB)
 	virtual void			SetPortalPlayerLoss( qhandle_t portal, float loss ) = 0;
 
+	// changes every time portal state or sound loss is changed, or map is reloaded
+	// sound system checks it to know when its routing through portals must be recomputed
+	virtual int				GetPortalsVersion( void ) const = 0;
+
 	// returns true only if a chain of portals without the given connection bits set
 	// exists between the two areas (a door doesn't separate them, etc)
 	virtual	bool			AreasAreConnected( int areaNum1, int areaNum2, portalConnection_t connection ) = 0;
@@ -456,6 +460,8 @@ public:
 	virtual lightQuery_t	LightAtPointQuery_AddQuery( qhandle_t onEntity, const samplePointOnModel_t &point, const idList<qhandle_t> &ignoredEntities ) = 0;
 	virtual bool			LightAtPointQuery_CheckResult( lightQuery_t query, idVec3 &outputValue, idVec3& outputPosition ) const = 0;
 	virtual void			LightAtPointQuery_Forget( lightQuery_t query ) = 0;
+	// average frontend time spent per evaluated query (in microseconds), 0 if nothing measured yet
+	virtual float			LightAtPointQuery_GetAverageCost() const = 0;
 
 	//-------------- Demo Control  -----------------
 
@@ -43,6 +43,7 @@ void idRenderWorldLocal::FreeWorld() {
 
 	portalAreas.ClearFree();
 	doublePortals.ClearFree();
+	FreeViewPortalFlowCache();
 
 	if ( areaNodes ) {
 		R_StaticFree( areaNodes );
@@ -224,6 +225,7 @@ void idRenderWorldLocal::SetupAreaRefs() {
 	int		i;
 
 	connectedAreaNum = 0;
+	portalsVersion++;
 	for ( i = 0; i < portalAreas.Num(); i++ ) {
 		portalAreas[i].areaNum = i;
 		assert(portalAreas[i].entityRefs.Num() == 0);
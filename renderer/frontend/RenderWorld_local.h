@@ -165,6 +165,7 @@ public:
 	virtual	int				NumPortalsInArea( int areaNum ) override;
 	// grayman #3042 - set portal sound loss (in dB)
 	virtual void			SetPortalPlayerLoss( qhandle_t portal, float loss ) override;
+	virtual int				GetPortalsVersion( void ) const override;
 
 	virtual exitPortal_t	GetPortal( int areaNum, int portalNum ) override;
 
@@ -181,6 +182,7 @@ public:
 	virtual lightQuery_t	LightAtPointQuery_AddQuery( qhandle_t onEntity, const samplePointOnModel_t &point, const idList<qhandle_t> &ignoredEntities ) override;
 	virtual bool			LightAtPointQuery_CheckResult( lightQuery_t query, idVec3 &outputValue, idVec3& outputPosition ) const override;
 	virtual void			LightAtPointQuery_Forget( lightQuery_t query ) override;
+	virtual float			LightAtPointQuery_GetAverageCost() const override;
 
 	virtual void			DebugClearLines( int time ) override;
 	virtual void			DebugLine( const idVec4 &color, const idVec3 &start, const idVec3 &end, const int lifetime = 0, const bool depthTest = false ) override;
@@ -212,6 +214,7 @@ public:
 	idList<portalArea_t> portalAreas;
 	//int						numPortalAreas;
 	int						connectedAreaNum;		// incremented every time a door portal state changes
+	int						portalsVersion;			// incremented on any change of portals, see GetPortalsVersion
 
 	idList<doublePortal_t>	doublePortals;
 	//int						numInterAreaPortals;
@@ -239,6 +242,10 @@ public:
 
 	LightQuerySystem *		lightQuerySystem;
 
+	// results of recent view flows through portals, reused by views with same parameters
+	struct ViewPortalFlowCache;
+	ViewPortalFlowCache *	viewPortalFlowCache;
+
 	typedef idFlexList<int, 128> AreaList;
 
 	//-----------------------
@@ -261,10 +268,14 @@ public:
 	//--------------------------
 	// RenderWorld_portals.cpp
 
-	idScreenRect			ScreenRectFromWinding( const idWinding *w, viewEntity_t *space );
-	bool					PortalIsFoggedOut( const portal_t *p );
-	void					FloodViewThroughArea_r( const idVec3 origin, int areaNum, const struct portalStack_s *ps );
+	idScreenRect			ScreenRectFromWinding( const idWinding *w, const viewEntity_t *space ) const;
+	bool					PortalIsFoggedOut( const portal_t *p ) const;
+	struct FlowViewThroughPortalsContext;
+	bool					FlowViewIntoPortal( FlowViewThroughPortalsContext &context, portal_t *p, const struct portalStack_s *ps, struct portalStack_s &newStack ) const;
+	void					FloodViewThroughArea_r( FlowViewThroughPortalsContext &context, int areaNum, const struct portalStack_s *ps ) const;
+	void					FloodViewThroughAreaParallel( FlowViewThroughPortalsContext &context, int areaNum, const struct portalStack_s *ps ) const;
 	void					FlowViewThroughPortals( const idVec3 origin, int numPlanes, const idPlane *planes );
+	void					FreeViewPortalFlowCache();
 	struct FlowLightThroughPortalsContext;
 	void					FloodLightThroughArea_r( FlowLightThroughPortalsContext &context, int areaNum, const struct portalStack_s *ps ) const;
 	void					FlowLightThroughPortals( const idRenderLightLocal *light, const AreaList &startingAreaIds, AreaList *areaIds, lightPortalFlow_t *portalFlow ) const;
@@ -19,6 +19,8 @@ Project: The Dark Mod (http://www.thedarkmod.com/)
 #include "renderer/tr_local.h"
 
 idCVar r_useLightAreaCulling( "r_useLightAreaCulling", "1", CVAR_RENDERER | CVAR_BOOL, "0 = off, 1 = on" );
+idCVar r_parallelPortalFlow( "r_parallelPortalFlow", "1", CVAR_RENDERER | CVAR_BOOL | CVAR_ARCHIVE, "flood view through each portal of the starting area in a separate job" );
+idCVar r_cachePortalFlow( "r_cachePortalFlow", "1", CVAR_RENDERER | CVAR_BOOL | CVAR_ARCHIVE, "reuse view flow through portals when view parameters and portal states did not change" );
 idCVar r_singleModelName( "r_singleModelName", "", CVAR_RENDERER, "filter entities by model name, e.g. 'models/darkmod/nature/flowers/flowers_patch_01.ase'" );
 
 /*
@@ -50,6 +52,22 @@ typedef struct portalStack_s {
 	// positive side is outside the visible frustum
 } portalStack_t;
 
+// area reached by view flow through portals, with the portal stack it was reached through
+// flow is computed first (possibly in parallel), then its steps are applied in order of serial recursion
+typedef struct {
+	int				areaNum;
+	portalStack_t	stack;		// "next" link is not valid here
+} viewFlowStep_t;
+
+struct idRenderWorldLocal::FlowViewThroughPortalsContext {
+	idVec3 origin;
+	idList<viewFlowStep_t> steps;
+	bool dependsOnFog = false;		// some fogged portal was checked
+};
+
+// max number of initial planes in view flow which can be cached
+const int MAX_VIEW_FLOW_CACHE_PLANES = 6;
+
 
 //====================================================================
 
@@ -59,7 +77,7 @@ typedef struct portalStack_s {
 idRenderWorldLocal::ScreenRectForWinding
 ===================
 */
-idScreenRect idRenderWorldLocal::ScreenRectFromWinding( const idWinding *w, viewEntity_t *space ) {
+idScreenRect idRenderWorldLocal::ScreenRectFromWinding( const idWinding *w, const viewEntity_t *space ) const {
 	idScreenRect	r;
 	int				i;
 	idVec3			v;
@@ -86,7 +104,7 @@ idScreenRect idRenderWorldLocal::ScreenRectFromWinding( const idWinding *w, view
 PortalIsFoggedOut
 ===================
 */
-bool idRenderWorldLocal::PortalIsFoggedOut( const portal_t *p ) {
+bool idRenderWorldLocal::PortalIsFoggedOut( const portal_t *p ) const {
 	idRenderLightLocal	*ldef;
 	int			i;
 	idPlane		forward;
@@ -133,140 +151,262 @@ bool idRenderWorldLocal::PortalIsFoggedOut( const portal_t *p ) {
 
 /*
 ===================
-FloodViewThroughArea_r
+FlowViewIntoPortal
+
+Checks if view can flow from portal stack ps through portal p.
+If it can, fills newStack and returns true.
 ===================
 */
-void idRenderWorldLocal::FloodViewThroughArea_r( const idVec3 origin, int areaNum,
-        const struct portalStack_s *ps ) {
-	//portal_t*		p;
-	float			d;
+bool idRenderWorldLocal::FlowViewIntoPortal( FlowViewThroughPortalsContext &context, portal_t *p, const portalStack_t *ps, portalStack_t &newStack ) const {
+	const idVec3 &origin = context.origin;
 	const portalStack_t	*check;
-	portalStack_t	newStack;
-	int				j;
-	idVec3			v1, v2;
-	int				addPlanes;
 	idFixedWinding	w;		// we won't overflow because MAX_PORTAL_PLANES = 20
+	idVec3			v1, v2;
+	int				j, addPlanes;
 
-	auto &area = portalAreas[ areaNum ];
-
-	// cull models and lights to the current collection of planes
-	AddAreaRefs( areaNum, ps );
-
-	if ( portalAreas[areaNum].areaScreenRect.IsEmpty() ) {
-		portalAreas[areaNum].areaScreenRect = ps->rect;
-	} else {
-		portalAreas[areaNum].areaScreenRect.Union( ps->rect );
+	// an enclosing door may have sealed the portal off
+	if ( p->doublePortal->blockingBits & PS_BLOCK_VIEW ) {
+		return false;
 	}
 
-	// For r_showPortals. Keep track whether the player's view flows through
-	// individual portals, not just whole visleafs.  -- SteveL #4162
-	if ( r_showPortals && ps->p )
-		ps->p->doublePortal->portalViewCount = tr.viewCount;
+	// make sure this portal is facing away from the view
+	float d = p->plane.Distance( origin );
+	if ( d < -0.1f ) {
+		return false;
+	}
 
-	// go through all the portals
-	for ( auto p : area.areaPortals ) {
-		// an enclosing door may have sealed the portal off
-		if ( p->doublePortal->blockingBits & PS_BLOCK_VIEW ) {
-			continue;
+	// make sure the portal isn't in our stack trace,
+	// which would cause an infinite loop
+	for ( check = ps; check; check = check->next ) {
+		if ( check->p == p ) {
+			break;		// don't recursively enter a stack
 		}
+	}
+	if ( check ) {
+		return false;	// already in stack
+	}
 
-		// make sure this portal is facing away from the view
-		d = p->plane.Distance( origin );
-		if ( d < -0.1f ) {
-			continue;
+	// if we are very close to the portal surface, don't bother clipping
+	// it, which tends to give epsilon problems that make the area vanish
+	if ( d < 1.0f ) {
+		// SteveL #3815: check the view origin is really near portal surface
+		if ( p->w.PointInsideDst( p->plane.Normal(), origin, 1.0f ) ) {
+			// go through this portal
+			newStack = *ps;
+			newStack.p = p;
+			newStack.next = ps;
+			return true;
 		}
+	}
 
-		// make sure the portal isn't in our stack trace,
-		// which would cause an infinite loop
-		for ( check = ps; check; check = check->next ) {
-			if ( check->p == p ) {
-				break;		// don't recursively enter a stack
-			}
-		}
-		if ( check ) {
-			continue;	// already in stack
+	// clip the portal winding to all of the planes
+	w = p->w;
+	for ( j = 0; j < ps->numPortalPlanes; j++ ) {
+		if ( !w.ClipInPlace( -ps->portalPlanes[j], 0 ) ) {
+			break;
 		}
+	}
+	if ( !w.GetNumPoints() ) {
+		return false;	// portal not visible
+	}
 
-		// if we are very close to the portal surface, don't bother clipping
-		// it, which tends to give epsilon problems that make the area vanish
-		if ( d < 1.0f ) {
-			// SteveL #3815: check the view origin is really near portal surface
-			if ( p->w.PointInsideDst( p->plane.Normal(), origin, 1.0f ) ) {
-				// go through this portal
-				newStack = *ps;
-				newStack.p = p;
-				newStack.next = ps;
-				FloodViewThroughArea_r( origin, p->intoArea, &newStack );
-				continue;
-			}
+	// see if it is fogged out
+	if ( p->doublePortal->fogLight ) {
+		// fog density can change without any notice, so this flow must not be reused
+		context.dependsOnFog = true;
+		if ( PortalIsFoggedOut( p ) ) {
+			return false;
 		}
+	}
 
-		// clip the portal winding to all of the planes
-		w = p->w;
-		for ( j = 0; j < ps->numPortalPlanes; j++ ) {
-			if ( !w.ClipInPlace( -ps->portalPlanes[j], 0 ) ) {
-				break;
-			}
-		}
-		if ( !w.GetNumPoints() ) {
-			continue;	// portal not visible
-		}
+	// go through this portal
+	newStack.p = p;
+	newStack.next = ps;
 
-		// see if it is fogged out
-		if ( PortalIsFoggedOut( p ) ) {
+	// find the screen pixel bounding box of the remaining portal
+	// so we can scissor things outside it
+	newStack.rect = ScreenRectFromWinding( &w, &tr.identitySpace );
+
+	// slop might have spread it a pixel outside, so trim it back
+	newStack.rect.Intersect( ps->rect );
+
+	// generate a set of clipping planes that will further restrict
+	// the visible view beyond just the scissor rect
+	addPlanes = w.GetNumPoints();
+	if ( addPlanes > MAX_PORTAL_PLANES ) {
+		addPlanes = MAX_PORTAL_PLANES;
+	}
+	newStack.numPortalPlanes = 0;
+
+	for ( int i = 0; i < addPlanes; i++ ) {
+		j = i + 1;
+		if ( j == w.GetNumPoints() ) {
+			j = 0;
+		}
+		v1 = origin - w[i].ToVec3();
+		v2 = origin - w[j].ToVec3();
+
+		//stgatilov: drop plane if its direction is not precise enough
+		idVec3 normal;
+		normal.Cross( v2, v1 );
+		float sinAng = normal.LengthFast() * idMath::RSqrt( v2.LengthSqr() * v1.LengthSqr() );
+		static const float SIN_THRESHOLD = idMath::FLT_EPS / MAX_PLANE_NORMAL_ERROR;
+		if ( sinAng <= SIN_THRESHOLD ) {
 			continue;
 		}
+		newStack.portalPlanes[newStack.numPortalPlanes].Normal() = normal;
+		newStack.portalPlanes[newStack.numPortalPlanes].Normalize();
+		newStack.portalPlanes[newStack.numPortalPlanes].FitThroughPoint( origin );
 
-		// go through this portal
-		newStack.p = p;
-		newStack.next = ps;
+		newStack.numPortalPlanes++;
+	}
 
-		// find the screen pixel bounding box of the remaining portal
-		// so we can scissor things outside it
-		newStack.rect = ScreenRectFromWinding( &w, &tr.identitySpace );
+	// the last stack plane is the portal plane
+	newStack.portalPlanes[newStack.numPortalPlanes] = p->plane;
+	newStack.numPortalPlanes++;
 
-		// slop might have spread it a pixel outside, so trim it back
-		newStack.rect.Intersect( ps->rect );
+	return true;
+}
 
-		// generate a set of clipping planes that will further restrict
-		// the visible view beyond just the scissor rect
-		addPlanes = w.GetNumPoints();
-		if ( addPlanes > MAX_PORTAL_PLANES ) {
-			addPlanes = MAX_PORTAL_PLANES;
+/*
+===================
+FloodViewThroughArea_r
+
+Only records areas and portal stacks into context,
+they are applied later by FlowViewThroughPortals
+===================
+*/
+void idRenderWorldLocal::FloodViewThroughArea_r( FlowViewThroughPortalsContext &context, int areaNum, const portalStack_t *ps ) const {
+	viewFlowStep_t step;
+	step.areaNum = areaNum;
+	step.stack = *ps;
+	step.stack.next = nullptr;
+	context.steps.AddGrow( step );
+
+	// go through all the portals
+	for ( portal_t *p : portalAreas[areaNum].areaPortals ) {
+		portalStack_t newStack;
+		if ( FlowViewIntoPortal( context, p, ps, newStack ) ) {
+			FloodViewThroughArea_r( context, p->intoArea, &newStack );
 		}
-		newStack.numPortalPlanes = 0;
+	}
+}
 
-		for ( int i = 0; i < addPlanes; i++ ) {
-			j = i + 1;
-			if ( j == w.GetNumPoints() ) {
-				j = 0;
-			}
-			v1 = origin - w[i].ToVec3();
-			v2 = origin - w[j].ToVec3();
+/*
+===================
+FloodViewThroughAreaParallel
 
-			//stgatilov: drop plane if its direction is not precise enough
-			idVec3 normal;
-			normal.Cross( v2, v1 );
-			float sinAng = normal.LengthFast() * idMath::RSqrt( v2.LengthSqr() * v1.LengthSqr() );
-			static const float SIN_THRESHOLD = idMath::FLT_EPS / MAX_PLANE_NORMAL_ERROR;
-			if ( sinAng <= SIN_THRESHOLD ) {
-				continue;
-			}
-			newStack.portalPlanes[newStack.numPortalPlanes].Normal() = normal;
-			newStack.portalPlanes[newStack.numPortalPlanes].Normalize();
-			newStack.portalPlanes[newStack.numPortalPlanes].FitThroughPoint( origin );
+Same as FloodViewThroughArea_r, but every portal of the starting area is flooded in a separate job.
+Results are concatenated in portal order, so they match the serial recursion exactly.
+===================
+*/
+void idRenderWorldLocal::FloodViewThroughAreaParallel( FlowViewThroughPortalsContext &context, int areaNum, const portalStack_t *ps ) const {
+	TRACE_CPU_SCOPE( "FloodViewThroughAreaParallel" )
 
-			newStack.numPortalPlanes++;
+	struct Job {
+		const idRenderWorldLocal *world;
+		portalStack_t stack;
+		FlowViewThroughPortalsContext context;
+
+		static void Invoke( void *param ) {
+			Job *job = (Job*)param;
+			job->world->FloodViewThroughArea_r( job->context, job->stack.p->intoArea, &job->stack );
+		}
+	};
+
+	viewFlowStep_t step;
+	step.areaNum = areaNum;
+	step.stack = *ps;
+	step.stack.next = nullptr;
+	context.steps.AddGrow( step );
+
+	// note: jobs must not move in memory after they are submitted
+	const auto &areaPortals = portalAreas[areaNum].areaPortals;
+	idList<Job> jobs;
+	jobs.SetNum( areaPortals.Num() );
+	int numJobs = 0;
+	for ( portal_t *p : areaPortals ) {
+		Job &job = jobs[numJobs];
+		if ( FlowViewIntoPortal( context, p, ps, job.stack ) ) {
+			job.world = this;
+			job.context.origin = context.origin;
+			numJobs++;
 		}
+	}
 
-		// the last stack plane is the portal plane
-		newStack.portalPlanes[newStack.numPortalPlanes] = p->plane;
-		newStack.numPortalPlanes++;
+	if ( numJobs >= 2 ) {
+		RegisterJob( Job::Invoke, "viewPortalFlow" );
+		idParallelJobList *joblist = tr.frontEndJobList;
+		for ( int i = 0; i < numJobs; i++ )
+			joblist->AddJob( Job::Invoke, &jobs[i] );
+		joblist->Submit( nullptr, JOBLIST_PARALLELISM_REALTIME );
+		joblist->Wait();
+		tr.pc.frontEndJobUsec += (int)joblist->GetTotalProcessingTimeMicroSec();
+		tr.pc.frontEndJobWaitUsec += (int)joblist->GetWaitTimeMicroSec();
+	} else {
+		for ( int i = 0; i < numJobs; i++ )
+			Job::Invoke( &jobs[i] );
+	}
 
-		FloodViewThroughArea_r( origin, p->intoArea, &newStack );
+	for ( int i = 0; i < numJobs; i++ ) {
+		const FlowViewThroughPortalsContext &jobContext = jobs[i].context;
+		context.steps.Append( jobContext.steps );
+		context.dependsOnFog |= jobContext.dependsOnFog;
 	}
 }
 
+/*
+===================
+ViewPortalFlowCache
+
+Flow through portals depends only on the view parameters and portal states.
+Several last flows are remembered, so that a view identical to one of them
+(same frustum in the next frame, or same subview rendered again) skips clipping entirely.
+Note that a view which changed even slightly is flooded from scratch:
+its area set might differ, so old portal stacks are not reliable.
+===================
+*/
+struct viewFlowKey_t {
+	int				areaNum;
+	int				portalStatesNum;		// connectedAreaNum changes whenever any portal state changes
+	idVec3			origin;
+	int				numPlanes;
+	idPlane			planes[MAX_VIEW_FLOW_CACHE_PLANES];
+	idScreenRect	viewport;
+	idScreenRect	scissor;
+	float			modelViewMatrix[16];
+	float			projectionMatrix[16];
+
+	bool Equals( const viewFlowKey_t &other ) const {
+		return areaNum == other.areaNum && portalStatesNum == other.portalStatesNum &&
+			numPlanes == other.numPlanes && viewport.Equals( other.viewport ) && scissor.Equals( other.scissor ) &&
+			memcmp( &origin, &other.origin, sizeof( origin ) ) == 0 &&
+			memcmp( planes, other.planes, numPlanes * sizeof( planes[0] ) ) == 0 &&
+			memcmp( modelViewMatrix, other.modelViewMatrix, sizeof( modelViewMatrix ) ) == 0 &&
+			memcmp( projectionMatrix, other.projectionMatrix, sizeof( projectionMatrix ) ) == 0;
+	}
+};
+
+struct idRenderWorldLocal::ViewPortalFlowCache {
+	static const int SIZE = 4;
+	struct Entry {
+		bool valid = false;
+		viewFlowKey_t key;
+		idList<viewFlowStep_t> steps;
+	} entries[SIZE];
+	int nextReplaced = 0;
+};
+
+/*
+===================
+FreeViewPortalFlowCache
+===================
+*/
+void idRenderWorldLocal::FreeViewPortalFlowCache() {
+	delete viewPortalFlowCache;
+	viewPortalFlowCache = nullptr;
+}
+
 /*
 =======================
 FlowViewThroughPortals
@@ -300,15 +440,84 @@ void idRenderWorldLocal::FlowViewThroughPortals( const idVec3 origin, int numPla
 		for ( i = 0; i < portalAreas.Num(); i++ ) {
 			AddAreaRefs( i, &ps );
 		}
-	} else {
+		return;
+	}
 
-		for ( auto &a : portalAreas ) {
-			a.areaScreenRect.Clear();
+	for ( auto &a : portalAreas ) {
+		a.areaScreenRect.Clear();
+	}
+
+	// find cached flow for exactly same view
+	viewFlowKey_t key;
+	memset( &key, 0, sizeof( key ) );
+	bool cacheable = r_cachePortalFlow.GetBool() && numPlanes <= MAX_VIEW_FLOW_CACHE_PLANES;
+	const idList<viewFlowStep_t> *steps = nullptr;
+	if ( cacheable ) {
+		key.areaNum = tr.viewDef->areaNum;
+		key.portalStatesNum = connectedAreaNum;
+		key.origin = origin;
+		key.numPlanes = numPlanes;
+		for ( i = 0; i < numPlanes; i++ ) {
+			key.planes[i] = planes[i];
+		}
+		key.viewport = tr.viewDef->viewport;
+		key.scissor = tr.viewDef->scissor;
+		memcpy( key.modelViewMatrix, tr.viewDef->worldSpace.modelViewMatrix, sizeof( key.modelViewMatrix ) );
+		memcpy( key.projectionMatrix, tr.viewDef->projectionMatrix, sizeof( key.projectionMatrix ) );
+
+		if ( !viewPortalFlowCache ) {
+			viewPortalFlowCache = new ViewPortalFlowCache();
+		}
+		for ( const auto &entry : viewPortalFlowCache->entries ) {
+			if ( entry.valid && entry.key.Equals( key ) ) {
+				steps = &entry.steps;
+				tr.pc.c_viewFlowCacheHits++;
+				break;
+			}
+		}
+	}
+
+	FlowViewThroughPortalsContext context;
+	if ( !steps ) {
+		// flood out through portals, recording every area visit
+		context.origin = origin;
+		if ( r_parallelPortalFlow.GetBool() ) {
+			FloodViewThroughAreaParallel( context, tr.viewDef->areaNum, &ps );
+		} else {
+			FloodViewThroughArea_r( context, tr.viewDef->areaNum, &ps );
+		}
+		steps = &context.steps;
+
+		if ( cacheable && !context.dependsOnFog ) {
+			auto &entry = viewPortalFlowCache->entries[viewPortalFlowCache->nextReplaced];
+			viewPortalFlowCache->nextReplaced = ( viewPortalFlowCache->nextReplaced + 1 ) % ViewPortalFlowCache::SIZE;
+			entry.valid = true;
+			entry.key = key;
+			entry.steps = context.steps;
 		}
+	}
+
+	// add models and lights in the same order as recursive flood does, setting area viewCount
+	for ( const viewFlowStep_t &step : *steps ) {
+		const portalStack_t *stack = &step.stack;
 
-		// flood out through portals, setting area viewCount
-		FloodViewThroughArea_r( origin, tr.viewDef->areaNum, &ps );
+		// cull models and lights to the current collection of planes
+		AddAreaRefs( step.areaNum, stack );
+
+		portalArea_t &area = portalAreas[step.areaNum];
+		if ( area.areaScreenRect.IsEmpty() ) {
+			area.areaScreenRect = stack->rect;
+		} else {
+			area.areaScreenRect.Union( stack->rect );
+		}
+
+		// For r_showPortals. Keep track whether the player's view flows through
+		// individual portals, not just whole visleafs.  -- SteveL #4162
+		if ( r_showPortals && stack->p ) {
+			stack->p->doublePortal->portalViewCount = tr.viewCount;
+		}
 	}
+	tr.pc.c_viewFlowAreas += steps->Num();
 }
 
 //==================================================================================================
@@ -1121,6 +1330,7 @@ void idRenderWorldLocal::SetPortalState( qhandle_t portal, int blockTypes ) {
 		return;
 	}
 	doublePortals[portal - 1].blockingBits = blockTypes;
+	portalsVersion++;
 
 	// leave the connectedAreaGroup the same on one side,
 	// then flood fill from the other side with a new number for each changed attribute
@@ -1706,6 +1706,8 @@ void R_AddModelSurfaces( void ) {
 		}
 		tr.frontEndJobList->Submit();
 		tr.frontEndJobList->Wait();
+		tr.pc.frontEndJobUsec += (int)tr.frontEndJobList->GetTotalProcessingTimeMicroSec();
+		tr.pc.frontEndJobWaitUsec += (int)tr.frontEndJobList->GetWaitTimeMicroSec();
 	} else {
 		for ( viewEntity_t *vEntity = tr.viewDef->viewEntitys; vEntity; vEntity = vEntity->next ) {
 			R_AddSingleModel( vEntity );
@@ -1926,4 +1928,5 @@ void R_AssignShadowMapAtlasPages( void ) {
 
 	for ( int i = 0; i < pages.Num(); i++ )
 		shadowMappers[i].vLight->shadowMapPage = pages[i];
+	tr.pc.c_shadowMapPages += pages.Num();
 }
@@ -757,7 +757,8 @@ bool R_GenerateSubViews( void ) {
 	bool subviews = false;
 
 	extern idCVar cv_lg_interleave;								// FIXME a better way to check for RenderWindow views? (compass, etc)
-	if ( !tr.viewDef->isSubview && cv_lg_interleave.GetBool() && !tr.viewDef->renderWorld->mapName.IsEmpty() ) {
+	extern idCVar cv_lg_estimate;
+	if ( !tr.viewDef->isSubview && cv_lg_interleave.GetBool() && !cv_lg_estimate.GetBool() && !tr.viewDef->renderWorld->mapName.IsEmpty() ) {
 		R_Lightgem_Render();
 		subviews = true;
 	}
@@ -2231,12 +2231,104 @@ idCVar r_modelBvhLeafSize(
 	1, 1<<20
 );
 
+static void R_ApplyBvhToTri( srfTriangles_t *tri, const idList<int> &order, const idBounds &rootBounds, const idList<bvhNode_t> &nodes );
+
+idCVar r_modelBvhCache(
+	"r_modelBvhCache", "1",
+	CVAR_RENDERER | CVAR_INTEGER,
+	"Load BVH of large surfaces from precomputed cache files (generated/bvh/*.bvh) instead of building them:\n"
+	"  0 - always build on load\n"
+	"  1 - load from cache if present\n"
+	"  2 - load from cache, build and save missing entries",
+	0, 2
+);
+idCVar r_modelBvhCacheMinTris(
+	"r_modelBvhCacheMinTris", "4096",
+	CVAR_RENDERER | CVAR_INTEGER,
+	"Only surfaces with at least this number of triangles are stored in BVH cache",
+	0, 1<<30
+);
+idCVar r_modelBvhCacheQuality(
+	"r_modelBvhCacheQuality", "4",
+	CVAR_RENDERER | CVAR_INTEGER,
+	"BVH trees saved to cache are built with K-means clustering this many times more thorough than usual. "
+	"Cached trees of this or higher quality are used, with r_modelBvhCache 2 trees of lower quality are rebuilt",
+	1, 64
+);
+
+// cache file contains idBvhFile data, also stores the quality the tree was built with
+compile_time_assert( sizeof( bvhNode_t ) == 16 );
+
+/*
+===================
+R_BvhCacheFileName
+
+The name is hash of all input data that affects BVH construction.
+Quality is not included: file built with higher quality is good for lower one too.
+===================
+*/
+static idStr R_BvhCacheFileName( const srfTriangles_t *tri, int leafSize ) {
+	MD4_CTX ctx;
+	MD4_Init( &ctx );
+	int params[4] = { idBvhFile::VERSION, leafSize, tri->numVerts, tri->numIndexes };
+	MD4_Update( &ctx, params, sizeof( params ) );
+	for ( int i = 0; i < tri->numVerts; i++ ) {
+		MD4_Update( &ctx, tri->verts[i].xyz.ToFloatPtr(), sizeof( idVec3 ) );
+	}
+	MD4_Update( &ctx, tri->indexes, tri->numIndexes * sizeof( tri->indexes[0] ) );
+	byte digest[16];
+	MD4_Final( digest, &ctx );
+
+	idStr fileName = "generated/bvh/";
+	for ( int i = 0; i < 16; i++ ) {
+		fileName += va( "%02x", digest[i] );
+	}
+	fileName += ".bvh";
+	return fileName;
+}
+
+/*
+===================
+R_LoadBvhFromCache
+
+Fails if the tree in cache was built with quality lower than minQuality.
+===================
+*/
+static bool R_LoadBvhFromCache( const char *fileName, int numTris, int minQuality, idList<int> &order, idBounds &rootBounds, idList<bvhNode_t> &nodes ) {
+	void *buffer = nullptr;
+	int size = fileSystem->ReadFile( fileName, &buffer );
+	if ( size < 0 || !buffer ) {
+		return false;
+	}
+
+	int quality = 0;
+	bool ok = idBvhFile::Read( (const byte *)buffer, size, numTris, quality, order, rootBounds, nodes );
+	if ( !ok ) {
+		common->Warning( "R_LoadBvhFromCache: ignoring invalid cache file %s", fileName );
+	}
+	fileSystem->FreeFile( buffer );
+
+	return ok && quality >= minQuality;
+}
+
+/*
+===================
+R_SaveBvhToCache
+===================
+*/
+static void R_SaveBvhToCache( const char *fileName, int quality, const idList<int> &order, const idBounds &rootBounds, const idList<bvhNode_t> &nodes ) {
+	idList<byte> data;
+	idBvhFile::Write( quality, order, rootBounds, nodes, data );
+	fileSystem->WriteFile( fileName, data.Ptr(), data.Num() );
+}
+
 /*
 ===================
 R_BuildBvhForTri
 
 stgatilov #5886: Builds BVH tree for triangles listed in "indexes" array
 Note: reorders triangles in process!
+Large surfaces can take the tree from cache instead (see r_modelBvhCache).
 ===================
 */
 void R_BuildBvhForTri( srfTriangles_t *tri ) {
@@ -2253,6 +2345,26 @@ void R_BuildBvhForTri( srfTriangles_t *tri ) {
 
 	int n = tri->numIndexes / 3;
 
+	// BVH structure: original index of triangle at each position + compressed nodes
+	idList<int> order;
+	idBounds rootBounds;
+	idList<bvhNode_t> nodes;
+
+	idStr cacheFileName;
+	bool useCache = ( r_modelBvhCache.GetInteger() > 0 && n >= r_modelBvhCacheMinTris.GetInteger() );
+	if ( useCache ) {
+		cacheFileName = R_BvhCacheFileName( tri, r_modelBvhLeafSize.GetInteger() );
+		// any cached tree is at least as good as the one built now,
+		// but when generating cache, trees of lower quality are rebuilt
+		int minQuality = ( r_modelBvhCache.GetInteger() >= 2 ? r_modelBvhCacheQuality.GetInteger() : 1 );
+		if ( R_LoadBvhFromCache( cacheFileName.c_str(), n, minQuality, order, rootBounds, nodes ) ) {
+			R_ApplyBvhToTri( tri, order, rootBounds, nodes );
+			return;
+		}
+	}
+	// only spend time on better tree if we are going to save it
+	bool saveCache = ( useCache && r_modelBvhCache.GetInteger() >= 2 );
+
 	// generate one element per triangle
 	idList<bvhElement_t> elems;
 	elems.SetNum(n);
@@ -2281,8 +2393,35 @@ void R_BuildBvhForTri( srfTriangles_t *tri ) {
 	// create BVH tree
 	idBvhCreator creator;
 	creator.SetLeafSize(r_modelBvhLeafSize.GetInteger());
+	if ( saveCache )
+		creator.SetQuality( r_modelBvhCacheQuality.GetInteger() );
 	creator.Build(n, elems.Ptr());
 
+	order.SetNum(n);
+	for (int i = 0; i < n; i++)
+		order[i] = creator.GetIdAtPos(i);
+	rootBounds = creator.GetRootBounds();
+	nodes.SetNum(creator.GetNodesNumber());
+	creator.CopyNodes(nodes.Ptr());
+
+	if ( saveCache ) {
+		R_SaveBvhToCache( cacheFileName.c_str(), r_modelBvhCacheQuality.GetInteger(), order, rootBounds, nodes );
+	}
+
+	R_ApplyBvhToTri( tri, order, rootBounds, nodes );
+}
+
+/*
+===================
+R_ApplyBvhToTri
+
+Reorders triangles according to BVH and attaches compressed BVH nodes to surface.
+===================
+*/
+static void R_ApplyBvhToTri( srfTriangles_t *tri, const idList<int> &order, const idBounds &rootBounds, const idList<bvhNode_t> &nodes ) {
+	int n = tri->numIndexes / 3;
+	assert(order.Num() == n);
+
 	// save triangles remap: old index -> new index
 	idList<int> triangleRemap;
 	triangleRemap.SetNum(n + 1);
@@ -2293,7 +2432,7 @@ void R_BuildBvhForTri( srfTriangles_t *tri ) {
 	triIdsBuff.SetNum(3 * n);
 	memcpy(triIdsBuff.Ptr(), tri->indexes, triIdsBuff.Allocated());
 	for (int i = 0; i < n; i++) {
-		int src = creator.GetIdAtPos(i);
+		int src = order[i];
 		tri->indexes[3 * i + 0] = triIdsBuff[3 * src + 0];
 		tri->indexes[3 * i + 1] = triIdsBuff[3 * src + 1];
 		tri->indexes[3 * i + 2] = triIdsBuff[3 * src + 2];
@@ -2315,7 +2454,7 @@ void R_BuildBvhForTri( srfTriangles_t *tri ) {
 		triIdsBuff.SetNum(3 * n);
 		memcpy(triIdsBuff.Ptr(), tri->silIndexes, triIdsBuff.Allocated());
 		for (int i = 0; i < n; i++) {
-			int src = creator.GetIdAtPos(i);
+			int src = order[i];
 			tri->silIndexes[3 * i + 0] = triIdsBuff[3 * src + 0];
 			tri->silIndexes[3 * i + 1] = triIdsBuff[3 * src + 1];
 			tri->silIndexes[3 * i + 2] = triIdsBuff[3 * src + 2];
@@ -2327,7 +2466,7 @@ void R_BuildBvhForTri( srfTriangles_t *tri ) {
 		triIdsBuff.SetNum(3 * n);
 		memcpy(triIdsBuff.Ptr(), tri->adjTris, triIdsBuff.Allocated());
 		for (int i = 0; i < n; i++) {
-			int src = creator.GetIdAtPos(i);
+			int src = order[i];
 			tri->adjTris[3 * i + 0] = triangleRemap[triIdsBuff[3 * src + 0]];
 			tri->adjTris[3 * i + 1] = triangleRemap[triIdsBuff[3 * src + 1]];
 			tri->adjTris[3 * i + 2] = triangleRemap[triIdsBuff[3 * src + 2]];
@@ -2337,10 +2476,10 @@ void R_BuildBvhForTri( srfTriangles_t *tri ) {
 	assert(tri->facePlanesCalculated == false && tri->facePlanes == NULL);
 
 	// copy compressed BVH into surface
-	tri->bounds = creator.GetRootBounds();
-	tri->numBvhNodes = creator.GetNodesNumber();
+	tri->bounds = rootBounds;
+	tri->numBvhNodes = nodes.Num();
 	tri->bvhNodes = (bvhNode_t*)triBvhAllocator.Alloc(tri->numBvhNodes);
-	creator.CopyNodes(tri->bvhNodes);
+	memcpy(tri->bvhNodes, nodes.Ptr(), nodes.MemoryUsed());
 }
 
 
@@ -61,6 +61,9 @@ typedef struct mtrParsingData_s {
 } mtrParsingData_t;
 
 
+// incremented when any material is freed, so that its address can't produce a false hit in view registers cache
+static std::atomic<int> materialViewRegistersGeneration( 1 );
+
 /*
 =============
 idMaterial::CommonInit
@@ -77,6 +80,7 @@ void idMaterial::CommonInit() {
 	cullType = CT_FRONT_SIDED;
 	deform = DFRM_NONE;
 	numOps = 0;
+	numViewOps = 0;
 	ops = NULL;
 	numRegisters = 0;
 	expressionRegisters = NULL;
@@ -180,6 +184,8 @@ void idMaterial::FreeData() {
 		R_StaticFree( ops );
 		ops = NULL;
 	}
+	numViewOps = 0;
+	materialViewRegistersGeneration++;
 }
 
 /*
@@ -2601,6 +2607,9 @@ bool idMaterial::Parse( const char *text, const int textLength ) {
 		memcpy( expressionRegisters, pd->shaderRegisters, numRegisters * sizeof( expressionRegisters[0] ) );
 	}
 
+	// move ops which depend only on view to the beginning
+	SplitViewExpressionOps();
+
 	// see if the registers are completely constant, and don't need to be evaluated
 	// per-surface
 	CheckForConstantRegisters();
@@ -2686,53 +2695,13 @@ void idMaterial::AddReference() {
 
 /*
 ===============
-idMaterial::EvaluateRegisters
-
-Parameters are taken from the localSpace and the renderView,
-then all expressions are evaluated, leaving the material registers
-set to their apropriate values.
+R_EvaluateExpressionOps
 ===============
 */
-void idMaterial::EvaluateRegisters( float *registers, const float shaderParms[MAX_ENTITY_SHADER_PARMS],
-									const viewDef_t *view, idSoundEmitter *soundEmitter ) const {
+static void R_EvaluateExpressionOps( float *registers, const expOp_t *op, int count, idSoundEmitter *soundEmitter ) {
 	int		i, b;
 
-	expOp_t	*op = ops;
-
-	if ( !op && numOps ) {
-		common->FatalError( "R_EvaluateExpression: NULL operators pointer" );
-		return;
-	}
-
-	// copy the material constants
-	for ( i = EXP_REG_NUM_PREDEFINED ; i < numRegisters ; i++ ) {
-		registers[i] = expressionRegisters[i];
-	}
-
-	// copy the local and global parameters
-	registers[EXP_REG_TIME] = view->floatTime;
-	registers[EXP_REG_PARM0] = shaderParms[0];
-	registers[EXP_REG_PARM1] = shaderParms[1];
-	registers[EXP_REG_PARM2] = shaderParms[2];
-	registers[EXP_REG_PARM3] = shaderParms[3];
-	registers[EXP_REG_PARM4] = shaderParms[4];
-	registers[EXP_REG_PARM5] = shaderParms[5];
-	registers[EXP_REG_PARM6] = shaderParms[6];
-	registers[EXP_REG_PARM7] = shaderParms[7];
-	registers[EXP_REG_PARM8] = shaderParms[8];
-	registers[EXP_REG_PARM9] = shaderParms[9];
-	registers[EXP_REG_PARM10] = shaderParms[10];
-	registers[EXP_REG_PARM11] = shaderParms[11];
-	registers[EXP_REG_GLOBAL0] = view->renderView.shaderParms[0];
-	registers[EXP_REG_GLOBAL1] = view->renderView.shaderParms[1];
-	registers[EXP_REG_GLOBAL2] = view->renderView.shaderParms[2];
-	registers[EXP_REG_GLOBAL3] = view->renderView.shaderParms[3];
-	registers[EXP_REG_GLOBAL4] = view->renderView.shaderParms[4];
-	registers[EXP_REG_GLOBAL5] = view->renderView.shaderParms[5];
-	registers[EXP_REG_GLOBAL6] = view->renderView.shaderParms[6];
-	registers[EXP_REG_GLOBAL7] = view->renderView.shaderParms[7];
-
-	for ( i = 0 ; i < numOps ; i++, op++ ) {
+	for ( i = 0 ; i < count ; i++, op++ ) {
 		switch( op->opType ) {
 		case OP_TYPE_ADD:
 			registers[op->c] = registers[op->a] + registers[op->b];
@@ -2800,6 +2769,97 @@ void idMaterial::EvaluateRegisters( float *registers, const float shaderParms[MA
 	}
 }
 
+// registers after evaluating the view-only ops of a material
+// they depend only on material, view time and global parms, so they are cached per thread:
+// the same material is usually evaluated for many surfaces (e.g. foliage) with the same view
+typedef struct {
+	const idMaterial *	material;
+	int					generation;
+	float				floatTime;
+	float				globalParms[8];
+	idList<float>		registers;
+} materialViewRegisters_t;
+
+static const int MATERIAL_VIEW_REGISTERS_CACHE_SIZE = 64;	// direct-mapped by material pointer
+static thread_local materialViewRegisters_t materialViewRegistersCache[MATERIAL_VIEW_REGISTERS_CACHE_SIZE];
+
+/*
+===============
+idMaterial::EvaluateRegisters
+
+Parameters are taken from the localSpace and the renderView,
+then all expressions are evaluated, leaving the material registers
+set to their apropriate values.
+===============
+*/
+void idMaterial::EvaluateRegisters( float *registers, const float shaderParms[MAX_ENTITY_SHADER_PARMS],
+									const viewDef_t *view, idSoundEmitter *soundEmitter ) const {
+	int		i;
+
+	if ( !ops && numOps ) {
+		common->FatalError( "R_EvaluateExpression: NULL operators pointer" );
+		return;
+	}
+
+	const float *globalParms = view->renderView.shaderParms;
+	const int firstOp = ( r_useMaterialViewCache.GetBool() ? numViewOps : 0 );
+
+	if ( firstOp > 0 ) {
+		// take registers computed by view-only ops from cache, or compute them now
+		int generation = materialViewRegistersGeneration.load( std::memory_order_relaxed );
+		materialViewRegisters_t &cached = materialViewRegistersCache[( (size_t)this / sizeof( *this ) ) % MATERIAL_VIEW_REGISTERS_CACHE_SIZE];
+		if ( cached.material != this || cached.generation != generation ||
+			cached.floatTime != view->floatTime || memcmp( cached.globalParms, globalParms, sizeof( cached.globalParms ) ) != 0
+		) {
+			cached.material = this;
+			cached.generation = generation;
+			cached.floatTime = view->floatTime;
+			memcpy( cached.globalParms, globalParms, sizeof( cached.globalParms ) );
+
+			cached.registers.SetNum( numRegisters );
+			float *viewRegs = cached.registers.Ptr();
+			memcpy( viewRegs, expressionRegisters, numRegisters * sizeof( viewRegs[0] ) );
+			memset( viewRegs, 0, EXP_REG_NUM_PREDEFINED * sizeof( viewRegs[0] ) );
+			viewRegs[EXP_REG_TIME] = view->floatTime;
+			for ( i = 0; i < 8; i++ ) {
+				viewRegs[EXP_REG_GLOBAL0 + i] = globalParms[i];
+			}
+			R_EvaluateExpressionOps( viewRegs, ops, numViewOps, nullptr );
+		}
+		memcpy( registers, cached.registers.Ptr(), numRegisters * sizeof( registers[0] ) );
+	} else {
+		// copy the material constants
+		for ( i = EXP_REG_NUM_PREDEFINED ; i < numRegisters ; i++ ) {
+			registers[i] = expressionRegisters[i];
+		}
+		registers[EXP_REG_TIME] = view->floatTime;
+		registers[EXP_REG_GLOBAL0] = globalParms[0];
+		registers[EXP_REG_GLOBAL1] = globalParms[1];
+		registers[EXP_REG_GLOBAL2] = globalParms[2];
+		registers[EXP_REG_GLOBAL3] = globalParms[3];
+		registers[EXP_REG_GLOBAL4] = globalParms[4];
+		registers[EXP_REG_GLOBAL5] = globalParms[5];
+		registers[EXP_REG_GLOBAL6] = globalParms[6];
+		registers[EXP_REG_GLOBAL7] = globalParms[7];
+	}
+
+	// copy the local parameters
+	registers[EXP_REG_PARM0] = shaderParms[0];
+	registers[EXP_REG_PARM1] = shaderParms[1];
+	registers[EXP_REG_PARM2] = shaderParms[2];
+	registers[EXP_REG_PARM3] = shaderParms[3];
+	registers[EXP_REG_PARM4] = shaderParms[4];
+	registers[EXP_REG_PARM5] = shaderParms[5];
+	registers[EXP_REG_PARM6] = shaderParms[6];
+	registers[EXP_REG_PARM7] = shaderParms[7];
+	registers[EXP_REG_PARM8] = shaderParms[8];
+	registers[EXP_REG_PARM9] = shaderParms[9];
+	registers[EXP_REG_PARM10] = shaderParms[10];
+	registers[EXP_REG_PARM11] = shaderParms[11];
+
+	R_EvaluateExpressionOps( registers, ops + firstOp, numOps - firstOp, soundEmitter );
+}
+
 /*
 =============
 idMaterial::Texgen
@@ -2933,6 +2993,57 @@ void idMaterial::CheckForConstantRegisters() {
 	EvaluateRegisters( constantRegisters, shaderParms, &viewDef, 0 );
 }
 
+/*
+==================
+idMaterial::SplitViewExpressionOps
+
+Ops which don't depend (even indirectly) on entity parms or sound amplitude
+produce the same values for all surfaces rendered in a view.
+They are stably moved to the beginning of ops array, so that EvaluateRegisters can reuse their results.
+==================
+*/
+void idMaterial::SplitViewExpressionOps() {
+	numViewOps = 0;
+	if ( numOps == 0 ) {
+		return;
+	}
+
+	idList<bool> perSurface;
+	idList<bool> written;
+	perSurface.SetNum( numRegisters );
+	written.SetNum( numRegisters );
+	for ( int r = 0; r < numRegisters; r++ ) {
+		perSurface[r] = ( r >= EXP_REG_PARM0 && r <= EXP_REG_PARM11 );
+		written[r] = false;
+	}
+
+	idList<expOp_t> viewOps, surfaceOps;
+	for ( int i = 0; i < numOps; i++ ) {
+		const expOp_t &op = ops[i];
+		// every op must write its own temporary register, otherwise reordering is not safe
+		if ( op.c < EXP_REG_NUM_PREDEFINED || op.c >= numRegisters || written[op.c] ) {
+			return;
+		}
+		written[op.c] = true;
+
+		bool dep;
+		if ( op.opType == OP_TYPE_SOUND ) {
+			dep = true;
+		} else if ( op.opType == OP_TYPE_TABLE ) {
+			// "a" is table index, not register
+			dep = perSurface[op.b];
+		} else {
+			dep = perSurface[op.a] || perSurface[op.b];
+		}
+		perSurface[op.c] = dep;
+		( dep ? surfaceOps : viewOps ).AddGrow( op );
+	}
+
+	numViewOps = viewOps.Num();
+	memcpy( ops, viewOps.Ptr(), viewOps.Num() * sizeof( ops[0] ) );
+	memcpy( ops + numViewOps, surfaceOps.Ptr(), surfaceOps.Num() * sizeof( ops[0] ) );
+}
+
 /*
 ===================
 idMaterial::ImageName
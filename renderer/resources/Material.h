@@ -657,6 +657,7 @@ private:
 	void				MultiplyTextureMatrix( textureStage_t *ts, int registers[2][3] );	// FIXME: for some reason the const is bad for gcc and Mac
 	void				SortInteractionStages();
 	void				AddImplicitStages( const textureRepeat_t trpDefault = TR_REPEAT );
+	void				SplitViewExpressionOps();
 	void				CheckForConstantRegisters();
 	bool				IsFrobStage(int stageIdx, bool *isStandard = nullptr) const;
 	void				AddFrobStages(const idVec3 &rgbAdd, const char *imageName, const idVec3 &rgbMult, const textureRepeat_t trpDefault = TR_REPEAT);
@@ -710,6 +711,7 @@ private:
 
 	int					numOps;
 	expOp_t *			ops;				// evaluate to make expressionRegisters
+	int					numViewOps;			// first ops which depend only on time and global parms
 																										
 	int					numRegisters;																			//
 	float *				expressionRegisters;
@@ -693,6 +693,14 @@ typedef struct {
 
 	int					memoryHighwater;	// max used on any frame
 
+	// R_FrameAlloc serves small requests from per-thread arenas (see r_frameAllocArenas)
+	// every arena is a chunk carved from frameMemory, so frontend jobs don't fight over frameMemoryAllocated
+	int					arenaGeneration;		// unique id of current frame, arenas with other id are stale
+	std::atomic<int>	arenaChunks;			// number of chunks carved for arenas on this frame
+	std::atomic<int>	arenaRetiredWaste;		// unused bytes at the end of chunks which were replaced
+	int					arenaWaste;				// total unused bytes in chunks (see R_UpdateFrameMemoryStats)
+	int					arenaWasteHighwater;	// max waste on any frame
+
 	// the currently building command list
 	// commands can be inserted at the front if needed, as for required
 	// dynamically generated textures
@@ -733,6 +741,7 @@ typedef struct {
 	int		c_sphere_cull_in, c_sphere_cull_clip, c_sphere_cull_out;
 	int		c_box_cull_in, c_box_cull_out;
 	int		c_createInteractions;	// number of calls to idInteraction::CreateInteraction
+	int		c_reusedInteractions;	// active interactions which were already created before
 	int		c_createLightTris;
 	int		c_createShadowVolumes;
 	int		c_generateMd5;
@@ -750,6 +759,12 @@ typedef struct {
 	int		c_guiSurfs, c_noshadowSurfs;
 	int		frontEndMsec;			// sum of time in all RE_RenderScene's in a frame
 	int		frontEndMsecLast;		// time in last RE_RenderScene
+	int		frontEndUsec;			// same as frontEndMsec, but more precise (see FrameStats)
+	int		frontEndJobUsec;		// total processing time of frontEndJobList jobs on all threads
+	int		frontEndJobWaitUsec;	// time spent in frontEndJobList->Wait()
+	int		c_shadowMapPages;		// number of pages assigned in shadow map atlas
+	int		c_viewFlowAreas;		// area visits made by view flow through portals
+	int		c_viewFlowCacheHits;	// views which reused cached flow through portals
 } performanceCounters_t;
 
 
@@ -796,6 +811,7 @@ typedef struct {
 
 	int		msec;			// total msec for backend run
 	int		msecLast;		// last msec for backend run
+	int		usec;			// same as msec, but more precise (see FrameStats)
 	char	waitedFor;		// . - backend, F = frontend, S - GPU Sync
 } backEndCounters_t;
 
@@ -879,6 +895,8 @@ public:
 	virtual void			DrawDemoPics() override;
 	virtual void			BeginFrame( int windowWidth, int windowHeight ) override;
 	virtual void			EndFrame( int *frontEndMsec, int *backEndMsec ) override;
+	virtual void			BeginFrameStatsCapture() override;
+	virtual void			EndFrameStatsCapture( const char *title ) override;
 	virtual void			TakeScreenshot( int width, int height, const char *fileName, int downSample, renderView_t *ref, bool envshot = false ) override;
 	virtual void			CropRenderSize( int width, int height, bool makePowerOfTwo = false, bool forceDimensions = false ) override;
 	virtual void			GetCurrentRenderCropSize( int &width, int &height ) override;
@@ -1002,6 +1020,7 @@ extern idCVar r_checkBounds;			// compare all surface bounds with precalculated
 
 extern idCVar r_useShadowSurfaceScissor;// 1 = scissor shadows by the scissor rect of the interaction surfaces
 extern idCVar r_useConstantMaterials;	// 1 = use pre-calculated material registers if possible
+extern idCVar r_useMaterialViewCache;	// 1 = evaluate material ops independent of entity once per view time
 extern idCVar r_useNodeCommonChildren;	// stop pushing reference bounds early when possible
 extern idCVar r_useSilRemap;			// 1 = consider verts with the same XYZ, but different ST the same for shadows
 extern idCVar r_useCulling;				// 0 = none, 1 = sphere, 2 = sphere + box
@@ -1715,6 +1734,7 @@ SCENE GENERATION
 void R_InitFrameData( void );
 void R_ShutdownFrameData( void );
 void R_ToggleSmpFrame( void );
+void R_UpdateFrameMemoryStats( frameData_t *frameData );
 void *R_FrameAlloc( int bytes );
 void *R_ClearedFrameAlloc( int bytes );
 void R_FrameFree( void *data );
@@ -30,6 +30,29 @@ frameData_t 	*frameData;
 frameData_t		*backendFrameData;
 unsigned int	smpFrame;
 
+idCVar r_frameAllocArenas(
+	"r_frameAllocArenas", "1", CVAR_RENDERER | CVAR_BOOL,
+	"Serve small R_FrameAlloc requests from per-thread arenas to avoid contention between frontend jobs"
+);
+
+// every thread allocates from its own chunk of frame memory
+static const int FRAME_ARENA_CHUNK_SIZE = 64 * 1024;
+// larger requests go directly to shared frame memory
+static const int FRAME_ARENA_MAX_REQUEST = FRAME_ARENA_CHUNK_SIZE / 8;
+// threads beyond this limit always use shared frame memory
+static const int MAX_FRAME_ARENAS = 64;
+
+// note: aligned to cache line to avoid false sharing between threads
+struct alignas(64) frameArena_t {
+	int		generation;		// equals frameData->arenaGeneration if chunk is valid
+	int		pos;			// offset of the next allocation in frameMemory
+	int		end;			// offset of the end of the chunk
+};
+static frameArena_t frameArenas[MAX_FRAME_ARENAS];
+static std::atomic<int> frameArenasUsed;
+static thread_local int threadFrameArena = -1;
+static int frameArenaLastGeneration = 0;
+
 /*
 ======================
 idScreenRect::Clear
@@ -215,10 +238,8 @@ R_ToggleSmpFrame
 ====================
 */
 void R_ToggleSmpFrame( void ) {
-	// update the highwater mark
-	if ( frameData->frameMemoryAllocated > frameData->memoryHighwater ) {
-		frameData->memoryHighwater = frameData->frameMemoryAllocated;
-	}
+	// update the highwater marks
+	R_UpdateFrameMemoryStats( frameData );
 
 	// switch to the next frame
 	smpFrame++;
@@ -239,10 +260,43 @@ void R_ToggleSmpFrame( void ) {
 	frameData->frameMemoryAllocated = bytesNeededForAlignment;
 	frameData->frameMemoryUsed = 0;
 
+	// invalidate chunks of all thread arenas
+	frameData->arenaGeneration = ++frameArenaLastGeneration;
+	frameData->arenaChunks = 0;
+	frameData->arenaRetiredWaste = 0;
+	frameData->arenaWaste = 0;
+
 	R_ClearCommandChain( frameData );
 }
 
 
+/*
+====================
+R_UpdateFrameMemoryStats
+
+Must be called when no thread is running R_FrameAlloc.
+====================
+*/
+void R_UpdateFrameMemoryStats( frameData_t *frameData ) {
+	// unused tails of active arenas are wasted too
+	int waste = frameData->arenaRetiredWaste;
+	int numArenas = idMath::Imin( frameArenasUsed, MAX_FRAME_ARENAS );
+	for ( int i = 0; i < numArenas; i++ ) {
+		const frameArena_t &arena = frameArenas[i];
+		if ( arena.generation == frameData->arenaGeneration ) {
+			waste += arena.end - arena.pos;
+		}
+	}
+	frameData->arenaWaste = waste;
+
+	if ( frameData->frameMemoryAllocated > frameData->memoryHighwater ) {
+		frameData->memoryHighwater = frameData->frameMemoryAllocated;
+	}
+	if ( frameData->arenaWaste > frameData->arenaWasteHighwater ) {
+		frameData->arenaWasteHighwater = frameData->arenaWaste;
+	}
+}
+
 //=====================================================
 
 #define	MEMORY_BLOCK_SIZE	0x100000
@@ -325,6 +379,45 @@ void R_StaticFree( void *data ) {
 	Mem_Free( data );
 }
 
+/*
+================
+R_FrameAllocShared
+================
+*/
+static byte *R_FrameAllocShared( int bytes ) {
+	// thread safe add
+	int	end = frameData->frameMemoryAllocated += bytes;
+
+	if ( end > MAX_FRAME_MEMORY ) {
+		idLib::Error( "R_FrameAlloc ran out of memory. bytes = %d, end = %d, highWaterAllocated = %d\n", bytes, end, frameData->memoryHighwater );
+	}
+	byte *ptr = frameData->frameMemory + end - bytes;
+
+	return ptr;
+}
+
+/*
+================
+R_FrameAllocArena
+================
+*/
+static byte *R_FrameAllocArena( frameArena_t &arena, int bytes ) {
+	if ( arena.generation != frameData->arenaGeneration || arena.pos + bytes > arena.end ) {
+		if ( arena.generation == frameData->arenaGeneration ) {
+			frameData->arenaRetiredWaste += arena.end - arena.pos;
+		}
+		// carve a new chunk for this thread
+		byte *chunk = R_FrameAllocShared( FRAME_ARENA_CHUNK_SIZE );
+		frameData->arenaChunks++;
+		arena.generation = frameData->arenaGeneration;
+		arena.pos = int( chunk - frameData->frameMemory );
+		arena.end = arena.pos + FRAME_ARENA_CHUNK_SIZE;
+	}
+	byte *ptr = frameData->frameMemory + arena.pos;
+	arena.pos += bytes;
+	return ptr;
+}
+
 /*
 ================
 R_FrameAlloc
@@ -348,20 +441,26 @@ from this frame.
 
 The memory is NOT zero filled.
 Should part of this be inlined in a macro?
+
+Small requests are served from the chunk
+owned by the calling thread, so parallel frontend jobs
+don't need to atomically bump the shared pointer.
 ================
 */
 void *R_FrameAlloc( int bytes ) {
 	bytes = ( bytes + FRAME_ALLOC_ALIGNMENT - 1 ) & ~( FRAME_ALLOC_ALIGNMENT - 1 );
 
-	// thread safe add
-	int	end = frameData->frameMemoryAllocated += bytes;
-
-	if ( end > MAX_FRAME_MEMORY ) {
-		idLib::Error( "R_FrameAlloc ran out of memory. bytes = %d, end = %d, highWaterAllocated = %d\n", bytes, end, frameData->memoryHighwater );
+	if ( bytes <= FRAME_ARENA_MAX_REQUEST && r_frameAllocArenas.GetBool() ) {
+		if ( threadFrameArena < 0 ) {
+			// first allocation on this thread: grab an arena
+			threadFrameArena = frameArenasUsed++;
+		}
+		if ( threadFrameArena < MAX_FRAME_ARENAS ) {
+			return R_FrameAllocArena( frameArenas[threadFrameArena], bytes );
+		}
 	}
-	byte *ptr = frameData->frameMemory + end - bytes;
 
-	return ptr;
+	return R_FrameAllocShared( bytes );
 }
 
 /*
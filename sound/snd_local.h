@@ -528,6 +528,33 @@ typedef struct soundPortalTrace_s {
 	const struct soundPortalTrace_s	*prevStack;
 } soundPortalTrace_t;
 
+// path of sound from an area to the listener's area through portals
+// it does not depend on emitter and listener positions, so intermediate points are centers of portals
+typedef struct {
+	int			hops;			// number of portals on the path (0 = no path)
+	int			lastArea;		// portal into listener's area is GetPortal( lastArea, lastPortal )
+	int			lastPortal;
+	idVec3		point;			// center of portal by which sound leaves this area
+	idVec3		nextPoint;		// next point after it
+	idVec3		prevPoint;		// last point before portal into listener's area
+	float		distance;		// path length from point to prevPoint (doom units)
+	float		length;			// path length from point to center of last portal (doom units)
+	float		loss;			// portal losses and diffraction at intermediate points (dB)
+} soundRoute_t;
+
+// max number of routes kept per area: effective volume depends on emitter's falloff,
+// so the loudest route is chosen and origins are blended when emitter is resolved
+static const int SOUND_ROUTE_CANDIDATES = 4;
+
+// routes from every area to given listener's area
+typedef struct {
+	int			listenArea;
+	int			portalsVersion;
+	float		diffractionMax;
+	idList<soundRoute_t> routes;	// SOUND_ROUTE_CANDIDATES per area, indexed by area * SOUND_ROUTE_CANDIDATES + i
+	idList<int>	numRoutes;		// indexed by area number
+} soundRouteTable_t;
+
 class idSoundWorldLocal : public idSoundWorld {
 public:
 	virtual					~idSoundWorldLocal( void ) override;
@@ -605,6 +632,8 @@ public:
 	void					AVIUpdate( void );
 	float					GetDiffractionLoss(const idVec3 p1, const idVec3 p2, const idVec3 p3); // grayman #4219
 	bool					ResolveOrigin( bool primary, const int stackDepth, const soundPortalTrace_t *prevStack, const int soundArea, const float dist, const float loss, const idVec3& soundOrigin, const idVec3& prevSoundOrigin, idSoundEmitterLocal *def , SoundChainResults *results); // grayman #3042 // grayman #4219 // grayman #4882
+	bool					ResolveOriginByRoutes( bool primary, const int soundArea, const float dist, const float loss, const idVec3& soundOrigin, idSoundEmitterLocal *def, SoundChainResults *results );
+	void					BuildRouteTable( soundRouteTable_t &table, int listenArea );
 	float					FindAmplitude( idSoundEmitterLocal *sound, const int localTime, const idVec3 *listenerPosition, const s_channelType channel, bool shakesOnly );
 	void					GetSubtitles( idList<SubtitleMatch> &dest ) override;	//stgatilov #2454
 
@@ -633,6 +662,8 @@ public:
 
 	idList<idSoundEmitterLocal *>emitters;
 
+	soundRouteTable_t		routeTables[2];		// for primary and secondary listener
+
 	idSoundFade				soundClassFade[SOUND_MAX_CLASSES];	// for global sound fading
 
 	// avi stuff
@@ -810,6 +841,7 @@ public:
 	static idCVar			s_constantAmplitude;
 	static idCVar			s_playDefaultSound;
 	static idCVar			s_useOcclusion;
+	static idCVar			s_soundRoutes;
 	static idCVar			s_subFraction;
 	static idCVar			s_globalFraction;
 	static idCVar			s_doorDistanceAdd;
@@ -36,6 +36,11 @@ void idSoundWorldLocal::Init( idRenderWorld *renderWorld ) {
 	listenerQU.Zero();
 	listenerArea = 0;
 	listenerAreaName = "Undefined";
+	for ( int i = 0; i < 2; i++ ) {
+		routeTables[i].listenArea = -1;
+		routeTables[i].routes.Clear();
+		routeTables[i].numRoutes.Clear();
+	}
 	listenerEffect = AL_EFFECTSLOT_NULL;
 	// nbohr1more: #5587 Reverb volume control
 	listenerSlotReverbGain = 1.0f;
@@ -829,8 +834,75 @@ set at maxDistance
 */
 static const int MAX_PORTAL_TRACE_DEPTH = 10;
 
+/*
+===================
+GetPortalSoundPoint
+
+Point where sound going from "from" towards "to" passes through the portal.
+If the straight line misses the portal, the point is slid inside portal edges.
+===================
+*/
+static idVec3 GetPortalSoundPoint( const idWinding &w, const idVec3 &from, const idVec3 &to )
+{
+	idPlane	pl;
+	w.GetPlane( pl );
+
+	float  scale;
+	idVec3 dir = to - from;
+	if ( !pl.RayIntersection( from, dir, scale ) )
+	{
+		return w.GetCenter();
+	}
+
+	idVec3 source = from + scale * dir;
+
+	// if this point isn't inside the portal edges, slide it in
+	for ( int i = 0 ; i < w.GetNumPoints() ; i++ )
+	{
+		int j = ( i + 1 ) % w.GetNumPoints();
+		idVec3	edgeDir = w[j].ToVec3() - w[i].ToVec3();
+		idVec3	edgeNormal;
+
+		edgeNormal.Cross( pl.Normal(), edgeDir );
+
+		idVec3 fromVert = source - w[j].ToVec3();
+
+		float d = edgeNormal * fromVert;
+		if ( d > 0 )
+		{
+			// move it in
+			float div = edgeNormal.Normalize();
+			d /= div;
+			source -= d * edgeNormal;
+		}
+	}
+	return source;
+}
+
+/*
+===================
+GetPathDiffractionLoss
+
+Diffraction loss at p2, zero if path does not really turn there.
+===================
+*/
+static float GetPathDiffractionLoss( idSoundWorldLocal *world, const idVec3 &p1, const idVec3 &p2, const idVec3 &p3 )
+{
+	if ( p1.Compare( p2, VECTOR_EPSILON ) || p2.Compare( p3, VECTOR_EPSILON ) )
+	{
+		return 0.0f;
+	}
+	return world->GetDiffractionLoss( p1, p2, p3 );
+}
+
 bool idSoundWorldLocal::ResolveOrigin( bool primary, const int stackDepth, const soundPortalTrace_t *prevStack, const int soundArea, const float dist, const float loss, const idVec3& soundOrigin, const idVec3& prevSoundOrigin, idSoundEmitterLocal *def , SoundChainResults *results) // grayman #3042 // grayman #4219
 {
+	if ( stackDepth == 0 && idSoundSystemLocal::s_soundRoutes.GetBool() )
+	{
+		// don't trace portals for every emitter, use precomputed routes
+		return ResolveOriginByRoutes( primary, soundArea, dist, loss, soundOrigin, def, results );
+	}
+
 	if ( dist >= def->distance ) // compare meters to meters
 	{
 		// we can't possibly hear the sound through this chain of portals
@@ -940,42 +1012,7 @@ bool idSoundWorldLocal::ResolveOrigin( bool primary, const int stackDepth, const
 
 		// pick a point on the portal to serve as our virtual sound origin
 #if 1
-		idVec3 source;
-
-		idPlane	pl;
-		re.w.GetPlane( pl );
-
-		float  scale;
-		idVec3 dir = listenerPosition - soundOrigin; // grayman #4882
-		if ( !pl.RayIntersection( soundOrigin, dir, scale ) )
-		{
-			source = re.w.GetCenter();
-		}
-		else
-		{
-			source = soundOrigin + scale * dir;
-
-			// if this point isn't inside the portal edges, slide it in
-			for ( int i = 0 ; i < re.w.GetNumPoints() ; i++ )
-			{
-				int j = ( i + 1 ) % re.w.GetNumPoints();
-				idVec3	edgeDir = re.w[j].ToVec3() - re.w[i].ToVec3();
-				idVec3	edgeNormal;
-
-				edgeNormal.Cross( pl.Normal(), edgeDir );
-
-				idVec3 fromVert = source - re.w[j].ToVec3();
-
-				float d = edgeNormal * fromVert;
-				if ( d > 0 )
-				{
-					// move it in
-					float div = edgeNormal.Normalize();
-					d /= div;
-					source -= d * edgeNormal;
-				}
-			}
-		}
+		idVec3 source = GetPortalSoundPoint( re.w, soundOrigin, listenerPosition ); // grayman #4882
 #else
 		// clip the ray from the listener to the center of the portal by
 		// all the portal edge planes, then project that point (or the original if not clipped)
@@ -1155,6 +1192,303 @@ bool idSoundWorldLocal::ResolveOrigin( bool primary, const int stackDepth, const
 }
 
 
+/*
+===================
+AddSoundRoute
+
+Adds route to candidates of area, unless it is both longer and louder than some candidate.
+If there are too many candidates, the one with largest loss is dropped:
+routes are ranked by loss here, distance falloff is only known for emitter.
+Returns true if route was added.
+===================
+*/
+static bool AddSoundRoute( soundRoute_t *candidates, int &num, const soundRoute_t &route )
+{
+	for ( int i = 0; i < num; i++ )
+	{
+		if ( candidates[i].loss <= route.loss && candidates[i].length <= route.length )
+		{
+			return false;
+		}
+	}
+
+	// drop candidates which are worse in both respects
+	for ( int i = 0; i < num; i++ )
+	{
+		if ( route.loss <= candidates[i].loss && route.length <= candidates[i].length )
+		{
+			candidates[i--] = candidates[--num];
+		}
+	}
+
+	if ( num == SOUND_ROUTE_CANDIDATES )
+	{
+		int worst = 0;
+		for ( int i = 1; i < num; i++ )
+		{
+			if ( candidates[i].loss > candidates[worst].loss )
+			{
+				worst = i;
+			}
+		}
+		if ( candidates[worst].loss <= route.loss )
+		{
+			return false;
+		}
+		candidates[worst] = route;
+		return true;
+	}
+
+	candidates[num++] = route;
+	return true;
+}
+
+/*
+===================
+idSoundWorldLocal::BuildRouteTable
+
+Finds paths through portals from every area to listener's area.
+Paths are extended from listener's area one portal at a time,
+so no path is longer than MAX_PORTAL_TRACE_DEPTH portals, just like in ResolveOrigin.
+Every area keeps a few shortest and least lossy paths (see AddSoundRoute),
+since the loudest one can only be chosen for particular emitter.
+Intermediate points are portal centers, so the table only depends on listener's area and portals.
+===================
+*/
+void idSoundWorldLocal::BuildRouteTable( soundRouteTable_t &table, int listenArea )
+{
+	table.listenArea = listenArea;
+	table.portalsVersion = rw->GetPortalsVersion();
+	table.diffractionMax = idSoundSystemLocal::s_diffractionMax.GetFloat();
+
+	int numAreas = rw->NumAreas();
+	table.routes.SetNum( numAreas * SOUND_ROUTE_CANDIDATES );
+	table.numRoutes.SetNum( numAreas );
+	memset( table.numRoutes.Ptr(), 0, numAreas * sizeof( int ) );
+
+	idList<int> frontier, nextFrontier;
+	idList<int> frontierDepth;
+	frontierDepth.SetNum( numAreas );
+	memset( frontierDepth.Ptr(), 0, numAreas * sizeof( int ) );
+
+	frontier.Append( listenArea );
+	for ( int depth = 1; depth <= MAX_PORTAL_TRACE_DEPTH && frontier.Num() > 0; depth++ )
+	{
+		nextFrontier.Clear();
+		for ( int k = 0; k < frontier.Num(); k++ )
+		{
+			int area = frontier[k];
+			// listener's area is the start of all paths: extend a single empty path from it
+			int numFrom = ( area == listenArea ? 1 : table.numRoutes[area] );
+			int numPortals = rw->NumPortalsInArea( area );
+
+			for ( int c = 0; c < numFrom; c++ )
+			{
+				// copy: candidates of area may be changed while they are extended
+				soundRoute_t from = table.routes[area * SOUND_ROUTE_CANDIDATES + c];
+				if ( area != listenArea && from.hops >= MAX_PORTAL_TRACE_DEPTH )
+				{
+					continue;
+				}
+
+				for ( int p = 0; p < numPortals; p++ )
+				{
+					exitPortal_t re = rw->GetPortal( area, p );
+					int otherArea = ( re.areas[0] == area ? re.areas[1] : re.areas[0] );
+					if ( otherArea == listenArea )
+					{
+						continue;
+					}
+
+					soundRoute_t route;
+					route.point = re.w.GetCenter();
+					if ( area == listenArea )
+					{
+						route.hops = 1;
+						route.lastArea = area;
+						route.lastPortal = p;
+						route.nextPoint = route.point;
+						route.prevPoint = route.point;
+						route.distance = 0.0f;
+						route.length = 0.0f;
+						route.loss = re.lossPlayer;
+					}
+					else
+					{
+						float segment = ( route.point - from.point ).LengthFast();
+						route.hops = from.hops + 1;
+						route.lastArea = from.lastArea;
+						route.lastPortal = from.lastPortal;
+						route.nextPoint = from.point;
+						// diffraction at last portal depends on listener position, it is added later
+						if ( from.hops == 1 )
+						{
+							route.prevPoint = route.point;
+							route.distance = 0.0f;
+							route.loss = from.loss + re.lossPlayer;
+						}
+						else
+						{
+							route.prevPoint = from.prevPoint;
+							route.distance = from.distance + segment;
+							route.loss = from.loss + re.lossPlayer + GetPathDiffractionLoss( this, route.point, from.point, from.nextPoint );
+						}
+						route.length = from.length + segment;
+					}
+
+					if ( AddSoundRoute( &table.routes[otherArea * SOUND_ROUTE_CANDIDATES], table.numRoutes[otherArea], route ) )
+					{
+						if ( frontierDepth[otherArea] != depth )
+						{
+							frontierDepth[otherArea] = depth;
+							nextFrontier.Append( otherArea );
+						}
+					}
+				}
+			}
+		}
+		frontier.Swap( nextFrontier );
+	}
+}
+
+/*
+===================
+idSoundWorldLocal::ResolveOriginByRoutes
+
+Same as ResolveOrigin, but takes paths from routing table of listener's area.
+The ends of every path are refined for actual positions of emitter and listener,
+then the path with highest effective volume is chosen, taking both losses and distance falloff into account.
+Spatialized origin is blended from all audible paths weighted by their effective volumes,
+just like ResolveOrigin does for chains at depth 0.
+===================
+*/
+bool idSoundWorldLocal::ResolveOriginByRoutes( bool primary, const int soundArea, const float dist, const float loss, const idVec3& soundOrigin, idSoundEmitterLocal *def, SoundChainResults *results )
+{
+	idVec3 listenerPosition = (primary ? listenerQU : gameLocal.GetLocalPlayer()->GetSecondaryListenerLoc()); // doom units
+	int listenArea = rw->GetAreaAtPoint(listenerPosition);
+	if ( listenArea < 0 || soundArea < 0 )
+	{
+		return false;
+	}
+
+	SoundChainResults chains[SOUND_ROUTE_CANDIDATES];
+	float pathLength[SOUND_ROUTE_CANDIDATES]; // from emitter to spatialized origin (doom units)
+	int numChains = 0;
+
+	if ( soundArea == listenArea )
+	{
+		chains[0].spatializedOrigin = soundOrigin;
+		chains[0].loss = loss;
+		pathLength[0] = 0.0f;
+		numChains = 1;
+	}
+	else
+	{
+		soundRouteTable_t &table = routeTables[primary ? 0 : 1];
+		if ( table.listenArea != listenArea || table.portalsVersion != rw->GetPortalsVersion() ||
+			table.diffractionMax != idSoundSystemLocal::s_diffractionMax.GetFloat() || table.numRoutes.Num() != rw->NumAreas() )
+		{
+			BuildRouteTable( table, listenArea );
+		}
+
+		for ( int c = 0; c < table.numRoutes[soundArea]; c++ )
+		{
+			const soundRoute_t &route = table.routes[soundArea * SOUND_ROUTE_CANDIDATES + c];
+			SoundChainResults &chain = chains[numChains];
+			float &length = pathLength[numChains];
+			numChains++;
+
+			exitPortal_t re = rw->GetPortal( route.lastArea, route.lastPortal );
+			if ( route.hops == 1 )
+			{
+				chain.spatializedOrigin = GetPortalSoundPoint( re.w, soundOrigin, listenerPosition );
+				length = ( chain.spatializedOrigin - soundOrigin ).LengthFast();
+				chain.loss = loss + route.loss + GetPathDiffractionLoss( this, soundOrigin, chain.spatializedOrigin, listenerPosition );
+			}
+			else
+			{
+				chain.spatializedOrigin = GetPortalSoundPoint( re.w, route.prevPoint, listenerPosition );
+				length = ( route.point - soundOrigin ).LengthFast() + route.distance + ( chain.spatializedOrigin - route.prevPoint ).LengthFast();
+				chain.loss = loss + route.loss;
+				chain.loss += GetPathDiffractionLoss( this, soundOrigin, route.point, route.nextPoint );
+				chain.loss += GetPathDiffractionLoss( this, route.prevPoint, chain.spatializedOrigin, listenerPosition );
+			}
+		}
+	}
+
+	// effective volume of every audible path, same as in ResolveOrigin
+	float mind = def->minDistance * METERS_TO_DOOM;
+	float maxd = def->maxDistance * METERS_TO_DOOM;
+	bool quadratic = idSoundSystemLocal::s_quadraticFalloff.GetBool();
+	float volumes[SOUND_ROUTE_CANDIDATES];
+	float totalVolume = 0.0f;
+	float maxVolume = -1.0f;
+	int pickMe = -1;
+
+	for ( int c = 0; c < numChains; c++ )
+	{
+		SoundChainResults &chain = chains[c];
+		volumes[c] = 0.0f;
+
+		chain.spatialDistance = ( listenerPosition - chain.spatializedOrigin ).LengthFast(); // doom units
+		chain.distance = dist * METERS_TO_DOOM + pathLength[c] + chain.spatialDistance; // doom units
+		if ( chain.distance * DOOM_TO_METERS >= def->distance )
+		{
+			continue;
+		}
+		float vol = soundSystemLocal.dB2Scale(def->parms.volume - chain.loss);
+		if ( vol < SND_EPSILON )
+		{
+			continue;
+		}
+
+		// reduce effective volume based on distance
+		if ( chain.distance >= maxd )
+		{
+			vol = 0.0f;
+		}
+		else if ( chain.distance > mind )
+		{
+			float frac = idMath::ClampFloat( 0.0f, 1.0f, 1.0f - ((chain.distance - mind) / (maxd - mind)));
+			if (quadratic)
+			{
+				frac *= frac;
+			}
+			vol *= frac;
+		}
+
+		volumes[c] = vol;
+		totalVolume += vol;
+		if ( vol > maxVolume )
+		{
+			maxVolume = vol;
+			pickMe = c;
+		}
+	}
+
+	if ( pickMe < 0 )
+	{
+		return false;
+	}
+
+	const SoundChainResults &best = chains[pickMe];
+	idVec3 spatialOrigin = best.spatializedOrigin;
+	if ( totalVolume > 0.0f )
+	{
+		spatialOrigin.Zero();
+		for ( int c = 0; c < numChains; c++ )
+		{
+			spatialOrigin += chains[c].spatializedOrigin * ( volumes[c] / totalVolume );
+		}
+	}
+
+	results->distance = best.distance;
+	results->spatializedOrigin = spatialOrigin;
+	results->loss = best.loss;
+	results->spatialDistance = ( spatialOrigin - listenerPosition ).LengthFast();
+	return true;
+}
+
 /*
 ===================
 idSoundWorldLocal::PlaceListener
@@ -30,13 +30,6 @@ Project: The Dark Mod (http://www.thedarkmod.com/)
 
 #define BUILD_OS_ID						0
 
-#ifdef _WIN64
-//stgatilov: see idClass::ProcessEventArgPtr for info
-#define CPU_EASYARGS					0
-#else
-#define CPU_EASYARGS					1
-#endif
-
 #define PACKED
 
 
@@ -82,11 +75,6 @@ Project: The Dark Mod (http://www.thedarkmod.com/)
 #if defined(MACOS_X)
 
 #define BUILD_OS_ID					1
-#ifdef __ppc__
-	#define CPU_EASYARGS				0
-#elif defined(__i386__)
-	#define CPU_EASYARGS				1
-#endif
 
 #ifdef __MWERKS__
 #define PACKED
@@ -118,14 +106,6 @@ Project: The Dark Mod (http://www.thedarkmod.com/)
 
 #define BUILD_OS_ID					2
 
-#ifdef __i386__
-	#define CPU_EASYARGS				1
-#elif defined(__x86_64__)
-	#define CPU_EASYARGS				0
-#elif defined(__ppc__)
-	#define CPU_EASYARGS				0
-#endif
-
 #define _alloca							alloca
 
 #define PACKED							__attribute__((packed))
@@ -151,14 +131,6 @@ Project: The Dark Mod (http://www.thedarkmod.com/)
 
 #define BUILD_OS_ID					3
 
-#ifdef __i386__
-	#define CPU_EASYARGS				1
-#elif defined(__x86_64__)
-	#define CPU_EASYARGS				0
-#elif defined(__ppc__)
-	#define CPU_EASYARGS				0
-#endif
-
 #define _alloca							alloca
 
 #define PACKED							__attribute__((packed))